@@ -0,0 +1,252 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+/**
+ * @file archive_benchmark.cpp
+ * Compares the stream based binary_data_archive with the buffer based
+ * binary_buffer_archive, which the MQueue and shared memory transports
+ * use to serialize samples. For each type it measures the time to save
+ * and to load one sample. The results are written as JSON.
+ *
+ * Usage: archive-benchmark [--samples N] [--output file.json]
+ */
+
+#include <os/main.h>
+#include <os/fosi.h>
+#include <transports/mqueue/binary_data_archive.hpp>
+#include <transports/mqueue/binary_buffer_archive.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace RTT;
+
+namespace
+{
+    /**
+     * Describes how the benchmark creates a sample type.
+     * \a streamed is false for types which the binary_data_archive
+     * can not transport.
+     */
+    template<class T>
+    struct SampleTraits;
+
+    template<>
+    struct SampleTraits<double>
+    {
+        static const char* name() { return "double"; }
+        static double make() { return 1.5; }
+        static const bool streamed = true;
+    };
+
+    template<>
+    struct SampleTraits<int>
+    {
+        static const char* name() { return "int"; }
+        static int make() { return 42; }
+        static const bool streamed = true;
+    };
+
+    template<>
+    struct SampleTraits< std::vector<double> >
+    {
+        static const char* name() { return "vector1k"; }
+        static std::vector<double> make() { return std::vector<double>( 1000, 1.5 ); }
+        static const bool streamed = true;
+    };
+
+    template<>
+    struct SampleTraits< std::vector< std::vector<double> > >
+    {
+        static const char* name() { return "vector100x10"; }
+        static std::vector< std::vector<double> > make() { return std::vector< std::vector<double> >( 100, std::vector<double>( 10, 1.5 ) ); }
+        static const bool streamed = true;
+    };
+
+    template<>
+    struct SampleTraits<std::string>
+    {
+        static const char* name() { return "string"; }
+        static std::string make() { return std::string( 64, 'x' ); }
+        // binary_data_archive copies the std::string object itself.
+        static const bool streamed = false;
+    };
+
+    template<>
+    struct SampleTraits< std::vector<std::string> >
+    {
+        static const char* name() { return "vector100xstring"; }
+        static std::vector<std::string> make() { return std::vector<std::string>( 100, std::string( 16, 'x' ) ); }
+        static const bool streamed = false;
+    };
+
+    void ignore(const void*) {}
+
+    /**
+     * Called after every save and load, such that the
+     * compiler can not optimise the archive away.
+     */
+    void (*volatile consume)(const void*) = &ignore;
+
+    /**
+     * Collects the results as a JSON array of objects.
+     */
+    class Report
+    {
+        std::ostringstream out;
+        bool first;
+    public:
+        Report() : first(true) {}
+
+        void begin(const std::string& type, const std::string& archive)
+        {
+            out << (first ? "\n" : ",\n") << "    { \"type\": \"" << type << "\", \"archive\": \"" << archive << "\"";
+            first = false;
+        }
+
+        template<class V>
+        void field(const std::string& name, V value)
+        {
+            out << ", \"" << name << "\": " << value;
+        }
+
+        void skipped(const std::string& reason)
+        {
+            out << ", \"skipped\": \"" << reason << "\"";
+        }
+
+        void end()
+        {
+            out << " }";
+        }
+
+        std::string str() const { return out.str(); }
+    };
+
+    template<class T>
+    void benchStream(Report& report, std::vector<char>& buffer, int samples)
+    {
+        namespace io = boost::iostreams;
+        report.begin( SampleTraits<T>::name(), "binary_data_archive" );
+        if ( !SampleTraits<T>::streamed ) {
+            report.skipped( "not supported" );
+            report.end();
+            return;
+        }
+        T sample = SampleTraits<T>::make();
+        T result;
+        int size = 0;
+        nsecs start = rtos_get_time_ns();
+        for (int i = 0; i != samples; ++i) {
+            io::stream<io::array_sink> outbuf( &buffer[0], buffer.size() );
+            mqueue::binary_data_oarchive out( outbuf );
+            out << sample;
+            size = out.getArchiveSize();
+            consume( &buffer[0] );
+        }
+        nsecs saved = rtos_get_time_ns();
+        for (int i = 0; i != samples; ++i) {
+            io::stream<io::array_source> inbuf( &buffer[0], size );
+            mqueue::binary_data_iarchive in( inbuf );
+            in >> result;
+            consume( &result );
+        }
+        nsecs loaded = rtos_get_time_ns();
+        report.field( "bytes", size );
+        report.field( "save_ns", double(saved - start) / samples );
+        report.field( "load_ns", double(loaded - saved) / samples );
+        report.end();
+    }
+
+    template<class T>
+    void benchBuffer(Report& report, std::vector<char>& buffer, int samples)
+    {
+        report.begin( SampleTraits<T>::name(), "binary_buffer_archive" );
+        T sample = SampleTraits<T>::make();
+        T result;
+        int size = 0;
+        nsecs start = rtos_get_time_ns();
+        for (int i = 0; i != samples; ++i) {
+            mqueue::binary_buffer_oarchive out( &buffer[0], buffer.size() );
+            out << sample;
+            size = out.getArchiveSize();
+            consume( &buffer[0] );
+        }
+        nsecs saved = rtos_get_time_ns();
+        for (int i = 0; i != samples; ++i) {
+            mqueue::binary_buffer_iarchive in( &buffer[0], size );
+            in >> result;
+            consume( &result );
+        }
+        nsecs loaded = rtos_get_time_ns();
+        report.field( "bytes", size );
+        report.field( "save_ns", double(saved - start) / samples );
+        report.field( "load_ns", double(loaded - saved) / samples );
+        report.field( "roundtrip_ok", result == sample ? "true" : "false" );
+        report.end();
+    }
+
+    template<class T>
+    void benchType(Report& report, int samples)
+    {
+        std::vector<char> buffer( 64 * 1024 );
+        benchStream<T>( report, buffer, samples );
+        benchBuffer<T>( report, buffer, samples );
+    }
+}
+
+int ORO_main(int argc, char** argv)
+{
+    int samples = 100000;
+    std::string output;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ( arg == "--samples" && i + 1 < argc )
+            samples = atoi( argv[++i] );
+        else if ( arg == "--output" && i + 1 < argc )
+            output = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--samples N] [--output file.json]" << std::endl;
+            return 1;
+        }
+    }
+    if ( samples <= 0 )
+        samples = 1;
+
+    Report report;
+    benchType<double>( report, samples );
+    benchType<int>( report, samples );
+    benchType<std::string>( report, samples );
+    benchType< std::vector<double> >( report, samples / 10 + 1 );
+    benchType< std::vector< std::vector<double> > >( report, samples / 10 + 1 );
+    benchType< std::vector<std::string> >( report, samples / 10 + 1 );
+
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"archives\",\n  \"samples\": " << samples << ",\n  \"results\": ["
+         << report.str() << "\n  ]\n}\n";
+    if ( output.empty() )
+        std::cout << json.str();
+    else {
+        std::ofstream file( output.c_str() );
+        file << json.str();
+        if ( !file ) {
+            std::cerr << "Could not write " << output << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
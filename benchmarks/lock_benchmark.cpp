@@ -0,0 +1,240 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/**
+ * @file lock_benchmark.cpp
+ * Measures how long a high priority thread waits for an RTT lock that
+ * is shared with a low priority thread, while medium priority threads
+ * load the same CPU. Without priority inheritance, the medium priority
+ * threads can preempt the low priority owner of the lock and stretch the
+ * wait of the high priority thread. The results are written as JSON, like
+ * the port benchmark.
+ *
+ * The 'mutex' case measures the time to take an os::Mutex, the 'semaphore'
+ * case the time from an os::Semaphore signal until the waiter runs.
+ * All threads run SCHED_FIFO on one CPU, the cases are skipped when this
+ * process may not use SCHED_FIFO.
+ *
+ * Usage: lock-benchmark [--samples N] [--output file.json]
+ */
+
+#include <os/main.h>
+#include <os/Thread.hpp>
+#include <os/Mutex.hpp>
+#include <os/MutexLock.hpp>
+#include <os/Semaphore.hpp>
+#include <os/CpuSet.hpp>
+#include <os/MainThread.hpp>
+#include <os/TimeService.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace RTT;
+
+namespace
+{
+    const nsecs HoldTime = 200000;   // the writer holds the lock 0.2ms
+    const nsecs HogBusyTime = 2000000; // each hog runs 2ms of every 5ms
+
+    os::Mutex lock;
+    os::Semaphore wakeup(0);
+    volatile nsecs signal_stamp;
+
+    nsecs now() { return os::TimeService::Instance()->getNSecs(); }
+
+    void spin(nsecs duration)
+    {
+        nsecs end = now() + duration;
+        while ( now() < end )
+            ;
+    }
+
+    /**
+     * A SCHED_FIFO thread on a single CPU which plays one part in the
+     * benchmark.
+     */
+    class Worker : public os::Thread
+    {
+    public:
+        enum Role {
+            Hog,     //! Periodically keeps the CPU busy.
+            Writer,  //! Periodically holds the lock, and signals the semaphore after that when \a signals is set.
+            Reader,  //! Periodically measures how long it takes to get the lock.
+            Waiter   //! Measures how long it takes to wake up on the semaphore.
+        };
+
+        std::vector<nsecs> latencies;
+
+        Worker(Role role, int priority, Seconds period, int cpu, int samples, bool signals = false)
+            : os::Thread( ORO_SCHED_RT, priority, period, 0, "Lock" ),
+              role(role), samples(samples), signals(signals), quit(false)
+        {
+            os::CpuSet cpus;
+            cpus.set( cpu );
+            setCpuSet( cpus );
+            latencies.reserve( samples );
+        }
+
+        ~Worker() { stop(); }
+
+        bool done() const { return (int)latencies.size() >= samples; }
+
+    protected:
+        void step()
+        {
+            switch ( role ) {
+            case Hog:
+                spin( HogBusyTime );
+                break;
+            case Writer:
+                {
+                    os::MutexLock locker( lock );
+                    spin( HoldTime );
+                }
+                if ( signals ) {
+                    signal_stamp = now();
+                    wakeup.signal();
+                }
+                break;
+            case Reader:
+                if ( !done() ) {
+                    nsecs start = now();
+                    lock.lock();
+                    latencies.push_back( now() - start );
+                    lock.unlock();
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        void loop()
+        {
+            quit = false;
+            while ( !quit && !done() )
+                if ( wakeup.waitUntil( now() + 100000000LL ) )
+                    latencies.push_back( now() - signal_stamp );
+        }
+
+        bool breakLoop()
+        {
+            quit = true;
+            return true;
+        }
+
+    private:
+        Role role;
+        int samples;
+        bool signals;
+        volatile bool quit;
+    };
+
+    void bench(std::ostringstream& report, const std::string& name, int cpu, int samples)
+    {
+        report << (report.tellp() ? ",\n" : "\n") << "    { \"case\": \"" << name << "\"";
+
+        bool semaphore = name == "semaphore";
+        Worker writer( Worker::Writer, 10, 0.001, cpu, 0, semaphore );
+        if ( writer.getScheduler() != ORO_SCHED_RT ) {
+            report << ", \"skipped\": \"this process may not use SCHED_FIFO\" }";
+            return;
+        }
+        Worker hog1( Worker::Hog, 50, 0.005, cpu, 0 );
+        Worker hog2( Worker::Hog, 51, 0.0071, cpu, 0 );
+        Worker reader( semaphore ? Worker::Waiter : Worker::Reader, 90, semaphore ? 0.0 : 0.0013, cpu, samples );
+
+        reader.start();
+        writer.start();
+        hog1.start();
+        hog2.start();
+        for (int i = 0; i < 10000 && !reader.done(); ++i)
+            usleep( 1000 );
+        hog2.stop();
+        hog1.stop();
+        writer.stop();
+        reader.stop();
+
+        std::vector<nsecs> l = reader.latencies;
+        if ( l.empty() ) {
+            report << ", \"skipped\": \"no samples were taken\" }";
+            return;
+        }
+        std::sort( l.begin(), l.end() );
+        double mean = 0;
+        for (unsigned i = 0; i != l.size(); ++i)
+            mean += l[i];
+        mean /= l.size();
+        report << ", \"samples\": " << l.size()
+               << ", \"latency_ns\": { \"min\": " << l.front() << ", \"mean\": " << (nsecs)mean
+               << ", \"p50\": " << l[l.size() / 2] << ", \"p99\": " << l[l.size() * 99 / 100]
+               << ", \"max\": " << l.back() << " } }";
+    }
+}
+
+int ORO_main(int argc, char** argv)
+{
+    int samples = 2000;
+    std::string output;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ( arg == "--samples" && i + 1 < argc )
+            samples = atoi( argv[++i] );
+        else if ( arg == "--output" && i + 1 < argc )
+            output = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--samples N] [--output file.json]" << std::endl;
+            return 1;
+        }
+    }
+    if ( samples <= 0 )
+        samples = 1;
+
+    // all threads share the first CPU this process may run on.
+    os::CpuSet cpus = os::MainThread::Instance()->getCpuSet();
+    int cpu = 0;
+    while ( cpu < ORONUM_OS_MAX_CPUS - 1 && !cpus.isSet( cpu ) )
+        ++cpu;
+
+    std::ostringstream report;
+    bench( report, "mutex", cpu, samples );
+    bench( report, "semaphore", cpu, samples );
+
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"lock\",\n  \"samples\": " << samples << ",\n  \"cpu\": " << cpu
+#ifdef ORO_OS_MUTEX_PRIO_INHERIT
+         << ",\n  \"priority_inheritance\": true"
+#else
+         << ",\n  \"priority_inheritance\": false"
+#endif
+#ifdef ORO_OS_USE_FUTEX
+         << ",\n  \"futex\": true"
+#else
+         << ",\n  \"futex\": false"
+#endif
+         << ",\n  \"results\": [" << report.str() << "\n  ]\n}\n";
+    if ( output.empty() )
+        std::cout << json.str();
+    else {
+        std::ofstream file( output.c_str() );
+        file << json.str();
+        if ( !file ) {
+            std::cerr << "Could not write " << output << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
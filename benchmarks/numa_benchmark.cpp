@@ -0,0 +1,181 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/**
+ * @file numa_benchmark.cpp
+ * Measures the round trip latency of a port connection between two
+ * activities, once with both activities on the same NUMA node and once
+ * with them on different nodes. The results are written as JSON, like
+ * the port benchmark.
+ *
+ * Usage: numa-benchmark [--samples N] [--output file.json]
+ */
+
+#include <os/main.h>
+#include <InputPort.hpp>
+#include <OutputPort.hpp>
+#include <Activity.hpp>
+#include <TaskContext.hpp>
+#include <os/fosi_internal_interface.hpp>
+#include <os/TimeService.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace RTT;
+
+namespace
+{
+    /**
+     * One side of the round trip. The echo side sends back every time
+     * stamp it receives, the ping side records the round trip time of
+     * each time stamp and sends a new one, until it has enough samples.
+     */
+    class Peer : public TaskContext
+    {
+        InputPort<nsecs> in;
+        OutputPort<nsecs> out;
+        int samples;
+    public:
+        std::vector<nsecs> latencies;
+
+        Peer(const std::string& name, int samples)
+            : TaskContext(name), in("in"), out("out"), samples(samples)
+        {
+            latencies.reserve( samples );
+            ports()->addEventPort( in );
+            ports()->addPort( out );
+        }
+
+        bool done() const { return (int)latencies.size() >= samples; }
+
+        void send() { out.write( os::TimeService::Instance()->getNSecs() ); }
+
+        void updateHook()
+        {
+            nsecs stamp;
+            while ( in.read( stamp ) == NewData ) {
+                if ( samples == 0 ) {
+                    out.write( stamp );
+                    continue;
+                }
+                latencies.push_back( os::TimeService::Instance()->getNSecs() - stamp );
+                if ( !done() )
+                    send();
+            }
+        }
+    };
+
+    /**
+     * Returns the NUMA nodes of this machine.
+     */
+    std::vector<int> numaNodes()
+    {
+        std::vector<int> nodes;
+        for (int node = 0; node < ORONUM_OS_MAX_CPUS; ++node)
+            if ( !os::rtos_numa_node_cpus( node ).empty() )
+                nodes.push_back( node );
+        return nodes;
+    }
+
+    void bench(std::ostringstream& report, const std::string& name, int ping_node, int echo_node, int samples)
+    {
+        report << (report.tellp() ? ",\n" : "\n") << "    { \"placement\": \"" << name << "\"";
+        if ( ping_node < 0 || echo_node < 0 ) {
+            report << ", \"skipped\": \"this machine has only one NUMA node\" }";
+            return;
+        }
+        report << ", \"ping_node\": " << ping_node << ", \"echo_node\": " << echo_node;
+
+        Peer ping( "Ping", samples );
+        Peer echo( "Echo", 0 );
+        Activity* ping_activity = new Activity( ORO_SCHED_OTHER, os::LowestPriority, 0.0, 0, "Ping" );
+        Activity* echo_activity = new Activity( ORO_SCHED_OTHER, os::LowestPriority, 0.0, 0, "Echo" );
+        ping.setActivity( ping_activity );
+        echo.setActivity( echo_activity );
+        ping_activity->setNumaNode( ping_node );
+        echo_activity->setNumaNode( echo_node );
+
+        ConnPolicy policy = ConnPolicy::buffer( 16 );
+        ping.ports()->getPort("out")->connectTo( echo.ports()->getPort("in"), policy );
+        echo.ports()->getPort("out")->connectTo( ping.ports()->getPort("in"), policy );
+        ping.start();
+        echo.start();
+
+        ping.send();
+        for (int i = 0; i < 10000 && !ping.done(); ++i)
+            usleep( 1000 );
+        ping.stop();
+        echo.stop();
+
+        std::vector<nsecs> l = ping.latencies;
+        if ( l.empty() ) {
+            report << ", \"skipped\": \"no samples came back\" }";
+            return;
+        }
+        std::sort( l.begin(), l.end() );
+        double mean = 0;
+        for (unsigned i = 0; i != l.size(); ++i)
+            mean += l[i];
+        mean /= l.size();
+        report << ", \"samples\": " << l.size()
+               << ", \"round_trip_ns\": { \"min\": " << l.front() << ", \"mean\": " << (nsecs)mean
+               << ", \"p50\": " << l[l.size() / 2] << ", \"p99\": " << l[l.size() * 99 / 100]
+               << ", \"max\": " << l.back() << " } }";
+    }
+}
+
+int ORO_main(int argc, char** argv)
+{
+    int samples = 10000;
+    std::string output;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ( arg == "--samples" && i + 1 < argc )
+            samples = atoi( argv[++i] );
+        else if ( arg == "--output" && i + 1 < argc )
+            output = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--samples N] [--output file.json]" << std::endl;
+            return 1;
+        }
+    }
+    if ( samples <= 0 )
+        samples = 1;
+
+    std::vector<int> nodes = numaNodes();
+    std::ostringstream report;
+    if ( nodes.empty() )
+        report << "\n    { \"skipped\": \"this OS does not report NUMA nodes\" }";
+    else {
+        bench( report, "same-node", nodes[0], nodes[0], samples );
+        bench( report, "cross-node", nodes[0], nodes.size() > 1 ? nodes[1] : -1, samples );
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"numa\",\n  \"samples\": " << samples << ",\n  \"results\": ["
+         << report.str() << "\n  ]\n}\n";
+    if ( output.empty() )
+        std::cout << json.str();
+    else {
+        std::ofstream file( output.c_str() );
+        file << json.str();
+        if ( !file ) {
+            std::cerr << "Could not write " << output << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
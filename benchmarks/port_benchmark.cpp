@@ -0,0 +1,616 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/**
+ * @file port_benchmark.cpp
+ * Measures the write to read latency, the throughput, the number of heap
+ * allocations and the number of cache misses of data flow connections, for
+ * each connection policy and for a few sample types. The results are written
+ * as JSON, such that they can be compared between releases.
+ *
+ * Usage: port-benchmark [--samples N] [--output file.json]
+ */
+
+#include <os/main.h>
+#include <InputPort.hpp>
+#include <OutputPort.hpp>
+#include <Activity.hpp>
+#include <TaskContext.hpp>
+#include <base/RunnableInterface.hpp>
+#include <os/Atomic.hpp>
+#include <os/fosi.h>
+#include <internal/ExecutionTrace.hpp>
+#include <types/TemplateTypeInfo.hpp>
+#include <types/TypeInfoRepository.hpp>
+
+#ifdef BENCHMARK_MQUEUE
+#include <transports/mqueue/MQLib.hpp>
+#include <transports/mqueue/MQTemplateProtocol.hpp>
+#include <transports/mqueue/MQSerializationProtocol.hpp>
+#include <boost/serialization/vector.hpp>
+#endif
+
+#ifdef BENCHMARK_SHM
+#include <transports/shm/ShmLib.hpp>
+#include <transports/shm/ShmTemplateProtocol.hpp>
+#include <transports/shm/ShmSerializationProtocol.hpp>
+#include <boost/serialization/vector.hpp>
+#endif
+
+#ifdef BENCHMARK_SOCKET
+#include <transports/socket/SocketLib.hpp>
+#include <transports/socket/SocketTemplateProtocol.hpp>
+#include <transports/socket/SocketSerializationProtocol.hpp>
+#include <boost/serialization/vector.hpp>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace RTT;
+using namespace RTT::internal;
+
+/**
+ * Every heap allocation of the process, including the ones
+ * in the RTT library, passes through this operator new.
+ */
+static os::AtomicInt allocations(0);
+
+#if __cplusplus >= 201103L
+#define BENCHMARK_THROW_BAD_ALLOC
+#else
+#define BENCHMARK_THROW_BAD_ALLOC throw(std::bad_alloc)
+#endif
+
+void* operator new(std::size_t size) BENCHMARK_THROW_BAD_ALLOC
+{
+    void* p = std::malloc( size ? size : 1 );
+    if ( p == 0 )
+        throw std::bad_alloc();
+    allocations.inc();
+    return p;
+}
+
+void operator delete(void* p) throw()
+{
+    std::free( p );
+}
+
+namespace
+{
+    /**
+     * Counts the cache misses of the calling thread, if the
+     * kernel allows us to use the performance counters.
+     */
+    class CacheMissCounter
+    {
+        int fd;
+    public:
+        CacheMissCounter() : fd(-1)
+        {
+#ifdef __linux__
+            struct perf_event_attr attr;
+            memset( &attr, 0, sizeof(attr) );
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd = syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 );
+#endif
+        }
+
+        ~CacheMissCounter()
+        {
+#ifdef __linux__
+            if ( fd >= 0 )
+                close( fd );
+#endif
+        }
+
+        bool available() const { return fd >= 0; }
+
+        void start()
+        {
+#ifdef __linux__
+            if ( fd >= 0 ) {
+                ioctl( fd, PERF_EVENT_IOC_RESET, 0 );
+                ioctl( fd, PERF_EVENT_IOC_ENABLE, 0 );
+            }
+#endif
+        }
+
+        long long stop()
+        {
+            long long count = 0;
+#ifdef __linux__
+            if ( fd >= 0 ) {
+                ioctl( fd, PERF_EVENT_IOC_DISABLE, 0 );
+                if ( read( fd, &count, sizeof(count) ) != sizeof(count) )
+                    count = 0;
+            }
+#endif
+            return count;
+        }
+    };
+
+    struct Blob1K
+    {
+        char data[1024];
+    };
+
+#if defined(BENCHMARK_MQUEUE) || defined(BENCHMARK_SHM) || defined(BENCHMARK_SOCKET)
+}
+
+namespace boost { namespace serialization {
+    template<class Archive>
+    void serialize(Archive& a, Blob1K& b, unsigned int)
+    {
+        a & make_array( b.data, sizeof(b.data) );
+    }
+} }
+
+namespace
+{
+#endif
+
+    /**
+     * Describes how the benchmark creates and registers a sample type.
+     */
+    template<class T>
+    struct SampleTraits;
+
+    template<>
+    struct SampleTraits<double>
+    {
+        static const char* name() { return "double"; }
+        static double make() { return 0.0; }
+        static void change(double& d, int i) { d = i; }
+#ifdef BENCHMARK_MQUEUE
+        static types::TypeTransporter* mqProtocol() { return new mqueue::MQTemplateProtocol<double>(); }
+#endif
+#ifdef BENCHMARK_SHM
+        static types::TypeTransporter* shmProtocol() { return new shm::ShmTemplateProtocol<double>(); }
+#endif
+#ifdef BENCHMARK_SOCKET
+        static types::TypeTransporter* socketProtocol() { return new socket::SocketTemplateProtocol<double>(); }
+#endif
+    };
+
+    template<>
+    struct SampleTraits<Blob1K>
+    {
+        static const char* name() { return "struct1k"; }
+        static Blob1K make() { Blob1K b; memset( b.data, 0, sizeof(b.data) ); return b; }
+        static void change(Blob1K& b, int i) { b.data[0] = char(i); }
+#ifdef BENCHMARK_MQUEUE
+        static types::TypeTransporter* mqProtocol() { return new mqueue::MQTemplateProtocol<Blob1K>(); }
+#endif
+#ifdef BENCHMARK_SHM
+        static types::TypeTransporter* shmProtocol() { return new shm::ShmTemplateProtocol<Blob1K>(); }
+#endif
+#ifdef BENCHMARK_SOCKET
+        static types::TypeTransporter* socketProtocol() { return new socket::SocketTemplateProtocol<Blob1K>(); }
+#endif
+    };
+
+    template<>
+    struct SampleTraits< std::vector<double> >
+    {
+        static const char* name() { return "vector10k"; }
+        static std::vector<double> make() { return std::vector<double>( 10000, 0.0 ); }
+        static void change(std::vector<double>& v, int i) { v[0] = i; }
+#ifdef BENCHMARK_MQUEUE
+        static types::TypeTransporter* mqProtocol() { return new mqueue::MQSerializationProtocol< std::vector<double> >(); }
+#endif
+#ifdef BENCHMARK_SHM
+        static types::TypeTransporter* shmProtocol() { return new shm::ShmSerializationProtocol< std::vector<double> >(); }
+#endif
+#ifdef BENCHMARK_SOCKET
+        static types::TypeTransporter* socketProtocol() { return new socket::SocketSerializationProtocol< std::vector<double> >(); }
+#endif
+    };
+
+    struct PolicyCase
+    {
+        std::string name;
+        std::string transport;
+        ConnPolicy policy;
+    };
+
+    std::vector<PolicyCase> policies()
+    {
+        const char* types[] = { "DATA", "BUFFER", "CIRCULAR_BUFFER" };
+        const char* locks[] = { "UNSYNC", "LOCKED", "LOCK_FREE" };
+        const int lock_ids[] = { ConnPolicy::UNSYNC, ConnPolicy::LOCKED, ConnPolicy::LOCK_FREE };
+        std::vector<PolicyCase> result;
+        for (int t = 0; t != 3; ++t)
+            for (int l = 0; l != 3; ++l) {
+                PolicyCase c;
+                c.name = std::string(types[t]) + "/" + locks[l];
+                c.transport = "local";
+                if ( t == 0 )
+                    c.policy = ConnPolicy::data( lock_ids[l] );
+                else if ( t == 1 )
+                    c.policy = ConnPolicy::buffer( 64, lock_ids[l] );
+                else
+                    c.policy = ConnPolicy::circularBuffer( 64, lock_ids[l] );
+                result.push_back( c );
+            }
+#ifdef BENCHMARK_MQUEUE
+        PolicyCase mq;
+        mq.transport = "mqueue";
+        mq.name = "DATA/LOCK_FREE";
+        mq.policy = ConnPolicy::data( ConnPolicy::LOCK_FREE );
+        mq.policy.transport = ORO_MQUEUE_PROTOCOL_ID;
+        result.push_back( mq );
+        // unprivileged processes may not create queues longer than msg_max (10).
+        mq.name = "BUFFER/LOCK_FREE";
+        mq.policy = ConnPolicy::buffer( 10, ConnPolicy::LOCK_FREE );
+        mq.policy.transport = ORO_MQUEUE_PROTOCOL_ID;
+        result.push_back( mq );
+        mq.name = "DATA/LOCK_FREE/FAST_COMPRESSION";
+        mq.policy = ConnPolicy::data( ConnPolicy::LOCK_FREE );
+        mq.policy.transport = ORO_MQUEUE_PROTOCOL_ID;
+        mq.policy.compression = ConnPolicy::FAST_COMPRESSION;
+        result.push_back( mq );
+#endif
+#ifdef BENCHMARK_SHM
+        PolicyCase shm;
+        shm.transport = "shm";
+        shm.name = "DATA/LOCK_FREE";
+        shm.policy = ConnPolicy::data( ConnPolicy::LOCK_FREE );
+        shm.policy.transport = ORO_SHM_PROTOCOL_ID;
+        result.push_back( shm );
+        shm.name = "BUFFER/LOCK_FREE";
+        shm.policy = ConnPolicy::buffer( 64, ConnPolicy::LOCK_FREE );
+        shm.policy.transport = ORO_SHM_PROTOCOL_ID;
+        result.push_back( shm );
+#endif
+#ifdef BENCHMARK_SOCKET
+        PolicyCase sock;
+        sock.transport = "socket";
+        sock.name = "DATA/LOCK_FREE";
+        sock.policy = ConnPolicy::data( ConnPolicy::LOCK_FREE );
+        sock.policy.transport = ORO_SOCKET_PROTOCOL_ID;
+        result.push_back( sock );
+        sock.name = "BUFFER/LOCK_FREE";
+        sock.policy = ConnPolicy::buffer( 64, ConnPolicy::LOCK_FREE );
+        sock.policy.transport = ORO_SOCKET_PROTOCOL_ID;
+        result.push_back( sock );
+#endif
+        return result;
+    }
+
+    /**
+     * Writes \a count samples as fast as possible.
+     */
+    template<class T>
+    struct Writer : public base::RunnableInterface
+    {
+        OutputPort<T>& port;
+        T sample;
+        int count;
+        volatile bool done;
+        Writer(OutputPort<T>& p, int n) : port(p), sample( SampleTraits<T>::make() ), count(n), done(false) {}
+        bool initialize() { return true; }
+        void step() {}
+        void loop() {
+            for (int i = 0; i != count; ++i) {
+                SampleTraits<T>::change( sample, i );
+                port.write( sample );
+            }
+            done = true;
+        }
+        void finalize() {}
+    };
+
+    /**
+     * Reads until it is told to stop and counts the new samples.
+     */
+    template<class T>
+    struct Reader : public base::RunnableInterface
+    {
+        InputPort<T>& port;
+        T sample;
+        volatile bool quit;
+        long received;
+        Reader(InputPort<T>& p) : port(p), sample( SampleTraits<T>::make() ), quit(false), received(0) {}
+        bool initialize() { quit = false; return true; }
+        void step() {}
+        void loop() {
+            while ( !quit ) {
+                if ( port.read( sample, false ) == NewData )
+                    ++received;
+            }
+            // drain what is still buffered.
+            while ( port.read( sample, false ) == NewData )
+                ++received;
+        }
+        bool breakLoop() { quit = true; return true; }
+        void finalize() {}
+    };
+
+    /**
+     * Collects the results as a JSON array of objects.
+     */
+    class Report
+    {
+        std::ostringstream out;
+        bool first;
+    public:
+        Report() : first(true) {}
+
+        void begin(const std::string& type, const PolicyCase& c, int writers, int readers)
+        {
+            out << (first ? "\n" : ",\n") << "    { \"type\": \"" << type << "\", \"policy\": \"" << c.name
+                << "\", \"transport\": \"" << c.transport
+                << "\", \"writers\": " << writers << ", \"readers\": " << readers;
+            first = false;
+        }
+
+        template<class V>
+        void field(const std::string& name, V value)
+        {
+            out << ", \"" << name << "\": " << value;
+        }
+
+        void skipped(const std::string& reason)
+        {
+            out << ", \"skipped\": \"" << reason << "\"";
+        }
+
+        void end()
+        {
+            out << " }";
+        }
+
+        std::string str() const { return out.str(); }
+    };
+
+    template<class T>
+    void prepareType()
+    {
+        types::TypeInfoRepository::shared_ptr types = types::TypeInfoRepository::Instance();
+        if ( types->getTypeInfo<T>() == 0 )
+            types->addType( new types::TemplateTypeInfo<T, false>( SampleTraits<T>::name() ) );
+#if defined(BENCHMARK_MQUEUE) || defined(BENCHMARK_SHM) || defined(BENCHMARK_SOCKET)
+        types::TypeInfo* ti = types->getTypeInfo<T>();
+#endif
+#ifdef BENCHMARK_MQUEUE
+        if ( ti && ti->getProtocol( ORO_MQUEUE_PROTOCOL_ID ) == 0 )
+            ti->addProtocol( ORO_MQUEUE_PROTOCOL_ID, SampleTraits<T>::mqProtocol() );
+#endif
+#ifdef BENCHMARK_SHM
+        if ( ti && ti->getProtocol( ORO_SHM_PROTOCOL_ID ) == 0 )
+            ti->addProtocol( ORO_SHM_PROTOCOL_ID, SampleTraits<T>::shmProtocol() );
+#endif
+#ifdef BENCHMARK_SOCKET
+        if ( ti && ti->getProtocol( ORO_SOCKET_PROTOCOL_ID ) == 0 )
+            ti->addProtocol( ORO_SOCKET_PROTOCOL_ID, SampleTraits<T>::socketProtocol() );
+#endif
+    }
+
+    /**
+     * Measures the latency of one write() followed by read()s until
+     * the sample arrives, in the calling thread.
+     */
+    template<class T>
+    void benchLatency(Report& report, const PolicyCase& c, int samples)
+    {
+        report.begin( SampleTraits<T>::name(), c, 1, 1 );
+        OutputPort<T> out("out");
+        InputPort<T> in("in");
+        // transports name their streams after the owner of the ports.
+        TaskContext owner("benchmark");
+        owner.ports()->addPort( out );
+        owner.ports()->addPort( in );
+        T sample = SampleTraits<T>::make();
+        T result = SampleTraits<T>::make();
+        out.setDataSample( sample );
+        if ( !out.connectTo( &in, c.policy ) ) {
+            report.skipped( "connection failed" );
+            report.end();
+            return;
+        }
+
+        LatencyHistogram latency;
+        CacheMissCounter misses;
+        int lost = 0;
+        int allocs = allocations.read();
+        misses.start();
+        for (int i = 0; i != samples; ++i) {
+            SampleTraits<T>::change( sample, i );
+            nsecs start = rtos_get_time_ns();
+            out.write( sample );
+            FlowStatus fs;
+            while ( (fs = in.read( result, false )) != NewData && rtos_get_time_ns() - start < 1000000000LL )
+                ;
+            nsecs end = rtos_get_time_ns();
+            if ( fs == NewData )
+                latency.add( end - start );
+            else
+                ++lost;
+        }
+        long long missed = misses.stop();
+        allocs = allocations.read() - allocs;
+
+        report.field( "latency_min_ns", latency.min() );
+        report.field( "latency_mean_ns", latency.mean() );
+        report.field( "latency_p50_ns", latency.percentile(50) );
+        report.field( "latency_p99_ns", latency.percentile(99) );
+        report.field( "latency_max_ns", latency.max() );
+        report.field( "lost", lost );
+        report.field( "allocations_per_op", double(allocs) / samples );
+        if ( misses.available() )
+            report.field( "cache_misses_per_op", double(missed) / samples );
+        else
+            report.field( "cache_misses_per_op", "null" );
+        report.end();
+        out.disconnect();
+    }
+
+    /**
+     * Measures the number of samples per second which \a writers
+     * threads can write and \a readers threads can read.
+     */
+    template<class T>
+    void benchThroughput(Report& report, const PolicyCase& c, int writers, int readers, int samples)
+    {
+        report.begin( SampleTraits<T>::name(), c, writers, readers );
+        if ( c.policy.lock_policy == ConnPolicy::UNSYNC ) {
+            report.skipped( "not thread-safe" );
+            report.end();
+            return;
+        }
+        TaskContext owner("benchmark");
+        std::vector< OutputPort<T>* > outs;
+        std::vector< InputPort<T>* > ins;
+        for (int w = 0; w != writers; ++w) {
+            std::ostringstream name;
+            name << "out" << w;
+            outs.push_back( new OutputPort<T>( name.str() ) );
+            outs.back()->setDataSample( SampleTraits<T>::make() );
+            owner.ports()->addPort( *outs.back() );
+        }
+        for (int r = 0; r != readers; ++r) {
+            std::ostringstream name;
+            name << "in" << r;
+            ins.push_back( new InputPort<T>( name.str() ) );
+            owner.ports()->addPort( *ins.back() );
+        }
+        bool connected = true;
+        for (int w = 0; w != writers; ++w)
+            for (int r = 0; r != readers; ++r)
+                connected = outs[w]->connectTo( ins[r], c.policy ) && connected;
+
+        if ( connected ) {
+            std::vector< Writer<T>* > wr;
+            std::vector< Reader<T>* > rd;
+            std::vector< Activity* > wa, ra;
+            for (int r = 0; r != readers; ++r) {
+                rd.push_back( new Reader<T>( *ins[r] ) );
+                ra.push_back( new Activity( ORO_SCHED_OTHER, os::LowestPriority, 0.0, rd.back(), "Reader" ) );
+                ra.back()->start();
+            }
+            for (int w = 0; w != writers; ++w) {
+                wr.push_back( new Writer<T>( *outs[w], samples ) );
+                wa.push_back( new Activity( ORO_SCHED_OTHER, os::LowestPriority, 0.0, wr.back(), "Writer" ) );
+            }
+            nsecs start = rtos_get_time_ns();
+            for (int w = 0; w != writers; ++w)
+                wa[w]->start();
+            TIME_SPEC poll = ticks2timespec( nano2ticks( 1000000 ) );
+            for (int w = 0; w != writers; ++w)
+                while ( !wr[w]->done )
+                    rtos_nanosleep( &poll, 0 );
+            Seconds written = nsecs_to_Seconds( rtos_get_time_ns() - start );
+            for (int r = 0; r != readers; ++r)
+                ra[r]->stop();
+            Seconds elapsed = nsecs_to_Seconds( rtos_get_time_ns() - start );
+            long received = 0;
+            for (int r = 0; r != readers; ++r)
+                received += rd[r]->received;
+
+            report.field( "writes_per_s", writers * samples / written );
+            report.field( "reads_per_s", received / elapsed );
+            for (int w = 0; w != writers; ++w) {
+                delete wa[w];
+                delete wr[w];
+            }
+            for (int r = 0; r != readers; ++r) {
+                delete ra[r];
+                delete rd[r];
+            }
+        } else
+            report.skipped( "connection failed" );
+        report.end();
+        for (int w = 0; w != writers; ++w) {
+            outs[w]->disconnect();
+            owner.ports()->removePort( outs[w]->getName() );
+            delete outs[w];
+        }
+        for (int r = 0; r != readers; ++r) {
+            owner.ports()->removePort( ins[r]->getName() );
+            delete ins[r];
+        }
+    }
+
+    template<class T>
+    void benchType(Report& report, int samples)
+    {
+        prepareType<T>();
+        std::vector<PolicyCase> cases = policies();
+        for (unsigned int i = 0; i != cases.size(); ++i) {
+            log(Info) << "Benchmarking " << SampleTraits<T>::name() << " over " << cases[i].name
+                      << " (" << cases[i].transport << ")" << endlog();
+            benchLatency<T>( report, cases[i], samples );
+            benchThroughput<T>( report, cases[i], 1, 1, samples );
+            // the transports connect one writer to one reader.
+            if ( cases[i].policy.transport == 0 ) {
+                benchThroughput<T>( report, cases[i], 1, 4, samples );
+                benchThroughput<T>( report, cases[i], 4, 1, samples );
+            }
+        }
+    }
+}
+
+int ORO_main(int argc, char** argv)
+{
+    int samples = 10000;
+    std::string output;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ( arg == "--samples" && i + 1 < argc )
+            samples = atoi( argv[++i] );
+        else if ( arg == "--output" && i + 1 < argc )
+            output = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--samples N] [--output file.json]" << std::endl;
+            return 1;
+        }
+    }
+    if ( samples <= 0 )
+        samples = 1;
+
+    Report report;
+    benchType<double>( report, samples );
+    benchType<Blob1K>( report, samples );
+    // a 10k vector is expensive to copy, so take fewer samples.
+    benchType< std::vector<double> >( report, samples / 10 + 1 );
+
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"ports\",\n  \"samples\": " << samples << ",\n  \"results\": ["
+         << report.str() << "\n  ]\n}\n";
+    if ( output.empty() )
+        std::cout << json.str();
+    else {
+        std::ofstream file( output.c_str() );
+        file << json.str();
+        if ( !file ) {
+            std::cerr << "Could not write " << output << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -78,7 +78,7 @@ namespace RTT
     }
 
     ConnPolicy::ConnPolicy(int type /* = DATA*/, int lock_policy /*= LOCK_FREE*/)
-        : type(type), init(false), lock_policy(lock_policy), pull(false), size(0), transport(0), data_size(0) {}
+        : type(type), init(false), lock_policy(lock_policy), pull(false), size(0), transport(0), data_size(0), shared(false), compression(NO_COMPRESSION), keyframe_period(0), max_elements(0), decimation(0), min_period(0.0), coalesce(false) {}
 
     /** @cond */
     /** This is dead code. We use the boost::serialization now.
@@ -55,11 +55,14 @@ namespace RTT {
      *       \a size number of elements can be stored until the reader reads
      *       them. BUFFER drops newer samples on full, CIRCULAR_BUFFER drops older samples on full.
      *       UNBUFFERED is only valid for output streaming connections.
-     *  <li> the locking policy: LOCKED, LOCK_FREE or UNSYNC. This defines how locking is done in the
-     *       connection. For now, only three policies are available. LOCKED uses
+     *  <li> the locking policy: LOCKED, LOCK_FREE, LOCK_FREE_SPSC or UNSYNC. This defines how locking is done in the
+     *       connection. For now, only four policies are available. LOCKED uses
      *       mutexes, LOCK_FREE uses a lock free method and UNSYNC means there's no
      *       synchronisation at all (not thread safe). The latter should
      *       be used only when there is no contention (simultaneous write-read).
+     *       LOCK_FREE_SPSC uses wait-free storage that is only safe when one
+     *       thread writes the output port and one thread reads the input port.
+     *       Circular buffers and CORBA connections fall back to LOCK_FREE.
      *
      *  <li> if, upon connection, the last value that has been written on the
      *       writer end should be written on the connection as well to
@@ -81,6 +84,30 @@ namespace RTT {
      *       especially if the data is dynamically sized (like std::vector<double>).
      *       If you leave this empty (recommended), the protocol will try to guess it.
      *       The unit of data size is protocol dependent.
+     *  <li> if the connection stores shared samples. A shared connection stores
+     *       extras::ReadOnlyPointer objects instead of copies of the data, such
+     *       that samples written with OutputPort::loan() and OutputPort::commit()
+     *       can be read with InputPort::readShared() without being copied. This
+     *       flag only has an effect on local (in-process) connections.
+     *  <li> the compression of the samples. Inter-process transports may
+     *       compress each marshalled sample, which trades CPU time for
+     *       bandwidth. The sender skips compression of samples that do not
+     *       compress well, and the receiver accepts both, so only the sending
+     *       side needs to enable it.
+     *  <li> the keyframe period. Inter-process transports may send only the
+     *       bytes of each marshalled sample that changed since the previous
+     *       one, and a complete sample every keyframe_period samples. Both
+     *       ends of the connection must use the same setting.
+     *  <li> the maximum number of elements of a sequence sample. Inter-process
+     *       transports may allocate their buffers and samples for this many
+     *       elements when the connection is made, such that samples of any
+     *       size up to it are transported without allocating memory.
+     *  <li> the rate of the samples. A connection may forward only one
+     *       out of \a decimation samples, at most one sample per
+     *       \a min_period seconds, and only the latest sample of a batch
+     *       if \a coalesce is set. The other samples are dropped on the
+     *       writer side, before they are stored or marshalled, which suits
+     *       loggers and user interfaces that do not need every sample.
      *  <li> the name of the connection. Can be used to coordinate out of band
      *       transport such that they can find each other by name. In practice,
      *       the name contains a port number or file descriptor to be opened.
@@ -100,6 +127,10 @@ namespace RTT {
         static const int UNSYNC    = 0;
         static const int LOCKED    = 1;
         static const int LOCK_FREE = 2;
+        static const int LOCK_FREE_SPSC = 3;
+
+        static const int NO_COMPRESSION   = 0;
+        static const int FAST_COMPRESSION = 1;
 
         /**
          * Create a policy for a (lock-free) fifo buffer connection of a given size.
@@ -173,6 +204,63 @@ namespace RTT {
          */
         mutable int    data_size;
 
+        /**
+         * If true, the connection stores shared samples instead of copies,
+         * which avoids copying large samples that are written with
+         * OutputPort::loan() and OutputPort::commit(). Plain writes to a shared
+         * connection allocate memory. Only used for local connections.
+         */
+        bool   shared;
+
+        /**
+         * NO_COMPRESSION or FAST_COMPRESSION. The latter compresses the
+         * marshalled samples with a fast LZ77 codec in transports that
+         * support it (currently the mqueue transport). Only used for
+         * inter-process connections.
+         */
+        int    compression;
+
+        /**
+         * If not zero, inter-process connections send only the bytes that
+         * changed since the previous sample, and a complete sample every
+         * keyframe_period samples or when the size of the sample changes
+         * (see types::DeltaMarshaller). This suits DATA connections of large
+         * samples of which only a few fields change at a time.
+         */
+        int    keyframe_period;
+
+        /**
+         * If not zero, the largest number of elements the samples of this
+         * connection will hold, if they are a std::vector or a std::string.
+         * Transports that support it (currently the mqueue and socket
+         * transports) then allocate their buffers and receive sample for
+         * that many elements once, when the connection is made, instead of
+         * when a larger sample arrives. The mqueue transport still transports
+         * larger samples, at the cost of an allocation, the socket transport
+         * drops them.
+         */
+        int    max_elements;
+
+        /**
+         * If larger than one, only one out of every \a decimation samples
+         * written is forwarded on this connection, starting with the first.
+         */
+        int    decimation;
+
+        /**
+         * If not zero, the least number of seconds between two samples
+         * forwarded on this connection. Samples written sooner are dropped.
+         */
+        double min_period;
+
+        /**
+         * If true, a batch of samples written with OutputPort::write(const std::vector<T>&)
+         * forwards only its latest sample, if any sample of the batch is let
+         * through by \a decimation and \a min_period. Otherwise, each sample
+         * of the batch is considered on its own.
+         */
+        bool   coalesce;
+
         /**
          * The name of this connection. May be used by transports to define a 'topic' or
          * lookup name to connect two data streams. If you leave this empty (recommended),
@@ -45,6 +45,7 @@
 #include "internal/MWSRQueue.hpp"
 #include "TaskContext.hpp"
 #include "internal/CatchConfig.hpp"
+#include "internal/ExecutionTrace.hpp"
 #include "extras/SlaveActivity.hpp"
 
 #include <boost/bind.hpp>
@@ -54,7 +55,9 @@
 #include <functional>
 #include <algorithm>
 
+#ifndef ORONUM_EE_MQUEUE_SIZE
 #define ORONUM_EE_MQUEUE_SIZE 100
+#endif
 
 namespace RTT
 {
@@ -71,8 +74,8 @@ namespace RTT
 
     ExecutionEngine::ExecutionEngine( TaskCore* owner )
         : taskc(owner),
-          mqueue(new MWSRQueue<DisposableInterface*>(ORONUM_EE_MQUEUE_SIZE) ),
-          f_queue( new MWSRQueue<ExecutableInterface*>(ORONUM_EE_MQUEUE_SIZE) ),
+          mqueue(new SegmentedMWSRQueue<DisposableInterface*>(ORONUM_EE_MQUEUE_SIZE, ORONUM_EE_MQUEUE_SIZE) ),
+          f_queue( new SegmentedMWSRQueue<ExecutableInterface*>(ORONUM_EE_MQUEUE_SIZE, ORONUM_EE_MQUEUE_SIZE) ),
           mmaster(0)
     {
     }
@@ -208,6 +211,57 @@ namespace RTT
         return true;
     }
 
+    void ExecutionEngine::setMessageQueueCapacity(unsigned int capacity)
+    {
+        mqueue->setCapacity( capacity );
+    }
+
+    unsigned int ExecutionEngine::getMessageQueueCapacity() const
+    {
+        return mqueue->capacity();
+    }
+
+    bool ExecutionEngine::setFunctionQueueCapacity(unsigned int capacity)
+    {
+        // processFunctions() re-queues the loaded functions,
+        // which must never be rejected.
+        if ( capacity < f_queue->size() )
+            return false;
+        f_queue->setCapacity( capacity );
+        return true;
+    }
+
+    unsigned int ExecutionEngine::getFunctionQueueCapacity() const
+    {
+        return f_queue->capacity();
+    }
+
+    unsigned int ExecutionEngine::getMessageQueueHighWaterMark() const
+    {
+        return mqueue->highWaterMark();
+    }
+
+    unsigned int ExecutionEngine::getMessageQueueRejected() const
+    {
+        return mqueue->rejected();
+    }
+
+    unsigned int ExecutionEngine::getFunctionQueueHighWaterMark() const
+    {
+        return f_queue->highWaterMark();
+    }
+
+    unsigned int ExecutionEngine::getFunctionQueueRejected() const
+    {
+        return f_queue->rejected();
+    }
+
+    void ExecutionEngine::resetQueueStatistics()
+    {
+        mqueue->resetStatistics();
+        f_queue->resetStatistics();
+    }
+
     bool ExecutionEngine::initialize() {
         // nop
         return true;
@@ -349,9 +403,24 @@ namespace RTT
     }
 
     void ExecutionEngine::step() {
-        processMessages();
-        processFunctions();
-        processChildren(); // aren't these ExecutableInterfaces ie functions ?
+        ExecutionTrace* trace = taskc ? taskc->mtrace : 0;
+        if ( trace == 0 || !trace->isEnabled() ) {
+            processMessages();
+            processFunctions();
+            processChildren(); // aren't these ExecutableInterfaces ie functions ?
+            return;
+        }
+        nsecs start = rtos_get_time_ns();
+        {
+            TraceScope scope( trace, ExecutionTrace::Messages );
+            processMessages();
+        }
+        {
+            TraceScope scope( trace, ExecutionTrace::Functions );
+            processFunctions();
+        }
+        processChildren();
+        trace->cycle( start, rtos_get_time_ns() - start, this->getActivity() ? this->getActivity()->getPeriod() : 0.0 );
     }
 
     void ExecutionEngine::processChildren() {
@@ -360,7 +429,11 @@ namespace RTT
             // A trigger() in startHook() will be ignored, we trigger in TaskCore after startHook finishes.
             if ( taskc->mTaskState == TaskCore::Running && taskc->mTargetState == TaskCore::Running ) {
                 TRY (
-                    taskc->prepareUpdateHook();
+                    {
+                        TraceScope scope( taskc->mtrace, ExecutionTrace::PrepareUpdateHook );
+                        taskc->prepareUpdateHook();
+                    }
+                    TraceScope scope( taskc->mtrace, ExecutionTrace::UpdateHook );
                     taskc->updateHook();
                 ) CATCH(std::exception const& e,
                     log(Error) << "in updateHook(): switching to exception state because of unhandled exception" << endlog();
@@ -374,6 +447,7 @@ namespace RTT
             // in case start() or updateHook() called error(), this will be called:
             if (  taskc->mTaskState == TaskCore::RunTimeError ) {
                 TRY (
+                    TraceScope scope( taskc->mtrace, ExecutionTrace::ErrorHook );
                     taskc->errorHook();
                 ) CATCH(std::exception const& e,
                     log(Error) << "in errorHook(): switching to exception state because of unhandled exception" << endlog();
@@ -391,7 +465,11 @@ namespace RTT
         for (std::vector<TaskCore*>::iterator it = children.begin(); it != children.end();++it) {
             if ( (*it)->mTaskState == TaskCore::Running  && (*it)->mTargetState == TaskCore::Running  ){
                 TRY (
-                    (*it)->prepareUpdateHook();
+                    {
+                        TraceScope scope( (*it)->mtrace, ExecutionTrace::PrepareUpdateHook );
+                        (*it)->prepareUpdateHook();
+                    }
+                    TraceScope scope( (*it)->mtrace, ExecutionTrace::UpdateHook );
                     (*it)->updateHook();
                 ) CATCH(std::exception const& e,
                     log(Error) << "in updateHook(): switching to exception state because of unhandled exception" << endlog();
@@ -404,6 +482,7 @@ namespace RTT
             }
             if (  (*it)->mTaskState == TaskCore::RunTimeError ){
                 TRY (
+                    TraceScope scope( (*it)->mtrace, ExecutionTrace::ErrorHook );
                     (*it)->errorHook();
                 ) CATCH(std::exception const& e,
                     log(Error) << "in errorHook(): switching to exception state because of unhandled exception" << endlog();
@@ -145,6 +145,64 @@ namespace RTT
          */
         virtual bool removeSelfFunction(base::ExecutableInterface* f);
 
+        /**
+         * Set the maximum number of messages that can be queued
+         * by process() in between two executions of this engine.
+         * When the queue is full, process() returns false.
+         * The queue allocates its storage in segments from the
+         * real-time allocator as it fills up. This may be called
+         * at any time.
+         * @param capacity The maximum number of queued messages.
+         */
+        void setMessageQueueCapacity(unsigned int capacity);
+
+        /**
+         * Returns the maximum number of messages that can be queued.
+         */
+        unsigned int getMessageQueueCapacity() const;
+
+        /**
+         * Set the maximum number of functions that can be run
+         * with runFunction(). This may be called at any time, but
+         * can not be lowered below the number of loaded functions.
+         * @param capacity The maximum number of loaded functions.
+         * @return false if more functions are loaded than \a capacity.
+         */
+        bool setFunctionQueueCapacity(unsigned int capacity);
+
+        /**
+         * Returns the maximum number of functions that can be run.
+         */
+        unsigned int getFunctionQueueCapacity() const;
+
+        /**
+         * Returns the largest number of messages that were queued.
+         */
+        unsigned int getMessageQueueHighWaterMark() const;
+
+        /**
+         * Returns the number of messages that were rejected
+         * because the message queue was full.
+         */
+        unsigned int getMessageQueueRejected() const;
+
+        /**
+         * Returns the largest number of functions that were loaded.
+         */
+        unsigned int getFunctionQueueHighWaterMark() const;
+
+        /**
+         * Returns the number of functions that were rejected
+         * because the function queue was full.
+         */
+        unsigned int getFunctionQueueRejected() const;
+
+        /**
+         * Resets the high-water marks and rejected counters
+         * of the message and function queues.
+         */
+        void resetQueueStatistics();
+
         /**
          * Call this if you wish to block on a message arriving in the Execution Engine.
          * Each time one or more messages are processed, waitForMessages will return
@@ -251,14 +309,14 @@ namespace RTT
         /**
          * Our Message queue
          */
-        internal::MWSRQueue<base::DisposableInterface*>* mqueue;
+        internal::SegmentedMWSRQueue<base::DisposableInterface*>* mqueue;
 
         std::vector<base::TaskCore*> children;
 
         /**
          * Stores all functions we're executing.
          */
-        internal::MWSRQueue<base::ExecutableInterface*>* f_queue;
+        internal::SegmentedMWSRQueue<base::ExecutableInterface*>* f_queue;
 
         os::Mutex msg_lock;
         os::Condition msg_cond;
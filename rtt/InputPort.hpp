@@ -84,6 +84,41 @@ namespace RTT
             return false;
         }
 
+        bool do_read_shared(typename base::ChannelElement<T>::shared_sample_t& sample, FlowStatus& result, bool copy_old_data, const internal::ConnectionManager::ChannelDescriptor& descriptor)
+        {
+            typename base::ChannelElement<T>::shared_ptr input = static_cast< base::ChannelElement<T>* >( descriptor.get<1>().get() );
+            assert( result != NewData );
+            if ( input ) {
+                FlowStatus tresult = input->readShared(sample, copy_old_data);
+                // the result trickery is for not overwriting OldData with NoData.
+                if (tresult == NewData) {
+                    result = tresult;
+                    return true;
+                }
+                // stores OldData result
+                if (tresult > result)
+                    result = tresult;
+            }
+            return false;
+        }
+
+        bool do_read_batch(std::vector<T>& samples, FlowStatus& result, bool copy_old_data, const internal::ConnectionManager::ChannelDescriptor& descriptor)
+        {
+            typename base::ChannelElement<T>::shared_ptr input = static_cast< base::ChannelElement<T>* >( descriptor.get<1>().get() );
+            assert( result != NewData );
+            if ( input ) {
+                FlowStatus tresult = input->readBatch(samples);
+                if (tresult == NewData) {
+                    result = tresult;
+                    return true;
+                }
+                // stores OldData result
+                if (tresult > result)
+                    result = tresult;
+            }
+            return false;
+        }
+
         /**
          * You are not allowed to copy ports.
          * In case you want to create a container of ports,
@@ -157,6 +192,41 @@ namespace RTT
         }
 
 
+        /** Reads a shared sample from the connection, without copying it.
+         * This only avoids the copy if the connection was created with the
+         * ConnPolicy::shared flag set, otherwise a new shared sample holding
+         * a copy is returned.
+         *
+         * The sample is shared with the writer and other readers and must not
+         * be modified. Release it (or read again) as soon as possible, since the
+         * writer can only re-use it in OutputPort::loan() when no reader refers
+         * to it anymore.
+         * @see read() for the meaning of @arg copy_old_data and the return value.
+         */
+        FlowStatus readShared(typename base::ChannelElement<T>::shared_sample_t& sample, bool copy_old_data = true)
+        {
+            FlowStatus result = NoData;
+            // read and iterate if necessary.
+            cmanager.select_reader_channel( boost::bind( &InputPort::do_read_shared, this, boost::ref(sample), boost::ref(result), boost::lambda::_1, boost::lambda::_2), copy_old_data );
+            return result;
+        }
+
+        /** Reads all new samples of a connection at once. \a samples is cleared
+         * and filled with the new samples, in the order they were written. A
+         * buffered connection hands out all its samples in one go, a data
+         * connection only has its last sample.
+         *
+         * Returns RTT::NewData if at least one new sample was read, and
+         * either RTT::OldData or RTT::NoData otherwise. In the latter case,
+         * \a samples is empty.
+         */
+        FlowStatus readAll(std::vector<T>& samples)
+        {
+            FlowStatus result = NoData;
+            cmanager.select_reader_channel( boost::bind( &InputPort::do_read_batch, this, boost::ref(samples), boost::ref(result), boost::lambda::_1, boost::lambda::_2), false );
+            return result;
+        }
+
         /** Read all new samples that are available on this port, and returns
          * the last one.
          *
@@ -183,7 +253,7 @@ namespace RTT
          */
         void getDataSample(T& sample)
         {
-            typename base::ChannelElement<T>::shared_ptr input = static_cast< base::ChannelElement<T>* >( cmanager.getCurrentChannel() );
+            typename base::ChannelElement<T>::shared_ptr input = boost::static_pointer_cast< base::ChannelElement<T> >( cmanager.getCurrentChannel() );
             if ( input ) {
                 sample = input->data_sample();
             }
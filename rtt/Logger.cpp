@@ -41,9 +41,22 @@
 #include "os/MutexLock.hpp"
 #include "os/Mutex.hpp"
 #include "os/TimeService.hpp"
+#include "os/Thread.hpp"
+#include "os/Atomic.hpp"
+#include "os/CAS.hpp"
 
 #include "Logger.hpp"
 #include <iomanip>
+#include <cstring>
+#include <cstdio>
+
+#ifndef OROBLD_DISABLE_LOGGING
+#ifdef OROBLD_OS_NO_ASM
+#  include "base/BufferLocked.hpp"
+#else
+#  include "base/BufferLockFree.hpp"
+#endif
+#endif
 
 #ifdef OROSEM_PRINTF_LOGGING
 #  include <stdio.h>
@@ -114,6 +127,53 @@ namespace RTT
 
 #endif
 
+/**
+ * The maximum length of a line logged in asynchronous mode.
+ * Longer lines are truncated.
+ */
+#ifndef ORONUM_LOGGING_RECORD_SIZE
+#define ORONUM_LOGGING_RECORD_SIZE 256
+#endif
+
+/**
+ * The period in seconds of the thread which writes the
+ * lines of an asynchronous Logger.
+ */
+#ifndef ORONUM_LOGGING_FLUSH_PERIOD
+#define ORONUM_LOGGING_FLUSH_PERIOD 0.01
+#endif
+
+/**
+ * The number of threads which can format their log lines
+ * in their own buffer in asynchronous mode. Other threads
+ * share one line buffer, which is guarded by a mutex.
+ */
+#ifndef ORONUM_LOGGING_THREAD_LINES
+#define ORONUM_LOGGING_THREAD_LINES ORONUM_OS_MAX_THREADS
+#endif
+
+/**
+ * Thread local storage is used to find the line buffer of
+ * the current thread. Without it, all threads share one line.
+ */
+#if defined(__GNUC__) && !defined(__APPLE__)
+#  define ORO_LOGGING_TLS __thread
+#elif defined(_MSC_VER)
+#  define ORO_LOGGING_TLS __declspec(thread)
+#endif
+
+    namespace {
+        /**
+         * Each Logger::D gets a new generation, such that threads
+         * do not use a line of a previous Logger instance.
+         */
+        unsigned int generations = 0;
+#ifdef ORO_LOGGING_TLS
+        ORO_LOGGING_TLS void* threadline = 0;
+        ORO_LOGGING_TLS unsigned int threadgeneration = 0;
+#endif
+    }
+
     Logger& Logger::log() {
         return *Instance();
     }
@@ -147,13 +207,22 @@ namespace RTT
               timestamp(0),
               started(false), showtime(true), allowRT(false),
               mlogStdOut(true), mlogFile(true),
-              moduleptr("Logger")
+              moduleptr("Logger"),
+              records(0), flusher(0), dropped(0), truncated(0), reported(0),
+              lines(0), linesfull(0), linesreported(false),
+              asyncmode(0), producers(0), generation(++generations)
         {
 #if defined(OROSEM_FILE_LOGGING) && !defined(OROSEM_LOG4CPP_LOGGING) && defined(OROSEM_PRINTF_LOGGING)
             logfile = fopen(logfile_name ? logfile_name : "orocos.log","w");
 #endif
         }
 
+        ~D()
+        {
+            delete records;
+            delete[] lines;
+        }
+
         bool maylog() const {
             if (!started || (outloglevel == RealTime && allowRT == false))
                 return false;
@@ -161,13 +230,21 @@ namespace RTT
         }
 
         bool maylogStdOut() const {
-            if ( inloglevel <= outloglevel && outloglevel != Never && inloglevel != Never && mlogStdOut)
+            return maylogStdOut(inloglevel);
+        }
+
+        bool maylogStdOut(LogLevel ll) const {
+            if ( ll <= outloglevel && outloglevel != Never && ll != Never && mlogStdOut)
                 return true;
             return false;
         }
 
         bool maylogFile() const {
-            if ( (inloglevel <= Info || inloglevel <= outloglevel)  && mlogFile)
+            return maylogFile(inloglevel);
+        }
+
+        bool maylogFile(LogLevel ll) const {
+            if ( (ll <= Info || ll <= outloglevel)  && mlogFile)
                 return true;
             return false;
         }
@@ -180,8 +257,18 @@ namespace RTT
         void logit(std::ostream& (*pf)(std::ostream&))
         {
             // only on Logger::nl or Logger::endl, a time+log-line is written.
+            Line* line = threadLine();
+            if ( line ) {
+                commit( *line, pf == Logger::endl );
+                return;
+            }
             os::MutexLock lock( inpguard );
-            std:: string res = showTime() +" " + showLevel(inloglevel) + showModule() + " ";
+            if ( asyncmode ) {
+                enqueue( pf == Logger::endl );
+                return;
+            }
+            std:: string res = showTime( TimeService::Instance()->getTicks() ) +" " + showLevel(inloglevel) + showModule() + " ";
+            os::MutexLock olock( outguard );
 
             // do not log if not wanted.
             if ( maylogStdOut() ) {
@@ -219,6 +306,277 @@ namespace RTT
             }
         }
 
+        /**
+         * A log line as it is stored by an asynchronous Logger.
+         * The time stamp, level and module are only formatted
+         * when the Flusher writes the line.
+         */
+        struct Record
+        {
+            Record() : stamp(0), level(Never), tostdout(false), tofile(false), flush(false)
+            {
+                module[0] = 0;
+                text[0] = 0;
+            }
+            TimeService::ticks stamp;
+            LogLevel level;
+            bool tostdout, tofile, flush;
+            char module[64];
+            char text[ORONUM_LOGGING_RECORD_SIZE];
+        };
+
+        typedef base::BufferInterface<Record> RecordBuffer;
+
+        /**
+         * The line buffer of one thread of an asynchronous Logger.
+         * The text is formatted directly into the Record, which
+         * is copied into the asynchronous buffer when the line ends.
+         * Text which does not fit in the Record is dropped.
+         */
+        struct Line
+            : public std::streambuf
+        {
+            Line() : stream(this), level(Info), owner(0)
+            {
+                reset();
+            }
+
+            void reset()
+            {
+                setp( rec.text, rec.text + sizeof(rec.text) - 1 );
+                overflowed = false;
+            }
+
+            int overflow(int c)
+            {
+                overflowed = true;
+                return c == EOF ? 0 : c;
+            }
+
+            /**
+             * Terminates the text of the record.
+             */
+            void terminate()
+            {
+                *pptr() = 0;
+            }
+
+            Record rec;
+            std::ostream stream;
+            LogLevel level;
+            bool overflowed;
+            /**
+             * Set to 1 by the thread which uses this line.
+             */
+            volatile int owner;
+        };
+
+        /**
+         * The low priority thread which periodically writes
+         * the records of an asynchronous Logger.
+         */
+        struct Flusher
+            : public os::Thread
+        {
+            D* d;
+            Flusher(D* owner)
+                : os::Thread(ORO_SCHED_OTHER, os::LowestPriority, ORONUM_LOGGING_FLUSH_PERIOD, ~0, "LogFlusher"),
+                  d(owner)
+            {}
+            void step() {
+                d->drain();
+            }
+        };
+
+        /**
+         * Copies the current log line into a Record of the
+         * asynchronous buffer. Does not allocate memory and
+         * does no I/O. Must be called with inpguard locked.
+         */
+        void enqueue(bool flush)
+        {
+            Record rec;
+            rec.stamp = TimeService::Instance()->getTicks();
+            rec.level = inloglevel;
+            rec.tostdout = maylogStdOut();
+            rec.tofile = maylogFile();
+            rec.flush = flush;
+            if ( !rec.tostdout && !rec.tofile )
+                return;
+            strncpy( rec.module, moduleptr.c_str(), sizeof(rec.module) - 1 );
+            rec.module[sizeof(rec.module) - 1] = 0;
+            // both lines contain the same text when both are enabled.
+#if defined(OROSEM_FILE_LOGGING) || defined(OROSEM_REMOTE_LOGGING)
+            std::stringstream& line = rec.tostdout ? logline : fileline;
+#else
+            std::stringstream& line = logline;
+#endif
+            std::streamsize n = line.rdbuf()->sgetn( rec.text, sizeof(rec.text) - 1 );
+            rec.text[n] = 0;
+            if ( line.rdbuf()->in_avail() > 0 )
+                truncated.inc();
+            if ( rec.tostdout )
+                logline.str("");
+#if defined(OROSEM_FILE_LOGGING) || defined(OROSEM_REMOTE_LOGGING)
+            if ( rec.tofile )
+                fileline.str("");
+#endif
+            if ( !push( rec ) )
+                write( rec );
+        }
+
+        /**
+         * Returns the line of the calling thread if the Logger is
+         * asynchronous, and claims one on the first call of a thread.
+         * @return null if the Logger is synchronous, or if the thread
+         * must use the shared line buffer.
+         */
+        Line* threadLine()
+        {
+#ifdef ORO_LOGGING_TLS
+            if ( asyncmode == 0 )
+                return 0;
+            if ( threadgeneration == generation )
+                return static_cast<Line*>( threadline );
+            Line* line = 0;
+            for (unsigned int i = 0; i != ORONUM_LOGGING_THREAD_LINES; ++i)
+                if ( os::CAS( &lines[i].owner, 0, 1 ) ) {
+                    line = &lines[i];
+                    break;
+                }
+            if ( line == 0 )
+                linesfull = 1;
+            else {
+                // only once per thread.
+                os::MutexLock lock( inpguard );
+                line->level = inloglevel;
+                strncpy( line->rec.module, moduleptr.c_str(), sizeof(line->rec.module) - 1 );
+                line->rec.module[sizeof(line->rec.module) - 1] = 0;
+            }
+            threadline = line;
+            threadgeneration = generation;
+            return line;
+#else
+            return 0;
+#endif
+        }
+
+        /**
+         * Hands the finished line of a thread to the flusher.
+         * Takes no lock and does no I/O, unless the Logger was
+         * switched to synchronous mode in the mean time.
+         */
+        void commit(Line& line, bool flush)
+        {
+            Record& rec = line.rec;
+            line.terminate();
+            rec.stamp = TimeService::Instance()->getTicks();
+            rec.level = line.level;
+            rec.tostdout = maylogStdOut( line.level );
+            rec.tofile = maylogFile( line.level );
+            rec.flush = flush;
+            if ( line.overflowed )
+                truncated.inc();
+            if ( (rec.tostdout || rec.tofile) && !push( rec ) )
+                write( rec );
+            line.reset();
+        }
+
+        /**
+         * Pushes a record in the asynchronous buffer.
+         * @return false if the Logger is not asynchronous.
+         */
+        bool push(const Record& rec)
+        {
+            // setAsynchronous(false) waits until producers drops to zero.
+            producers.inc();
+            if ( asyncmode == 0 ) {
+                producers.dec();
+                return false;
+            }
+            if ( records->Push( rec ) == false )
+                dropped.inc();
+            producers.dec();
+            return true;
+        }
+
+        /**
+         * Formats a Record and writes it to the log streams.
+         */
+        void write(const Record& rec)
+        {
+            std::string res = showTime( rec.stamp ) + " " + showLevel( rec.level ) + "[" + rec.module + "] ";
+            os::MutexLock lock( outguard );
+            if ( rec.tostdout ) {
+#ifndef OROSEM_PRINTF_LOGGING
+                *stdoutput << res << rec.text << Logger::nl;
+                if ( rec.flush )
+                    stdoutput->flush();
+#else
+                printf("%s%s\n", res.c_str(), rec.text );
+#endif
+            }
+
+            if ( rec.tofile ) {
+#ifdef OROSEM_FILE_LOGGING
+#if     defined(OROSEM_LOG4CPP_LOGGING)
+                category.log(level2Priority(rec.level), rec.text);
+#elif   !defined(OROSEM_PRINTF_LOGGING)
+                logfile << res << rec.text << Logger::nl;
+                if ( rec.flush )
+                    logfile.flush();
+#else
+                fprintf( logfile, "%s%s\n", res.c_str(), rec.text );
+#endif
+#ifdef OROSEM_REMOTE_LOGGING
+                if ( messagecnt >= ORONUM_LOGGING_BUFSIZE ) {
+                    std::string dummy;
+                    remotestream >> dummy;
+                    --messagecnt;
+                }
+                remotestream << res << rec.text << Logger::nl;
+                ++messagecnt;
+#endif
+#endif
+            }
+        }
+
+        /**
+         * Writes all records of the asynchronous buffer and
+         * reports the lines which were dropped since the last call.
+         */
+        void drain()
+        {
+            Record rec;
+            while ( records->Pop( rec ) )
+                write( rec );
+            int n = dropped.read();
+            if ( n != reported ) {
+                Record warn;
+                warn.stamp = TimeService::Instance()->getTicks();
+                warn.level = Warning;
+                warn.tostdout = Warning <= outloglevel && outloglevel != Never && mlogStdOut;
+                warn.tofile = mlogFile;
+                warn.flush = true;
+                strcpy( warn.module, "Logger" );
+                snprintf( warn.text, sizeof(warn.text), "Dropped %d log lines because the asynchronous log buffer was full.", n - reported );
+                reported = n;
+                write( warn );
+            }
+            if ( linesfull && !linesreported ) {
+                Record warn;
+                warn.stamp = TimeService::Instance()->getTicks();
+                warn.level = Warning;
+                warn.tostdout = Warning <= outloglevel && outloglevel != Never && mlogStdOut;
+                warn.tofile = mlogFile;
+                warn.flush = true;
+                strcpy( warn.module, "Logger" );
+                snprintf( warn.text, sizeof(warn.text), "All %d thread line buffers are taken: further threads share one locked line buffer.", ORONUM_LOGGING_THREAD_LINES );
+                linesreported = true;
+                write( warn );
+            }
+        }
+
 #ifndef OROSEM_PRINTF_LOGGING
         std::ostream* stdoutput;
 #endif
@@ -267,11 +625,11 @@ namespace RTT
         }
 
 
-        std::string showTime() const
+        std::string showTime(TimeService::ticks stamp) const
         {
             std::stringstream time;
             if ( showtime )
-                time <<fixed<< showpoint << setprecision(3) << TimeService::Instance()->secondsSince(timestamp);
+                time <<fixed<< showpoint << setprecision(3) << Seconds(TimeService::ticks2nsecs(stamp - timestamp))/NSECS_IN_SECS;
             return time.str();
         }
 
@@ -327,7 +685,53 @@ namespace RTT
 
         std::string moduleptr;
 
+        /**
+         * Guards the input lines and the fields below.
+         */
         os::Mutex inpguard;
+        /**
+         * Guards the output streams. Must be locked after inpguard.
+         */
+        os::Mutex outguard;
+
+        /**
+         * The buffer of an asynchronous Logger, or null.
+         */
+        RecordBuffer* records;
+        Flusher* flusher;
+        os::AtomicInt dropped, truncated;
+        /**
+         * The number of dropped lines already reported by drain().
+         */
+        int reported;
+        /**
+         * The line buffers of the threads. Allocated when the
+         * Logger first becomes asynchronous, and kept until
+         * it is destroyed, since threads keep a pointer to them.
+         * A line is not released when its thread exits.
+         */
+        Line* lines;
+        /**
+         * Set to 1 when a thread found no free line.
+         */
+        volatile int linesfull;
+        /**
+         * True once drain() reported that the lines ran out.
+         */
+        bool linesreported;
+        /**
+         * 1 if the Logger is asynchronous.
+         */
+        volatile int asyncmode;
+        /**
+         * The number of threads which are pushing a record.
+         */
+        os::AtomicInt producers;
+        /**
+         * Serializes setAsynchronous().
+         */
+        os::Mutex asyncguard;
+        unsigned int generation;
     };
 
     Logger::Logger(std::ostream& str)
@@ -339,6 +743,7 @@ namespace RTT
 
     Logger::~Logger()
     {
+        this->setAsynchronous(false);
         delete d;
     }
 
@@ -371,6 +776,61 @@ namespace RTT
         d->allowRT = false;
     }
 
+    bool Logger::setAsynchronous(bool async, unsigned int lines) {
+        os::MutexLock alock( d->asyncguard );
+        if ( async == (d->asyncmode != 0) )
+            return true;
+        if ( async ) {
+            // asyncmode is 0, so no thread uses records: it may be replaced.
+            if ( d->records == 0 || d->records->capacity() != base::BufferBase::size_type(lines) ) {
+                delete d->records;
+#ifdef OROBLD_OS_NO_ASM
+                d->records = new base::BufferLocked<D::Record>( lines );
+#else
+                d->records = new base::BufferLockFree<D::Record>( lines );
+#endif
+            }
+            if ( d->lines == 0 )
+                d->lines = new D::Line[ORONUM_LOGGING_THREAD_LINES];
+            // creating the thread logs a line, so don't hold inpguard.
+            D::Flusher* f = new D::Flusher( d );
+            if ( f->start() == false ) {
+                delete f;
+                return false;
+            }
+            d->flusher = f;
+            // the CAS publishes records and lines before asyncmode.
+            os::CAS( &d->asyncmode, 0, 1 );
+            return true;
+        }
+        os::CAS( &d->asyncmode, 1, 0 );
+        // wait for the threads which saw asyncmode == 1.
+        while ( d->producers.read() != 0 ) {
+            TIME_SPEC ts;
+            ts.tv_sec = 0;
+            ts.tv_nsec = 100000;
+            rtos_nanosleep( &ts, 0 );
+        }
+        d->flusher->stop();
+        delete d->flusher;
+        d->flusher = 0;
+        // write the last records before new lines are written synchronously.
+        d->drain();
+        return true;
+    }
+
+    bool Logger::isAsynchronous() const {
+        return d->asyncmode != 0;
+    }
+
+    unsigned int Logger::getDroppedLines() const {
+        return d->dropped.read();
+    }
+
+    unsigned int Logger::getTruncatedLines() const {
+        return d->truncated.read();
+    }
+
     TimeService::ticks Logger::getReferenceTime()const
     {
         return d->timestamp;
@@ -420,6 +880,11 @@ namespace RTT
 
     Logger& Logger::in(const std::string& modname)
     {
+        D::Line* line = d->threadLine();
+        if ( line ) {
+            strncpy( line->rec.module, modname.c_str(), sizeof(line->rec.module) - 1 );
+            return *this;
+        }
         os::MutexLock lock( d->inpguard );
         d->moduleptr = modname.c_str();
         return *this;
@@ -427,17 +892,29 @@ namespace RTT
 
     Logger& Logger::out(const std::string& oldmod)
     {
-        os::MutexLock lock( d->inpguard );
-        d->moduleptr = oldmod.c_str();
-        return *this;
+        return this->in( oldmod );
     }
 
     std::string Logger::getLogModule() const {
+        D::Line* line = d->threadLine();
+        if ( line )
+            return line->rec.module;
         os::MutexLock lock( d->inpguard );
         std::string ret = d->moduleptr.c_str();
         return ret;
     }
 
+    bool Logger::threadStream(std::ostream*& stream) {
+        D::Line* line = d->threadLine();
+        if ( !line )
+            return false;
+        if ( d->maylogStdOut( line->level ) || d->maylogFile( line->level ) )
+            stream = &line->stream;
+        else
+            stream = 0;
+        return true;
+    }
+
 
 #define ORO_xstr(s) ORO_str(s)
 #define ORO_str(s) #s
@@ -496,6 +973,7 @@ namespace RTT
         if (!d->started)
             return;
         *this<<Logger::Info<<"Orocos Logging Deactivated." << Logger::endl;
+        this->setAsynchronous(false);
         this->logflush();
         d->started = false;
     }
@@ -506,7 +984,7 @@ namespace RTT
             return "";
         std::string line;
         {
-            os::MutexLock lock( d->inpguard );
+            os::MutexLock lock( d->outguard );
             getline( d->remotestream, line );
             if ( !d->remotestream )
                 d->remotestream.clear();
@@ -529,6 +1007,12 @@ namespace RTT
         if ( !d->maylog() )
             return *this;
 
+        std::ostream* stream = 0;
+        if ( threadStream( stream ) ) {
+            if ( stream )
+                *stream << t;
+            return *this;
+        }
         os::MutexLock lock( d->inpguard );
         if ( d->maylogStdOut() )
             d->logline << t;
@@ -548,7 +1032,11 @@ namespace RTT
     Logger& Logger::operator<<(LogLevel ll) {
         if ( !d->maylog() )
             return *this;
-        d->inloglevel = ll;
+        D::Line* line = d->threadLine();
+        if ( line )
+            line->level = ll;
+        else
+            d->inloglevel = ll;
         return *this;
     }
 
@@ -563,6 +1051,12 @@ namespace RTT
         else if ( pf == Logger::flush )
             this->logflush();
         else {
+            std::ostream* stream = 0;
+            if ( threadStream( stream ) ) {
+                if ( stream )
+                    *stream << pf;
+                return *this;
+            }
             os::MutexLock lock( d->inpguard );
             if ( d->maylogStdOut() )
                 d->logline << pf; // normal std operator in stream.
@@ -575,11 +1069,12 @@ namespace RTT
     }
 
     void Logger::logflush() {
-        if (!d->maylog())
+        // the flusher flushes the streams after each line ended with endl.
+        if (!d->maylog() || d->asyncmode)
             return;
         {
             // just flush all buffers, do not produce a new logline
-            os::MutexLock lock( d->inpguard );
+            os::MutexLock lock( d->outguard );
             if ( d->maylogStdOut() ) {
 #ifndef OROSEM_PRINTF_LOGGING
                 d->stdoutput->flush();
@@ -55,6 +55,14 @@
 #include "os/Mutex.hpp"
 #include "os/MutexLock.hpp"
 
+/**
+ * The default number of log lines which can wait in the buffer
+ * of an asynchronous Logger.
+ */
+#ifndef ORONUM_LOGGING_ASYNC_SIZE
+#define ORONUM_LOGGING_ASYNC_SIZE 512
+#endif
+
 namespace RTT
 {
     /**
@@ -90,6 +98,13 @@ namespace RTT
      * is 6 or lower, these messages will not appear and do no harm to real-time performance.
      * You need to call @verbatim Logger::log().allowRealTime(); @endverbatim once in your program
      * to confirm this choice. AGAIN: THIS WILL BREAK REAL-TIME PERFORMANCE.
+     *
+     * Threads which log frequently may switch the Logger to asynchronous mode
+     * with setAsynchronous(). Each thread then formats its log lines in its own
+     * preallocated line buffer, without taking a lock. A finished log line is
+     * stored in a lock-free buffer and a low priority thread adds the time stamp,
+     * level and module and writes it to the log streams. In this mode, the
+     * LogLevel and the module set by Logger::In are kept per thread.
      * @ingroup CoreLib
      */
     class RTT_API Logger
@@ -130,6 +145,44 @@ namespace RTT
          */
         void disallowRealTime();
 
+        /**
+         * Switch the Logger to or from asynchronous mode. In asynchronous
+         * mode, a thread formats its log lines into its own line buffer, and
+         * logendl() and lognl() copy the line into a lock-free buffer.
+         * They never take a lock or wait for I/O. A low priority flusher thread
+         * formats and writes the buffered lines. Lines which do not fit in the buffer
+         * are dropped and counted. When more than ORONUM_LOGGING_THREAD_LINES
+         * threads log, or the compiler offers no thread local storage,
+         * the remaining threads share a line buffer guarded by a mutex.
+         * A thread keeps its line buffer until the Logger is destroyed, also
+         * after it exited, and the flusher logs a warning once when they run out.
+         * Switching back to synchronous mode writes out all buffered lines.
+         * This function may be called from any thread, but not from
+         * a real-time thread.
+         * @param async true to log asynchronously.
+         * @param lines The number of log lines the buffer can hold.
+         * @return false if the flusher thread could not be started.
+         */
+        bool setAsynchronous(bool async, unsigned int lines = ORONUM_LOGGING_ASYNC_SIZE);
+
+        /**
+         * Returns true if the Logger is in asynchronous mode.
+         * @see setAsynchronous()
+         */
+        bool isAsynchronous() const;
+
+        /**
+         * Returns the number of log lines that were dropped because
+         * the asynchronous buffer was full.
+         */
+        unsigned int getDroppedLines() const;
+
+        /**
+         * Returns the number of log lines that were cut off because
+         * they did not fit in a record of the asynchronous buffer.
+         */
+        unsigned int getTruncatedLines() const;
+
         /**
          * Toggles the flag if the logger may log to the
          * standard output stream.
@@ -329,6 +382,14 @@ namespace RTT
         bool mayLogStdOut() const;
         bool mayLogFile() const;
 
+        /**
+         * Returns true if the calling thread formats into its own line
+         * buffer, because the Logger is asynchronous.
+         * @param stream Is set to the stream of that line buffer, or to
+         * null if the current LogLevel of the thread is not logged.
+         */
+        bool threadStream(std::ostream*& stream);
+
         Logger(std::ostream& str=std::cerr);
         ~Logger();
 
@@ -17,6 +17,12 @@ namespace RTT
         if ( !mayLog() )
             return *this;
 
+        std::ostream* stream = 0;
+        if ( threadStream( stream ) ) {
+            if ( stream )
+                *stream << t;
+            return *this;
+        }
         os::MutexLock lock( inpguard );
         if ( this->mayLogStdOut() )
             logline << t;
@@ -57,6 +63,22 @@ namespace RTT
     inline void Logger::disallowRealTime() {
     }
 
+    inline bool Logger::setAsynchronous(bool, unsigned int) {
+        return false;
+    }
+
+    inline bool Logger::isAsynchronous() const {
+        return false;
+    }
+
+    inline unsigned int Logger::getDroppedLines() const {
+        return 0;
+    }
+
+    inline unsigned int Logger::getTruncatedLines() const {
+        return 0;
+    }
+
     inline std::ostream&
     Logger::nl(std::ostream& __os)
     {
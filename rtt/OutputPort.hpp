@@ -49,6 +49,8 @@
 
 #include "InputPort.hpp"
 
+#include <vector>
+
 namespace RTT
 {
     /**
@@ -84,6 +86,32 @@ namespace RTT
             }
         }
 
+        bool do_write_shared(typename base::ChannelElement<T>::shared_sample_t const& sample, const internal::ConnectionManager::ChannelDescriptor& descriptor)
+        {
+            typename base::ChannelElement<T>::shared_ptr output
+                = boost::static_pointer_cast< base::ChannelElement<T> >(descriptor.get<1>());
+            if (output->writeShared(sample))
+                return false;
+            else
+            {
+                log(Error) << "A channel of port " << getName() << " has been invalidated during commit(), it will be removed" << endlog();
+                return true;
+            }
+        }
+
+        bool do_write_batch(std::vector<T> const& samples, const internal::ConnectionManager::ChannelDescriptor& descriptor)
+        {
+            typename base::ChannelElement<T>::shared_ptr output
+                = boost::static_pointer_cast< base::ChannelElement<T> >(descriptor.get<1>());
+            if (output->writeBatch(samples))
+                return false;
+            else
+            {
+                log(Error) << "A channel of port " << getName() << " has been invalidated during write(), it will be removed" << endlog();
+                return true;
+            }
+        }
+
         bool do_init(typename base::ChannelElement<T>::param_t sample, const internal::ConnectionManager::ChannelDescriptor& descriptor)
         {
             typename base::ChannelElement<T>::shared_ptr output
@@ -136,6 +164,14 @@ namespace RTT
         bool keeps_last_written_value;
         typename base::DataObjectInterface<T>::shared_ptr sample;
 
+        /// The samples handed out by loan(). A sample can be loaned again
+        // as soon as no connection or reader refers to it anymore.
+        std::vector< typename base::ChannelElement<T>::shared_sample_t > loan_pool;
+        /// The sample returned by loan() and not yet committed, or null.
+        T* loaned_sample;
+        /// The index in \c loan_pool of \c loaned_sample.
+        std::size_t loaned_index;
+
         /**
          * You are not allowed to copy ports.
          * In case you want to create a container of ports,
@@ -169,11 +205,18 @@ namespace RTT
             , keeps_next_written_value(false)
             , keeps_last_written_value(false)
             , sample( new base::DataObject<T>() )
+            , loaned_sample(0)
+            , loaned_index(0)
         {
             if (keep_last_written_value)
                 keepLastWrittenValue(true);
         }
 
+        ~OutputPort()
+        {
+            delete loaned_sample;
+        }
+
         void keepNextWrittenValue(bool keep)
         {
             keeps_next_written_value = keep;
@@ -257,6 +300,85 @@ namespace RTT
                     );
         }
 
+        /**
+         * Writes a batch of new samples to all receivers (if any), in order.
+         * Buffered connections store the whole batch at once and signal
+         * the reader only once. Data connections only store the last sample.
+         * @param samples The new samples to send out.
+         */
+        void write(const std::vector<T>& samples)
+        {
+            if ( samples.empty() )
+                return;
+            if (keeps_last_written_value || keeps_next_written_value)
+            {
+                keeps_next_written_value = false;
+                has_initial_sample = true;
+                this->sample->Set(samples.back());
+            }
+            has_last_written_value = keeps_last_written_value;
+
+            cmanager.delete_if( boost::bind(
+                        &OutputPort<T>::do_write_batch, this, boost::cref(samples), boost::lambda::_1)
+                    );
+        }
+
+        /**
+         * Returns a sample which can be filled in and then sent to
+         * all receivers with commit(), without copying it. The sample
+         * is re-used from an earlier commit() when no receiver refers to
+         * it anymore, so it contains old data which must be overwritten.
+         * New samples are allocated as a copy of the data sample of this port
+         * (see setDataSample()), until enough samples are available.
+         *
+         * Only connections with the ConnPolicy::shared flag set store the
+         * committed sample without copying it, other connections receive
+         * a copy.
+         * @return the loaned sample, which remains valid until commit().
+         */
+        T& loan()
+        {
+            if (loaned_sample)
+                return *loaned_sample;
+            for (loaned_index = 0; loaned_index != loan_pool.size(); ++loaned_index) {
+                loaned_sample = loan_pool[loaned_index].try_write_access();
+                if (loaned_sample)
+                    return *loaned_sample;
+            }
+            // All samples are still in use: grow the pool.
+            loan_pool.push_back( typename base::ChannelElement<T>::shared_sample_t() );
+            loaned_sample = new T( sample->Get() );
+            return *loaned_sample;
+        }
+
+        /**
+         * Sends the sample returned by loan() to all receivers (if any).
+         * The sample may no longer be modified after this call.
+         * Unlike write(), the sample is not kept as the last written value,
+         * except for the first commit() or if keepNextWrittenValue() was set.
+         */
+        void commit()
+        {
+            if (!loaned_sample) {
+                log(Error) << "commit() called on port " << getName() << " without loan()" << endlog();
+                return;
+            }
+            typename base::ChannelElement<T>::shared_sample_t const& shared = loan_pool[loaned_index];
+            loan_pool[loaned_index].reset(loaned_sample);
+            loaned_sample = 0;
+            if (keeps_next_written_value || !has_initial_sample)
+            {
+                keeps_next_written_value = false;
+                has_initial_sample = true;
+                this->sample->Set(*shared);
+            }
+            has_last_written_value = false;
+
+            cmanager.delete_if( boost::bind(
+                        &OutputPort<T>::do_write_shared, this, boost::cref(shared), boost::lambda::_1)
+                    );
+        }
+
         void write(base::DataSourceBase::shared_ptr source)
         {
             typename internal::AssignableDataSource<T>::shared_ptr ds =
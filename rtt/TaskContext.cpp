@@ -50,6 +50,8 @@
 #include "internal/DataSource.hpp"
 #include "internal/mystd.hpp"
 #include "internal/MWSRQueue.hpp"
+#include "internal/FusedFunctorDataSource.hpp"
+#include "internal/ExecutionTrace.hpp"
 #include "OperationCaller.hpp"
 
 #include "rtt-config.h"
@@ -69,7 +71,7 @@ namespace RTT
 
     TaskContext::TaskContext(const std::string& name, TaskState initial_state /*= Stopped*/)
         :  TaskCore( initial_state)
-           ,portqueue( new MWSRQueue<PortInterface*>(64) )
+           ,portqueue( new SegmentedMWSRQueue<PortInterface*>(64, 64) )
            ,tcservice(new Service(name,this) ), tcrequests( new ServiceRequester(name,this) )
 #if defined(ORO_ACT_DEFAULT_SEQUENTIAL)
            ,our_act( new SequentialActivity( this->engine() ) )
@@ -82,7 +84,7 @@ namespace RTT
 
     TaskContext::TaskContext(const std::string& name, ExecutionEngine* parent, TaskState initial_state /*= Stopped*/ )
         :  TaskCore(parent, initial_state)
-           ,portqueue( new MWSRQueue<PortInterface*>(64) )
+           ,portqueue( new SegmentedMWSRQueue<PortInterface*>(64, 64) )
            ,tcservice(new Service(name,this) ), tcrequests( new ServiceRequester(name,this) )
 #if defined(ORO_ACT_DEFAULT_SEQUENTIAL)
            ,our_act( parent ? 0 : new SequentialActivity( this->engine() ) )
@@ -93,6 +95,23 @@ namespace RTT
         this->setup();
     }
 
+    namespace {
+        unsigned int messageQueueHighWaterMark(TaskContext* tc) { return tc->engine()->getMessageQueueHighWaterMark(); }
+        unsigned int messageQueueRejected(TaskContext* tc) { return tc->engine()->getMessageQueueRejected(); }
+        unsigned int functionQueueHighWaterMark(TaskContext* tc) { return tc->engine()->getFunctionQueueHighWaterMark(); }
+        unsigned int functionQueueRejected(TaskContext* tc) { return tc->engine()->getFunctionQueueRejected(); }
+
+        /**
+         * Adds a read-only attribute which reads its value from \a f.
+         * This allows the statistics of our engine to be inspected even if
+         * the engine was replaced after construction.
+         */
+        void addStatistic(Service* service, const std::string& name, boost::function<unsigned int(void)> f) {
+            Alias a(name, new internal::FusedFunctorDataSource<unsigned int(void)>( f ) );
+            service->addAttribute( a );
+        }
+    }
+
     void TaskContext::setup()
     {
         tcservice->setOwner(this);
@@ -227,13 +246,45 @@ namespace RTT
     }
 
     bool TaskContext::prepareProvide(const std::string& name) {
-         return tcservice->hasService(name) || plugin::PluginLoader::Instance()->loadService(name, this);
+         return tcservice->hasService(name) || loadBuiltinService(name) || plugin::PluginLoader::Instance()->loadService(name, this);
     }
 
     bool TaskContext::loadService(const std::string& service_name) {
         if ( provides()->hasService(service_name))
             return true;
-        return PluginLoader::Instance()->loadService(service_name, this);
+        return loadBuiltinService(service_name) || PluginLoader::Instance()->loadService(service_name, this);
+    }
+
+    bool TaskContext::loadBuiltinService(const std::string& service_name) {
+        if ( service_name == "statistics" ) {
+            Service::shared_ptr ss = provides("statistics");
+            ss->doc("The fill statistics of the queues of the ExecutionEngine of this TaskContext.");
+            addStatistic(ss.get(), "MessageQueueHighWaterMark", boost::bind(&messageQueueHighWaterMark, this));
+            addStatistic(ss.get(), "MessageQueueRejected", boost::bind(&messageQueueRejected, this));
+            addStatistic(ss.get(), "FunctionQueueHighWaterMark", boost::bind(&functionQueueHighWaterMark, this));
+            addStatistic(ss.get(), "FunctionQueueRejected", boost::bind(&functionQueueRejected, this));
+            addStatistic(ss.get(), "PortQueueHighWaterMark", boost::bind(&internal::SegmentedMWSRQueue<PortInterface*>::highWaterMark, portqueue));
+            addStatistic(ss.get(), "PortQueueRejected", boost::bind(&internal::SegmentedMWSRQueue<PortInterface*>::rejected, portqueue));
+            return true;
+        }
+        if ( service_name == "trace" ) {
+            internal::ExecutionTrace* tr = this->trace();
+            Service::shared_ptr ts = provides("trace");
+            ts->doc("Timing of the execution of this TaskContext by its ExecutionEngine. The phases are messages, functions, prepareUpdateHook, updateHook, errorHook and cycle.");
+            ts->addOperation("enable", &internal::ExecutionTrace::enable, tr, ClientThread).doc("Enable or disable tracing.").arg("on", "True to enable tracing.");
+            ts->addOperation("isEnabled", &internal::ExecutionTrace::isEnabled, tr, ClientThread).doc("Is tracing enabled ?");
+            ts->addOperation("reset", &internal::ExecutionTrace::reset, tr, ClientThread).doc("Clear all traced timings.");
+            ts->addOperation("count", &internal::ExecutionTrace::getCount, tr, ClientThread).doc("The number of times a phase was traced.").arg("phase", "The name of the phase.");
+            ts->addOperation("min", &internal::ExecutionTrace::getMin, tr, ClientThread).doc("The shortest duration of a phase, in seconds.").arg("phase", "The name of the phase.");
+            ts->addOperation("mean", &internal::ExecutionTrace::getMean, tr, ClientThread).doc("The mean duration of a phase, in seconds.").arg("phase", "The name of the phase.");
+            ts->addOperation("max", &internal::ExecutionTrace::getMax, tr, ClientThread).doc("The longest duration of a phase, in seconds.").arg("phase", "The name of the phase.");
+            ts->addOperation("percentile", &internal::ExecutionTrace::getPercentile, tr, ClientThread).doc("The duration of a phase which is not exceeded in p percent of the cycles, in seconds.").arg("phase", "The name of the phase.").arg("p", "A percentage between 0 and 100.");
+            ts->addOperation("cycles", &internal::ExecutionTrace::cycles, tr, ClientThread).doc("The number of traced cycles.");
+            ts->addOperation("overruns", &internal::ExecutionTrace::overruns, tr, ClientThread).doc("The number of traced cycles which took longer than the period.");
+            ts->addOperation("write", &internal::ExecutionTrace::write, tr, ClientThread).doc("Write the last traced phases to a binary trace file.").arg("filename", "The name of the file.");
+            return true;
+        }
+        return false;
     }
 
     void TaskContext::addUser( TaskContext* peer )
@@ -431,6 +482,16 @@ namespace RTT
         }
     }
 
+    void TaskContext::setPortQueueCapacity(unsigned int capacity)
+    {
+        portqueue->setCapacity( capacity );
+    }
+
+    unsigned int TaskContext::getPortQueueCapacity() const
+    {
+        return portqueue->capacity();
+    }
+
     bool TaskContext::dataOnPortHook( base::PortInterface* ) {
         return this->isRunning();
     }
@@ -320,6 +320,12 @@ namespace RTT
 
         /**
          * Use this method to load a service known to RTT into this component.
+         * Besides the services of the PluginLoader, a TaskContext can load
+         * these built-in services:
+         * - "statistics": the high-water marks and rejected counts of the
+         *   message, function and port queues of its ExecutionEngine.
+         * - "trace": the operations of the internal::ExecutionTrace of this
+         *   component, which is created when this service is loaded.
          * @param service_name The name with which the service is registered by in the PluginLoader.
          * @return true if the service was present already or could be loaded.
          */
@@ -589,6 +595,20 @@ namespace RTT
          * Add a data flow connection from this task's ports to a peer's ports.
          */
         virtual bool connectPorts( TaskContext* peer );
+        /**
+         * Set the maximum number of event port notifications that
+         * can be queued in between two executions of updateHook().
+         * Notifications which do not fit are dropped and counted in the
+         * 'PortQueueRejected' attribute. This may be called at any time.
+         * @param capacity The maximum number of queued notifications.
+         */
+        void setPortQueueCapacity(unsigned int capacity);
+
+        /**
+         * Returns the maximum number of event port notifications
+         * that can be queued.
+         */
+        unsigned int getPortQueueCapacity() const;
         /** @} */
 
     protected:
@@ -643,7 +663,7 @@ namespace RTT
         void setup();
 
         friend class DataFlowInterface;
-        internal::MWSRQueue<base::PortInterface*>* portqueue;
+        internal::SegmentedMWSRQueue<base::PortInterface*>* portqueue;
         typedef std::map<base::PortInterface*, SlotFunction > UserCallbacks;
         UserCallbacks user_callbacks;
 
@@ -682,6 +702,13 @@ namespace RTT
          */
         bool prepareProvide(const std::string& name);
 
+        /**
+         * Adds the built-in service \a service_name, which is only
+         * created when it is asked for.
+         * @return false if \a service_name is not a built-in service.
+         */
+        bool loadBuiltinService(const std::string& service_name);
+
         typedef std::map<std::string, boost::shared_ptr<ServiceRequester> > LocalServices;
         LocalServices localservs;
 
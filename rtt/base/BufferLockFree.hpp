@@ -44,6 +44,7 @@
 #include "../internal/AtomicMWSRQueue.hpp"
 #include "../internal/TsPool.hpp"
 #include <vector>
+#include <algorithm>
 
 #ifdef ORO_PRAGMA_INTERFACE
 #pragma interface
@@ -75,6 +76,11 @@ namespace RTT
         typedef T value_t;
     private:
         typedef T Item;
+        /**
+         * The number of items that is allocated and queued at once
+         * by the batch Push() and Pop() functions.
+         */
+        enum { BatchSize = 64 };
         internal::AtomicMWSRQueue<Item*> bufs;
         // is mutable because of reference counting.
         mutable internal::TsPool<Item> mpool;
@@ -180,14 +186,32 @@ namespace RTT
 
         size_type Push(const std::vector<T>& items)
         {
-            // @todo Make this function more efficient as in BufferLocked.
-            int towrite  = items.size();
-            typename std::vector<T>::const_iterator it;
-            for(  it = items.begin(); it != items.end(); ++it)
-                if ( this->Push( *it ) == false ) {
-                    break; // will only happen in non-circular case !
-                }
-            return towrite - (items.end() - it);
+            if (mcircular) {
+                int towrite  = items.size();
+                typename std::vector<T>::const_iterator it;
+                for(  it = items.begin(); it != items.end(); ++it)
+                    if ( this->Push( *it ) == false ) {
+                        break;
+                    }
+                return towrite - (items.end() - it);
+            }
+            // allocate, fill and queue the items per batch, each step
+            // taking one atomic operation.
+            Item* ipush[BatchSize];
+            size_type written = 0;
+            while ( written != (size_type)items.size() ) {
+                size_type n = std::min<size_type>( BatchSize, items.size() - written );
+                size_type got = mpool.allocate( ipush, n );
+                for (size_type i = 0; i != got; ++i)
+                    *ipush[i] = items[written + i];
+                size_type queued = bufs.enqueue( ipush, got );
+                // got memory, but buffer is full: give it back.
+                mpool.deallocate( ipush + queued, got - queued );
+                written += queued;
+                if ( queued != n )
+                    break;
+            }
+            return written;
         }
 
 
@@ -204,12 +228,13 @@ namespace RTT
 
         size_type Pop(std::vector<T>& items )
         {
-            Item* ipop;
+            Item* ipop[BatchSize];
+            size_type n;
             items.clear();
-            while( bufs.dequeue(ipop) ) {
-                items.push_back( *ipop );
-                if (mpool.deallocate(ipop) == false)
-                    assert(false);
+            while( (n = bufs.dequeue(ipop, BatchSize)) != 0 ) {
+                for (size_type i = 0; i != n; ++i)
+                    items.push_back( *ipop[i] );
+                mpool.deallocate(ipop, n);
             }
             return items.size();
         }
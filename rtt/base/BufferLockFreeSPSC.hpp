@@ -0,0 +1,230 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_BUFFER_LOCK_FREE_SPSC_HPP
+#define ORO_BUFFER_LOCK_FREE_SPSC_HPP
+
+#include "BufferInterface.hpp"
+#include "../internal/AtomicSPSCQueue.hpp"
+#include <vector>
+#include <algorithm>
+
+namespace RTT
+{ namespace base {
+
+    /**
+     * A wait-free buffer implementation to read and write
+     * data of type \a T in a FIFO way, for exactly one writer thread and
+     * one reader thread.
+     * No memory allocation is done during read or write and no
+     * compare-and-swap is used: written items travel from the writer
+     * to the reader in one internal::AtomicSPSCQueue and are handed back to the
+     * writer in a second one, once the reader released them.
+     *
+     * Push() may only be called from the writer thread. Pop(),
+     * PopWithoutRelease(), Release() and clear() may only be called
+     * from the reader thread. Use BufferLockFree if more than one thread
+     * writes or reads, or if a circular buffer is required, since dropping
+     * the oldest sample from the writer side requires a read.
+     * @param T The value type to be stored in the Buffer.
+     * Example : BufferLockFreeSPSC<A> is a buffer which holds values of type A.
+     * @ingroup PortBuffers
+     */
+    template< class T>
+    class BufferLockFreeSPSC
+        : public BufferInterface<T>
+    {
+    public:
+        typedef typename BufferInterface<T>::reference_t reference_t;
+        typedef typename BufferInterface<T>::param_t param_t;
+        typedef typename BufferInterface<T>::size_type size_type;
+        typedef T value_t;
+    private:
+        typedef T Item;
+        /**
+         * The number of items that is moved at once
+         * by the batch Push() and Pop() functions.
+         */
+        enum { BatchSize = 64 };
+        /**
+         * The items that were written and not yet read.
+         */
+        internal::AtomicSPSCQueue<Item*> bufs;
+        /**
+         * The items that may be (re-)written by the writer.
+         */
+        internal::AtomicSPSCQueue<Item*> mpool;
+        /**
+         * Storage for all items: the buffer capacity, one item
+         * held by the writer and two items held by the reader in
+         * between PopWithoutRelease() and Release().
+         */
+        const unsigned int mcount;
+        Item* mitems;
+        /**
+         * An item taken from mpool by the writer that could not
+         * be queued because the buffer was full.
+         */
+        Item* mspare;
+        T lastSample;
+    public:
+        /**
+         * Create a wait-free buffer wich can store \a bufsize elements.
+         * @param bufsize the capacity of the buffer.
+         */
+        BufferLockFreeSPSC( unsigned int bufsize, const T& initial_value = T())
+            : bufs( bufsize ), mpool( bufsize + 3 ), mcount( bufsize + 3 ), mitems( new Item[bufsize + 3] ), mspare(0)
+        {
+            data_sample( initial_value );
+            for (unsigned int i = 0; i != mcount; ++i)
+                mpool.enqueue( &mitems[i] );
+        }
+
+        ~BufferLockFreeSPSC() {
+            delete[] mitems;
+        }
+
+        virtual void data_sample( const T& sample )
+        {
+            for (unsigned int i = 0; i != mcount; ++i)
+                mitems[i] = sample;
+            lastSample = sample;
+        }
+
+        virtual T data_sample() const
+        {
+            return lastSample;
+        }
+
+        size_type capacity() const
+        {
+            return bufs.capacity();
+        }
+
+        size_type size() const
+        {
+            return bufs.size();
+        }
+
+        bool empty() const
+        {
+            return bufs.isEmpty();
+        }
+
+        bool full() const
+        {
+            return bufs.isFull();
+        }
+
+        void clear()
+        {
+            Item* item;
+            while ( bufs.dequeue(item) )
+                mpool.enqueue( item );
+        }
+
+        bool Push( param_t item)
+        {
+            Item* mitem = mspare;
+            if ( mitem == 0 && mpool.dequeue( mitem ) == false )
+                return false; // the reader holds on to too many items.
+            mspare = 0;
+            *mitem = item;
+            if ( bufs.enqueue( mitem ) == false ) {
+                mspare = mitem;
+                return false;
+            }
+            return true;
+        }
+
+        size_type Push(const std::vector<T>& items)
+        {
+            Item* ipush[BatchSize];
+            size_type written = 0;
+            while ( written != (size_type)items.size() ) {
+                // only take as many items as there is room for, since we
+                // can not hand them back to the pool.
+                size_type n = std::min<size_type>( BatchSize, items.size() - written );
+                n = std::min<size_type>( n, bufs.capacity() - bufs.size() );
+                size_type got = 0;
+                if ( n != 0 && mspare ) {
+                    ipush[got++] = mspare;
+                    mspare = 0;
+                }
+                got += mpool.dequeue( ipush + got, n - got );
+                for (size_type i = 0; i != got; ++i)
+                    *ipush[i] = items[written + i];
+                bufs.enqueue( ipush, got );
+                written += got;
+                if ( got != n || n == 0 )
+                    break;
+            }
+            return written;
+        }
+
+        bool Pop( reference_t item )
+        {
+            Item* ipop;
+            if (bufs.dequeue( ipop ) == false )
+                return false;
+            item = *ipop;
+            mpool.enqueue( ipop );
+            return true;
+        }
+
+        size_type Pop(std::vector<T>& items )
+        {
+            Item* ipop[BatchSize];
+            size_type n;
+            items.clear();
+            while( (n = bufs.dequeue(ipop, BatchSize)) != 0 ) {
+                for (size_type i = 0; i != n; ++i)
+                    items.push_back( *ipop[i] );
+                mpool.enqueue( ipop, n );
+            }
+            return items.size();
+        }
+
+        value_t* PopWithoutRelease()
+        {
+            Item* ipop;
+            if (bufs.dequeue( ipop ) == false )
+                return 0;
+            return ipop;
+        }
+
+        void Release(value_t *item)
+        {
+            mpool.enqueue( item );
+        }
+    };
+}}
+
+#endif
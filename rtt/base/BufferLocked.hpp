@@ -46,6 +46,7 @@
 #include "../os/MutexLock.hpp"
 #include "BufferInterface.hpp"
 #include <deque>
+#include <algorithm>
 
 namespace RTT
 { namespace base {
@@ -125,10 +126,10 @@ namespace RTT
                     buf.pop_front();
                 // itl still points at first element of items.
             }
-            while ( ((size_type)buf.size() != cap) && (itl != items.end()) ) {
-                buf.push_back( *itl );
-                ++itl;
-            }
+            // append as many elements as fit in one go.
+            size_type n = std::min<size_type>( cap - buf.size(), items.end() - itl );
+            buf.insert( buf.end(), itl, itl + n );
+            itl += n;
             // this is in any case the number of elements taken from items.
             if (mcircular)
                 assert( (size_type)(itl - items.begin() ) == (size_type)items.size() );
@@ -149,14 +150,9 @@ namespace RTT
         size_type Pop(std::vector<T>& items )
         {
             os::MutexLock locker(lock);
-            int quant = 0;
-            items.clear();
-            while ( !buf.empty() ) {
-                items.push_back( buf.front() );
-                buf.pop_front();
-                ++quant;
-            }
-            return quant;
+            items.assign( buf.begin(), buf.end() );
+            buf.clear();
+            return items.size();
         }
 
 	value_t* PopWithoutRelease()
@@ -42,6 +42,7 @@
 
 #include "BufferInterface.hpp"
 #include <deque>
+#include <algorithm>
 
 namespace RTT
 { namespace base {
@@ -115,10 +116,10 @@ namespace RTT
                     buf.pop_front();
                 // itl still points at first element of items.
             }
-            while ( ((size_type)buf.size() != cap) && (itl != items.end()) ) {
-                buf.push_back( *itl );
-                ++itl;
-            }
+            // append as many elements as fit in one go.
+            size_type n = std::min<size_type>( cap - buf.size(), items.end() - itl );
+            buf.insert( buf.end(), itl, itl + n );
+            itl += n;
             return (itl - items.begin());
         }
 
@@ -134,14 +135,9 @@ namespace RTT
 
         size_type Pop(std::vector<T>& items )
         {
-            int quant = 0;
-            items.clear();
-            while ( !buf.empty() ) {
-                items.push_back( buf.front() );
-                buf.pop_front();
-                ++quant;
-            }
-            return quant;
+            items.assign( buf.begin(), buf.end() );
+            buf.clear();
+            return items.size();
         }
 
 	value_t* PopWithoutRelease()
@@ -51,6 +51,8 @@
 #include "Buffer.hpp"
 #include "BufferLocked.hpp"
 #include "BufferLockFree.hpp"
+#include "BufferLockFreeSPSC.hpp"
 #include "DataObject.hpp"
 #include "DataObjectLockFree.hpp"
+#include "DataObjectLockFreeSPSC.hpp"
 #include "DataObjectLocked.hpp"
@@ -41,8 +41,10 @@
 
 #include <boost/intrusive_ptr.hpp>
 #include <boost/call_traits.hpp>
+#include <vector>
 #include "ChannelElementBase.hpp"
 #include "../FlowStatus.hpp"
+#include "../extras/ReadOnlyPointer.hpp"
 
 namespace RTT { namespace base {
 
@@ -58,6 +60,7 @@ namespace RTT { namespace base {
         typedef boost::intrusive_ptr< ChannelElement<T> > shared_ptr;
         typedef typename boost::call_traits<T>::param_type param_t;
         typedef typename boost::call_traits<T>::reference reference_t;
+        typedef extras::ReadOnlyPointer<T> shared_sample_t;
 
         shared_ptr getOutput()
         {
@@ -121,6 +124,63 @@ namespace RTT { namespace base {
             else
                 return NoData;
         }
+
+        /** Writes a batch of samples on this connection, in order. Elements
+         * that can store all samples at once override this method. The default
+         * implementation writes them one by one using write().
+         *
+         * @returns false if an error occured that requires the channel to be invalidated.
+         */
+        virtual bool writeBatch(std::vector<T> const& samples)
+        {
+            for (typename std::vector<T>::const_iterator it = samples.begin(); it != samples.end(); ++it)
+                if ( !this->write(*it) )
+                    return false;
+            return true;
+        }
+
+        /** Reads all new samples from the connection, in order. \a samples
+         * is cleared and filled with the samples that were available. The
+         * default implementation reads them one by one using read().
+         *
+         * @return NewData if \a samples is not empty, OldData or NoData otherwise.
+         */
+        virtual FlowStatus readBatch(std::vector<T>& samples)
+        {
+            samples.clear();
+            T sample = this->data_sample();
+            FlowStatus result = this->read(sample, false);
+            if (result != NewData)
+                return result;
+            do {
+                samples.push_back(sample);
+            } while ( this->read(sample, false) == NewData );
+            return NewData;
+        }
+
+        /** Writes a shared sample on this connection. Elements that can store
+         * \a sample without copying it override this method. The default
+         * implementation copies the sample using write().
+         *
+         * @returns false if an error occured that requires the channel to be invalidated.
+         */
+        virtual bool writeShared(shared_sample_t const& sample)
+        {
+            return this->write(*sample);
+        }
+
+        /** Reads a shared sample from the connection. Elements that store
+         * shared samples return them without copying. The default
+         * implementation reads a copy using read() and allocates a new
+         * shared sample for it.
+         */
+        virtual FlowStatus readShared(shared_sample_t& sample, bool copy_old_data)
+        {
+            T* value = sample.valid() ? sample.write_access() : new T( this->data_sample() );
+            FlowStatus result = this->read(*value, copy_old_data);
+            sample.reset(value);
+            return result;
+        }
     };
 }}
 
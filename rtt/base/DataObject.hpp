@@ -51,6 +51,7 @@
 #else
 #include "DataObjectLocked.hpp"
 #include "DataObjectLockFree.hpp"
+#include "DataObjectLockFreeSPSC.hpp"
 #endif
 
 namespace RTT
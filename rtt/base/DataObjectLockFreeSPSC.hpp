@@ -0,0 +1,155 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef CORELIB_DATAOBJECT_LOCK_FREE_SPSC_HPP
+#define CORELIB_DATAOBJECT_LOCK_FREE_SPSC_HPP
+
+
+#include "../os/oro_arch.h"
+#include "DataObjectInterface.hpp"
+
+namespace RTT
+{ namespace base {
+
+    /**
+     * @brief This DataObject is a wait-free implementation for exactly one
+     * writer thread and one reader thread.
+     *
+     * It implements Simpson's four-slot mechanism: the data is stored
+     * in two pairs of two slots. The writer always writes to the pair
+     * the reader is not reading from, in the slot of that pair that
+     * was not written last. Neither Set() nor Get() ever retries or
+     * waits, and only plain loads and stores are used for the control
+     * variables, no compare-and-swap. Each side issues one memory
+     * barrier per operation to announce the pair it uses.
+     *
+     * Get() may only be called from one thread and Set() may only
+     * be called from one (other) thread. Use DataObjectLockFree if more
+     * threads read or write.
+     * @ingroup PortBuffers
+     */
+    template<class T>
+    class DataObjectLockFreeSPSC
+        : public DataObjectInterface<T>
+    {
+    public:
+        /**
+         * The type of the data.
+         */
+        typedef T DataType;
+    private:
+        /**
+         * Assumed size of a cache line, in bytes.
+         */
+        enum { CacheLineSize = 64 };
+
+        DataType data[2][2];
+
+        /**
+         * Written by the writer: the last written slot of each pair
+         * and the last written pair.
+         */
+        volatile unsigned int slot[2];
+        volatile unsigned int latest;
+        char pad0[CacheLineSize];
+
+        /**
+         * Written by the reader: the pair it is reading from.
+         */
+        mutable volatile unsigned int reading;
+        char pad1[CacheLineSize];
+    public:
+        /**
+         * Construct a DataObjectLockFreeSPSC.
+         *
+         * @param initial_value The initial value of this DataObject.
+         */
+        DataObjectLockFreeSPSC( const T& initial_value = T() )
+            : latest(0), reading(0)
+        {
+            slot[0] = slot[1] = 0;
+            data_sample(initial_value);
+        }
+
+        /**
+         * Get a copy of the data.
+         * This method will allocate memory twice if data is not a value type.
+         * Use Get(DataType&) for the non-allocating version.
+         *
+         * @return A copy of the data.
+         */
+        virtual DataType Get() const {DataType cache; Get(cache); return cache; }
+
+        /**
+         * Get a copy of the Data (non allocating).
+         * If pull has reserved enough memory to store the copy,
+         * no memory will be allocated.
+         *
+         * @param pull A copy of the data.
+         */
+        virtual void Get( DataType& pull ) const
+        {
+            // finish reading the previous pair before announcing a new one.
+            oro_release_barrier();
+            unsigned int pair = latest;
+            reading = pair;
+            // the writer must see 'reading' before we look up the slot.
+            oro_smp_mb();
+            unsigned int index = slot[pair];
+            oro_acquire_barrier();
+            pull = data[pair][index];
+        }
+
+        /**
+         * Set the data to a certain value (non blocking).
+         *
+         * @param push The data which must be set.
+         */
+        virtual void Set( const DataType& push )
+        {
+            // the reader must see our previous 'latest' before we look up 'reading'.
+            oro_smp_mb();
+            unsigned int pair = 1 - reading;
+            unsigned int index = 1 - slot[pair];
+            oro_acquire_barrier();
+            data[pair][index] = push;
+            oro_release_barrier();
+            slot[pair] = index;
+            oro_release_barrier();
+            latest = pair;
+        }
+
+        virtual void data_sample( const DataType& sample ) {
+            data[0][0] = data[0][1] = data[1][0] = data[1][1] = sample;
+        }
+    };
+}}
+
+#endif
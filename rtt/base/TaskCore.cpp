@@ -42,6 +42,7 @@
 #include "ActivityInterface.hpp"
 #include "Logger.hpp"
 #include "internal/CatchConfig.hpp"
+#include "internal/ExecutionTrace.hpp"
 
 namespace RTT {
     using namespace detail;
@@ -53,6 +54,7 @@ namespace RTT {
            ,mTaskState(initial_state)
            ,mInitialState(initial_state)
            ,mTargetState(initial_state)
+           ,mtrace(0)
     {
     }
 
@@ -61,6 +63,7 @@ namespace RTT {
            ,mTaskState(initial_state)
            ,mInitialState(initial_state)
            ,mTargetState(initial_state)
+           ,mtrace(0)
     {
         parent->addChild( this );
     }
@@ -73,6 +76,7 @@ namespace RTT {
         } else {
             ee->removeChild(this);
         }
+        delete mtrace;
         // Note: calling cleanup() here has no use or even dangerous, as
         // cleanupHook() is a virtual function and the user code is already
         // destroyed. The user's subclass is responsible to make this state
@@ -337,5 +341,11 @@ namespace RTT {
         }
     }
 
+    internal::ExecutionTrace* TaskCore::trace() {
+        if ( mtrace == 0 )
+            mtrace = new internal::ExecutionTrace();
+        return mtrace;
+    }
+
 }
 
@@ -337,6 +337,14 @@ namespace RTT
             return ee;
         }
 
+        /**
+         * Returns the object which records how long the ExecutionEngine
+         * spends in the hooks of this TaskCore. It is created by the first
+         * call and tracing is disabled until ExecutionTrace::enable() is called.
+         * Don't call this from a real-time thread.
+         */
+        internal::ExecutionTrace* trace();
+
     protected:
         /**
          * Implement this method such that it contains the code which
@@ -458,6 +466,10 @@ namespace RTT
          * mTaskState to mTargetState.
          */
         TaskState mTargetState;
+        /**
+         * Null until trace() is called.
+         */
+        internal::ExecutionTrace* mtrace;
         // non copyable
         TaskCore( TaskCore& );
 
@@ -49,6 +49,7 @@
 #include "SlaveActivity.hpp"
 #include "SequentialActivity.hpp"
 #include "PeriodicActivity.hpp"
+#include "PoolActivity.hpp"
 #include "../Activity.hpp"
 #include "../base/RunnableInterface.hpp"
 
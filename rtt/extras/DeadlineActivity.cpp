@@ -0,0 +1,87 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "DeadlineActivity.hpp"
+#include "../os/fosi_internal_interface.hpp"
+#include "../Logger.hpp"
+
+namespace RTT {
+    using namespace extras;
+    using namespace base;
+
+    DeadlineActivity::DeadlineActivity(Seconds period, Seconds budget, Seconds deadline,
+                                       RunnableInterface* r, const std::string& name)
+        : Activity(ORO_SCHED_OTHER, os::LowestPriority, period, r, name),
+          max_execution_time(0)
+    {
+        Logger::In in("DeadlineActivity");
+#ifdef ORO_SCHED_DEADLINE
+        if ( !setBudget(budget, deadline) )
+            log(Error) << "Could not reserve " << budget << "s in every " << period
+                       << "s period for " << name << "." << endlog();
+        else if ( !setScheduler(ORO_SCHED_DEADLINE) )
+            log(Error) << name << " may not use SCHED_DEADLINE and runs with ORO_SCHED_OTHER."
+                       << " Budget overruns are still detected." << endlog();
+#else
+        log(Warning) << "This OS has no deadline scheduler, " << name
+                     << " runs with ORO_SCHED_OTHER." << endlog();
+#endif
+    }
+
+    bool DeadlineActivity::setBudget(Seconds budget, Seconds deadline)
+    {
+        if ( budget <= 0.0 || ( deadline != 0.0 && deadline > getPeriod() ) )
+            return false;
+        return setDeadline(budget, deadline);
+    }
+
+    Seconds DeadlineActivity::getBudget() const
+    {
+        return getRuntime();
+    }
+
+    Seconds DeadlineActivity::getMaxExecutionTime() const
+    {
+        return nsecs_to_Seconds(max_execution_time);
+    }
+
+    void DeadlineActivity::resetMaxExecutionTime()
+    {
+        max_execution_time = 0;
+    }
+
+    void DeadlineActivity::step()
+    {
+        nsecs start = os::rtos_task_get_cpu_time( getTask() );
+        Activity::step();
+        nsecs used = os::rtos_task_get_cpu_time( getTask() ) - start;
+        if ( used > max_execution_time )
+            max_execution_time = used;
+    }
+}
@@ -0,0 +1,104 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef ORO_DEADLINE_ACTIVITY_HPP
+#define ORO_DEADLINE_ACTIVITY_HPP
+
+#include "../Activity.hpp"
+
+namespace RTT
+{ namespace extras {
+
+    /**
+     * @brief A periodic Activity which runs under the Linux SCHED_DEADLINE
+     * scheduler. The kernel reserves a budget of CPU time in every period,
+     * which must be used before the deadline, and does not let the
+     * activity use more.
+     *
+     * The period of the reservation is the period of the activity, and
+     * follows setPeriod(). The budget should be the measured worst case
+     * execution time of one step, getMaxExecutionTime() measures it.
+     * A step which uses more than its budget, or passes the deadline,
+     * is an overrun, which stops the activity when there are too many of
+     * them, see os::Thread::setMaxOverrun().
+     *
+     * SCHED_DEADLINE requires CAP_SYS_NICE and a thread which may run on
+     * all CPUs. Without it, the activity runs with ORO_SCHED_OTHER, but
+     * still reports budget overruns. Other OSes do not have a deadline
+     * scheduler, there the activity is a plain ORO_SCHED_OTHER Activity.
+     */
+    class RTT_API DeadlineActivity
+        : public Activity
+    {
+    public:
+        /**
+         * @brief Create a DeadlineActivity.
+         *
+         * @param period The period of the activity and of its reservation.
+         * @param budget The CPU time the activity may use in each period.
+         * @param deadline The time since the start of a period by which
+         *        the budget must be used, zero for the period itself.
+         * @param r The optional base::RunnableInterface to run exclusively within this Activity
+         * @param name The name of the underlying thread.
+         */
+        DeadlineActivity(Seconds period, Seconds budget, Seconds deadline = 0.0,
+                         base::RunnableInterface* r = 0, const std::string& name ="DeadlineActivity");
+
+        /**
+         * Change the budget and deadline of this activity.
+         * @return false if they do not fit in the period or the OS
+         * has no deadline scheduler.
+         */
+        bool setBudget(Seconds budget, Seconds deadline = 0.0);
+
+        /**
+         * @return the CPU time reserved in each period.
+         */
+        Seconds getBudget() const;
+
+        /**
+         * @return the largest CPU time a single step has used since the
+         * activity was created or resetMaxExecutionTime() was called.
+         */
+        Seconds getMaxExecutionTime() const;
+
+        /**
+         * Forget the execution times measured so far.
+         */
+        void resetMaxExecutionTime();
+
+        virtual void step();
+
+    private:
+        nsecs max_execution_time;
+    };
+
+}}
+
+#endif
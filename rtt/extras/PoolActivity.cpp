@@ -0,0 +1,233 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "PoolActivity.hpp"
+#include "../os/MainThread.hpp"
+#include "../os/MutexLock.hpp"
+
+namespace RTT {
+    using namespace extras;
+    using namespace base;
+    using os::MutexLock;
+
+    PoolActivity::PoolActivity( RunnableInterface* run /*= 0*/ )
+        : ActivityInterface(run), mpool( ThreadPool::Instance() ), mstate(Idle), active(false), maccepting(false), mcurrent(0), mrefs(0)
+    {
+    }
+
+    PoolActivity::PoolActivity( ThreadPoolPtr pool, RunnableInterface* run /*= 0*/ )
+        : ActivityInterface(run), mpool( pool ), mstate(Idle), active(false), maccepting(false), mcurrent(0), mrefs(0)
+    {
+    }
+
+    PoolActivity::~PoolActivity()
+    {
+        stop();
+        MutexLock lock(mlock);
+        while ( mstate == Running || mstate == Rerun || mrefs.read() != 0 )
+            mcond.wait(mlock);
+    }
+
+    ThreadPoolPtr PoolActivity::getPool() const
+    {
+        return mpool;
+    }
+
+    Seconds PoolActivity::getPeriod() const
+    {
+        return 0.0;
+    }
+
+    bool PoolActivity::setPeriod(Seconds s) {
+        if ( s == 0.0)
+            return true;
+        return false;
+    }
+
+    unsigned PoolActivity::getCpuAffinity() const
+    {
+        return ~0;
+    }
+
+    bool PoolActivity::setCpuAffinity(unsigned cpu)
+    {
+        return false;
+    }
+
+    os::ThreadInterface* PoolActivity::thread()
+    {
+        os::ThreadInterface* current = mcurrent;
+        return current ? current : os::MainThread::Instance();
+    }
+
+    bool PoolActivity::initialize()
+    {
+        return true;
+    }
+
+    void PoolActivity::step()
+    {
+    }
+
+    void PoolActivity::loop()
+    {
+        this->step();
+    }
+
+    bool PoolActivity::breakLoop()
+    {
+        return false;
+    }
+
+    void PoolActivity::finalize()
+    {
+    }
+
+    bool PoolActivity::start()
+    {
+        {
+            MutexLock lock(mlock);
+            if ( active )
+                return false;
+            // wait for a worker which still holds us from a previous run.
+            if ( !(mcurrent && mcurrent->isSelf()) ) {
+                while ( mstate == Running || mstate == Rerun || mrefs.read() != 0 )
+                    mcond.wait(mlock);
+            }
+            active = true;
+        }
+        bool ok = runner ? runner->initialize() : this->initialize();
+        MutexLock lock(mlock);
+        active = ok;
+        maccepting = ok;
+        return ok;
+    }
+
+    bool PoolActivity::stop()
+    {
+        {
+            MutexLock lock(mlock);
+            if ( !maccepting )
+                return false;
+            maccepting = false;
+            // a worker which already took us from its
+            // queue will notice that we are no longer queued.
+            if ( mstate == Queued ) {
+                mpool->cancel(this);
+                mstate = Idle;
+            }
+            // when called from our own step(), the worker
+            // finishes the step after we return.
+            if ( !(mcurrent && mcurrent->isSelf()) ) {
+                while ( mstate == Running || mstate == Rerun || mrefs.read() != 0 )
+                    mcond.wait(mlock);
+            }
+        }
+        if (runner)
+            runner->finalize();
+        else
+            this->finalize();
+        MutexLock lock(mlock);
+        active = false;
+        return true;
+    }
+
+    bool PoolActivity::isRunning() const
+    {
+        MutexLock lock(mlock);
+        return mstate == Running || mstate == Rerun;
+    }
+
+    bool PoolActivity::isPeriodic() const
+    {
+        return false;
+    }
+
+    bool PoolActivity::isActive() const
+    {
+        MutexLock lock(mlock);
+        return active;
+    }
+
+    bool PoolActivity::trigger()
+    {
+        MutexLock lock(mlock);
+        if ( !maccepting )
+            return false;
+        if ( mstate == Idle ) {
+            mstate = Queued;
+            mpool->schedule(this);
+        } else if ( mstate == Running )
+            mstate = Rerun;
+        return true;
+    }
+
+    bool PoolActivity::execute()
+    {
+        return false;
+    }
+
+    void PoolActivity::work(os::ThreadInterface* worker)
+    {
+        MutexLock lock(mlock);
+        // we may have been stopped since we were queued.
+        if ( mstate == Queued && maccepting ) {
+            mstate = Running;
+            mcurrent = worker;
+            mlock.unlock();
+            bool more = false;
+            try {
+                if (runner) {
+                    runner->step();
+                    more = runner->hasWork();
+                } else
+                    this->step();
+            } catch (...) {
+                // leave the activity idle, such that stop() does not wait for it.
+                mlock.lock();
+                mcurrent = 0;
+                mstate = Idle;
+                mrefs.dec();
+                mcond.broadcast();
+                throw;
+            }
+            mlock.lock();
+            mcurrent = 0;
+            // requeue at the back, such that other activities get their turn.
+            if ( maccepting && (mstate == Rerun || more) ) {
+                mstate = Queued;
+                mpool->schedule(this);
+            } else
+                mstate = Idle;
+        }
+        mrefs.dec();
+        mcond.broadcast();
+    }
+}
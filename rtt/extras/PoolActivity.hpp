@@ -0,0 +1,160 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_POOL_ACTIVITY_HPP
+#define ORO_POOL_ACTIVITY_HPP
+
+#include "../base/ActivityInterface.hpp"
+#include "../base/RunnableInterface.hpp"
+#include "../os/Mutex.hpp"
+#include "../os/Condition.hpp"
+#include "../os/Atomic.hpp"
+#include "ThreadPool.hpp"
+
+namespace RTT
+{ namespace extras {
+
+    /**
+     * @brief An activity which executes its RunnableInterface in one
+     * of the worker threads of a ThreadPool.
+     *
+     * Use this activity for the many non real-time components of an
+     * application, such that they share a small number of threads instead of
+     * each requiring a thread of its own. The pool guarantees that the step()
+     * of a PoolActivity is never executed by two workers at the same time,
+     * but consecutive steps may be executed by different workers.
+     *
+     * \section ExecReact Reactions to execute():
+     * Always returns false.
+     *
+     * \section TrigReact Reactions to trigger():
+     * This queues step() for execution in the pool. A trigger() during step()
+     * causes step() to be executed once more afterwards.
+     *
+     * @ingroup CoreLibActivities
+     */
+    class RTT_API PoolActivity
+        :public base::ActivityInterface
+    {
+    public:
+        /**
+         * Create an activity which executes in the default pool.
+         * @param run Run this instance.
+         * @see ThreadPool::Instance()
+         */
+        PoolActivity( base::RunnableInterface* run = 0 );
+
+        /**
+         * Create an activity which executes in \a pool.
+         * @param pool The pool to execute in.
+         * @param run Run this instance.
+         */
+        PoolActivity( ThreadPoolPtr pool, base::RunnableInterface* run = 0 );
+
+        /**
+         * Cleanup and notify the base::RunnableInterface that we are gone.
+         */
+        ~PoolActivity();
+
+        /**
+         * Returns the pool this activity executes in.
+         */
+        ThreadPoolPtr getPool() const;
+
+        Seconds getPeriod() const;
+
+        bool setPeriod(Seconds s);
+
+        unsigned getCpuAffinity() const;
+
+        bool setCpuAffinity(unsigned cpu);
+
+        /**
+         * Returns the worker thread executing this activity,
+         * or the main thread if it is not being executed.
+         */
+        os::ThreadInterface* thread();
+
+        bool initialize();
+        void step();
+        void loop();
+        bool breakLoop();
+        void finalize();
+
+        bool start();
+
+        bool stop();
+
+        bool isRunning() const;
+
+        bool isPeriodic() const;
+
+        bool isActive() const;
+
+        bool execute();
+
+        bool trigger();
+
+    protected:
+        friend class ThreadPool;
+
+        /**
+         * Called by a worker of the pool to execute one step.
+         */
+        void work(os::ThreadInterface* worker);
+
+        enum State { Idle, Queued, Running, Rerun };
+
+        ThreadPoolPtr mpool;
+        /**
+         * Guards the fields below. A worker of the pool may
+         * take a queue lock while holding this lock, never the
+         * other way around.
+         */
+        mutable os::Mutex mlock;
+        os::Condition mcond;
+        State mstate;
+        bool active;
+        /**
+         * True between initialize() and finalize(), when
+         * triggers are accepted.
+         */
+        bool maccepting;
+        os::ThreadInterface* volatile mcurrent;
+        /**
+         * The number of workers which took this activity
+         * from a queue and did not finish with it yet.
+         */
+        os::AtomicInt mrefs;
+    };
+
+}}
+
+#endif
@@ -41,9 +41,9 @@
 
 #include <boost/intrusive_ptr.hpp>
 #include <boost/call_traits.hpp>
+#include <algorithm>
 
-#include "../os/Mutex.hpp"
-#include "../os/MutexLock.hpp"
+#include "../os/oro_arch.h"
 
 namespace RTT
 { namespace extras {
@@ -51,21 +51,25 @@ namespace RTT
         template<typename T>
         struct ROPtrInternal
         {
-            os::Mutex  lock;
             T*     value;
-            size_t readers;
+            oro_atomic_t readers;
 
             ROPtrInternal(T* value)
-                : value(value), readers(0) {}
-            ~ROPtrInternal() { delete value; }
+                : value(value) { ORO_ATOMIC_SETUP(&readers, 0); }
+            ~ROPtrInternal() { ORO_ATOMIC_CLEANUP(&readers); delete value; }
 
             void ref()
-            { os::MutexLock do_lock(lock);
-                ++readers;
+            {
+                oro_atomic_inc(&readers);
             }
             bool deref()
-            { os::MutexLock do_lock(lock);
-                return (--readers) != 0;
+            {
+                return !oro_atomic_dec_and_test(&readers);
+            }
+            /** True if exactly \a count references to this object exist. */
+            bool owners(int count) const
+            {
+                return oro_atomic_read(&readers) == count;
             }
         };
 
@@ -150,21 +154,15 @@ namespace RTT
             if (safe->value == ptr)
                 return;
 
-            { os::MutexLock do_lock(safe->lock);
-                if (safe->readers == 2) // we are sole owner
-                {
-                    delete safe->value;
-                    safe->value = ptr;
-                    return;
-                }
+            if (safe->owners(2)) // we are sole owner
+            {
+                delete safe->value;
+                safe->value = ptr;
+                return;
             }
 
-            // We must *not* change 'internal' while safe->lock is taken. The
-            // above block returns in case we don't need to reallocate a new
+            // If we are here, it is because we *need* to reallocate a new
             // Internal structure.
-            //
-            // In other words, if we are here, it is because we *need* to
-            // reallocate.
             internal = new Internal(ptr);
         }
 
@@ -183,18 +181,16 @@ namespace RTT
             if (!safe)
                 return 0;
 
-            { os::MutexLock do_lock(safe->lock);
-                if (safe->readers == 2)
-                { // we're the only owner (don't forget +safe+ above).
-                  // Just promote the current copy
-                    T* value = 0;
-                    std::swap(value, safe->value);
-                    return value;
-                }
-                else
-                { // there are other owners
-                    return NULL;
-                }
+            if (safe->owners(2))
+            { // we're the only owner (don't forget +safe+ above).
+              // Just promote the current copy
+                T* value = 0;
+                std::swap(value, safe->value);
+                return value;
+            }
+            else
+            { // there are other owners
+                return NULL;
             }
         }
 
@@ -215,18 +211,16 @@ namespace RTT
             if (!safe)
                 return 0;
 
-            { os::MutexLock do_lock(safe->lock);
-                if (safe->readers == 2)
-                { // we're the only owner (don't forget +safe+ above).
-                  // Just promote the current copy
-                    T* value = 0;
-                    std::swap(value, safe->value);
-                    return value;
-                }
-                else
-                { // there are other owners, do a copy
-                    return new T(*safe->value);
-                }
+            if (safe->owners(2))
+            { // we're the only owner (don't forget +safe+ above).
+              // Just promote the current copy
+                T* value = 0;
+                std::swap(value, safe->value);
+                return value;
+            }
+            else
+            { // there are other owners, do a copy
+                return new T(*safe->value);
             }
         }
     };
@@ -0,0 +1,224 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "ThreadPool.hpp"
+#include "PoolActivity.hpp"
+#include "../os/Thread.hpp"
+#include "../os/MutexLock.hpp"
+#include "../os/threads.hpp"
+#include "../Logger.hpp"
+#include <algorithm>
+#include <sstream>
+
+#ifndef ORONUM_EXTRAS_POOL_THREADS
+#define ORONUM_EXTRAS_POOL_THREADS 4
+#endif
+
+namespace RTT {
+    using namespace extras;
+    using os::MutexLock;
+    using namespace std;
+
+    /**
+     * A non periodic thread which executes the
+     * activities of its pool until it is stopped.
+     */
+    class ThreadPool::Worker
+        : public os::Thread
+    {
+        ThreadPool* mpool;
+        unsigned int mindex;
+        volatile bool mquit;
+    public:
+        Worker(ThreadPool* pool, unsigned int index, int scheduler, int priority, const std::string& name)
+            : os::Thread(scheduler, priority, 0.0, ~0, name), mpool(pool), mindex(index), mquit(false)
+        {}
+
+        ~Worker()
+        {
+            this->stop();
+        }
+
+        virtual bool initialize()
+        {
+            mquit = false;
+            return true;
+        }
+
+        virtual void loop()
+        {
+            while ( !mquit ) {
+                PoolActivity* act = 0;
+                if ( mpool->take(mindex, act) ) {
+                    act->work( this );
+                    continue;
+                }
+                // no work: sleep until an activity is scheduled.
+                mpool->idle.inc();
+                {
+                    MutexLock lock( mpool->idle_lock );
+                    while ( !mquit && mpool->pending.read() == 0 )
+                        mpool->idle_cond.wait( mpool->idle_lock );
+                }
+                mpool->idle.dec();
+            }
+        }
+
+        virtual bool breakLoop()
+        {
+            mquit = true;
+            MutexLock lock( mpool->idle_lock );
+            mpool->idle_cond.broadcast();
+            return true;
+        }
+    };
+
+    ThreadPool::ThreadPoolList ThreadPool::ThreadPools;
+
+    ThreadPoolPtr ThreadPool::Instance()
+    {
+        ThreadPoolList::iterator it = ThreadPools.begin();
+        while ( it != ThreadPools.end() ) {
+            ThreadPoolPtr pptr = it->lock();
+            // detect old pointer.
+            if ( !pptr ) {
+                ThreadPools.erase(it);
+                it = ThreadPools.begin();
+                continue;
+            }
+            return pptr;
+        }
+        ThreadPoolPtr ret( new ThreadPool(ORONUM_EXTRAS_POOL_THREADS, ORO_SCHED_OTHER, os::LowestPriority, "PoolWorker") );
+        ThreadPools.push_back( ret );
+        return ret;
+    }
+
+    ThreadPool::ThreadPool(unsigned int threads, int scheduler, int priority, const std::string& name)
+        : pending(0), idle(0), next_queue(0)
+    {
+        if ( threads == 0 )
+            threads = 1;
+        for (unsigned int i = 0; i != threads; ++i)
+            queues.push_back( new Queue() );
+        for (unsigned int i = 0; i != threads; ++i) {
+            stringstream wname;
+            wname << name << i;
+            workers.push_back( new Worker(this, i, scheduler, priority, wname.str()) );
+        }
+        for (unsigned int i = 0; i != threads; ++i)
+            workers[i]->start();
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        for (unsigned int i = 0; i != workers.size(); ++i)
+            delete workers[i];
+        for (unsigned int i = 0; i != queues.size(); ++i) {
+            if ( !queues[i]->tasks.empty() )
+                log(Error) << "ThreadPool destroyed while activities were still scheduled." << endlog();
+            delete queues[i];
+        }
+    }
+
+    unsigned int ThreadPool::size() const
+    {
+        return workers.size();
+    }
+
+    os::ThreadInterface* ThreadPool::thread(unsigned int i) const
+    {
+        return i < workers.size() ? workers[i] : 0;
+    }
+
+    void ThreadPool::schedule(PoolActivity* act)
+    {
+        // keep work triggered by a worker local to that worker.
+        unsigned int q = queues.size();
+        for (unsigned int i = 0; i != workers.size(); ++i)
+            if ( workers[i]->isSelf() ) {
+                q = i;
+                break;
+            }
+        if ( q == queues.size() )
+            q = (next_queue++) % queues.size();
+        {
+            MutexLock lock( queues[q]->lock );
+            queues[q]->tasks.push_back( act );
+        }
+        pending.inc();
+        if ( idle.read() != 0 ) {
+            MutexLock lock( idle_lock );
+            idle_cond.broadcast();
+        }
+    }
+
+    bool ThreadPool::cancel(PoolActivity* act)
+    {
+        bool found = false;
+        for (unsigned int i = 0; i != queues.size(); ++i) {
+            MutexLock lock( queues[i]->lock );
+            deque<PoolActivity*>::iterator it = find( queues[i]->tasks.begin(), queues[i]->tasks.end(), act );
+            if ( it != queues[i]->tasks.end() ) {
+                queues[i]->tasks.erase( it );
+                pending.dec();
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    bool ThreadPool::take(unsigned int self, PoolActivity*& act)
+    {
+        // first our own work, oldest first:
+        {
+            MutexLock lock( queues[self]->lock );
+            if ( !queues[self]->tasks.empty() ) {
+                act = queues[self]->tasks.front();
+                queues[self]->tasks.pop_front();
+                act->mrefs.inc();
+                pending.dec();
+                return true;
+            }
+        }
+        // steal the most recent work of the others:
+        for (unsigned int i = 1; i < queues.size(); ++i) {
+            Queue* q = queues[ (self + i) % queues.size() ];
+            MutexLock lock( q->lock );
+            if ( !q->tasks.empty() ) {
+                act = q->tasks.back();
+                q->tasks.pop_back();
+                act->mrefs.inc();
+                pending.dec();
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,156 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_THREADPOOL_HPP
+#define ORO_THREADPOOL_HPP
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include "../os/Mutex.hpp"
+#include "../os/Condition.hpp"
+#include "../os/Atomic.hpp"
+#include "rtt-extras-fwd.hpp"
+
+namespace RTT
+{ namespace extras {
+
+    /**
+     * ThreadPool objects are reference counted such that
+     * when the last PoolActivity which uses it is deleted,
+     * the worker threads are deleted as well.
+     */
+    typedef boost::shared_ptr<ThreadPool> ThreadPoolPtr;
+
+    /**
+     * A fixed set of worker threads which execute triggered
+     * PoolActivity objects.
+     *
+     * Each worker owns a deque of scheduled activities. A worker
+     * executes the activities of its own deque in FIFO order and,
+     * when it runs out of work, steals from the back of the deques of
+     * the other workers. Activities triggered by a worker are queued on
+     * the deque of that worker, others are distributed round-robin.
+     *
+     * This pool is meant for many non real-time components, which would
+     * otherwise each require a thread of their own.
+     *
+     * @see PoolActivity
+     */
+    class RTT_API ThreadPool
+    {
+    public:
+        /**
+         * Create a pool of worker threads.
+         *
+         * @param threads The number of worker threads, at least one.
+         * @param scheduler The scheduler in which the workers run.
+         * @param priority The priority of the workers within \a scheduler.
+         * @param name The name prefix of the worker threads.
+         */
+        ThreadPool(unsigned int threads, int scheduler, int priority, const std::string& name = "ThreadPool");
+
+        /**
+         * Stops and deletes all worker threads. No PoolActivity
+         * may use this pool any more.
+         */
+        ~ThreadPool();
+
+        /**
+         * Returns the number of worker threads in this pool.
+         */
+        unsigned int size() const;
+
+        /**
+         * Returns the worker thread with index \a i.
+         */
+        os::ThreadInterface* thread(unsigned int i) const;
+
+        /**
+         * Returns the shared default pool, which has ORONUM_EXTRAS_POOL_THREADS
+         * non real-time workers. It is created on first use.
+         */
+        static ThreadPoolPtr Instance();
+
+    protected:
+        friend class PoolActivity;
+        class Worker;
+        friend class Worker;
+
+        /**
+         * Queue \a act on a worker's deque and wake up an idle worker.
+         * The activity's lock must be held by the caller.
+         */
+        void schedule(PoolActivity* act);
+
+        /**
+         * Remove \a act from all deques.
+         * @return true if it was found.
+         */
+        bool cancel(PoolActivity* act);
+
+        /**
+         * Take the next activity for worker \a self,
+         * stealing from the other workers if required.
+         */
+        bool take(unsigned int self, PoolActivity*& act);
+
+        /**
+         * A deque of scheduled activities, owned by one worker.
+         */
+        struct Queue
+        {
+            os::Mutex lock;
+            std::deque<PoolActivity*> tasks;
+        };
+
+        std::vector<Queue*> queues;
+        std::vector<Worker*> workers;
+
+        /**
+         * The number of activities in all deques.
+         */
+        os::AtomicInt pending;
+        /**
+         * The number of workers waiting for work.
+         */
+        os::AtomicInt idle;
+        os::Mutex idle_lock;
+        os::Condition idle_cond;
+        unsigned int next_queue;
+
+        typedef std::vector< boost::weak_ptr<ThreadPool> > ThreadPoolList;
+        static ThreadPoolList ThreadPools;
+    };
+}}
+
+#endif
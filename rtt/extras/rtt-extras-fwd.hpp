@@ -3,13 +3,16 @@
 
 namespace RTT {
     namespace extras {
+        class DeadlineActivity;
         class FileDescriptorActivity;
         class IRQActivity;
         class PeriodicActivity;
+        class PoolActivity;
         class SequentialActivity;
         class SimulationActivity;
         class SimulationThread;
         class SlaveActivity;
+        class ThreadPool;
         class TimerThread;
         struct Provider;
         struct RT_INTR;
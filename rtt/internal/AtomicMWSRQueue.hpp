@@ -121,6 +121,33 @@ namespace RTT
                 return &_buf[oldval._index[0]];
             }
 
+            /**
+             * Atomic advance and wrap of the Write pointer over at most
+             * \a n positions. Stores the old position in \a first and
+             * returns the number of positions reserved, zero if queue is full.
+             */
+            int advance_w(int n, int& first)
+            {
+                SIndexes oldval, newval;
+                int count;
+                do
+                {
+                    oldval._value = _indxes._value;
+                    newval._value = oldval._value;
+                    // free positions, one position is always kept empty.
+                    count = oldval._index[1] - oldval._index[0] - 1;
+                    if (count < 0)
+                        count += _size;
+                    if (count == 0)
+                        return 0;
+                    if (count > n)
+                        count = n;
+                    newval._index[0] = (oldval._index[0] + count) % _size;
+                } while (!os::CAS(&_indxes._value, oldval._value, newval._value));
+                first = oldval._index[0];
+                return count;
+            }
+
             /**
              * Advance and wrap of the Read pointer.
              * Only one thread may call this.
@@ -254,6 +281,60 @@ namespace RTT
                 return false;
             }
 
+            /**
+             * Enqueue a batch of items, reserving all positions at once.
+             * @param values The values to enqueue, none of them may be null.
+             * @param n The number of values.
+             * @return the number of values that were queued. This is less
+             * than \a n if the queue got full, the first items of \a values
+             * are queued in that case.
+             */
+            size_type enqueue(const T* values, size_type n)
+            {
+                int first;
+                int count = n == 0 ? 0 : advance_w(n, first);
+                for (int i = 0; i != count; ++i)
+                {
+                    _buf[first] = values[i];
+                    if (++first == _size)
+                        first = 0;
+                }
+                return count;
+            }
+
+            /**
+             * Dequeue a batch of items, advancing the read pointer once.
+             * @param results Stores at most \a n dequeued values.
+             * @param n The maximum number of values to dequeue.
+             * @return the number of values written in \a results.
+             */
+            size_type dequeue(T* results, size_type n)
+            {
+                SIndexes oldval, newval;
+                oldval._value = _indxes._value;
+                int index = oldval._index[1];
+                size_type count = 0;
+                // only take the items that are already written.
+                while (count != n && _buf[index] != 0)
+                {
+                    results[count] = _buf[index];
+                    _buf[index] = 0;
+                    ++count;
+                    if (++index == _size)
+                        index = 0;
+                }
+                if (count == 0)
+                    return 0;
+                do
+                {
+                    oldval._value = _indxes._value;
+                    newval._value = oldval._value;
+                    newval._index[1] = index;
+                    // we need to CAS since the write pointer may have moved.
+                } while (!os::CAS(&_indxes._value, oldval._value, newval._value));
+                return count;
+            }
+
             /**
              * Return the next to be read value.
              */
@@ -0,0 +1,276 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_CORELIB_ATOMIC_SPSC_QUEUE_HPP
+#define ORO_CORELIB_ATOMIC_SPSC_QUEUE_HPP
+
+#include "../os/oro_arch.h"
+
+namespace RTT
+{
+    namespace internal
+    {
+        /**
+         * Create a wait-free Single-Writer Single-Reader FIFO for storing
+         * a value \a T. Exactly one thread may enqueue and exactly one
+         * (other) thread may dequeue. No compare-and-swap or other atomic
+         * read-modify-write instruction is used: each index is only
+         * written by its owner and published with a release barrier.
+         *
+         * The write index and the read index live on separate cache lines,
+         * such that the writer and the reader do not invalidate each other's
+         * cache line on every operation. Each side also caches the last index
+         * it has seen of the other side and only re-reads it when the queue
+         * looks full (writer) or empty (reader).
+         * @param T The value type to be stored in the Queue.
+         * Example : AtomicSPSCQueue< A* > is a queue of pointers to A.
+         * @ingroup CoreLibBuffers
+         */
+        template<class T>
+        class AtomicSPSCQueue
+        {
+        public:
+            typedef unsigned int size_type;
+        private:
+            /**
+             * Assumed size of a cache line, in bytes.
+             */
+            enum { CacheLineSize = 64 };
+
+            const size_type _size;
+            T* _buf;
+            char _pad0[CacheLineSize];
+
+            /**
+             * Owned by the writer: the next slot to write.
+             */
+            volatile size_type _windex;
+            /**
+             * The writer's copy of _rindex.
+             */
+            size_type _rcache;
+            char _pad1[CacheLineSize];
+
+            /**
+             * Owned by the reader: the next slot to read.
+             */
+            volatile size_type _rindex;
+            /**
+             * The reader's copy of _windex.
+             */
+            size_type _wcache;
+            char _pad2[CacheLineSize];
+
+            size_type next(size_type index) const
+            {
+                return index + 1 == _size ? 0 : index + 1;
+            }
+
+            // non-copyable !
+            AtomicSPSCQueue(const AtomicSPSCQueue<T>&);
+        public:
+            /**
+             * Create an AtomicSPSCQueue with queue size \a size.
+             * @param size The size of the queue, should be 1 or greater.
+             */
+            AtomicSPSCQueue(unsigned int size) :
+                _size(size + 1), _buf( new T[size + 1] ),
+                _windex(0), _rcache(0), _rindex(0), _wcache(0)
+            {
+            }
+
+            ~AtomicSPSCQueue()
+            {
+                delete[] _buf;
+            }
+
+            /**
+             * Inspect if the Queue is full.
+             * @return true if full, false otherwise.
+             */
+            bool isFull() const
+            {
+                return next(_windex) == _rindex;
+            }
+
+            /**
+             * Inspect if the Queue is empty.
+             * @return true if empty, false otherwise.
+             */
+            bool isEmpty() const
+            {
+                return _windex == _rindex;
+            }
+
+            /**
+             * Return the maximum number of items this queue can contain.
+             */
+            size_type capacity() const
+            {
+                return _size - 1;
+            }
+
+            /**
+             * Return the number of elements in the queue.
+             */
+            size_type size() const
+            {
+                size_type w = _windex;
+                size_type r = _rindex;
+                return w >= r ? w - r : w + _size - r;
+            }
+
+            /**
+             * Enqueue an item. May only be called by the writer thread.
+             * @param value The value to enqueue.
+             * @return false if queue is full, true if queued.
+             */
+            bool enqueue(const T& value)
+            {
+                size_type w = _windex;
+                size_type n = next(w);
+                if ( n == _rcache ) {
+                    _rcache = _rindex;
+                    // the reader must be done with slot w before we overwrite it.
+                    oro_acquire_barrier();
+                    if ( n == _rcache )
+                        return false;
+                }
+                _buf[w] = value;
+                oro_release_barrier();
+                _windex = n;
+                return true;
+            }
+
+            /**
+             * Dequeue an item. May only be called by the reader thread.
+             * @param result Stores the dequeued value. It is unchanged when
+             * dequeue returns false and contains the dequeued value
+             * when it returns true.
+             * @return false if queue is empty, true if result was written.
+             */
+            bool dequeue(T& result)
+            {
+                size_type r = _rindex;
+                if ( r == _wcache ) {
+                    _wcache = _windex;
+                    if ( r == _wcache )
+                        return false;
+                }
+                oro_acquire_barrier();
+                result = _buf[r];
+                oro_release_barrier();
+                _rindex = next(r);
+                return true;
+            }
+
+            /**
+             * Enqueue a batch of items, publishing them at once.
+             * May only be called by the writer thread.
+             * @param values The values to enqueue.
+             * @param n The number of values.
+             * @return the number of values that were queued. This is less
+             * than \a n if the queue got full, the first items of \a values
+             * are queued in that case.
+             */
+            size_type enqueue(const T* values, size_type n)
+            {
+                size_type w = _windex;
+                size_type room = (_rcache + _size - w - 1) % _size;
+                if ( room < n ) {
+                    _rcache = _rindex;
+                    oro_acquire_barrier();
+                    room = (_rcache + _size - w - 1) % _size;
+                }
+                size_type count = room < n ? room : n;
+                if ( count == 0 )
+                    return 0;
+                for (size_type i = 0; i != count; ++i) {
+                    _buf[w] = values[i];
+                    w = next(w);
+                }
+                oro_release_barrier();
+                _windex = w;
+                return count;
+            }
+
+            /**
+             * Dequeue a batch of items, releasing their slots at once.
+             * May only be called by the reader thread.
+             * @param results Stores at most \a n dequeued values.
+             * @param n The maximum number of values to dequeue.
+             * @return the number of values written in \a results.
+             */
+            size_type dequeue(T* results, size_type n)
+            {
+                size_type r = _rindex;
+                size_type avail = (_wcache + _size - r) % _size;
+                if ( avail < n ) {
+                    _wcache = _windex;
+                    avail = (_wcache + _size - r) % _size;
+                }
+                size_type count = avail < n ? avail : n;
+                if ( count == 0 )
+                    return 0;
+                oro_acquire_barrier();
+                for (size_type i = 0; i != count; ++i) {
+                    results[i] = _buf[r];
+                    r = next(r);
+                }
+                oro_release_barrier();
+                _rindex = r;
+                return count;
+            }
+
+            /**
+             * Return the next to be read value. May only be called
+             * by the reader thread and only if the queue is not empty.
+             */
+            const T& front() const
+            {
+                oro_acquire_barrier();
+                return _buf[_rindex];
+            }
+
+            /**
+             * Clear all contents of the Queue and thus make it empty.
+             * May only be called by the reader thread.
+             */
+            void clear()
+            {
+                _wcache = _windex;
+                oro_release_barrier();
+                _rindex = _wcache;
+            }
+        };
+    }
+}
+
+#endif
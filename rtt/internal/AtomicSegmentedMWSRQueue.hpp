@@ -0,0 +1,444 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_CORELIB_ATOMIC_SEGMENTED_MWSR_QUEUE_HPP
+#define ORO_CORELIB_ATOMIC_SEGMENTED_MWSR_QUEUE_HPP
+
+#include "../os/CAS.hpp"
+#include "../os/Atomic.hpp"
+#include "../os/oro_malloc.h"
+#include <new>
+
+namespace RTT
+{
+    namespace internal
+    {
+        /**
+         * Create an atomic, non-blocking Multi-Writer Single-Reader FIFO for storing
+         * a pointer \a T by value, which grows on demand. The queue is a
+         * linked list of fixed-size segments. When a writer finds the last
+         * segment full, it links a new segment, obtained from the real-time
+         * allocator (oro_rt_malloc()), to it. Segments which were emptied by
+         * the reader are recycled as soon as no writer can still access them.
+         * To find out when that is, writers register in one of two epochs
+         * when they enter enqueue(). The reader retires emptied segments in
+         * the current epoch, switches to the other epoch and releases them
+         * once all writers of the previous epoch have left enqueue(). Thus
+         * continuous writing does not prevent reclamation; only a writer
+         * which is preempted inside enqueue() delays it until it resumes.
+         *
+         * The number of elements in the queue is limited by capacity(),
+         * which may be changed at any time with setCapacity(). A queue
+         * which capacity is equal to its segment size behaves like an
+         * AtomicMWSRQueue of that size.
+         *
+         * @warning You can not store null pointers.
+         * @param T The pointer type to be stored in the Queue.
+         * Example : AtomicSegmentedMWSRQueue< A* > is a queue of pointers to A.
+         * @ingroup CoreLibBuffers
+         */
+        template<class T>
+        class AtomicSegmentedMWSRQueue
+        {
+            typedef T C;
+            typedef volatile C* CachePtrType;
+
+            /**
+             * A segment header. The slots of the segment
+             * are stored directly after the header.
+             */
+            struct Segment
+            {
+                /**
+                 * The number of slots handed out to writers.
+                 */
+                volatile int claimed;
+                /**
+                 * The next segment, linked in by a writer.
+                 */
+                Segment* volatile next;
+                /**
+                 * Reader only: the next slot to read.
+                 */
+                int read;
+                /**
+                 * Reader only: links the retired segments.
+                 */
+                Segment* retired;
+            };
+
+            const int _segsize;
+            /**
+             * The segment writers store in.
+             */
+            Segment* volatile _tail;
+            /**
+             * Reader only: the segment we read from.
+             */
+            Segment* _head;
+            /**
+             * Reader only: segments emptied in the current epoch.
+             */
+            Segment* _retired;
+            /**
+             * Reader only: segments emptied before the last epoch change,
+             * which are released when the previous epoch has no writers.
+             */
+            Segment* _draining;
+            /**
+             * Reader only: the number of segments in _retired and _draining.
+             */
+            int _nretired;
+            /**
+             * One recycled segment, ready for use by a writer.
+             */
+            Segment* volatile _spare;
+
+            volatile int _capacity;
+            os::AtomicInt _count;
+            /**
+             * The epoch new writers register in, 0 or 1.
+             */
+            volatile int _epoch;
+            /**
+             * The number of writers inside enqueue(), per epoch.
+             */
+            os::AtomicInt _writers[2];
+
+            CachePtrType slots(Segment* s) const
+            {
+                return reinterpret_cast<CachePtrType>(s + 1);
+            }
+
+            Segment* newSegment()
+            {
+                void* mem = oro_rt_malloc( sizeof(Segment) + _segsize * sizeof(C) );
+                if ( !mem )
+                    return 0;
+                Segment* s = new (mem) Segment();
+                for (int i = 0; i != _segsize; ++i)
+                    slots(s)[i] = 0;
+                reset(s);
+                return s;
+            }
+
+            void deleteSegment(Segment* s)
+            {
+                s->~Segment();
+                oro_rt_free( s );
+            }
+
+            void reset(Segment* s)
+            {
+                s->claimed = 0;
+                s->next = 0;
+                s->read = 0;
+                s->retired = 0;
+            }
+
+            /**
+             * Writer side: take the spare segment or allocate a new one.
+             */
+            Segment* acquireSegment()
+            {
+                Segment* s = _spare;
+                if ( s && os::CAS(&_spare, s, (Segment*)0) )
+                    return s;
+                return newSegment();
+            }
+
+            /**
+             * Store an unused segment as spare or free it.
+             */
+            void releaseSegment(Segment* s)
+            {
+                reset(s);
+                if ( !os::CAS(&_spare, (Segment*)0, s) )
+                    deleteSegment(s);
+            }
+
+            /**
+             * Writer side: register in the current epoch.
+             * @return the epoch to pass to leave().
+             */
+            int enter()
+            {
+                for (;;) {
+                    int e = _epoch;
+                    _writers[e].inc();
+                    // the reader may have switched epochs before it could
+                    // see our registration: retry in the new epoch.
+                    if ( _epoch == e )
+                        return e;
+                    _writers[e].dec();
+                }
+            }
+
+            void leave(int e)
+            {
+                _writers[e].dec();
+            }
+
+            /**
+             * Reader side: release the retired segments once
+             * no writer can hold a pointer to them any more.
+             * A writer only reaches a segment through _tail, which
+             * was moved past all retired segments before they were retired.
+             * So only writers which entered before the epoch change
+             * can still access the draining segments.
+             */
+            void reclaim()
+            {
+                if ( _draining ) {
+                    if ( _writers[1 - _epoch].read() != 0 )
+                        return;
+                    while ( _draining ) {
+                        Segment* s = _draining;
+                        _draining = s->retired;
+                        releaseSegment(s);
+                        --_nretired;
+                    }
+                }
+                if ( _retired ) {
+                    _draining = _retired;
+                    _retired = 0;
+                    // the CAS orders the switch before reading _writers.
+                    int e = _epoch;
+                    os::CAS(&_epoch, e, 1 - e);
+                }
+            }
+
+            void deleteList(Segment* s)
+            {
+                while ( s ) {
+                    Segment* n = s->retired;
+                    deleteSegment(s);
+                    s = n;
+                }
+            }
+
+            // non-copyable !
+            AtomicSegmentedMWSRQueue(const AtomicSegmentedMWSRQueue<T>&);
+        public:
+            typedef unsigned int size_type;
+
+            /**
+             * Create an AtomicSegmentedMWSRQueue.
+             * @param segsize The number of elements in a segment, should be 1 or greater.
+             * @param capacity The maximum number of elements in the queue.
+             * @throw std::bad_alloc if the first segment could not be allocated.
+             */
+            AtomicSegmentedMWSRQueue(unsigned int segsize, unsigned int capacity)
+                : _segsize(segsize ? segsize : 1), _tail(0), _head(0), _retired(0), _draining(0),
+                  _nretired(0), _spare(0), _capacity(capacity), _count(0), _epoch(0)
+            {
+                _head = newSegment();
+                if ( !_head )
+                    throw std::bad_alloc();
+                _tail = _head;
+            }
+
+            ~AtomicSegmentedMWSRQueue()
+            {
+                while ( _head ) {
+                    Segment* s = _head;
+                    _head = s->next;
+                    deleteSegment(s);
+                }
+                deleteList(_retired);
+                deleteList(_draining);
+                if ( _spare )
+                    deleteSegment(_spare);
+            }
+
+            /**
+             * Inspect if the Queue is full.
+             * @return true if full, false otherwise.
+             */
+            bool isFull() const
+            {
+                return size() >= capacity();
+            }
+
+            /**
+             * Inspect if the Queue is empty.
+             * @return true if empty, false otherwise.
+             */
+            bool isEmpty() const
+            {
+                return size() == 0;
+            }
+
+            /**
+             * Return the maximum number of items this queue can contain.
+             */
+            size_type capacity() const
+            {
+                return _capacity;
+            }
+
+            /**
+             * Change the maximum number of items this queue can contain.
+             * This may be called concurrently with enqueue() and dequeue().
+             * Lowering the capacity below size() only rejects new items.
+             */
+            void setCapacity(size_type capacity)
+            {
+                _capacity = capacity;
+            }
+
+            /**
+             * Return the number of elements stored per segment.
+             */
+            size_type segmentSize() const
+            {
+                return _segsize;
+            }
+
+            /**
+             * Return the number of emptied segments which are not
+             * recycled yet, because a writer might still access them.
+             * Only the reader thread may call this.
+             */
+            size_type retiredSegments() const
+            {
+                return _nretired;
+            }
+
+            /**
+             * Return the number of elements in the queue.
+             * This includes elements which are being enqueued.
+             */
+            size_type size() const
+            {
+                int c = const_cast<os::AtomicInt&>(_count).read();
+                return c > 0 ? c : 0;
+            }
+
+            /**
+             * Enqueue an item.
+             * @param value The value to enqueue.
+             * @return false if queue is full or no segment could be
+             * allocated, true if queued.
+             */
+            bool enqueue(const T& value)
+            {
+                if (value == 0)
+                    return false;
+                _count.inc();
+                if ( _count.read() > _capacity ) {
+                    _count.dec();
+                    return false;
+                }
+                int epoch = enter();
+                for (;;) {
+                    Segment* seg = _tail;
+                    int i = seg->claimed;
+                    if ( i < _segsize ) {
+                        if ( os::CAS(&seg->claimed, i, i + 1) ) {
+                            slots(seg)[i] = value;
+                            break;
+                        }
+                        continue;
+                    }
+                    // segment is full: link a next one and move the tail.
+                    Segment* next = seg->next;
+                    if ( next == 0 ) {
+                        next = acquireSegment();
+                        if ( next == 0 ) {
+                            leave(epoch);
+                            _count.dec();
+                            return false;
+                        }
+                        if ( !os::CAS(&seg->next, (Segment*)0, next) ) {
+                            releaseSegment(next);
+                            next = seg->next;
+                        }
+                    }
+                    os::CAS(&_tail, seg, next);
+                }
+                leave(epoch);
+                return true;
+            }
+
+            /**
+             * Dequeue an item.
+             * Only one thread may call this.
+             * @param result The value dequeued.
+             * @return false if queue is empty, true if dequeued.
+             */
+            bool dequeue(T& result)
+            {
+                for (;;) {
+                    Segment* seg = _head;
+                    if ( seg->read < _segsize ) {
+                        T value = slots(seg)[seg->read];
+                        // empty, or the writer did not store it yet.
+                        if ( value == 0 ) {
+                            reclaim();
+                            return false;
+                        }
+                        slots(seg)[seg->read] = 0;
+                        ++seg->read;
+                        _count.dec();
+                        result = value;
+                        return true;
+                    }
+                    // all slots of seg were read: continue in the next one.
+                    Segment* next = seg->next;
+                    if ( next == 0 ) {
+                        reclaim();
+                        return false;
+                    }
+                    os::CAS(&_tail, seg, next);
+                    _head = next;
+                    seg->retired = _retired;
+                    _retired = seg;
+                    ++_nretired;
+                    reclaim();
+                }
+            }
+
+            /**
+             * Clear all contents of the Queue and thus make it empty.
+             * Only the reader thread may call this.
+             */
+            void clear()
+            {
+                T result;
+                while ( dequeue(result) )
+                    ;
+            }
+        };
+
+    }
+}
+
+#endif
@@ -76,6 +76,18 @@ namespace RTT { namespace internal {
             return true;
         }
 
+        /** Appends a batch of samples at the end of the FIFO, with only one
+         * signal to the reader.
+         *
+         * @return true, also if not all samples fitted in the FIFO.
+         */
+        virtual bool writeBatch(std::vector<T> const& samples)
+        {
+            if (buffer->Push(samples) > 0)
+                return this->signal();
+            return true;
+        }
+
         /** Pops and returns the first element of the FIFO
          *
          * @return false if the FIFO was empty, and true otherwise
@@ -99,6 +111,33 @@ namespace RTT { namespace internal {
             return NoData;
         }
 
+        /** Pops all elements of the FIFO at once.
+         *
+         * @return NewData if \a samples is not empty, OldData or NoData otherwise
+         */
+        virtual FlowStatus readBatch(std::vector<T>& samples)
+        {
+            // hold on to one element of the buffer for later OldData reads.
+            value_t *first_sample_p = last_sample_p ? 0 : buffer->PopWithoutRelease();
+            if (first_sample_p) {
+                // only happens on the first read: the held element goes
+                // in front, followed by the remaining elements in order.
+                samples.clear();
+                samples.reserve( buffer->size() + 1 );
+                samples.push_back( *first_sample_p );
+                value_t sample;
+                while ( buffer->Pop(sample) )
+                    samples.push_back( sample );
+                last_sample_p = first_sample_p;
+            } else
+                buffer->Pop(samples);
+            if (samples.empty())
+                return last_sample_p ? OldData : NoData;
+            if (last_sample_p)
+                *last_sample_p = samples.back();
+            return NewData;
+        }
+
         /** Removes all elements in the FIFO. After a call to clear(), read()
          * will always return false (provided write() has not been called in the
          * meantime).
@@ -0,0 +1,130 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef ORO_CHANNEL_QOS_ELEMENT_HPP
+#define ORO_CHANNEL_QOS_ELEMENT_HPP
+
+#include "../base/ChannelElement.hpp"
+#include "../ConnPolicy.hpp"
+#include "../os/TimeService.hpp"
+
+namespace RTT { namespace internal {
+
+    /** A connection element on the writer side which only forwards
+     * the samples that the ConnPolicy::decimation, ConnPolicy::min_period
+     * and ConnPolicy::coalesce settings let through. The other samples
+     * are dropped before they reach the data storage or the transport,
+     * so they are never copied nor marshalled.
+     */
+    template<typename T>
+    class ChannelQosElement : public base::ChannelElement<T>
+    {
+        /** Forward one out of this many samples. */
+        int mdecimation;
+        /** The number of samples since the last one that was due. */
+        int mcount;
+        /** The least number of ticks between two forwarded samples. */
+        os::TimeService::ticks mmin_period;
+        /** When the last sample was forwarded, if mforwarded is set. */
+        os::TimeService::ticks mlast;
+        bool mforwarded;
+        bool mcoalesce;
+
+    public:
+        typedef typename base::ChannelElement<T>::param_t param_t;
+
+        ChannelQosElement(ConnPolicy const& policy)
+            : mdecimation(policy.decimation > 1 ? policy.decimation : 1), mcount(0),
+              mmin_period( os::TimeService::nsecs2ticks( os::TimeService::nsecs(policy.min_period * 1e9) ) ),
+              mlast(0), mforwarded(false), mcoalesce(policy.coalesce) {}
+
+        /** Returns true if \a policy asks for samples to be dropped
+         * on the writer side, such that a ChannelQosElement is needed.
+         */
+        static bool isNeeded(ConnPolicy const& policy)
+        {
+            return policy.decimation > 1 || policy.min_period > 0 || policy.coalesce;
+        }
+
+        /** Forwards \a sample if it is due, drops it otherwise.
+         * It always returns true when a sample is dropped. */
+        virtual bool write(param_t sample)
+        {
+            if ( !due(1) )
+                return true;
+            return base::ChannelElement<T>::write(sample);
+        }
+
+        /** Forwards \a sample if it is due, without copying it. */
+        virtual bool writeShared(typename base::ChannelElement<T>::shared_sample_t const& sample)
+        {
+            if ( !due(1) )
+                return true;
+            typename base::ChannelElement<T>::shared_ptr output = this->getOutput();
+            if (output)
+                return output->writeShared(sample);
+            return false;
+        }
+
+        /** Forwards the due samples one by one, or, if the policy
+         * coalesces samples, only the latest sample of the batch if
+         * any of them is due. */
+        virtual bool writeBatch(std::vector<T> const& samples)
+        {
+            if ( !mcoalesce )
+                return base::ChannelElement<T>::writeBatch(samples);
+            if ( samples.empty() || !due( samples.size() ) )
+                return true;
+            return base::ChannelElement<T>::write( samples.back() );
+        }
+
+    private:
+        /** Counts \a samples new samples and returns true if one of them
+         * is due according to the decimation, and if at least the
+         * minimum period passed since the last forwarded sample. */
+        bool due(int samples)
+        {
+            // sample mcount is due, and every mdecimation samples after it.
+            bool decimated = mcount + samples <= mdecimation && mcount != 0;
+            mcount = (mcount + samples) % mdecimation;
+            if ( decimated )
+                return false;
+            if ( mmin_period > 0 ) {
+                os::TimeService::ticks now = os::TimeService::Instance()->getTicks();
+                if ( mforwarded && now - mlast < mmin_period )
+                    return false;
+                mlast = now;
+                mforwarded = true;
+            }
+            return true;
+        }
+    };
+}}
+
+#endif
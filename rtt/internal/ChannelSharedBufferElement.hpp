@@ -0,0 +1,137 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef ORO_CHANNEL_SHARED_BUFFER_ELEMENT_HPP
+#define ORO_CHANNEL_SHARED_BUFFER_ELEMENT_HPP
+
+#include "../base/ChannelElement.hpp"
+#include "../base/BufferInterface.hpp"
+
+namespace RTT { namespace internal {
+
+    /** A connection element that can store a fixed number of shared data samples.
+     * Samples written with writeShared() are queued and handed out to
+     * readShared() without copying them. A plain write() allocates
+     * a new shared sample and is therefore not real-time.
+     */
+    template<typename T>
+    class ChannelSharedBufferElement : public base::ChannelElement<T>
+    {
+    public:
+        typedef typename base::ChannelElement<T>::param_t param_t;
+        typedef typename base::ChannelElement<T>::reference_t reference_t;
+        typedef typename base::ChannelElement<T>::shared_sample_t shared_sample_t;
+
+    private:
+        typename base::BufferInterface<shared_sample_t>::shared_ptr buffer;
+        shared_sample_t last_sample;
+        bool has_last_sample;
+
+    public:
+        ChannelSharedBufferElement(typename base::BufferInterface<shared_sample_t>::shared_ptr buffer)
+            : buffer(buffer), has_last_sample(false) {}
+
+        /** Appends a copy of \a sample at the end of the FIFO. This allocates memory.
+         */
+        virtual bool write(param_t sample)
+        {
+            return writeShared( shared_sample_t( new T(sample) ) );
+        }
+
+        /** Appends a shared sample at the end of the FIFO
+         *
+         * @return true if there was room in the FIFO for the new sample, and false otherwise.
+         */
+        virtual bool writeShared(shared_sample_t const& sample)
+        {
+            if (buffer->Push(sample))
+                return this->signal();
+            return true;
+        }
+
+        /** Pops the first element of the FIFO and copies it into \a sample.
+         */
+        virtual FlowStatus read(reference_t sample, bool copy_old_data)
+        {
+            if ( buffer->Pop(last_sample) ) {
+                has_last_sample = true;
+                sample = *last_sample;
+                return NewData;
+            }
+            if (has_last_sample) {
+                if(copy_old_data)
+                    sample = *last_sample;
+                return OldData;
+            }
+            return NoData;
+        }
+
+        /** Pops the first element of the FIFO and returns it without copying.
+         */
+        virtual FlowStatus readShared(shared_sample_t& sample, bool copy_old_data)
+        {
+            if ( buffer->Pop(last_sample) ) {
+                has_last_sample = true;
+                sample = last_sample;
+                return NewData;
+            }
+            if (has_last_sample) {
+                if(copy_old_data)
+                    sample = last_sample;
+                return OldData;
+            }
+            return NoData;
+        }
+
+        /** Removes all elements in the FIFO. After a call to clear(), read()
+         * will always return false (provided write() has not been called in the
+         * meantime).
+         */
+        virtual void clear()
+        {
+            has_last_sample = false;
+            buffer->clear();
+            base::ChannelElement<T>::clear();
+        }
+
+        virtual bool data_sample(param_t sample)
+        {
+            buffer->data_sample( shared_sample_t( new T(sample) ) );
+            return base::ChannelElement<T>::data_sample(sample);
+        }
+
+        virtual T data_sample()
+        {
+            shared_sample_t sample = buffer->data_sample();
+            return sample.valid() ? *sample : T();
+        }
+    };
+}}
+
+#endif
@@ -0,0 +1,150 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef ORO_CHANNEL_SHARED_DATA_ELEMENT_HPP
+#define ORO_CHANNEL_SHARED_DATA_ELEMENT_HPP
+
+#include "../base/ChannelElement.hpp"
+#include "../base/DataObjectInterface.hpp"
+
+namespace RTT { namespace internal {
+
+    /** A connection element that stores a single shared data sample.
+     * Samples written with writeShared() are stored and handed out to
+     * readShared() without copying them. A plain write() allocates
+     * a new shared sample and is therefore not real-time.
+     */
+    template<typename T>
+    class ChannelSharedDataElement : public base::ChannelElement<T>
+    {
+    public:
+        typedef typename base::ChannelElement<T>::param_t param_t;
+        typedef typename base::ChannelElement<T>::reference_t reference_t;
+        typedef typename base::ChannelElement<T>::shared_sample_t shared_sample_t;
+
+    private:
+        bool written, mread;
+        typename base::DataObjectInterface<shared_sample_t>::shared_ptr data;
+
+    public:
+        ChannelSharedDataElement(typename base::DataObjectInterface<shared_sample_t>::shared_ptr sample)
+            : written(false), mread(false), data(sample) {}
+
+        /** Stores a copy of \a sample. This allocates memory. */
+        virtual bool write(param_t sample)
+        {
+            return writeShared( shared_sample_t( new T(sample) ) );
+        }
+
+        /** Only the last sample of a batch is kept, so only
+         * that one is copied. */
+        virtual bool writeBatch(std::vector<T> const& samples)
+        {
+            if ( samples.empty() )
+                return true;
+            return write( samples.back() );
+        }
+
+        /** Update the shared sample stored in this element.
+         * It always returns true. */
+        virtual bool writeShared(shared_sample_t const& sample)
+        {
+            data->Set(sample);
+            written = true;
+            mread = false;
+            return this->signal();
+        }
+
+        /** Copies the last sample given to write() or writeShared() into \a sample.
+         */
+        virtual FlowStatus read(reference_t sample, bool copy_old_data)
+        {
+            if (written)
+            {
+                if ( !mread ) {
+                    sample = *data->Get();
+                    mread = true;
+                    return NewData;
+                }
+
+                if(copy_old_data)
+                    sample = *data->Get();
+
+                return OldData;
+            }
+            return NoData;
+        }
+
+        /** Returns the last sample given to write() or writeShared(), without
+         * copying it.
+         */
+        virtual FlowStatus readShared(shared_sample_t& sample, bool copy_old_data)
+        {
+            if (written)
+            {
+                if ( !mread ) {
+                    data->Get(sample);
+                    mread = true;
+                    return NewData;
+                }
+
+                if(copy_old_data)
+                    data->Get(sample);
+
+                return OldData;
+            }
+            return NoData;
+        }
+
+        /** Resets the stored sample. After clear() has been called, read()
+         * returns false
+         */
+        virtual void clear()
+        {
+            written = false;
+            mread = false;
+            base::ChannelElement<T>::clear();
+        }
+
+        virtual bool data_sample(param_t sample)
+        {
+            data->data_sample( shared_sample_t( new T(sample) ) );
+            return base::ChannelElement<T>::data_sample(sample);
+        }
+
+        virtual T data_sample()
+        {
+            shared_sample_t sample = data->Get();
+            return sample.valid() ? *sample : T();
+        }
+
+    };
+}}
+
+#endif
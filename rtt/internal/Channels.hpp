@@ -41,6 +41,9 @@
 
 #include "ChannelDataElement.hpp"
 #include "ChannelBufferElement.hpp"
+#include "ChannelSharedDataElement.hpp"
+#include "ChannelSharedBufferElement.hpp"
+#include "ChannelQosElement.hpp"
 
 #endif
 
@@ -143,7 +143,7 @@ bool ConnFactory::createAndCheckStream(base::OutputPortInterface& output_port, C
         log(Error) << "Transport failed to create remote channel for output stream of port "<<output_port.getName() << endlog();
         return false;
     }
-    chan->setOutput( chan_stream );
+    chan->getOutputEndPoint()->setOutput( chan_stream );
 
     if ( output_port.addConnection( new StreamConnID(policy.name_id), chan, policy) ) {
         log(Info) << "Created output stream for output port "<< output_port.getName() <<endlog();
@@ -138,6 +138,8 @@ namespace RTT
         template<typename T>
         static base::ChannelElementBase* buildDataStorage(ConnPolicy const& policy, const T& initial_value = T())
         {
+            if (policy.shared)
+                return buildSharedDataStorage<T>(policy, initial_value);
             if (policy.type == ConnPolicy::DATA)
             {
                 typename base::DataObjectInterface<T>::shared_ptr data_object;
@@ -147,8 +149,12 @@ namespace RTT
                 case ConnPolicy::LOCK_FREE:
                     data_object.reset( new base::DataObjectLockFree<T>(initial_value) );
                     break;
+                case ConnPolicy::LOCK_FREE_SPSC:
+                    data_object.reset( new base::DataObjectLockFreeSPSC<T>(initial_value) );
+                    break;
 #else
 		case ConnPolicy::LOCK_FREE:
+		case ConnPolicy::LOCK_FREE_SPSC:
 		    RTT::log(Warning) << "lock free connection policy is unavailable on this system, defaulting to LOCKED" << RTT::endlog();
 #endif
                 case ConnPolicy::LOCKED:
@@ -168,11 +174,18 @@ namespace RTT
                 switch (policy.lock_policy)
                 {
 #ifndef OROBLD_OS_NO_ASM
+                case ConnPolicy::LOCK_FREE_SPSC:
+                    if (policy.type == ConnPolicy::BUFFER) {
+                        buffer_object = new base::BufferLockFreeSPSC<T>(policy.size, initial_value);
+                        break;
+                    }
+                    // a circular buffer must drop old samples from the writer side: use LOCK_FREE.
                 case ConnPolicy::LOCK_FREE:
                     buffer_object = new base::BufferLockFree<T>(policy.size, initial_value, policy.type == ConnPolicy::CIRCULAR_BUFFER);
                     break;
 #else
 		case ConnPolicy::LOCK_FREE:
+		case ConnPolicy::LOCK_FREE_SPSC:
 		    RTT::log(Warning) << "lock free connection policy is unavailable on this system, defaulting to LOCKED" << RTT::endlog();
 #endif
                 case ConnPolicy::LOCKED:
@@ -187,6 +200,74 @@ namespace RTT
             return NULL;
         }
 
+        /** This method creates the connection element that will store shared
+         * samples inside the connection, based on the given policy.
+         * @see ConnPolicy::shared
+         */
+        template<typename T>
+        static base::ChannelElementBase* buildSharedDataStorage(ConnPolicy const& policy, const T& initial_value = T())
+        {
+            typedef typename base::ChannelElement<T>::shared_sample_t shared_sample_t;
+            shared_sample_t initial_sample( new T(initial_value) );
+            if (policy.type == ConnPolicy::DATA)
+            {
+                typename base::DataObjectInterface<shared_sample_t>::shared_ptr data_object;
+                switch (policy.lock_policy)
+                {
+#ifndef OROBLD_OS_NO_ASM
+                case ConnPolicy::LOCK_FREE:
+                    data_object.reset( new base::DataObjectLockFree<shared_sample_t>(initial_sample) );
+                    break;
+                case ConnPolicy::LOCK_FREE_SPSC:
+                    data_object.reset( new base::DataObjectLockFreeSPSC<shared_sample_t>(initial_sample) );
+                    break;
+#else
+		case ConnPolicy::LOCK_FREE:
+		case ConnPolicy::LOCK_FREE_SPSC:
+		    RTT::log(Warning) << "lock free connection policy is unavailable on this system, defaulting to LOCKED" << RTT::endlog();
+#endif
+                case ConnPolicy::LOCKED:
+                    data_object.reset( new base::DataObjectLocked<shared_sample_t>(initial_sample) );
+                    break;
+                case ConnPolicy::UNSYNC:
+                    data_object.reset( new base::DataObjectUnSync<shared_sample_t>(initial_sample) );
+                    break;
+                }
+
+                return new ChannelSharedDataElement<T>(data_object);
+            }
+            else if (policy.type == ConnPolicy::BUFFER || policy.type == ConnPolicy::CIRCULAR_BUFFER)
+            {
+                base::BufferInterface<shared_sample_t>* buffer_object = 0;
+                switch (policy.lock_policy)
+                {
+#ifndef OROBLD_OS_NO_ASM
+                case ConnPolicy::LOCK_FREE_SPSC:
+                    if (policy.type == ConnPolicy::BUFFER) {
+                        buffer_object = new base::BufferLockFreeSPSC<shared_sample_t>(policy.size, initial_sample);
+                        break;
+                    }
+                    // a circular buffer must drop old samples from the writer side: use LOCK_FREE.
+                case ConnPolicy::LOCK_FREE:
+                    buffer_object = new base::BufferLockFree<shared_sample_t>(policy.size, initial_sample, policy.type == ConnPolicy::CIRCULAR_BUFFER);
+                    break;
+#else
+		case ConnPolicy::LOCK_FREE:
+		case ConnPolicy::LOCK_FREE_SPSC:
+		    RTT::log(Warning) << "lock free connection policy is unavailable on this system, defaulting to LOCKED" << RTT::endlog();
+#endif
+                case ConnPolicy::LOCKED:
+                    buffer_object = new base::BufferLocked<shared_sample_t>(policy.size, initial_sample, policy.type == ConnPolicy::CIRCULAR_BUFFER);
+                    break;
+                case ConnPolicy::UNSYNC:
+                    buffer_object = new base::BufferUnSync<shared_sample_t>(policy.size, initial_sample, policy.type == ConnPolicy::CIRCULAR_BUFFER);
+                    break;
+                }
+                return new ChannelSharedBufferElement<T>(typename base::BufferInterface<shared_sample_t>::shared_ptr(buffer_object));
+            }
+            return NULL;
+        }
+
         /** During the process of building a connection between two ports, this
          * method builds the input half (starting from the OutputPort).
          *
@@ -227,6 +308,25 @@ namespace RTT
             return endpoint;
         }
 
+        /**
+         * Puts a ChannelQosElement in front of \a output_channel if the
+         * \a policy decimates, rate limits or coalesces the samples, such
+         * that the dropped samples never reach the storage or transport.
+         * @param output_channel Optional. The element that receives the
+         * forwarded samples.
+         * @return the ChannelQosElement, or \a output_channel if none is needed.
+         */
+        template<typename T>
+        static base::ChannelElementBase::shared_ptr buildChannelQos(ConnPolicy const& policy, base::ChannelElementBase::shared_ptr output_channel)
+        {
+            if ( !ChannelQosElement<T>::isNeeded(policy) )
+                return output_channel;
+            base::ChannelElementBase::shared_ptr qos = new ChannelQosElement<T>(policy);
+            if (output_channel)
+                qos->setOutput(output_channel);
+            return qos;
+        }
+
         /** During the process of building a connection between two ports, this
          * method builds the output part of the channel, that is the half that
          * is connected to the input port. The returned value is the connection
@@ -311,7 +411,7 @@ namespace RTT
             // Since output is local, buildChannelInput is local as well.
             // This this the input channel element of the whole connection
             base::ChannelElementBase::shared_ptr channel_input =
-                buildChannelInput<T>(output_port, input_port.getPortID(), output_half);
+                buildChannelInput<T>(output_port, input_port.getPortID(), buildChannelQos<T>(policy, output_half));
 
             return createAndCheckConnection(output_port, input_port, channel_input, policy );
         }
@@ -327,7 +427,7 @@ namespace RTT
         static bool createStream(OutputPort<T>& output_port, ConnPolicy const& policy)
         {
             StreamConnID *sid = new StreamConnID(policy.name_id);
-            RTT::base::ChannelElementBase::shared_ptr chan = buildChannelInput( output_port, sid, base::ChannelElementBase::shared_ptr() );
+            RTT::base::ChannelElementBase::shared_ptr chan = buildChannelInput( output_port, sid, buildChannelQos<T>(policy, base::ChannelElementBase::shared_ptr()) );
             return createAndCheckStream(output_port, policy, chan, sid);
         }
 
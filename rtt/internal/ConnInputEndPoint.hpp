@@ -75,6 +75,26 @@ namespace RTT
             return true;
         }
 
+        /** Forwards a shared sample, such that it is not copied
+         * before it reaches the data storage element. */
+        virtual bool writeShared(typename base::ChannelElement<T>::shared_sample_t const& sample)
+        {
+            typename base::ChannelElement<T>::shared_ptr output = this->getOutput();
+            if (output)
+                return output->writeShared(sample);
+            return false;
+        }
+
+        /** Forwards a batch of samples, such that the data storage
+         * element can store them at once. */
+        virtual bool writeBatch(std::vector<T> const& samples)
+        {
+            typename base::ChannelElement<T>::shared_ptr output = this->getOutput();
+            if (output)
+                return output->writeBatch(samples);
+            return false;
+        }
+
         virtual void disconnect(bool forward)
         {
             // Call the base class first
@@ -97,6 +97,27 @@ namespace RTT
         virtual bool write(typename base::ChannelElement<T>::param_t sample)
         { return false; }
 
+        /** Forwards the request for a shared sample to the data storage
+         * element, such that it is not copied. */
+        virtual FlowStatus readShared(typename base::ChannelElement<T>::shared_sample_t& sample, bool copy_old_data)
+        {
+            typename base::ChannelElement<T>::shared_ptr input = this->getInput();
+            if (input)
+                return input->readShared(sample, copy_old_data);
+            return NoData;
+        }
+
+        /** Forwards the request for a batch of samples to the data
+         * storage element, such that it can return them at once. */
+        virtual FlowStatus readBatch(std::vector<T>& samples)
+        {
+            typename base::ChannelElement<T>::shared_ptr input = this->getInput();
+            if (input)
+                return input->readBatch(samples);
+            samples.clear();
+            return NoData;
+        }
+
         virtual void disconnect(bool forward)
         {
             // Call the base class: it does the common cleanup
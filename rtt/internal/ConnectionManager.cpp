@@ -59,7 +59,7 @@ namespace RTT
     {
 
         ConnectionManager::ConnectionManager(PortInterface* port)
-            : mport(port)
+            : mport(port), connections(0), cur_channel(0)
         {
         }
 
@@ -76,9 +76,31 @@ namespace RTT
             descriptor.get<1>()->clear();
         }
 
+        /**
+         * Helper function to test if a descriptor holds \a channel.
+         */
+        static bool isSameChannel(ChannelElementBase* channel, ConnectionManager::ChannelDescriptor const& descriptor) {
+            return descriptor.get<1>().get() == channel;
+        }
+
+        /**
+         * Helper function to copy a descriptor into a std::list.
+         */
+        static void copyChannel(std::list<ConnectionManager::ChannelDescriptor>* result, ConnectionManager::ChannelDescriptor const& descriptor) {
+            result->push_back(descriptor);
+        }
+
+        /**
+         * Helper function to find \a channel, or the first channel if \a channel is null.
+         */
+        static void lookupChannel(ChannelElementBase* channel, ChannelElementBase::shared_ptr* result, ConnectionManager::ChannelDescriptor const& descriptor) {
+            if ( !*result && (channel == 0 || descriptor.get<1>().get() == channel) )
+                *result = descriptor.get<1>();
+        }
+
         void ConnectionManager::clear()
-        { RTT::os::MutexLock lock(connection_lock);
-            std::for_each(connections.begin(), connections.end(), &clearChannel);
+        {
+            connections.apply( &clearChannel );
         }
 
         bool ConnectionManager::findMatchingPort(ConnID const* conn_id, ChannelDescriptor const& descriptor)
@@ -88,10 +110,27 @@ namespace RTT
 
         void ConnectionManager::updateCurrentChannel(bool reset_current)
         {
-            if (connections.empty())
-                cur_channel = ChannelDescriptor();
-            else if (reset_current)
-                cur_channel = connections.front();
+            if (!reset_current)
+                return;
+            ChannelElementBase::shared_ptr first;
+            connections.apply( boost::bind(&lookupChannel, (ChannelElementBase*)0, &first, _1) );
+            cur_channel = first.get();
+        }
+
+        ChannelElementBase::shared_ptr ConnectionManager::getCurrentChannel() const
+        {
+            ChannelElementBase::shared_ptr result;
+            ChannelElementBase* current = cur_channel;
+            if (current)
+                connections.apply( boost::bind(&lookupChannel, current, &result, _1) );
+            return result;
+        }
+
+        std::list<ConnectionManager::ChannelDescriptor> ConnectionManager::getChannels() const
+        {
+            std::list<ChannelDescriptor> result;
+            connections.apply( boost::bind(&copyChannel, &result, _1) );
+            return result;
         }
 
         bool ConnectionManager::disconnect(PortInterface* port)
@@ -115,8 +154,11 @@ namespace RTT
         {
             std::list<ChannelDescriptor> all_connections;
             { RTT::os::MutexLock lock(connection_lock);
-                all_connections.splice(all_connections.end(), connections);
-                cur_channel = ChannelDescriptor();
+                connections.apply( boost::bind(&copyChannel, &all_connections, _1) );
+                connections.clear();
+                connections.shrink( all_connections.size() );
+                connections.clear_unused();
+                cur_channel = 0;
             }
             std::for_each(all_connections.begin(), all_connections.end(),
                     boost::bind(&ConnectionManager::eraseConnection, this, _1));
@@ -130,22 +172,25 @@ namespace RTT
         { RTT::os::MutexLock lock(connection_lock);
             assert(conn_id);
             ChannelDescriptor descriptor = boost::make_tuple(conn_id, channel, policy);
-            if (connections.empty())
-                cur_channel = descriptor;
-            connections.push_back(descriptor);
+            // grow() is not real-time, but only the connection_lock holder modifies the list.
+            connections.grow();
+            bool was_empty = connections.empty();
+            connections.append(descriptor);
+            if (was_empty)
+                cur_channel = channel.get();
         }
 
         bool ConnectionManager::removeConnection(ConnID* conn_id)
         {
             ChannelDescriptor descriptor;
             { RTT::os::MutexLock lock(connection_lock);
-                std::list<ChannelDescriptor>::iterator conn_it =
-                    std::find_if(connections.begin(), connections.end(), boost::bind(&ConnectionManager::findMatchingPort, this, conn_id, _1));
-                if (conn_it == connections.end())
+                descriptor = connections.find_if( boost::bind(&ConnectionManager::findMatchingPort, this, conn_id, _1) );
+                if ( !descriptor.get<1>() )
                     return false;
-                descriptor = *conn_it;
-                connections.erase(conn_it);
-                updateCurrentChannel( cur_channel.get<1>() == descriptor.get<1>() );
+                connections.delete_if( boost::bind(&isSameChannel, descriptor.get<1>().get(), _1) );
+                connections.shrink();
+                connections.clear_unused();
+                updateCurrentChannel( cur_channel == descriptor.get<1>().get() );
             }
 
             // disconnect needs to know if we're from Out->In (forward) or from In->Out
@@ -157,6 +202,16 @@ namespace RTT
             return true;
         }
 
+        bool ConnectionManager::removeChannel(ChannelElementBase* channel)
+        { RTT::os::MutexLock lock(connection_lock);
+            if ( !connections.delete_if( boost::bind(&isSameChannel, channel, _1) ) )
+                return false;
+            connections.shrink();
+            connections.clear_unused();
+            updateCurrentChannel( cur_channel == channel );
+            return true;
+        }
+
         bool is_same_id(ConnID* conn_id, ConnectionManager::ChannelDescriptor const& channel)
         {
             return conn_id->isSameID( *channel.get<0>() );
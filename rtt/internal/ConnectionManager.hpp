@@ -61,6 +61,7 @@
 #include <rtt/os/Mutex.hpp>
 #include <rtt/os/MutexLock.hpp>
 #include <list>
+#include <vector>
 
 
 namespace RTT
@@ -72,7 +73,26 @@ namespace RTT
          * Manages connections between ports.
          * This class is used for input and output ports
          * in order to manage their channels.
-         * TODO: use the mutex lock !!!
+         *
+         * The connections are stored in a lock-free list, such that
+         * the data flow path (write() and read() of a port) never needs
+         * to take a lock. Adding and removing connections happens by
+         * copy-on-write of that list and is serialized by connection_lock.
+         *
+         * Threading contract:
+         * - addConnection(), removeConnection() and disconnect() may be
+         *   called from any thread and are not real-time.
+         * - delete_if() (the write path) may be called concurrently from
+         *   several threads. Channels with a ConnPolicy::UNSYNC or
+         *   ConnPolicy::LOCK_FREE_SPSC lock policy accept only one writer
+         *   at a time, so writes to these channels are serialized by
+         *   write_lock. Writes to other channels do not take a lock.
+         * - find_if() and select_reader_channel() (the read path) do
+         *   not take a lock and expect one reader thread per port.
+         * - A removed channel is released before removeConnection()
+         *   or disconnect() returns, unless a concurrent reader or
+         *   writer still holds it. In that case, it is released by
+         *   the next connection change.
          */
         class RTT_API ConnectionManager
         {
@@ -115,21 +135,24 @@ namespace RTT
             /** Removes the channel that connects this port to \c port */
             bool disconnect(base::PortInterface* port);
 
+            /**
+             * Applies \a pred to all connections and removes those for
+             * which \a pred returns true.
+             * \a pred is called exactly once for each connection, without
+             * taking a lock, except for connections which only accept one
+             * writer at a time. Only if a connection must be removed,
+             * the connection list is modified, which is not real-time.
+             * @return true if at least one connection was removed.
+             */
             template<typename Pred>
             bool delete_if(Pred pred) {
-                RTT::os::MutexLock lock(connection_lock);
-                bool result = false;
-                std::list<ChannelDescriptor>::iterator it = connections.begin();
-                while (it != connections.end())
-                {
-                    if (pred(*it))
-                    {
-                        result = true;
-                        it = connections.erase(it);
-                    }
-                    else ++it;
-                }
-                return result;
+                std::vector<base::ChannelElementBase::shared_ptr> failed;
+                connections.apply( DeleteIfHelper<Pred>(pred, failed, write_lock) );
+                if ( failed.empty() )
+                    return false;
+                for(std::vector<base::ChannelElementBase::shared_ptr>::iterator it = failed.begin(); it != failed.end(); ++it)
+                    removeChannel( it->get() );
+                return true;
             }
 
             /**
@@ -138,37 +161,38 @@ namespace RTT
              * the current channel ( getCurrentChannel() ), if that
              * does not satisfy pred, iterate over \b all connections.
              * If none satisfy pred, the current channel remains unchanged.
+             * This function does not take a lock.
              * @param pred
              */
             template<typename Pred>
             void select_reader_channel(Pred pred, bool copy_old_data) {
-                RTT::os::MutexLock lock(connection_lock);
-                std::pair<bool, ChannelDescriptor> new_channel =
-                    find_if(pred, copy_old_data);
-                if (new_channel.first)
+                base::ChannelElementBase* new_channel = find_if(pred, copy_old_data);
+                if (new_channel)
                 {
                     // We don't clear the current channel (to get it to NoData state), because there is a race
                     // between find_if and this line. We have to accept (in other parts of the code) that eventually,
                     // all channels return 'OldData'.
-                    cur_channel = new_channel.second;
+                    cur_channel = new_channel;
                 }
             }
 
+            /**
+             * Returns the first channel for which pred(copy_old_data, descriptor)
+             * returns true, starting with the current channel.
+             * @return the channel found or null if none satisfies pred.
+             */
             template<typename Pred>
-            std::pair<bool, ChannelDescriptor> find_if(Pred pred, bool copy_old_data) {
+            base::ChannelElementBase* find_if(Pred pred, bool copy_old_data) {
                 // We only copy OldData in the initial read of the current channel.
                 // if it has no new data, the search over the other channels starts,
                 // but no old data is needed.
-                ChannelDescriptor channel = cur_channel;
-                if ( channel.get<1>() )
-                    if ( pred( copy_old_data, channel ) )
-                        return std::make_pair(true, channel);
-
-                std::list<ChannelDescriptor>::iterator result;
-                for (result = connections.begin(); result != connections.end(); ++result)
-                    if ( pred(false, *result) == true)
-                        return std::make_pair(true, *result);
-                return std::make_pair(false, ChannelDescriptor());
+                base::ChannelElementBase* result = 0;
+                base::ChannelElementBase* current = cur_channel;
+                if ( current )
+                    connections.apply( FindIfHelper<Pred>(pred, result, current, copy_old_data, true) );
+                if ( !result )
+                    connections.apply( FindIfHelper<Pred>(pred, result, current, false, false) );
+                return result;
             }
 
             /**
@@ -182,16 +206,12 @@ namespace RTT
              * @see select_if to change the current channel.
              * @return
              */
-            base::ChannelElementBase* getCurrentChannel() const {
-                return cur_channel.get<1>().get();
-            }
+            base::ChannelElementBase::shared_ptr getCurrentChannel() const;
 
             /**
              * Returns a list of all channels managed by this object.
              */
-            std::list<ChannelDescriptor> getChannels() const {
-                return connections;
-            }
+            std::list<ChannelDescriptor> getChannels() const;
 
             /**
              * Clears (removes) all data in the manager's connections.
@@ -201,9 +221,72 @@ namespace RTT
             void clear();
 
         protected:
+            /**
+             * Calls pred on each connection and stores the channels
+             * for which it returned true. Connections with a single
+             * writer lock policy are only passed to pred while holding
+             * \a lock.
+             */
+            template<typename Pred>
+            struct DeleteIfHelper
+            {
+                Pred& pred;
+                std::vector<base::ChannelElementBase::shared_ptr>& failed;
+                os::Mutex& lock;
+                DeleteIfHelper(Pred& p, std::vector<base::ChannelElementBase::shared_ptr>& f, os::Mutex& l)
+                    : pred(p), failed(f), lock(l) {}
+                void operator()(ChannelDescriptor& descriptor) {
+                    bool result;
+                    if ( isSingleWriter(descriptor) ) {
+                        os::MutexLock locker(lock);
+                        result = pred(descriptor);
+                    } else
+                        result = pred(descriptor);
+                    if ( result )
+                        failed.push_back( descriptor.get<1>() );
+                }
+            };
+
+            /**
+             * Returns true if the channel of \a descriptor may only be
+             * written by one thread at a time.
+             */
+            static bool isSingleWriter(ChannelDescriptor const& descriptor) {
+                return descriptor.get<2>().lock_policy == ConnPolicy::UNSYNC
+                    || descriptor.get<2>().lock_policy == ConnPolicy::LOCK_FREE_SPSC;
+            }
+
+            /**
+             * Calls pred on the connections until one returns true.
+             * If \a only_match is set, only the channel \a match is
+             * tried, otherwise \a match is skipped.
+             */
+            template<typename Pred>
+            struct FindIfHelper
+            {
+                Pred& pred;
+                base::ChannelElementBase*& result;
+                base::ChannelElementBase* match;
+                bool copy_old_data;
+                bool only_match;
+                FindIfHelper(Pred& p, base::ChannelElementBase*& r, base::ChannelElementBase* m, bool copy, bool only)
+                    : pred(p), result(r), match(m), copy_old_data(copy), only_match(only) {}
+                void operator()(ChannelDescriptor& descriptor) {
+                    if ( result || (descriptor.get<1>().get() == match) != only_match )
+                        return;
+                    if ( pred(copy_old_data, descriptor) )
+                        result = descriptor.get<1>().get();
+                }
+            };
 
             void updateCurrentChannel(bool reset_current);
 
+            /**
+             * Removes \a channel from the connection list, without
+             * disconnecting it.
+             */
+            bool removeChannel(base::ChannelElementBase* channel);
+
             /** Helper method for disconnect(PortInterface*)
              *
              * This method removes the channel listed in \c descriptor from the list
@@ -220,30 +303,36 @@ namespace RTT
              */
             bool eraseConnection(ChannelDescriptor& descriptor);
 
-            /** os::Mutex for when it is needed to resize the connections list */
-            os::Mutex connection_resize_mtx;
-
             /**
              * The port for which we manage connections.
              */
             base::PortInterface* mport;
 
             /**
-             * A list of all our connections. Only non-null if two or more connections
-             * were added.
+             * A lock-free list of all our connections. It is grown
+             * when a connection is added.
              */
-            std::list< ChannelDescriptor > connections;
+            mutable List< ChannelDescriptor > connections;
 
             /**
-             * Optimisation in case only one channel is to be managed.
+             * The channel that was last read from, or the first added
+             * channel. This pointer is only dereferenced after it has been
+             * found in \a connections, so it may point to a removed channel.
              */
-            ChannelDescriptor cur_channel;
+            base::ChannelElementBase* volatile cur_channel;
 
             /**
-             * Lock that should be taken before the list of connections is
-             * accessed or modified
+             * Lock that must be taken before the list of connections is
+             * modified. It is not taken for reading or writing data.
              */
             RTT::os::Mutex connection_lock;
+
+            /**
+             * Lock that serializes writes to the channels which only
+             * accept one writer at a time.
+             * @see isSingleWriter
+             */
+            RTT::os::Mutex write_lock;
         };
 
     }
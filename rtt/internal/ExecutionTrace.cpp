@@ -0,0 +1,250 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "ExecutionTrace.hpp"
+#include <boost/cstdint.hpp>
+#include <fstream>
+#include <cstring>
+
+namespace RTT
+{
+    namespace internal
+    {
+        namespace {
+            const char* const phase_names[ExecutionTrace::PhaseCount] =
+                { "messages", "functions", "prepareUpdateHook", "updateHook", "errorHook", "cycle" };
+
+            /**
+             * Returns the index of the highest bit set in \a v.
+             */
+            inline unsigned int highestBit(boost::uint64_t v) {
+#ifdef __GNUC__
+                return 63 - __builtin_clzll(v);
+#else
+                unsigned int r = 0;
+                while ( v >>= 1 )
+                    ++r;
+                return r;
+#endif
+            }
+
+            template<class T>
+            void writeRaw(std::ofstream& file, T value) {
+                file.write( reinterpret_cast<const char*>(&value), sizeof(value) );
+            }
+        }
+
+        LatencyHistogram::LatencyHistogram()
+        {
+            reset();
+        }
+
+        void LatencyHistogram::reset()
+        {
+            mcount = 0;
+            mtotal = 0;
+            mmin = 0;
+            mmax = 0;
+            memset( mbuckets, 0, sizeof(mbuckets) );
+        }
+
+        unsigned int LatencyHistogram::index(nsecs value)
+        {
+            if ( value < SubBuckets )
+                return value < 0 ? 0 : value;
+            unsigned int msb = highestBit( value );
+            // the first octave holds SubBuckets values exactly.
+            return (msb - SubBucketBits + 1) * SubBuckets + ( (value >> (msb - SubBucketBits)) & (SubBuckets - 1) );
+        }
+
+        nsecs LatencyHistogram::lowest(unsigned int i)
+        {
+            if ( i < SubBuckets )
+                return i;
+            unsigned int octave = i / SubBuckets;
+            return nsecs( SubBuckets + i % SubBuckets ) << (octave - 1);
+        }
+
+        void LatencyHistogram::add(nsecs value)
+        {
+            if ( value < 0 )
+                value = 0;
+            if ( mcount == 0 || value < mmin )
+                mmin = value;
+            if ( value > mmax )
+                mmax = value;
+            mtotal += value;
+            ++mcount;
+            ++mbuckets[ index(value) ];
+        }
+
+        nsecs LatencyHistogram::percentile(double p) const
+        {
+            if ( mcount == 0 )
+                return 0;
+            double wanted = p / 100.0 * mcount;
+            unsigned int seen = 0;
+            for (unsigned int i = 0; i != Buckets; ++i) {
+                seen += mbuckets[i];
+                if ( seen > 0 && seen >= wanted ) {
+                    // don't report more than we measured.
+                    nsecs upper = i + 1 < Buckets ? lowest(i + 1) - 1 : mmax;
+                    return upper < mmax ? upper : mmax;
+                }
+            }
+            return mmax;
+        }
+
+        ExecutionTrace::ExecutionTrace(unsigned int events)
+            : menabled(false), mhistograms(0), mevents(0), mcapacity(events),
+              mnext(0), mcycles(0), moverruns(0)
+        {
+        }
+
+        ExecutionTrace::~ExecutionTrace()
+        {
+            delete[] mhistograms;
+            delete[] mevents;
+        }
+
+        void ExecutionTrace::enable(bool on)
+        {
+            if ( on && mhistograms == 0 ) {
+                mhistograms = new LatencyHistogram[PhaseCount];
+                if ( mcapacity )
+                    mevents = new Event[mcapacity];
+            }
+            menabled = on;
+        }
+
+        void ExecutionTrace::reset()
+        {
+            if ( mhistograms )
+                for (unsigned int i = 0; i != PhaseCount; ++i)
+                    mhistograms[i].reset();
+            mnext = 0;
+            mcycles = 0;
+            moverruns = 0;
+        }
+
+        void ExecutionTrace::add(Phase phase, nsecs start, nsecs duration)
+        {
+            mhistograms[phase].add( duration );
+            if ( mevents ) {
+                Event& e = mevents[ mnext % mcapacity ];
+                e.start = start;
+                e.duration = duration;
+                e.phase = phase;
+                e.cycle = mcycles;
+                ++mnext;
+            }
+        }
+
+        void ExecutionTrace::cycle(nsecs start, nsecs duration, Seconds period)
+        {
+            add( Cycle, start, duration );
+            if ( period > 0.0 && duration > Seconds_to_nsecs(period) )
+                ++moverruns;
+            ++mcycles;
+        }
+
+        const LatencyHistogram* ExecutionTrace::histogram(Phase phase) const
+        {
+            if ( mhistograms == 0 || phase >= PhaseCount )
+                return 0;
+            return &mhistograms[phase];
+        }
+
+        ExecutionTrace::Phase ExecutionTrace::phase(const std::string& name)
+        {
+            for (unsigned int i = 0; i != PhaseCount; ++i)
+                if ( name == phase_names[i] )
+                    return Phase(i);
+            return PhaseCount;
+        }
+
+        const char* ExecutionTrace::phaseName(Phase phase)
+        {
+            return phase < PhaseCount ? phase_names[phase] : "unknown";
+        }
+
+        unsigned int ExecutionTrace::getCount(const std::string& name) const
+        {
+            const LatencyHistogram* h = histogram( phase(name) );
+            return h ? h->count() : 0;
+        }
+
+        Seconds ExecutionTrace::getMin(const std::string& name) const
+        {
+            const LatencyHistogram* h = histogram( phase(name) );
+            return h ? nsecs_to_Seconds( h->min() ) : 0.0;
+        }
+
+        Seconds ExecutionTrace::getMean(const std::string& name) const
+        {
+            const LatencyHistogram* h = histogram( phase(name) );
+            return h ? h->mean() / NSECS_IN_SECS : 0.0;
+        }
+
+        Seconds ExecutionTrace::getMax(const std::string& name) const
+        {
+            const LatencyHistogram* h = histogram( phase(name) );
+            return h ? nsecs_to_Seconds( h->max() ) : 0.0;
+        }
+
+        Seconds ExecutionTrace::getPercentile(const std::string& name, double p) const
+        {
+            const LatencyHistogram* h = histogram( phase(name) );
+            return h ? nsecs_to_Seconds( h->percentile(p) ) : 0.0;
+        }
+
+        bool ExecutionTrace::write(const std::string& filename) const
+        {
+            std::ofstream file( filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+            if ( !file )
+                return false;
+            unsigned int next = mnext;
+            unsigned int count = mevents ? (next < mcapacity ? next : mcapacity) : 0;
+            file.write( "RTTTRACE", 8 );
+            writeRaw<boost::uint32_t>( file, 1 );
+            writeRaw<boost::uint32_t>( file, 24 );
+            writeRaw<boost::uint32_t>( file, count );
+            writeRaw<boost::uint32_t>( file, PhaseCount );
+            for (unsigned int i = next - count; i != next; ++i) {
+                const Event& e = mevents[ i % mcapacity ];
+                writeRaw<boost::int64_t>( file, e.start );
+                writeRaw<boost::int64_t>( file, e.duration );
+                writeRaw<boost::uint32_t>( file, e.phase );
+                writeRaw<boost::uint32_t>( file, e.cycle );
+            }
+            return file.good();
+        }
+    }
+}
@@ -0,0 +1,256 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_EXECUTION_TRACE_HPP
+#define ORO_EXECUTION_TRACE_HPP
+
+#include "../rtt-config.h"
+#include "../Time.hpp"
+#include "../os/fosi.h"
+#include <string>
+
+/**
+ * The number of events an ExecutionTrace keeps for
+ * writing a binary trace file.
+ */
+#ifndef ORONUM_EE_TRACE_SIZE
+#define ORONUM_EE_TRACE_SIZE 4096
+#endif
+
+namespace RTT
+{
+    namespace internal
+    {
+        /**
+         * A histogram of durations in nanoseconds with a constant relative
+         * resolution, in the spirit of HdrHistogram. Each power of two is
+         * divided in SubBuckets linear buckets, such that any value is
+         * stored with an error of less than 1/SubBuckets (12.5%).
+         * Adding a value does not allocate memory and takes constant time.
+         */
+        class RTT_API LatencyHistogram
+        {
+        public:
+            enum { SubBucketBits = 3,
+                   SubBuckets = 1 << SubBucketBits,
+                   Buckets = (64 - SubBucketBits) * SubBuckets };
+
+            LatencyHistogram();
+
+            /**
+             * Adds a duration. Negative durations are counted as zero.
+             */
+            void add(nsecs value);
+
+            /**
+             * Removes all values.
+             */
+            void reset();
+
+            unsigned int count() const { return mcount; }
+            nsecs min() const { return mcount ? mmin : 0; }
+            nsecs max() const { return mmax; }
+            nsecs total() const { return mtotal; }
+            double mean() const { return mcount ? double(mtotal) / mcount : 0.0; }
+
+            /**
+             * Returns the smallest value such that at least \a p percent
+             * of the added values are not larger, within the resolution
+             * of this histogram.
+             * @param p A percentage between 0.0 and 100.0
+             */
+            nsecs percentile(double p) const;
+
+            /**
+             * Returns the number of values in bucket \a i.
+             */
+            unsigned int bucket(unsigned int i) const { return mbuckets[i]; }
+
+            /**
+             * Returns the index of the bucket which holds \a value.
+             */
+            static unsigned int index(nsecs value);
+
+            /**
+             * Returns the smallest value stored in bucket \a i.
+             */
+            static nsecs lowest(unsigned int i);
+        private:
+            unsigned int mcount;
+            nsecs mtotal, mmin, mmax;
+            unsigned int mbuckets[Buckets];
+        };
+
+        /**
+         * Records how long the ExecutionEngine spends in each phase of
+         * the execution of one TaskCore. It keeps a LatencyHistogram per
+         * Phase, counts the cycles which took longer than the period of the
+         * activity and keeps the last events in a ring buffer which can be
+         * written to a binary trace file.
+         *
+         * Tracing is off by default, such that the ExecutionEngine only checks
+         * isEnabled(). The histograms and the ring buffer are allocated by the first
+         * call to enable(true) and kept until destruction. add() and cycle() are
+         * only called from the thread of the ExecutionEngine, the other
+         * functions may be called from any thread, but may return a mix of
+         * old and new values while tracing.
+         */
+        class RTT_API ExecutionTrace
+        {
+        public:
+            enum Phase { Messages = 0, Functions, PrepareUpdateHook, UpdateHook, ErrorHook, Cycle, PhaseCount };
+
+            /**
+             * One traced phase, as stored in the trace file.
+             */
+            struct Event
+            {
+                nsecs start;
+                nsecs duration;
+                unsigned int phase;
+                unsigned int cycle;
+            };
+
+            /**
+             * Creates a disabled trace.
+             * @param events The number of events to keep for write().
+             */
+            ExecutionTrace(unsigned int events = ORONUM_EE_TRACE_SIZE);
+            ~ExecutionTrace();
+
+            /**
+             * Enables or disables tracing. Enabling allocates memory
+             * the first time, so don't call this from a real-time thread.
+             */
+            void enable(bool on);
+
+            bool isEnabled() const { return menabled; }
+
+            /**
+             * Clears all histograms, counters and events.
+             */
+            void reset();
+
+            /**
+             * Records the \a duration of \a phase.
+             * @pre isEnabled()
+             */
+            void add(Phase phase, nsecs start, nsecs duration);
+
+            /**
+             * Records the \a duration of a whole cycle and counts
+             * an overrun if it took longer than \a period.
+             * @param period The period of the activity, or 0.0 if
+             * it is not periodic.
+             * @pre isEnabled()
+             */
+            void cycle(nsecs start, nsecs duration, Seconds period);
+
+            /**
+             * Returns the histogram of \a phase, or null if
+             * tracing was never enabled.
+             */
+            const LatencyHistogram* histogram(Phase phase) const;
+
+            unsigned int cycles() const { return mcycles; }
+            unsigned int overruns() const { return moverruns; }
+
+            /**
+             * Returns the phase named \a name, one of "messages", "functions",
+             * "prepareUpdateHook", "updateHook", "errorHook" or "cycle".
+             * Returns PhaseCount for an unknown name.
+             */
+            static Phase phase(const std::string& name);
+
+            /**
+             * Returns the name of \a phase.
+             */
+            static const char* phaseName(Phase phase);
+
+            /**
+             * @name Queries by phase name
+             * These return durations in seconds and are used by
+             * the 'trace' service of a TaskContext.
+             * @{
+             */
+            unsigned int getCount(const std::string& phase) const;
+            Seconds getMin(const std::string& phase) const;
+            Seconds getMean(const std::string& phase) const;
+            Seconds getMax(const std::string& phase) const;
+            Seconds getPercentile(const std::string& phase, double p) const;
+            /** @} */
+
+            /**
+             * Writes the last events, oldest first, to a binary file.
+             * The file starts with the 8 characters "RTTTRACE", followed by
+             * four 32 bit unsigned integers: the format version (1), the
+             * size of one event (24), the number of events and the number of
+             * phases. Each event consists of the start and duration in nanoseconds
+             * as 64 bit integers, the Phase and the cycle number as 32 bit
+             * integers. All integers are in the byte order of the host.
+             * @return false if the file could not be written.
+             */
+            bool write(const std::string& filename) const;
+        private:
+            ExecutionTrace(const ExecutionTrace&);
+
+            volatile bool menabled;
+            LatencyHistogram* mhistograms;
+            Event* mevents;
+            unsigned int mcapacity;
+            unsigned int mnext;
+            unsigned int mcycles;
+            unsigned int moverruns;
+        };
+
+        /**
+         * Measures the duration of its own scope and adds it to
+         * an ExecutionTrace, if that trace is enabled.
+         */
+        class TraceScope
+        {
+            ExecutionTrace* mtrace;
+            ExecutionTrace::Phase mphase;
+            nsecs mstart;
+        public:
+            TraceScope(ExecutionTrace* trace, ExecutionTrace::Phase phase)
+                : mtrace( trace && trace->isEnabled() ? trace : 0 ), mphase(phase),
+                  mstart( mtrace ? rtos_get_time_ns() : 0 )
+            {}
+
+            ~TraceScope() {
+                if ( mtrace )
+                    mtrace->add( mphase, mstart, rtos_get_time_ns() - mstart );
+            }
+        };
+    }
+}
+
+#endif
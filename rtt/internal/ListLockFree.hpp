@@ -239,6 +239,26 @@ namespace RTT
             required -= items;
         }
 
+        /**
+         * Destroys the elements which are still held in the copies of
+         * the list that are not in use. Erasing an element leaves a copy
+         * of it in the previous version of the list until that buffer
+         * is reused. Call this function after erasing elements that hold
+         * resources. Copies which are in use by a concurrent reader are
+         * left alone and are released when their buffer is reused.
+         * @note This function is only real-time if the destructor
+         * of \a T is real-time.
+         */
+        void clear_unused() {
+            Storage bufptr = bufs;
+            for (unsigned int i=0; i < BufNum(); ++i) {
+                Item* item = &(*bufptr)[i];
+                if ( oro_atomic_inc_and_test( &item->count ) )
+                    item->data.clear();
+                oro_atomic_dec( &item->count );
+            }
+        }
+
         /**
          * Reserve a capacity for this list.
          * If you wish to invoke this method concurrently, guard it
@@ -154,6 +154,23 @@ namespace RTT
             required -= items;
         }
 
+        /**
+         * Destroys the values that are still held by the reserved,
+         * unused elements of this list.
+         * @note This function is not real-time.
+         */
+        void clear_unused() {
+            os::MutexLock lock(m);
+            std::vector<Cont*> unused;
+            while ( !mreserved.empty() ) {
+                mreserved.top()->data = value_t();
+                unused.push_back( mreserved.top() );
+                mreserved.pop();
+            }
+            for (typename std::vector<Cont*>::iterator it = unused.begin(); it != unused.end(); ++it)
+                mreserved.push( *it );
+        }
+
         /**
          * Reserve a capacity for this list.
          * @param lsize the \a minimal number of items this list will be
@@ -86,6 +86,7 @@ namespace RTT
 
         size_type capacity() const
         {
+            os::MutexLock locker(lock);
             return cap;
         }
 
@@ -112,7 +113,17 @@ namespace RTT
         bool isFull() const
         {
             os::MutexLock locker(lock);
-            return data.size() ==  cap;
+            return data.size() >=  cap;
+        }
+
+        /**
+         * Change the maximum number of items this queue can contain.
+         * Lowering the capacity below size() only rejects new items.
+         */
+        void setCapacity(size_type lsize)
+        {
+            os::MutexLock locker(lock);
+            cap = lsize;
         }
 
         void clear()
@@ -130,7 +141,7 @@ namespace RTT
         {
             {
                 os::MutexLock locker(lock);
-                if (cap == data.size() )
+                if (data.size() >= cap )
                     return false;
                 data.push_back(value);
             }
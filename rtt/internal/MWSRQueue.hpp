@@ -40,6 +40,7 @@
 #define ORO_MWSR_QUEUE_HPP
 
 #include "../rtt-config.h"
+#include "../os/Atomic.hpp"
 
 /**
  * @file MQSRQueue.hpp
@@ -51,6 +52,7 @@
 #include "LockedQueue.hpp"
 #else
 #include "AtomicMWSRQueue.hpp"
+#include "AtomicSegmentedMWSRQueue.hpp"
 #endif
 
 namespace RTT
@@ -83,6 +85,91 @@ namespace RTT
             {
             }
         };
+
+        /**
+         * This object represents the default Multi-Writer, Single-Reader queue
+         * implementation which capacity can be changed at run-time. In lock-free
+         * builds, it grows by allocating segments of \a segsize elements.
+         * It also keeps track of the high-water mark and of the number of
+         * rejected enqueues.
+         */
+        template<class T>
+        class SegmentedMWSRQueue
+#if defined(OROBLD_OS_NO_ASM)
+                : public LockedQueue<T>
+#else
+                : public AtomicSegmentedMWSRQueue<T>
+#endif
+        {
+#if defined(OROBLD_OS_NO_ASM)
+            typedef LockedQueue<T> Base;
+#else
+            typedef AtomicSegmentedMWSRQueue<T> Base;
+#endif
+            volatile unsigned int mhwm;
+            os::AtomicInt mrejected;
+        public:
+            typedef typename Base::size_type size_type;
+
+            /**
+             * Create a mw/sr queue which holds at most \a capacity elements.
+             * @param segsize The number of elements allocated at once.
+             * @param capacity The initial capacity.
+             */
+            SegmentedMWSRQueue(int segsize, int capacity)
+#if defined(OROBLD_OS_NO_ASM)
+            : Base(capacity),
+#else
+            : Base(segsize, capacity),
+#endif
+              mhwm(0), mrejected(0)
+            {
+            }
+
+            /**
+             * Enqueue an item and update the statistics.
+             * @param value The value to enqueue.
+             * @return false if queue is full, true if queued.
+             */
+            bool enqueue(const T& value)
+            {
+                if ( !Base::enqueue(value) ) {
+                    mrejected.inc();
+                    return false;
+                }
+                // concurrent writers may race here, which only
+                // makes the mark lag behind by one update.
+                size_type n = Base::size();
+                if ( n > mhwm )
+                    mhwm = n;
+                return true;
+            }
+
+            /**
+             * Return the largest number of elements this queue contained.
+             */
+            size_type highWaterMark() const
+            {
+                return mhwm;
+            }
+
+            /**
+             * Return the number of enqueue() calls which were rejected.
+             */
+            size_type rejected() const
+            {
+                return const_cast<os::AtomicInt&>(mrejected).read();
+            }
+
+            /**
+             * Reset the high-water mark and the rejected counter.
+             */
+            void resetStatistics()
+            {
+                mhwm = 0;
+                mrejected.set(0);
+            }
+        };
     }
 }
 
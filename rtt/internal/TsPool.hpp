@@ -196,6 +196,63 @@ namespace RTT
                 return true;
             }
 
+            /**
+             * Allocates at most \a n elements with one atomic operation.
+             * @param values Stores the allocated elements.
+             * @param n The number of elements requested.
+             * @return the number of elements written in \a values. This is
+             * less than \a n if the pool ran out of elements.
+             */
+            size_type allocate(value_t** values, size_type n)
+            {
+                volatile Pointer_t oldval;
+                volatile Pointer_t newval;
+                size_type count;
+                do
+                {
+                    oldval.value = head.next.value;
+                    newval.ptr.index = oldval.ptr.index;
+                    // walk the free list, the CAS below fails if it changed meanwhile.
+                    for (count = 0; count != n && newval.ptr.index != (unsigned short) -1; ++count)
+                    {
+                        values[count] = &pool[newval.ptr.index].value;
+                        newval.ptr.index = pool[newval.ptr.index].next.ptr.index;
+                    }
+                    if (count == 0)
+                        return 0;
+                    newval.ptr.tag = oldval.ptr.tag + 1;
+                } while (!os::CAS(&head.next.value, oldval.value, newval.value));
+                return count;
+            }
+
+            /**
+             * Returns \a n elements to the pool with one atomic operation.
+             * @param values The elements to deallocate.
+             * @param n The number of elements in \a values.
+             */
+            bool deallocate(value_t* const* values, size_type n)
+            {
+                if (n == 0)
+                    return true;
+                // chain the elements before publishing them.
+                for (size_type i = 0; i + 1 < n; ++i)
+                {
+                    assert(values[i] >= (T*) &pool[0] && values[i] <= (T*) &pool[pool_capacity]);
+                    reinterpret_cast<Item*>(values[i])->next.ptr.index = reinterpret_cast<Item*>(values[i+1]) - pool;
+                }
+                Item* last = reinterpret_cast<Item*> (values[n-1]);
+                volatile Pointer_t oldval;
+                Pointer_t head_next;
+                do
+                {
+                    oldval.value = head.next.value;
+                    last->next.value = oldval.value;
+                    head_next.ptr.index = reinterpret_cast<Item*>(values[0]) - pool;
+                    head_next.ptr.tag = oldval.ptr.tag + 1;
+                } while (!os::CAS(&head.next.value, oldval.value, head_next.value));
+                return true;
+            }
+
             /**
              * Return the number of elements that are available to be allocated.
              * This function is not thread-safe and should not be used when concurrent
@@ -8,7 +8,9 @@ namespace RTT {
         class ConnectionBase;
         class ConnectionManager;
         class DataSourceCommand;
+        class ExecutionTrace;
         class GlobalEngine;
+        class LatencyHistogram;
         class OffsetDataSource;
         class OperationCallerC;
         class OperationInterfacePartHelper;
@@ -89,10 +91,14 @@ namespace RTT {
         template<class T>
         class AtomicQueue;
         template<class T>
+        class AtomicSegmentedMWSRQueue;
+        template<class T>
         class MWSRQueue;
         template<class T>
         class Queue;
         template<class T>
+        class SegmentedMWSRQueue;
+        template<class T>
         struct AStore;
         template<class T>
         struct DSRStore;
@@ -0,0 +1,112 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef RTT_OS_CPUSET_HPP
+#define RTT_OS_CPUSET_HPP
+
+#include <bitset>
+#include "../rtt-config.h"
+
+#ifndef ORONUM_OS_MAX_CPUS
+/**
+ * The number of cpus a CpuSet can hold, which matches the
+ * size of the Linux cpu_set_t.
+ */
+#define ORONUM_OS_MAX_CPUS 1024
+#endif
+
+namespace RTT
+{ namespace os {
+
+    /**
+     * A set of cpus a thread may run on. Unlike the unsigned
+     * cpu affinity mask, it is not limited to the first 32 cpus.
+     * @see Thread::setCpuSet
+     */
+    class CpuSet
+    {
+    public:
+        enum { MaxCpus = ORONUM_OS_MAX_CPUS };
+
+        /**
+         * Creates an empty set.
+         */
+        CpuSet() {}
+
+        /**
+         * Creates a set from a cpu affinity mask, where bit 0 is cpu 0.
+         */
+        explicit CpuSet(unsigned mask)
+        {
+            for (unsigned i = 0; i < 8 * sizeof(mask); ++i)
+                if ( mask & (1u << i) )
+                    cpus.set(i);
+        }
+
+        /**
+         * Adds \a cpu to the set. Cpus beyond MaxCpus are ignored.
+         */
+        CpuSet& set(unsigned cpu) { if ( cpu < MaxCpus ) cpus.set(cpu); return *this; }
+
+        /**
+         * Removes \a cpu from the set.
+         */
+        CpuSet& clear(unsigned cpu) { if ( cpu < MaxCpus ) cpus.reset(cpu); return *this; }
+
+        /**
+         * Removes all cpus from the set.
+         */
+        CpuSet& clear() { cpus.reset(); return *this; }
+
+        bool isSet(unsigned cpu) const { return cpu < MaxCpus && cpus.test(cpu); }
+
+        unsigned count() const { return cpus.count(); }
+
+        bool empty() const { return cpus.none(); }
+
+        /**
+         * Returns the first 32 cpus of this set as a cpu affinity mask.
+         */
+        unsigned toMask() const
+        {
+            unsigned mask = 0;
+            for (unsigned i = 0; i < 8 * sizeof(mask); ++i)
+                if ( cpus.test(i) )
+                    mask |= (1u << i);
+            return mask;
+        }
+
+        bool operator==(const CpuSet& other) const { return cpus == other.cpus; }
+        bool operator!=(const CpuSet& other) const { return cpus != other.cpus; }
+    private:
+        std::bitset<MaxCpus> cpus;
+    };
+}}
+
+#endif
@@ -111,6 +111,16 @@ namespace RTT
     	return rtos_task_get_pid(&main_task);
     }
 
+    bool MainThread::setCpuSet(const CpuSet& cpus)
+    {
+        return rtos_task_set_cpu_set(&main_task, cpus) == 0;
+    }
+
+    CpuSet MainThread::getCpuSet() const
+    {
+        return rtos_task_get_cpu_set(&main_task);
+    }
+
     bool MainThread::setPeriod(Seconds period)
     {
         return false;
@@ -128,6 +128,10 @@ namespace RTT
 
         virtual unsigned int getPid() const;
 
+        virtual bool setCpuSet(const CpuSet& cpus);
+
+        virtual CpuSet getCpuSet() const;
+
         virtual void setMaxOverrun(int m);
 
         virtual int getMaxOverrun() const;
@@ -67,6 +67,8 @@ namespace RTT {
 
         void Thread::setStackSize(unsigned int ssize) { default_stack_size = ssize; }
 
+        bool Thread::lockMemory() { return rtos_lock_memory() == 0; }
+
         void Thread::setLockTimeoutNoPeriod(double timeout_in_s) { lock_timeout_no_period_in_s = timeout_in_s; }
        
         void Thread::setLockTimeoutPeriodFactor(double factor) { lock_timeout_period_factor = factor; }
@@ -81,6 +83,10 @@ namespace RTT {
 
             task->configure();
 
+            // with locked memory, touch the stack before any real-time work is done.
+            if ( rtos_memory_locked() && rtos_task_prefault_stack( Thread::default_stack_size ) != 0 )
+                log(Warning) << "Could not prefault the stack of thread " << task->getName() << endlog();
+
             // signal to setup() that we're created.
             rtos_sem_signal(&(task->sem));
 
@@ -94,6 +100,9 @@ namespace RTT {
 
             int overruns = 0, cur_sched = task->msched_type;
             NANO_TIME cur_period = task->period;
+            // page faults of the calling thread when it was started.
+            bool counting = false;
+            long minflt = 0, majflt = 0;
 
             while (!task->prepareForExit)
             {
@@ -105,6 +114,10 @@ namespace RTT {
                     {
                         if (!task->active || (task->active && task->period == 0) || !task->running )
                         {
+                            if ( counting && !task->running ) {
+                                task->countPageFaults( minflt, majflt );
+                                counting = false;
+                            }
                             // consider this the 'configuration or waiting for command state'
                             if (task->period != 0) {
                                 overruns = 0;
@@ -122,6 +135,8 @@ namespace RTT {
                         // This is the running state. Only enter if a task is running
                         if ( task->running )
                         {
+                            if ( !counting )
+                                counting = rtos_task_get_page_faults( &minflt, &majflt ) == 0;
                             if (task->period != 0) // periodic
                             {
                                 MutexLock lock(task->breaker);
@@ -222,6 +237,25 @@ namespace RTT {
             return 0;
         }
 
+        void Thread::countPageFaults(long minflt, long majflt)
+        {
+            long minor, major;
+            if ( rtos_task_get_page_faults( &minor, &major ) != 0 )
+                return;
+            mminor_faults = minor - minflt;
+            mmajor_faults = major - majflt;
+            if ( mminor_faults != 0 || mmajor_faults != 0 )
+                log(Info) << "Thread " << getName() << " had " << mminor_faults << " minor and "
+                          << mmajor_faults << " major page faults while running." << endlog();
+        }
+
+        bool Thread::getPageFaults(long& minor, long& major) const
+        {
+            minor = mminor_faults;
+            major = mmajor_faults;
+            return mminor_faults >= 0;
+        }
+
         void Thread::emergencyStop()
         {
             // set state to not running
@@ -234,7 +268,10 @@ namespace RTT {
 
         Thread::Thread(int scheduler, int _priority,
                 Seconds periods, unsigned cpu_affinity, const std::string & name) :
-                    msched_type(scheduler), active(false), prepareForExit(false),
+                    msched_type(scheduler), mnuma_node(-1), cur_numa_node(-1),
+                    mruntime(0), mdeadline(0),
+                    mminor_faults(-1), mmajor_faults(-1),
+                    active(false), prepareForExit(false),
                     inloop(false),running(false),
                     maxOverRun(OROSEM_OS_PERIODIC_THREADS_MAX_OVERRUN),
                     period(Seconds_to_nsecs(periods)) // Do not call setPeriod(), since the semaphores are not yet used !
@@ -506,6 +543,14 @@ namespace RTT {
                 rtos_task_set_scheduler(&rtos_task, msched_type);
                 msched_type = rtos_task_get_scheduler(&rtos_task);
             }
+
+            // reconfigure NUMA placement, which can only be done by the thread itself.
+            if (mnuma_node != cur_numa_node)
+            {
+                if ( rtos_task_set_numa_node(&rtos_task, mnuma_node) != 0 )
+                    log(Error) << "Could not place thread " << getName() << " on NUMA node " << mnuma_node << endlog();
+                cur_numa_node = mnuma_node;
+            }
         }
 
         void Thread::step()
@@ -607,6 +652,56 @@ namespace RTT {
             return rtos_task_get_cpu_affinity(&rtos_task);
         }
 
+        bool Thread::setCpuSet(const CpuSet& cpus)
+        {
+            return rtos_task_set_cpu_set(&rtos_task, cpus) == 0;
+        }
+
+        CpuSet Thread::getCpuSet() const
+        {
+            return rtos_task_get_cpu_set(&rtos_task);
+        }
+
+        bool Thread::setNumaNode(int node)
+        {
+            if ( node >= 0 && rtos_numa_node_cpus(node).empty() )
+                return false;
+            log(Info) << "Setting NUMA node of Thread '"
+                      << rtos_task_get_name(&rtos_task) << "' to "
+                      << node << endlog();
+            mnuma_node = node;
+            rtos_sem_signal(&sem);
+            return true;
+        }
+
+        int Thread::getNumaNode() const
+        {
+            return mnuma_node;
+        }
+
+        bool Thread::setDeadline(Seconds runtime, Seconds deadline)
+        {
+            nsecs nsruntime = Seconds_to_nsecs(runtime), nsdeadline = Seconds_to_nsecs(deadline);
+            if ( rtos_task_set_deadline(&rtos_task, nsruntime, nsdeadline) != 0 )
+                return false;
+            log(Info) << "Setting deadline reservation of Thread '"
+                      << rtos_task_get_name(&rtos_task) << "' to a runtime of "
+                      << runtime << "s with deadline " << deadline << "s" << endlog();
+            mruntime = nsruntime;
+            mdeadline = nsdeadline;
+            return true;
+        }
+
+        Seconds Thread::getRuntime() const
+        {
+            return nsecs_to_Seconds(mruntime);
+        }
+
+        Seconds Thread::getDeadline() const
+        {
+            return nsecs_to_Seconds(mdeadline);
+        }
+
         unsigned int Thread::getPid() const
         {
         	return rtos_task_get_pid(&rtos_task);
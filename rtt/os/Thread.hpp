@@ -136,6 +136,15 @@ namespace RTT
              */
             static void setStackSize(unsigned int ssize);
 
+            /**
+             * Locks all current and future memory of this process into RAM,
+             * like setting the ORO_LOCK_MEMORY environment variable does at
+             * startup. Threads created afterwards touch their stack, up to the
+             * size given to setStackSize(), before they run any user code.
+             * @return true if the memory could be locked.
+             */
+            static bool lockMemory();
+
             /**
              * Sets the lock timeout for a thread which does not have a period
              * The default is 1 second 
@@ -232,6 +241,60 @@ namespace RTT
              */
             virtual unsigned getCpuAffinity() const;
 
+            virtual bool setCpuSet(const CpuSet& cpus);
+
+            virtual CpuSet getCpuSet() const;
+
+            /**
+             * Place this thread on a NUMA node. The thread is bound to the
+             * cpus of \a node and the memory it touches first, such as the
+             * buffers and queues it allocates itself, is taken from that node.
+             * Memory that was touched before, or by another thread, such as the
+             * queues of an ExecutionEngine created with its TaskContext, is not moved.
+             * The placement is done by the thread itself, when it is not
+             * running step() or loop(), like setScheduler().
+             * @param node The NUMA node, or -1 to remove the placement.
+             * @return false if the node does not exist.
+             */
+            bool setNumaNode(int node);
+
+            /**
+             * @return the NUMA node given to setNumaNode(), or -1.
+             */
+            int getNumaNode() const;
+
+            /**
+             * Reserve CPU time for this thread under the ORO_SCHED_DEADLINE
+             * scheduler, which the OS must provide. The thread may use
+             * \a runtime seconds of CPU time in each of its periods, and must
+             * have used it \a deadline seconds after the start of the period.
+             * Using more CPU time, or passing the deadline, counts as an
+             * overrun of the period, see setMaxOverrun().
+             * @param runtime The CPU time per period, or zero to remove the reservation.
+             * @param deadline The deadline within the period, zero for the period itself.
+             * @return false if the reservation is invalid or the OS does not support it.
+             */
+            bool setDeadline(Seconds runtime, Seconds deadline = 0.0);
+
+            /**
+             * @return the CPU time per period given to setDeadline(), or zero.
+             */
+            Seconds getRuntime() const;
+
+            /**
+             * @return the deadline given to setDeadline(), or zero.
+             */
+            Seconds getDeadline() const;
+
+            /**
+             * Returns the page faults of this thread during its last run,
+             * from start() to stop(). A real-time thread should have none
+             * once it runs in its steady state.
+             * @return false if the thread has not been stopped yet or
+             * the OS does not count page faults per thread.
+             */
+            bool getPageFaults(long& minor, long& major) const;
+
             virtual void yield();
 
             virtual void setMaxOverrun(int m);
@@ -301,6 +364,27 @@ namespace RTT
              */
             int msched_type;
 
+            /**
+             * Desired and applied NUMA node.
+             */
+            int mnuma_node, cur_numa_node;
+
+            /**
+             * The deadline reservation, see setDeadline().
+             */
+            nsecs mruntime, mdeadline;
+
+            /**
+             * Page faults during the last run, or -1.
+             */
+            long mminor_faults, mmajor_faults;
+
+            /**
+             * Records the page faults since the thread was started,
+             * given the counters when it was started.
+             */
+            void countPageFaults(long minflt, long majflt);
+
             /**
              * When set to 1, the thread will run, when set to 0
              * the thread will stop ( isActive() )
@@ -59,3 +59,13 @@ bool ThreadInterface::isSelf() const
 {
     return rtos_task_is_self( this->getTask() ) == 1;
 }
+
+bool ThreadInterface::setCpuSet(const CpuSet& cpus)
+{
+    return false;
+}
+
+CpuSet ThreadInterface::getCpuSet() const
+{
+    return CpuSet();
+}
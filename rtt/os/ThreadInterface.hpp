@@ -42,6 +42,7 @@
 #include "fosi.h"
 #include "threads.hpp"
 #include "Time.hpp"
+#include "CpuSet.hpp"
 #include "../rtt-config.h"
 
 namespace RTT
@@ -190,6 +191,20 @@ namespace RTT
              */
             virtual unsigned int getPid() const = 0;
 
+            /**
+             * Set the cpus this thread may run on.
+             * @param cpus The allowed cpus. An empty set clears the affinity.
+             * @return true if the set has been applied. The default
+             * implementation applies nothing and returns false.
+             */
+            virtual bool setCpuSet(const CpuSet& cpus);
+
+            /**
+             * @return the cpus this thread may run on. The default
+             * implementation returns an empty set.
+             */
+            virtual CpuSet getCpuSet() const;
+
             virtual void setMaxOverrun(int m) = 0;
 
             virtual int getMaxOverrun() const = 0;
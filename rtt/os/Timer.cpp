@@ -41,6 +41,7 @@
 #include "../Activity.hpp"
 #include "../Logger.hpp"
 #include "../os/fosi.h"
+#include <algorithm>
 
 namespace RTT {
     using namespace base;
@@ -62,22 +63,15 @@ namespace RTT {
         // This code is executed from mThread's thread
         while (!mdo_quit) {
             Time wake_up_time;
-            TimerId next_timer_id = 0;
 
-            // Select next timer.
+            // Select next timer: the top of the heap.
             {// This scope is for MutexLock.
-                // find wake_up_time
-                // check timers queue.
                 MutexLock locker(m);
                 // We can't use infinite as the OS may internally use time_spec, which can not
                 // represent as much in the future (until 2038) // XXX Year-2038 Bug
                 wake_up_time = (TimeService::InfiniteNSecs/4)-1;
-                for (TimerIds::iterator it = mtimers.begin(); it != mtimers.end(); ++it) {
-                    if ( it->expires != 0 && it->expires < wake_up_time  ) {
-                        wake_up_time = it->expires;
-                        next_timer_id = it - mtimers.begin();
-                    }
-                }
+                if ( !mheap.empty() )
+                    wake_up_time = mtimers[ mheap.front() ].expires;
             }// MutexLock
 
             // Wait
@@ -89,35 +83,38 @@ namespace RTT {
 
             // Timeout handling
             if (ret == -1) {
-                // a timer expired
-                // expires: reset/reprogram the timer that expired:
+                // one or more timers expired
+                // First: take all expired timers from the heap and
+                // reset/reprogram them, such that each fires once.
                 {
                     MutexLock locker(m);
-                    // detect corner case for resize:
-                    if ( next_timer_id < int(mtimers.size()) ) {
-                        // now clear or reprogram it.
-                        TimerIds::iterator tim = mtimers.begin() + next_timer_id;
-                        if ( tim->period ) {
+                    Time now = rtos_get_time_ns();
+                    mexpired.clear();
+                    while ( !mheap.empty() && mtimers[ mheap.front() ].expires <= now ) {
+                        mexpired.push_back( mheap.front() );
+                        unschedule( mheap.front() );
+                    }
+                    for (std::vector<TimerId>::iterator it = mexpired.begin(); it != mexpired.end(); ++it) {
+                        TimerInfo& tim = mtimers[*it];
+                        if ( tim.period ) {
                             // periodic timer
-                            tim->expires += tim->period;
+                            tim.expires += tim.period;
+                            schedule( *it );
                         } else {
                             // aperiodic timer
-                            tim->expires = 0;
+                            tim.expires = 0;
                         }
+                        // Second: notify waiting threads
+                        tim.expired.broadcast();
                     }
                 }
 
-                // Second: notify waiting threads
-                {// This scope is for MutexLock.
-                    MutexLock locker(m);
-                    mtimers[next_timer_id].expired.broadcast();
-                }// MutexLock
-
-                // Third: send the timeout signal and allow (within the callback)
-                // to reprogram the timer.
+                // Third: send the timeout signals and allow (within the callback)
+                // to reprogram the timers.
                 // If we would expires call timeout(), the code above would overwrite
                 // user settings.
-                timeout( next_timer_id );
+                for (std::vector<TimerId>::iterator it = mexpired.begin(); it != mexpired.end(); ++it)
+                    timeout( *it );
             }
         }
     }
@@ -137,6 +134,8 @@ namespace RTT {
         : mThread(0), msem(0), mdo_quit(false)
     {
         mtimers.resize(max_timers);
+        mheap.reserve(max_timers);
+        mexpired.reserve(max_timers);
         if (scheduler != -1) {
             mThread = new Activity(scheduler, priority, 0.0, this, "Timer");
             mThread->start();
@@ -157,7 +156,77 @@ namespace RTT {
     void Timer::setMaxTimers(TimerId max)
     {
         MutexLock locker(m);
+        for (TimerId i = max; i < (int) mtimers.size(); ++i)
+            unschedule(i);
         mtimers.resize(max, TimerInfo() );
+        mheap.reserve(max);
+        // mexpired is only touched by loop(), which
+        // grows it if required.
+    }
+
+    void Timer::heapSwap(int a, int b)
+    {
+        std::swap( mheap[a], mheap[b] );
+        mtimers[ mheap[a] ].heap_index = a;
+        mtimers[ mheap[b] ].heap_index = b;
+    }
+
+    void Timer::siftUp(int i)
+    {
+        while ( i > 0 ) {
+            int parent = (i - 1) / 2;
+            if ( mtimers[ mheap[parent] ].expires <= mtimers[ mheap[i] ].expires )
+                break;
+            heapSwap( i, parent );
+            i = parent;
+        }
+    }
+
+    void Timer::siftDown(int i)
+    {
+        int n = mheap.size();
+        while ( true ) {
+            int first = i;
+            int left = 2 * i + 1, right = left + 1;
+            if ( left < n && mtimers[ mheap[left] ].expires < mtimers[ mheap[first] ].expires )
+                first = left;
+            if ( right < n && mtimers[ mheap[right] ].expires < mtimers[ mheap[first] ].expires )
+                first = right;
+            if ( first == i )
+                break;
+            heapSwap( i, first );
+            i = first;
+        }
+    }
+
+    bool Timer::schedule(TimerId timer_id)
+    {
+        TimerInfo& tim = mtimers[timer_id];
+        if ( tim.heap_index < 0 ) {
+            tim.heap_index = mheap.size();
+            mheap.push_back( timer_id );
+        }
+        // the expiry time may have moved in both directions.
+        siftUp( tim.heap_index );
+        siftDown( tim.heap_index );
+        return tim.heap_index == 0;
+    }
+
+    void Timer::unschedule(TimerId timer_id)
+    {
+        TimerInfo& tim = mtimers[timer_id];
+        int i = tim.heap_index;
+        if ( i < 0 )
+            return;
+        int last = mheap.size() - 1;
+        if ( i != last )
+            heapSwap( i, last );
+        mheap.pop_back();
+        tim.heap_index = -1;
+        if ( i != last ) {
+            siftUp( i );
+            siftDown( i );
+        }
     }
 
     bool Timer::startTimer(TimerId timer_id, double period)
@@ -170,12 +239,16 @@ namespace RTT {
 
         Time due_time = rtos_get_time_ns() + Seconds_to_nsecs( period );
 
+        bool first;
         {
             MutexLock locker(m);
             mtimers[timer_id].expires = due_time;
             mtimers[timer_id].period = Seconds_to_nsecs( period );
+            first = schedule( timer_id );
         }
-        msem.signal();
+        // only wake up loop() if it must wait less long.
+        if ( first )
+            msem.signal();
         return true;
     }
 
@@ -190,12 +263,16 @@ namespace RTT {
         Time now = rtos_get_time_ns();
         Time due_time = now + Seconds_to_nsecs( wait_time );
 
+        bool first;
         {
             MutexLock locker(m);
             mtimers[timer_id].expires  = due_time;
             mtimers[timer_id].period = 0;
+            first = schedule( timer_id );
         }
-        msem.signal();
+        // only wake up loop() if it must wait less long.
+        if ( first )
+            msem.signal();
         return true;
     }
 
@@ -234,6 +311,8 @@ namespace RTT {
             log(Error) << "Invalid timer id" << endlog();
             return false;
         }
+        // loop() may wake up once more for a killed timer, which is harmless.
+        unschedule( timer_id );
         mtimers[timer_id].expires = 0;
         mtimers[timer_id].period = 0;
         mtimers[timer_id].expired.broadcast();
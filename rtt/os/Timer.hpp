@@ -80,11 +80,12 @@ namespace RTT
 
         struct TimerInfo
         {
-            TimerInfo() : expires(0), period(0) {}
+            TimerInfo() : expires(0), period(0), heap_index(-1) {}
             TimerInfo(const TimerInfo& other) { *this = other; }
-            TimerInfo& operator=(const TimerInfo& other) { this->expires = other.expires; this->period = other.period; return *this; }
+            TimerInfo& operator=(const TimerInfo& other) { this->expires = other.expires; this->period = other.period; this->heap_index = other.heap_index; return *this; }
             Time expires; // was .first
             Time period;  // was .second
+            int heap_index; // position in mheap, -1 if not armed.
             Condition expired;
         };
 
@@ -95,6 +96,35 @@ namespace RTT
          */
         typedef std::vector<TimerInfo> TimerIds;
         TimerIds mtimers;
+
+        /**
+         * A binary min-heap of the armed timer ids, ordered
+         * by expiry time. The first element expires first.
+         */
+        std::vector<TimerId> mheap;
+
+        /**
+         * The timers which expired in the current wake-up.
+         * Only used by loop().
+         */
+        std::vector<TimerId> mexpired;
+
+        /**
+         * Insert or move \a timer_id in the heap after its
+         * expiry time was changed. Requires the lock on m.
+         * @return true if it became the first timer to expire.
+         */
+        bool schedule(TimerId timer_id);
+
+        /**
+         * Remove \a timer_id from the heap. Requires the lock on m.
+         */
+        void unschedule(TimerId timer_id);
+
+        void heapSwap(int a, int b);
+        void siftUp(int i);
+        void siftDown(int i);
+
         bool mdo_quit;
 
         bool initialize();
@@ -216,6 +216,56 @@ namespace RTT
     return ~0;
     }
 
+    INTERNAL_QUAL int rtos_task_set_cpu_set(RTOS_TASK * task, const CpuSet& cpus)
+    {
+        return rtos_task_set_cpu_affinity(task, cpus.toMask());
+    }
+
+    INTERNAL_QUAL CpuSet rtos_task_get_cpu_set(const RTOS_TASK * task)
+    {
+        return CpuSet( rtos_task_get_cpu_affinity(task) );
+    }
+
+    INTERNAL_QUAL CpuSet rtos_numa_node_cpus(int node)
+    {
+        return CpuSet();
+    }
+
+    INTERNAL_QUAL int rtos_task_set_numa_node(RTOS_TASK * task, int node)
+    {
+        return node < 0 ? 0 : -1;
+    }
+
+    INTERNAL_QUAL int rtos_lock_memory()
+    {
+        return rtos_memory_locked() ? 0 : -1;
+    }
+
+    INTERNAL_QUAL int rtos_memory_locked()
+    {
+        return 0;
+    }
+
+    INTERNAL_QUAL int rtos_task_prefault_stack(size_t size)
+    {
+        return -1;
+    }
+
+    INTERNAL_QUAL int rtos_task_get_page_faults(long* minor, long* major)
+    {
+        return -1;
+    }
+
+    INTERNAL_QUAL int rtos_task_set_deadline(RTOS_TASK* task, NANO_TIME runtime, NANO_TIME deadline)
+    {
+        return -1;
+    }
+
+    INTERNAL_QUAL NANO_TIME rtos_task_get_cpu_time(const RTOS_TASK* task)
+    {
+        return 0;
+    }
+
 	INTERNAL_QUAL unsigned int rtos_task_get_pid(const RTOS_TASK* task)
 	{
 		return 0;
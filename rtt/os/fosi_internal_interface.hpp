@@ -175,7 +175,9 @@ namespace RTT {
              * wants to go to sleep and wake up the next period.
              * @param task This must be RTOS_TASK struct of the calling thread.
              * @return zero on success (or if the thread is non periodic),
-             * non-zero to indicate an overrun.
+             * non-zero to indicate an overrun. With a deadline reservation,
+             * using more CPU time than the runtime, or passing the deadline,
+             * in a period is an overrun too.
              */
             int rtos_task_wait_period( RTOS_TASK* task );
 
@@ -241,6 +243,83 @@ namespace RTT {
              */
             unsigned rtos_task_get_cpu_affinity(const RTOS_TASK * task);
 
+            /**
+             * Set the cpus a thread may run on, without the 32 cpu limit
+             * of rtos_task_set_cpu_affinity. An empty set clears the affinity.
+             * @return 0 if the cpu set could be applied.
+             */
+            int rtos_task_set_cpu_set(RTOS_TASK * task, const CpuSet& cpus);
+
+            /**
+             * Return the cpus a thread may run on.
+             */
+            CpuSet rtos_task_get_cpu_set(const RTOS_TASK * task);
+
+            /**
+             * Return the cpus of a NUMA node, or an empty set if the node
+             * does not exist or the OS does not report NUMA nodes.
+             */
+            CpuSet rtos_numa_node_cpus(int node);
+
+            /**
+             * Place the calling thread on a NUMA node: it is bound to the
+             * cpus of \a node and the memory it touches first is taken from
+             * \a node. A negative \a node removes the placement again.
+             * This function must be called from within \a task.
+             * @return 0 if the placement could be applied, -1 if the node
+             * does not exist or the OS does not support NUMA placement.
+             */
+            int rtos_task_set_numa_node(RTOS_TASK * task, int node);
+
+            /**
+             * Set the CPU time reservation of a thread for the deadline
+             * scheduler. It is used when the thread runs with the
+             * ORO_SCHED_DEADLINE scheduler, and the period of the
+             * reservation is the period of the thread.
+             * @param task The thread to change.
+             * @param runtime The CPU time the thread may use in each period,
+             *        zero removes the reservation.
+             * @param deadline The time since the start of a period by which
+             *        the runtime must be used, zero for the period.
+             * @return 0 if the reservation could be set, -1 if it is invalid
+             * or the OS has no deadline scheduler.
+             */
+            int rtos_task_set_deadline(RTOS_TASK * task, NANO_TIME runtime, NANO_TIME deadline);
+
+            /**
+             * Return the CPU time a thread has used since it was created.
+             * @return the time in nanoseconds, or zero if the OS does not
+             * measure it.
+             */
+            NANO_TIME rtos_task_get_cpu_time(const RTOS_TASK * task);
+
+            /**
+             * Lock all current and future memory of this process into RAM.
+             * @return 0 if the memory could be locked.
+             */
+            int rtos_lock_memory();
+
+            /**
+             * @return 1 if the memory of this process is locked into RAM, 0 otherwise.
+             */
+            int rtos_memory_locked();
+
+            /**
+             * Touch the stack of the calling thread, such that it does not
+             * page fault when it grows later. The part of the stack that is
+             * in use and a small safety margin are left alone.
+             * @param size The number of bytes to touch, or zero for the whole stack.
+             * @return 0 if the stack could be touched.
+             */
+            int rtos_task_prefault_stack(size_t size);
+
+            /**
+             * Return the minor and major page faults of the calling thread
+             * since it was created.
+             * @return 0 on success, -1 if the OS does not count them per thread.
+             */
+            int rtos_task_get_page_faults(long* minor, long* major);
+
             /**
              * Returns the name by which a task is known in the RTOS.
              * @param task The task to query.
@@ -36,8 +36,18 @@
  ***************************************************************************/
 
 
+#include "../../rtt-config.h"
 #include "fosi.h"
 
-
-
-
+clockid_t rtos_clock_id = ORO_OS_CLOCK;
+
+int rtos_set_clock( clockid_t clock )
+{
+    TIME_SPEC tv;
+    if ( clock != CLOCK_REALTIME && clock != CLOCK_MONOTONIC && clock != CLOCK_MONOTONIC_RAW )
+        return -1;
+    if ( clock_gettime( clock, &tv ) != 0 )
+        return -1;
+    rtos_clock_id = clock;
+    return 0;
+}
@@ -53,6 +53,11 @@ extern "C"
 #include <time.h>
 #include <unistd.h>
 
+#ifdef ORO_OS_USE_FUTEX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
 
     typedef long long NANO_TIME;
     typedef long long TICK_TIME;
@@ -80,11 +85,29 @@ extern "C"
     int priority;
     int wait_policy;
     pid_t pid;
+
+    NANO_TIME runtime;  // the deadline reservation, see rtos_task_set_deadline()
+    NANO_TIME deadline;
+    NANO_TIME cpu_mark; // CPU time used at the start of this period
   } RTOS_TASK;
 
 
+#ifndef ORO_OS_CLOCK
+/** The default clock of the time base, see rtos_set_clock(). */
+#define ORO_OS_CLOCK CLOCK_REALTIME
+#endif
+
+/* glibc 2.30 added timed waits on a chosen clock, older versions wait on CLOCK_REALTIME. */
+#if defined(__USE_GNU) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 30))
+#define ORO_OS_HAVE_CLOCKWAIT
+#endif
+
 #define ORO_SCHED_RT    SCHED_FIFO /** Linux FIFO scheduler */
 #define ORO_SCHED_OTHER SCHED_OTHER /** Linux normal scheduler */
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+#define ORO_SCHED_DEADLINE SCHED_DEADLINE /** Linux deadline scheduler, see rtos_task_set_deadline() */
 
 
 	// high-resolution time to timespec
@@ -97,11 +120,34 @@ extern "C"
 		return timevl;
 	}
 
-    static inline NANO_TIME rtos_get_time_ns( void )
+    /**
+     * The clock of the time base, CLOCK_REALTIME, CLOCK_MONOTONIC or
+     * CLOCK_MONOTONIC_RAW. It defaults to ORO_OS_CLOCK and can be changed
+     * with the ORO_CLOCK environment variable or rtos_set_clock().
+     */
+    extern clockid_t rtos_clock_id;
+
+    /**
+     * Selects the clock of the time base. This must be done before any
+     * thread, timer or timed wait uses an absolute time, for example
+     * before __os_init() or from within main() before creating activities.
+     * @return 0 on success, -1 if \a clock is not supported.
+     */
+    int rtos_set_clock( clockid_t clock );
+
+    /**
+     * The clock on which sleeps and timed waits are done. The kernel can not
+     * sleep on CLOCK_MONOTONIC_RAW, so that time base waits on CLOCK_MONOTONIC.
+     */
+    static inline clockid_t rtos_wait_clock( void )
     {
+        return rtos_clock_id == CLOCK_MONOTONIC_RAW ? CLOCK_MONOTONIC : rtos_clock_id;
+    }
 
+    static inline NANO_TIME rtos_clock_get_ns( clockid_t clock )
+    {
         TIME_SPEC tv;
-        clock_gettime(CLOCK_REALTIME, &tv);
+        clock_gettime(clock, &tv);
         // we can not include the C++ Time.hpp header !
 #ifdef __cplusplus
         return NANO_TIME( tv.tv_sec ) * 1000000000LL + NANO_TIME( tv.tv_nsec );
@@ -110,6 +156,27 @@ extern "C"
 #endif
     }
 
+    static inline NANO_TIME rtos_get_time_ns( void )
+    {
+        return rtos_clock_get_ns( rtos_clock_id );
+    }
+
+    /**
+     * Converts an absolute time of the time base into an absolute
+     * timespec on \a clock, keeping the time left until \a abs_time.
+     */
+    static inline TIME_SPEC rtos_rebase_time( NANO_TIME abs_time, clockid_t clock )
+    {
+        NANO_TIME base;
+        if ( clock == rtos_clock_id || abs_time == InfiniteNSecs )
+            return ticks2timespec( abs_time );
+        base = rtos_clock_get_ns( clock );
+        abs_time -= rtos_get_time_ns();
+        if ( abs_time > InfiniteNSecs - base )
+            return ticks2timespec( InfiniteNSecs );
+        return ticks2timespec( base + abs_time );
+    }
+
     /**
      * This function should return ticks,
      * but we use ticks == nsecs in userspace
@@ -142,7 +209,110 @@ extern "C"
         return count;
     }
 
-	typedef sem_t rt_sem_t;
+#ifdef ORO_OS_USE_FUTEX
+
+    /**
+     * Waits on \a addr as long as it holds \a val, until the absolute
+     * time \a abs_time on \a clock or forever if \a abs_time is null.
+     * @return 0 when woken up, -1 with errno set otherwise.
+     */
+    static inline int rtos_futex_wait( volatile int* addr, int val, const TIME_SPEC* abs_time, clockid_t clock )
+    {
+        int op = FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG;
+        if ( abs_time && clock == CLOCK_REALTIME )
+            op |= FUTEX_CLOCK_REALTIME;
+        return syscall( SYS_futex, addr, op, val, abs_time, NULL, FUTEX_BITSET_MATCH_ANY );
+    }
+
+    static inline int rtos_futex_wake( volatile int* addr, int count )
+    {
+        return syscall( SYS_futex, addr, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, count, NULL, NULL, 0 );
+    }
+
+    /**
+     * A counting semaphore on a futex. Posting and taking an available
+     * count are a single atomic operation, the kernel is only entered
+     * when a waiter must sleep or a sleeping waiter must be woken.
+     */
+    typedef struct {
+        volatile int value;
+        volatile int waiters;
+    } rt_sem_t;
+
+    static inline int rtos_sem_init(rt_sem_t* m, int value )
+    {
+        m->value = value;
+        m->waiters = 0;
+        return 0;
+    }
+
+    static inline int rtos_sem_destroy(rt_sem_t* m )
+    {
+        return 0;
+    }
+
+    static inline int rtos_sem_signal(rt_sem_t* m )
+    {
+        __sync_fetch_and_add( &m->value, 1 );
+        if ( m->waiters )
+            rtos_futex_wake( &m->value, 1 );
+        return 0;
+    }
+
+    static inline int rtos_sem_trywait(rt_sem_t* m )
+    {
+        int val = m->value;
+        while ( val > 0 ) {
+            int old = __sync_val_compare_and_swap( &m->value, val, val - 1 );
+            if ( old == val )
+                return 0;
+            val = old;
+        }
+        errno = EAGAIN;
+        return -1;
+    }
+
+    static inline int rtos_sem_wait_abs(rt_sem_t* m, const TIME_SPEC* abs_time, clockid_t clock )
+    {
+        int ret;
+        while ( rtos_sem_trywait(m) != 0 ) {
+            __sync_fetch_and_add( &m->waiters, 1 );
+            ret = rtos_futex_wait( &m->value, 0, abs_time, clock );
+            __sync_fetch_and_sub( &m->waiters, 1 );
+            if ( ret == -1 && errno == ETIMEDOUT ) {
+                if ( rtos_sem_trywait(m) == 0 )
+                    return 0;
+                errno = ETIMEDOUT;
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    static inline int rtos_sem_wait(rt_sem_t* m )
+    {
+        return rtos_sem_wait_abs( m, NULL, CLOCK_MONOTONIC );
+    }
+
+    static inline int rtos_sem_wait_timed(rt_sem_t* m, NANO_TIME delay )
+    {
+        TIME_SPEC arg_time = ticks2timespec( rtos_clock_get_ns( CLOCK_MONOTONIC ) + delay );
+        return rtos_sem_wait_abs( m, &arg_time, CLOCK_MONOTONIC );
+    }
+
+    static inline int rtos_sem_wait_until(rt_sem_t* m, NANO_TIME abs_time )
+    {
+        TIME_SPEC arg_time = rtos_rebase_time( abs_time, rtos_wait_clock() );
+        return rtos_sem_wait_abs( m, &arg_time, rtos_wait_clock() );
+    }
+
+    static inline int rtos_sem_value(rt_sem_t* m )
+    {
+        return m->value;
+    }
+
+#else
+    typedef sem_t rt_sem_t;
 
     static inline int rtos_sem_init(rt_sem_t* m, int value )
     {
@@ -172,7 +342,12 @@ extern "C"
     static inline int rtos_sem_wait_timed(rt_sem_t* m, NANO_TIME delay )
     {
 		TIME_SPEC timevl, delayvl;
-        clock_gettime(CLOCK_REALTIME, &timevl);
+#ifdef ORO_OS_HAVE_CLOCKWAIT
+        const clockid_t clock = rtos_wait_clock();
+#else
+        const clockid_t clock = CLOCK_REALTIME;
+#endif
+        clock_gettime(clock, &timevl);
         delayvl = ticks2timespec(delay);
 
         // add current time with delay, detect&correct overflows.
@@ -188,13 +363,22 @@ extern "C"
 
         /// \todo should really deal with errno=EINTR due to signal,
         /// and errno=ETIMEDOUT appropriately.
+#ifdef ORO_OS_HAVE_CLOCKWAIT
+        return sem_clockwait( m, clock, &timevl);
+#else
         return sem_timedwait( m, &timevl);
+#endif
     }
 
     static inline int rtos_sem_wait_until(rt_sem_t* m, NANO_TIME abs_time )
     {
-        TIME_SPEC arg_time = ticks2timespec( abs_time );
+#ifdef ORO_OS_HAVE_CLOCKWAIT
+        TIME_SPEC arg_time = rtos_rebase_time( abs_time, rtos_wait_clock() );
+        return sem_clockwait( m, rtos_wait_clock(), &arg_time);
+#else
+        TIME_SPEC arg_time = rtos_rebase_time( abs_time, CLOCK_REALTIME );
         return sem_timedwait( m, &arg_time);
+#endif
     }
 
     static inline int rtos_sem_value(rt_sem_t* m )
@@ -205,14 +389,36 @@ extern "C"
 		return -1;
     }
 
+#endif
+
     // Mutex functions
 
     typedef pthread_mutex_t rt_mutex_t;
     typedef pthread_mutex_t rt_rec_mutex_t;
 
+/* glibc can not wait for a priority inheritance mutex on CLOCK_MONOTONIC on all kernels. */
+#if defined(ORO_OS_HAVE_CLOCKWAIT) && !defined(ORO_OS_MUTEX_PRIO_INHERIT)
+#define ORO_OS_HAVE_MUTEX_CLOCKLOCK
+#endif
+
+    /**
+     * With ORO_OS_MUTEX_PRIO_INHERIT, a thread holding a mutex runs at the
+     * priority of the highest priority thread waiting for it, such that
+     * a low priority owner can not be preempted by medium priority threads.
+     */
     static inline int rtos_mutex_init(rt_mutex_t* m)
     {
+#ifdef ORO_OS_MUTEX_PRIO_INHERIT
+        int ret;
+        pthread_mutexattr_t ma_t;
+        pthread_mutexattr_init(&ma_t);
+        pthread_mutexattr_setprotocol(&ma_t, PTHREAD_PRIO_INHERIT);
+        ret = pthread_mutex_init(m, &ma_t );
+        pthread_mutexattr_destroy(&ma_t);
+        return ret;
+#else
         return pthread_mutex_init(m, 0 );
+#endif
     }
 
     static inline int rtos_mutex_destroy(rt_mutex_t* m )
@@ -225,6 +431,9 @@ extern "C"
         pthread_mutexattr_t ma_t;
         pthread_mutexattr_init(&ma_t);
 		pthread_mutexattr_settype(&ma_t,PTHREAD_MUTEX_RECURSIVE_NP);
+#ifdef ORO_OS_MUTEX_PRIO_INHERIT
+        pthread_mutexattr_setprotocol(&ma_t, PTHREAD_PRIO_INHERIT);
+#endif
         return pthread_mutex_init(m, &ma_t );
     }
 
@@ -245,14 +454,24 @@ extern "C"
 
     static inline int rtos_mutex_lock_until( rt_mutex_t* m, NANO_TIME abs_time)
     {
-        TIME_SPEC arg_time = ticks2timespec( abs_time );
+#ifdef ORO_OS_HAVE_MUTEX_CLOCKLOCK
+        TIME_SPEC arg_time = rtos_rebase_time( abs_time, rtos_wait_clock() );
+        return pthread_mutex_clocklock(m, rtos_wait_clock(), &arg_time);
+#else
+        TIME_SPEC arg_time = rtos_rebase_time( abs_time, CLOCK_REALTIME );
         return pthread_mutex_timedlock(m, &arg_time);
+#endif
     }
 
     static inline int rtos_mutex_rec_lock_until( rt_mutex_t* m, NANO_TIME abs_time)
     {
-        TIME_SPEC arg_time = ticks2timespec( abs_time );
+#ifdef ORO_OS_HAVE_MUTEX_CLOCKLOCK
+        TIME_SPEC arg_time = rtos_rebase_time( abs_time, rtos_wait_clock() );
+        return pthread_mutex_clocklock(m, rtos_wait_clock(), &arg_time);
+#else
+        TIME_SPEC arg_time = rtos_rebase_time( abs_time, CLOCK_REALTIME );
         return pthread_mutex_timedlock(m, &arg_time);
+#endif
     }
 
     static inline int rtos_mutex_trylock( rt_mutex_t* m)
@@ -283,11 +502,79 @@ extern "C"
     {
     }
 
+#ifdef ORO_OS_USE_FUTEX
+
+    /**
+     * A condition variable on a futex. A broadcast bumps the sequence
+     * number and only enters the kernel when a thread is waiting.
+     * Timed waits are done on CLOCK_MONOTONIC.
+     */
+    typedef struct {
+        volatile int seq;
+        volatile int waiters;
+    } rt_cond_t;
+
+    static inline int rtos_cond_init(rt_cond_t *cond)
+    {
+        cond->seq = 0;
+        cond->waiters = 0;
+        return 0;
+    }
+
+    static inline int rtos_cond_destroy(rt_cond_t *cond)
+    {
+        return 0;
+    }
+
+    static inline int rtos_cond_wait_abs(rt_cond_t *cond, rt_mutex_t *mutex, const TIME_SPEC* abs_time)
+    {
+        int ret;
+        int seq = cond->seq;
+        __sync_fetch_and_add( &cond->waiters, 1 );
+        pthread_mutex_unlock(mutex);
+        ret = rtos_futex_wait( &cond->seq, seq, abs_time, CLOCK_MONOTONIC );
+        ret = ( ret == -1 && errno == ETIMEDOUT ) ? ETIMEDOUT : 0;
+        __sync_fetch_and_sub( &cond->waiters, 1 );
+        pthread_mutex_lock(mutex);
+        return ret;
+    }
+
+    static inline int rtos_cond_wait(rt_cond_t *cond, rt_mutex_t *mutex)
+    {
+        return rtos_cond_wait_abs(cond, mutex, NULL);
+    }
+
+    static inline int rtos_cond_timedwait(rt_cond_t *cond, rt_mutex_t *mutex, NANO_TIME abs_time)
+    {
+        TIME_SPEC arg_time = rtos_rebase_time( abs_time, CLOCK_MONOTONIC );
+        return rtos_cond_wait_abs(cond, mutex, &arg_time);
+    }
+
+    static inline int rtos_cond_broadcast(rt_cond_t *cond)
+    {
+        __sync_fetch_and_add( &cond->seq, 1 );
+        if ( cond->waiters )
+            rtos_futex_wake( &cond->seq, INT_MAX );
+        return 0;
+    }
+
+#else
+
     typedef pthread_cond_t rt_cond_t;
 
+    /**
+     * Condition variables always wait on CLOCK_MONOTONIC, such that a step
+     * of the wall clock does not stretch or cut a timed wait.
+     */
     static inline int rtos_cond_init(rt_cond_t *cond)
     {
-        return pthread_cond_init(cond, NULL);
+        int ret;
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        ret = pthread_cond_init(cond, &attr);
+        pthread_condattr_destroy(&attr);
+        return ret;
     }
 
     static inline int rtos_cond_destroy(rt_cond_t *cond)
@@ -302,7 +589,7 @@ extern "C"
 
     static inline int rtos_cond_timedwait(rt_cond_t *cond, rt_mutex_t *mutex, NANO_TIME abs_time)
     {
-        TIME_SPEC arg_time = ticks2timespec( abs_time );
+        TIME_SPEC arg_time = rtos_rebase_time( abs_time, CLOCK_MONOTONIC );
         return pthread_cond_timedwait(cond, mutex, &arg_time);
     }
 
@@ -311,6 +598,8 @@ extern "C"
         return pthread_cond_broadcast(cond);
     }
 
+#endif
+
 #define rtos_printf printf
 
 #ifdef __cplusplus
@@ -50,6 +50,11 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include <cstdio>
+#include <sys/mman.h>
+#include <alloca.h>
+#include <stdint.h>
 
 using namespace std;
 
@@ -58,10 +63,52 @@ using namespace std;
 namespace RTT
 { namespace os {
 
+    /**
+     * Applies the ORO_LOCK_MEMORY environment variable. When it is set,
+     * and not 0, the memory of the process is locked into RAM and threads
+     * prefault their stack when they are created.
+     */
+    static void rtos_select_memory_lock()
+    {
+        const char* lock = getenv("ORO_LOCK_MEMORY");
+        if ( lock == 0 || strcmp(lock, "0") == 0 )
+            return;
+        if ( rtos_lock_memory() == 0 )
+            log(Info) << "Locked all memory into RAM." << endlog();
+        else
+            log(Error) << "Could not lock memory into RAM: " << strerror(errno)
+                       << ". Raise RLIMIT_MEMLOCK or run with CAP_IPC_LOCK." << endlog();
+    }
+
+    /**
+     * Applies the ORO_CLOCK environment variable, which selects the clock
+     * of the time base: REALTIME, MONOTONIC or MONOTONIC_RAW, optionally
+     * prefixed with CLOCK_.
+     */
+    static void rtos_select_clock()
+    {
+        const char* clock = getenv("ORO_CLOCK");
+        if ( clock == 0 )
+            return;
+        if ( strncmp(clock, "CLOCK_", 6) == 0 )
+            clock += 6;
+        if ( strcmp(clock, "REALTIME") == 0 && rtos_set_clock(CLOCK_REALTIME) == 0 )
+            log(Info) << "Using CLOCK_REALTIME as time base." << endlog();
+        else if ( strcmp(clock, "MONOTONIC") == 0 && rtos_set_clock(CLOCK_MONOTONIC) == 0 )
+            log(Info) << "Using CLOCK_MONOTONIC as time base." << endlog();
+        else if ( strcmp(clock, "MONOTONIC_RAW") == 0 && rtos_set_clock(CLOCK_MONOTONIC_RAW) == 0 )
+            log(Info) << "Using CLOCK_MONOTONIC_RAW as time base." << endlog();
+        else
+            log(Error) << "Unsupported clock ORO_CLOCK=" << getenv("ORO_CLOCK") << ", keeping the default time base." << endlog();
+    }
+
 	INTERNAL_QUAL int rtos_task_create_main(RTOS_TASK* main_task)
 	{
         const char* name = "main";
+        rtos_select_clock();
+        rtos_select_memory_lock();
         main_task->wait_policy = ORO_WAIT_ABS;
+        main_task->runtime = main_task->deadline = main_task->cpu_mark = 0;
 	    main_task->name = strcpy( (char*)malloc( (strlen(name) + 1) * sizeof(char)), name);
         main_task->thread = pthread_self();
 	    pthread_attr_init( &(main_task->attr) );
@@ -113,7 +160,12 @@ namespace RTT
 	{
         int rv; // return value
         task->wait_policy = ORO_WAIT_ABS;
+        task->runtime = task->deadline = task->cpu_mark = 0;
         rtos_task_check_priority( &sched_type, &priority );
+        // A thread can not be created with SCHED_DEADLINE, it switches
+        // itself once it has a reservation, see rtos_task_set_deadline().
+        if ( sched_type == SCHED_DEADLINE )
+            sched_type = SCHED_OTHER;
         // Save priority internally, since the pthread_attr* calls are broken !
         // we will pick it up later in rtos_task_set_scheduler().
         task->priority = priority;
@@ -194,12 +246,69 @@ namespace RTT
 	    return 1;
 	}
 
+    /**
+     * The argument of the sched_setattr system call, which glibc does not
+     * wrap on all versions.
+     */
+    struct rtos_sched_attr {
+        uint32_t size;
+        uint32_t sched_policy;
+        uint64_t sched_flags;
+        int32_t sched_nice;
+        uint32_t sched_priority;
+        uint64_t sched_runtime;
+        uint64_t sched_deadline;
+        uint64_t sched_period;
+    };
+
+    /**
+     * Runs \a task under SCHED_DEADLINE with its reservation and period.
+     */
+    static int rtos_task_apply_deadline(RTOS_TASK* task)
+    {
+        if ( task->runtime == 0 || task->period == 0 ) {
+            log(Error) << "Thread " << task->name << " needs a period and a runtime for SCHED_DEADLINE." << endlog();
+            return -1;
+        }
+#ifdef SYS_sched_setattr
+        struct rtos_sched_attr attr;
+        memset( &attr, 0, sizeof(attr) );
+        attr.size = sizeof(attr);
+        attr.sched_policy = SCHED_DEADLINE;
+        attr.sched_runtime = task->runtime;
+        attr.sched_deadline = task->deadline ? task->deadline : task->period;
+        attr.sched_period = task->period;
+        if ( syscall(SYS_sched_setattr, task->pid, &attr, 0) == 0 )
+            return 0;
+        log(Error) << "Could not run thread " << task->name << " under SCHED_DEADLINE: " << strerror(errno) << endlog();
+#endif
+        return -1;
+    }
+
+    INTERNAL_QUAL int rtos_task_set_deadline(RTOS_TASK* task, NANO_TIME runtime, NANO_TIME deadline)
+    {
+        if ( runtime < 0 || deadline < 0 || (deadline != 0 && deadline < runtime) )
+            return -1;
+        bool active = rtos_task_get_scheduler(task) == SCHED_DEADLINE;
+        // a thread under SCHED_DEADLINE must leave it before it loses its reservation.
+        if ( active && runtime == 0 )
+            return -1;
+        task->runtime = runtime;
+        task->deadline = deadline;
+        task->cpu_mark = rtos_task_get_cpu_time(task);
+        if ( active )
+            return rtos_task_apply_deadline(task);
+        return 0;
+    }
+
     INTERNAL_QUAL int rtos_task_set_scheduler(RTOS_TASK* task, int sched_type) {
         int policy = -1;
         struct sched_param param;
         // first check the argument
         if ( task && task->thread != 0 && rtos_task_check_scheduler( &sched_type) == -1 )
             return -1;
+        if ( sched_type == SCHED_DEADLINE )
+            return rtos_task_apply_deadline(task);
         // if sched_type is different, the priority must change as well.
         if (pthread_getschedparam(task->thread, &policy, &param) == 0) {
             // now update the priority
@@ -214,7 +323,11 @@ namespace RTT
     INTERNAL_QUAL int rtos_task_get_scheduler(const RTOS_TASK* task) {
         int policy = -1;
         struct sched_param param;
-        // first retrieve thread scheduling parameters:
+        // only a thread with a reservation can be under SCHED_DEADLINE, which
+        // glibc does not know about: ask the kernel for those threads only.
+        if ( task && task->runtime != 0 && task->pid != 0 && (policy = sched_getscheduler(task->pid)) != -1 )
+            return policy & ~SCHED_RESET_ON_FORK;
+        // glibc returns the policy it cached, without a system call.
         if ( task && task->thread != 0 && pthread_getschedparam(task->thread, &policy, &param) == 0)
             return policy;
         return -1;
@@ -222,8 +335,15 @@ namespace RTT
 
 	INTERNAL_QUAL void rtos_task_make_periodic(RTOS_TASK* mytask, NANO_TIME nanosecs )
 	{
+	    // the reservation period follows the period of the thread.
+	    bool reserve = nanosecs != 0 && nanosecs != mytask->period && mytask->runtime != 0
+	        && rtos_task_get_scheduler(mytask) == SCHED_DEADLINE;
 	    // set period
 	    mytask->period = nanosecs;
+	    if ( reserve )
+	        rtos_task_apply_deadline(mytask);
+	    if ( mytask->runtime != 0 )
+	        mytask->cpu_mark = rtos_task_get_cpu_time(mytask);
 	    // set next wake-up time.
 	    mytask->periodMark = ticks2timespec( nano2ticks( rtos_get_time_ns() + nanosecs ) );
 	}
@@ -246,10 +366,16 @@ namespace RTT
         // record this to detect overrun.
 	    NANO_TIME now = rtos_get_time_ns();
 	    NANO_TIME wake= task->periodMark.tv_sec * 1000000000LL + task->periodMark.tv_nsec;
-
-        // inspired by nanosleep man page for this construct:
-        while ( clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &(task->periodMark), NULL) != 0 && errno == EINTR ) {
-            errno = 0;
+	    // with a reservation, using more than the runtime or missing the deadline is an overrun too.
+	    bool overbudget = false;
+	    if ( task->runtime != 0 )
+	        overbudget = rtos_task_get_cpu_time(task) - task->cpu_mark > task->runtime
+	            || ( task->deadline != 0 && now > wake - task->period + task->deadline );
+
+        // periodMark is on the time base, which may not be the clock we sleep on.
+        TIME_SPEC mark = rtos_rebase_time( wake, rtos_wait_clock() );
+        // clock_nanosleep returns the error instead of setting errno.
+        while ( clock_nanosleep(rtos_wait_clock(), TIMER_ABSTIME, &mark, NULL) == EINTR ) {
         }
 
         if (task->wait_policy == ORO_WAIT_ABS)
@@ -271,7 +397,9 @@ namespace RTT
           task->periodMark.tv_sec = ts.tv_sec + now.tv_sec + tn / 1000000000LL;
         }
 
-	    return now > wake ? -1 : 0;
+	    if ( task->runtime != 0 )
+	        task->cpu_mark = rtos_task_get_cpu_time(task);
+	    return (now > wake || overbudget) ? -1 : 0;
 	}
 
 	INTERNAL_QUAL void rtos_task_delete(RTOS_TASK* mytask) {
@@ -290,6 +418,17 @@ namespace RTT
         }
 #endif
 
+        if (*scheduler == SCHED_DEADLINE && geteuid() != 0
+#ifdef ORO_OS_LINUX_CAP_NG
+            && capng_have_capability(CAPNG_EFFECTIVE, CAP_SYS_NICE)==0
+#endif
+            ) {
+            // the rtprio ulimit does not allow SCHED_DEADLINE.
+            log(Warning) << "Lowering scheduler type to SCHED_OTHER, SCHED_DEADLINE requires CAP_SYS_NICE." <<endlog();
+            *scheduler = SCHED_OTHER;
+            return -1;
+        }
+
         if (*scheduler != SCHED_OTHER && geteuid() != 0
 #ifdef ORO_OS_LINUX_CAP_NG
             && capng_have_capability(CAPNG_EFFECTIVE, CAP_SYS_NICE)==0
@@ -307,7 +446,7 @@ namespace RTT
             }
         }
 
-        if (*scheduler != SCHED_OTHER && *scheduler != SCHED_FIFO && *scheduler != SCHED_RR ) {
+        if (*scheduler != SCHED_OTHER && *scheduler != SCHED_FIFO && *scheduler != SCHED_RR && *scheduler != SCHED_DEADLINE ) {
             log(Error) << "Unknown scheduler type." <<endlog();
             *scheduler = SCHED_OTHER;
             return -1;
@@ -322,10 +461,10 @@ namespace RTT
         ret = rtos_task_check_scheduler(scheduler);
 
         // correct priority
-        if (*scheduler == SCHED_OTHER) {
+        if (*scheduler == SCHED_OTHER || *scheduler == SCHED_DEADLINE) {
             if ( *priority != 0 ) {
                 if (*priority != LowestPriority)
-                    log(Warning) << "Forcing priority ("<<*priority<<") of thread with SCHED_OTHER policy to 0." <<endlog();
+                    log(Warning) << "Forcing priority ("<<*priority<<") of thread with SCHED_OTHER or SCHED_DEADLINE policy to 0." <<endlog();
                 *priority = 0;
                 ret = -1;
             }
@@ -429,6 +568,137 @@ namespace RTT
         return ~0;
         }
 
+	INTERNAL_QUAL int rtos_task_set_cpu_set(RTOS_TASK * task, const CpuSet& cpus)
+	{
+        if( task && task->thread != 0 ) {
+            cpu_set_t cs;
+            CPU_ZERO(&cs);
+            for(unsigned i = 0; i < CPU_SETSIZE && i < CpuSet::MaxCpus; i++)
+                if ( cpus.empty() || cpus.isSet(i) ) // an empty set clears the mask.
+                    CPU_SET(i, &cs);
+            return pthread_setaffinity_np(task->thread, sizeof(cs), &cs);
+        }
+        return -1;
+    }
+
+	INTERNAL_QUAL CpuSet rtos_task_get_cpu_set(const RTOS_TASK * task)
+	{
+        CpuSet cpus;
+        cpu_set_t cs;
+        if( task && task->thread != 0 && pthread_getaffinity_np(task->thread, sizeof(cs), &cs) == 0 ) {
+            for(unsigned i = 0; i < CPU_SETSIZE && i < CpuSet::MaxCpus; i++)
+                if ( CPU_ISSET(i, &cs) )
+                    cpus.set(i);
+        }
+        return cpus;
+    }
+
+	INTERNAL_QUAL CpuSet rtos_numa_node_cpus(int node)
+	{
+        CpuSet cpus;
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE* f = node >= 0 ? fopen(path, "r") : 0;
+        if ( f == 0 )
+            return cpus;
+        // the list looks like "0-3,8-11"
+        unsigned first, last;
+        while ( fscanf(f, "%u", &first) == 1 ) {
+            last = first;
+            int c = fgetc(f);
+            if ( c == '-' ) {
+                if ( fscanf(f, "%u", &last) != 1 )
+                    break;
+                c = fgetc(f);
+            }
+            for (unsigned i = first; i <= last && i < CpuSet::MaxCpus; ++i)
+                cpus.set(i);
+            if ( c != ',' )
+                break;
+        }
+        fclose(f);
+        return cpus;
+    }
+
+	INTERNAL_QUAL int rtos_task_set_numa_node(RTOS_TASK * task, int node)
+	{
+        if ( node < 0 ) {
+            syscall(SYS_set_mempolicy, MPOL_DEFAULT, NULL, 0);
+            return rtos_task_set_cpu_set(task, CpuSet());
+        }
+        if ( node >= ORONUM_OS_MAX_CPUS )
+            return -1;
+        CpuSet cpus = rtos_numa_node_cpus(node);
+        if ( cpus.empty() || rtos_task_set_cpu_set(task, cpus) != 0 )
+            return -1;
+        // prefer, but do not force, the node for the pages this thread faults in.
+        unsigned long nodes[ORONUM_OS_MAX_CPUS / (8 * sizeof(unsigned long))] = { 0 };
+        nodes[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+        return syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodes, 8 * sizeof(nodes) + 1) == 0 ? 0 : -1;
+    }
+
+    static int memory_locked = 0;
+
+	INTERNAL_QUAL int rtos_lock_memory()
+	{
+        if ( mlockall(MCL_CURRENT | MCL_FUTURE) != 0 )
+            return -1;
+        memory_locked = 1;
+        return 0;
+    }
+
+	INTERNAL_QUAL int rtos_memory_locked()
+	{
+        return memory_locked;
+    }
+
+	INTERNAL_QUAL int rtos_task_prefault_stack(size_t size)
+	{
+        pthread_attr_t attr;
+        void* stack_addr;
+        size_t stack_size, guard_size;
+        if ( pthread_getattr_np(pthread_self(), &attr) != 0 )
+            return -1;
+        pthread_attr_getstack(&attr, &stack_addr, &stack_size);
+        pthread_attr_getguardsize(&attr, &guard_size);
+        pthread_attr_destroy(&attr);
+
+        // the stack grows down from here to stack_addr, keep a few pages away from the guard.
+        const size_t page = sysconf(_SC_PAGESIZE);
+        char here;
+        size_t free_size = &here - (char*)stack_addr;
+        if ( free_size <= guard_size + 4 * page )
+            return -1;
+        free_size -= guard_size + 4 * page;
+        if ( size == 0 || size > free_size )
+            size = free_size;
+
+        volatile char* stack = (volatile char*)alloca(size);
+        for (size_t i = 0; i < size; i += page)
+            stack[i] = 0;
+        return 0;
+    }
+
+	INTERNAL_QUAL int rtos_task_get_page_faults(long* minor, long* major)
+	{
+        struct rusage usage;
+        if ( getrusage(RUSAGE_THREAD, &usage) != 0 )
+            return -1;
+        *minor = usage.ru_minflt;
+        *major = usage.ru_majflt;
+        return 0;
+    }
+
+    INTERNAL_QUAL NANO_TIME rtos_task_get_cpu_time(const RTOS_TASK* task)
+    {
+        clockid_t clock;
+        TIME_SPEC ts;
+        if ( task == 0 || task->thread == 0 || pthread_getcpuclockid(task->thread, &clock) != 0
+             || clock_gettime(clock, &ts) != 0 )
+            return 0;
+        return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
 	INTERNAL_QUAL const char * rtos_task_get_name(const RTOS_TASK* task)
 	{
 	    return task->name;
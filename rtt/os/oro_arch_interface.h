@@ -94,5 +94,29 @@ int oro_atomic_inc_and_test(oro_atomic_t *a);
  */
 int oro_cmpxchg(void volatile* ptr, unsigned long o, unsigned long n);
 
+/**
+ * Full memory barrier. No load or store is moved
+ * across this barrier, neither by the compiler nor
+ * by the processor. The barriers are not provided
+ * when OROBLD_OS_NO_ASM is set.
+ */
+void oro_smp_mb();
+
+/**
+ * Acquire barrier. Loads before this barrier are
+ * ordered before all loads and stores after it.
+ * Use it after reading a flag or index which publishes
+ * data written by another thread.
+ */
+void oro_acquire_barrier();
+
+/**
+ * Release barrier. Loads and stores before this barrier
+ * are ordered before all stores after it. Use it before
+ * writing a flag or index which publishes data to another
+ * thread.
+ */
+void oro_release_barrier();
+
 
 #endif // __ORO_ARCH_INTERFACE__
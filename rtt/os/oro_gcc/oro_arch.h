@@ -80,5 +80,24 @@ static __inline__ int oro_atomic_inc_and_test(oro_atomic_t *a_int)
 #define oro_cmpxchg(ptr,o,n)\
     ((__typeof__(*(ptr)))__sync_val_compare_and_swap((ptr),(o),(n)))
 
+#if ( OROBLD_GCC_VERSION >= 40700 )
+/**
+ * Full memory barrier.
+ */
+#define oro_smp_mb()            __atomic_thread_fence(__ATOMIC_SEQ_CST)
+/**
+ * Orders earlier loads before later loads and stores.
+ */
+#define oro_acquire_barrier()   __atomic_thread_fence(__ATOMIC_ACQUIRE)
+/**
+ * Orders earlier loads and stores before later stores.
+ */
+#define oro_release_barrier()   __atomic_thread_fence(__ATOMIC_RELEASE)
+#else
+#define oro_smp_mb()            __sync_synchronize()
+#define oro_acquire_barrier()   __sync_synchronize()
+#define oro_release_barrier()   __sync_synchronize()
+#endif
+
 
 #endif // __GCC_ORO_ARCH__
@@ -155,6 +155,18 @@ static inline unsigned long __oro_cmpxchg(volatile void *ptr, unsigned long old,
     ((__typeof__(*(ptr)))__oro_cmpxchg((ptr),(unsigned long)(o),\
                     (unsigned long)(n),sizeof(*(ptr))))
 
+/**
+ * Full memory barrier. mfence requires SSE2, a locked
+ * add on the stack works on all i386 processors.
+ */
+#define oro_smp_mb()            __asm__ __volatile__("lock; addl $0,0(%%esp)": : :"memory")
+/**
+ * x86 does not reorder loads with other loads or stores with
+ * older loads, so acquire and release only restrain the compiler.
+ */
+#define oro_acquire_barrier()   __asm__ __volatile__("": : :"memory")
+#define oro_release_barrier()   __asm__ __volatile__("": : :"memory")
+
 #undef ORO_LOCK
 #undef ORO_LOCK_PREFIX
 #endif
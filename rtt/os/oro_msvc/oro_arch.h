@@ -103,4 +103,15 @@ template<typename T> inline T oro_cmpxchg(volatile void * ptr, T old, T _new)
 
 #pragma warning(pop)
 
+/**
+ * Full memory barrier.
+ */
+#define oro_smp_mb()            MemoryBarrier()
+/**
+ * x86 and x64 do not reorder loads with other loads or stores with
+ * older loads, so acquire and release only restrain the compiler.
+ */
+#define oro_acquire_barrier()   _ReadWriteBarrier()
+#define oro_release_barrier()   _ReadWriteBarrier()
+
 #endif
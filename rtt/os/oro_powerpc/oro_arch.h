@@ -5,4 +5,15 @@
 #include "oro_atomic.h"
 #include "oro_system.h"
 
+/**
+ * Full memory barrier.
+ */
+#define oro_smp_mb()            __asm__ __volatile__("sync": : :"memory")
+/**
+ * lwsync orders all accesses except older stores with younger loads,
+ * which is sufficient for acquire and release semantics.
+ */
+#define oro_acquire_barrier()   __asm__ __volatile__("lwsync": : :"memory")
+#define oro_release_barrier()   __asm__ __volatile__("lwsync": : :"memory")
+
 #endif /* __ORO_ARCH_POWERPC__ */
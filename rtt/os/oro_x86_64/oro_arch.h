@@ -179,6 +179,17 @@ static inline unsigned long __oro_cmpxchg(volatile void *ptr, unsigned long old,
     ((__typeof__(*(ptr)))__oro_cmpxchg((ptr),(unsigned long)(o),\
                     (unsigned long)(n),sizeof(*(ptr))))
 
+/**
+ * Full memory barrier.
+ */
+#define oro_smp_mb()            __asm__ __volatile__("mfence": : :"memory")
+/**
+ * x86 does not reorder loads with other loads or stores with
+ * older loads, so acquire and release only restrain the compiler.
+ */
+#define oro_acquire_barrier()   __asm__ __volatile__("": : :"memory")
+#define oro_release_barrier()   __asm__ __volatile__("": : :"memory")
+
 #undef ORO_LOCK_PREFIX
 #undef ORO_LOCK
 #endif
@@ -54,3 +54,12 @@ namespace RTT
     }
 
 }}
+
+/**
+ * Lets the RT malloc pool, which is C code, only prefault
+ * its memory when the process locked it.
+ */
+extern "C" int oro_memory_locked(void)
+{
+    return RTT::os::rtos_memory_locked();
+}
@@ -68,6 +68,10 @@
 #define	TLSF_STATISTIC 	(0)
 #endif
 
+#ifndef TLSF_PREFAULT
+#define	TLSF_PREFAULT 	(0)
+#endif
+
 #ifndef USE_MMAP
 #define	USE_MMAP 	(0)
 #endif
@@ -118,6 +122,11 @@
 #define ORO_MEMORY_POOL
 #include "tlsf.h"
 
+#if TLSF_PREFAULT
+/* Defined in os/threads.cpp, returns 1 if the process locked its memory. */
+extern int oro_memory_locked(void);
+#endif
+
 #if !defined(__GNUC__)
 #ifndef __inline__
 #define __inline__
@@ -474,6 +483,12 @@ size_t init_memory_pool(size_t mem_pool_size, void *mem_pool)
     mp = mem_pool;
 
     /* Zeroing the memory pool */
+#if TLSF_PREFAULT
+    /* Touch every page now, such that allocations do not page fault later. */
+    if (oro_memory_locked())
+        memset(mem_pool, 0, mem_pool_size);
+    else
+#endif
     memset(mem_pool, 0, sizeof(tlsf_t));
 
     tlsf->tlsf_signature = TLSF_SIGNATURE;
@@ -50,12 +50,22 @@ RTT::corba::CConnPolicy toCORBA(RTT::ConnPolicy const& policy)
     RTT::corba::CConnPolicy corba_policy;
     corba_policy.type        = RTT::corba::CConnectionModel(policy.type);
     corba_policy.init        = policy.init;
-    corba_policy.lock_policy = RTT::corba::CLockPolicy(policy.lock_policy);
+    // CLockPolicy has no SPSC variant, the remote side uses the general lock-free storage.
+    if (policy.lock_policy == RTT::ConnPolicy::LOCK_FREE_SPSC)
+        corba_policy.lock_policy = RTT::corba::CLockFree;
+    else
+        corba_policy.lock_policy = RTT::corba::CLockPolicy(policy.lock_policy);
     corba_policy.pull        = policy.pull;
     corba_policy.size        = policy.size;
     corba_policy.data_size   = policy.data_size;
     corba_policy.transport   = policy.transport;
     corba_policy.name_id     = CORBA::string_dup( policy.name_id.c_str() );
+    corba_policy.compression = policy.compression;
+    corba_policy.keyframe_period = policy.keyframe_period;
+    corba_policy.max_elements = policy.max_elements;
+    corba_policy.decimation  = policy.decimation;
+    corba_policy.min_period  = policy.min_period;
+    corba_policy.coalesce    = policy.coalesce;
     return corba_policy;
 }
 
@@ -70,5 +80,11 @@ RTT::ConnPolicy toRTT(RTT::corba::CConnPolicy const& corba_policy)
     policy.data_size   = corba_policy.data_size;
     policy.transport   = corba_policy.transport;
     policy.name_id     = corba_policy.name_id;
+    policy.compression = corba_policy.compression;
+    policy.keyframe_period = corba_policy.keyframe_period;
+    policy.max_elements = corba_policy.max_elements;
+    policy.decimation  = corba_policy.decimation;
+    policy.min_period  = corba_policy.min_period;
+    policy.coalesce    = corba_policy.coalesce;
     return policy;
 }
@@ -37,6 +37,20 @@
 
 
 #include "Dispatcher.hpp"
+#include <cerrno>
+#include <cstring>
+#ifdef OROPKG_OS_GNULINUX
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+/**
+ * The maximum number of queue events handled per epoll_wait() call.
+ */
+#ifndef ORONUM_MQUEUE_DISPATCH_EVENTS
+#define ORONUM_MQUEUE_DISPATCH_EVENTS 32
+#endif
 
 namespace RTT {
     namespace mqueue {
@@ -48,6 +62,214 @@ namespace RTT {
         void intrusive_ptr_release(const RTT::mqueue::Dispatcher* p ) {
             if ( p->refcount.dec_and_test() ) delete p;
         }
+
+        Dispatcher::Dispatcher( const std::string& name)
+            : Activity(ORO_SCHED_RT, os::HighestPriority, 0.0, 0, name),
+#ifdef OROPKG_OS_GNULINUX
+              epollfd(-1), wakeupfd(-1),
+#else
+              highsock(0),
+#endif
+              do_exit(false)
+        {
+#ifdef OROPKG_OS_GNULINUX
+            Logger::In in("Dispatcher");
+            epollfd = epoll_create1(EPOLL_CLOEXEC);
+            wakeupfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (epollfd < 0 || wakeupfd < 0) {
+                log(Error) << "Dispatcher could not create its epoll set: " << strerror(errno) << endlog();
+                return;
+            }
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN;
+            ev.data.fd = wakeupfd;
+            if ( epoll_ctl(epollfd, EPOLL_CTL_ADD, wakeupfd, &ev) != 0 )
+                log(Error) << "Dispatcher could not monitor its wake-up descriptor: " << strerror(errno) << endlog();
+#endif
+        }
+
+        Dispatcher::~Dispatcher() {
+            Logger::In in("Dispatcher");
+            log(Info) << "Dispacher cleans up: no more work."<<endlog();
+            stop();
+#ifdef OROPKG_OS_GNULINUX
+            if (wakeupfd >= 0)
+                close(wakeupfd);
+            if (epollfd >= 0)
+                close(epollfd);
+#endif
+            DispatchI = 0;
+        }
+
+        void Dispatcher::addQueue( mqd_t mqdes, base::ChannelElementBase* chan ) {
+            Logger::In in("Dispatcher");
+            if (mqdes < 0) {
+                log(Error) <<"Invalid mqd_t given to MQueue Dispatcher." <<endlog();
+                return;
+            }
+            log(Debug) <<"Dispatcher is monitoring mqdes "<< mqdes <<endlog();
+            os::MutexLock lock(maplock);
+            // we add a refcount per channel we monitor.
+            if (mqmap.count(mqdes) == 0) {
+#ifdef OROPKG_OS_GNULINUX
+                // Edge-triggered: we are woken up once per received message
+                // instead of as long as the queue is not empty.
+                struct epoll_event ev;
+                memset(&ev, 0, sizeof(ev));
+                ev.events = EPOLLIN | EPOLLET;
+                ev.data.fd = mqdes;
+                if ( epoll_ctl(epollfd, EPOLL_CTL_ADD, mqdes, &ev) != 0 ) {
+                    log(Error) <<"Dispatcher could not monitor mqdes "<< mqdes <<": "<< strerror(errno) <<endlog();
+                    return;
+                }
+#endif
+                refcount.inc();
+            }
+            mqmap[mqdes] = chan;
+        }
+
+        void Dispatcher::removeQueue(mqd_t mqdes) {
+            Logger::In in("Dispatcher");
+            log(Debug) <<"Dispatcher drops mqdes "<< mqdes <<endlog();
+            os::MutexLock lock(maplock);
+            if (mqmap.count(mqdes)) {
+#ifdef OROPKG_OS_GNULINUX
+                epoll_ctl(epollfd, EPOLL_CTL_DEL, mqdes, 0);
+#endif
+                mqmap.erase( mqmap.find(mqdes) );
+                refcount.dec();
+            }
+        }
+
+        bool Dispatcher::initialize() {
+            do_exit = false;
+            return true;
+        }
+
+#ifdef OROPKG_OS_GNULINUX
+        void Dispatcher::dispatch(mqd_t mqdes) {
+            os::MutexLock lock(maplock);
+            // the queue may have been removed after epoll_wait() returned.
+            MQMap::iterator it = mqmap.find(mqdes);
+            if ( it == mqmap.end() )
+                return;
+            // Messages which arrive while we drain raise a new event, so
+            // we only read what was queued when we looked.
+            struct mq_attr attr;
+            if ( mq_getattr(mqdes, &attr) != 0 )
+                return;
+            for (long i = 0; i < attr.mq_curmsgs; ++i)
+                it->second->signal();
+        }
+
+        void Dispatcher::loop() {
+            struct epoll_event events[ORONUM_MQUEUE_DISPATCH_EVENTS];
+            while ( !do_exit ) {
+                int ready = epoll_wait(epollfd, events, ORONUM_MQUEUE_DISPATCH_EVENTS, -1);
+                if (ready < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    log(Error) <<"Dispatcher failed to wait on message queues. Stopped thread."<<endlog();
+                    return;
+                }
+                for (int i = 0; i != ready; ++i) {
+                    if ( events[i].data.fd == wakeupfd ) {
+                        eventfd_t count;
+                        eventfd_read(wakeupfd, &count);
+                    } else
+                        dispatch( events[i].data.fd );
+                }
+            }
+        }
+
+        bool Dispatcher::breakLoop() {
+            do_exit = true;
+            // the eventfd stays readable until loop() reads it, so this
+            // can not get lost before epoll_wait() is entered.
+            return eventfd_write(wakeupfd, 1) == 0;
+        }
+#else
+        void Dispatcher::build_select_list() {
+
+            /* First put together fd_set for select(), which will
+               consist of the sock veriable in case a new connection
+               is coming in, plus all the sockets we have already
+               accepted. */
+
+
+            /* FD_ZERO() clears out the fd_set called socks, so that
+                it doesn't contain any file descriptors. */
+
+            FD_ZERO(&socks);
+            highsock = 0;
+
+            /* Loops through all the possible connections and adds
+                those sockets to the fd_set */
+            os::MutexLock lock(maplock);
+            for (MQMap::const_iterator it = mqmap.begin(); it != mqmap.end(); ++it) {
+                FD_SET( it->first, &socks);
+                if ( int(it->first) > highsock)
+                    highsock = int(it->first);
+            }
+        }
+
+        void Dispatcher::read_socks() {
+            /* OK, now socks will be set with whatever socket(s)
+               are ready for reading.*/
+
+            /* Run through our sockets and check to see if anything
+                happened with them, if so 'service' them. */
+            os::MutexLock lock(maplock);
+            for (MQMap::iterator it = mqmap.begin(); it != mqmap.end(); ++it) {
+                if ( FD_ISSET( it->first, &socks) ) {
+                    //log(Debug) << "New data on " << it->first <<endlog();
+                    it->second->signal();
+                }
+            }
+        }
+
+        void Dispatcher::loop() {
+            struct timeval timeout;  /* Timeout for select */
+            int readsocks;       /* Number of sockets ready for reading */
+            while (1) { /* select loop */
+                build_select_list();
+                timeout.tv_sec = 0;
+                timeout.tv_usec = 50000;
+
+                /* The first argument to select is the highest file
+                    descriptor value plus 1.*/
+
+                readsocks = select(highsock+1, &socks, (fd_set *) 0,
+                  (fd_set *) 0, &timeout);
+
+                /* select() returns the number of sockets that had
+                    things going on with them -- i.e. they're readable. */
+
+                /* Once select() returns, the original fd_set has been
+                    modified so it now reflects the state of why select()
+                    woke up. i.e. If file descriptor 4 was originally in
+                    the fd_set, and then it became readable, the fd_set
+                    contains file descriptor 4 in it. */
+
+                if (readsocks < 0) {
+                    log(Error) <<"Dispatcher failed to select on message queues. Stopped thread."<<endlog();
+                    return;
+                }
+                if (readsocks == 0) {
+                    // nop
+                } else // readsocks > 0
+                    read_socks();
+
+                if ( do_exit )
+                    return;
+            } /* while(1) */
+        }
+
+        bool Dispatcher::breakLoop() {
+            do_exit = true;
+            return true;
+        }
+#endif
     }
 }
-
@@ -36,14 +36,15 @@
  ***************************************************************************/
 
 
-
 #include "../../os/MutexLock.hpp"
 #include "../../Activity.hpp"
 #include "../../base/ChannelElementBase.hpp"
 #include "../../Logger.hpp"
 #include <map>
-#include <sys/select.h>
 #include <mqueue.h>
+#ifndef OROPKG_OS_GNULINUX
+#include <sys/select.h>
+#endif
 
 namespace RTT { namespace mqueue { class Dispatcher; } }
 
@@ -58,6 +59,13 @@ namespace RTT {
          * received new data.
          * Reasonably, there should be one dispatcher for each
          * peer component sending us data.
+         *
+         * On GNU/Linux, the queues are registered edge-triggered
+         * in an epoll set when they are added, such that a wake-up
+         * costs O(1) in the number of queues and the number of
+         * queues is not limited by FD_SETSIZE. An eventfd wakes up
+         * the thread immediately when it must stop. On the other
+         * targets, the dispatcher select()s on all queues.
          */
         class Dispatcher : public Activity
         {
@@ -69,64 +77,33 @@ namespace RTT {
             typedef std::map<mqd_t,base::ChannelElementBase*> MQMap;
             MQMap mqmap;
 
-            fd_set socks;        /* Socket file descriptors we want to wake up for, using select() */
-
-            int highsock;        /* Highest #'d file descriptor, needed for select() */
-
-            bool do_exit;
-
-            os::Mutex maplock;
+#ifdef OROPKG_OS_GNULINUX
+            int epollfd;         /* The epoll set of all monitored queues */
 
-            Dispatcher( const std::string& name)
-            : Activity(ORO_SCHED_RT, os::HighestPriority, 0.0, 0, name),
-              highsock(0), do_exit(false)
-              {}
+            int wakeupfd;        /* An eventfd in the epoll set, written by breakLoop() */
 
-            ~Dispatcher() {
-                Logger::In in("Dispatcher");
-                log(Info) << "Dispacher cleans up: no more work."<<endlog();
-                stop();
-                DispatchI = 0;
-            }
+            /**
+             * Signals the channel of \a mqdes until its queue is empty.
+             * An edge-triggered event may stand for more than one message.
+             */
+            void dispatch(mqd_t mqdes);
+#else
+            fd_set socks;        /* Socket file descriptors we want to wake up for, using select() */
 
-            void build_select_list() {
+            int highsock;        /* Highest #'d file descriptor, needed for select() */
 
-                /* First put together fd_set for select(), which will
-                   consist of the sock veriable in case a new connection
-                   is coming in, plus all the sockets we have already
-                   accepted. */
+            void build_select_list();
 
+            void read_socks();
+#endif
 
-                /* FD_ZERO() clears out the fd_set called socks, so that
-                    it doesn't contain any file descriptors. */
+            bool do_exit;
 
-                FD_ZERO(&socks);
-                highsock = 0;
+            os::Mutex maplock;
 
-                /* Loops through all the possible connections and adds
-                    those sockets to the fd_set */
-                os::MutexLock lock(maplock);
-                for (MQMap::const_iterator it = mqmap.begin(); it != mqmap.end(); ++it) {
-                    FD_SET( it->first, &socks);
-                    if ( int(it->first) > highsock)
-                        highsock = int(it->first);
-                }
-            }
+            Dispatcher( const std::string& name);
 
-            void read_socks() {
-                /* OK, now socks will be set with whatever socket(s)
-                   are ready for reading.*/
-
-                /* Run through our sockets and check to see if anything
-                    happened with them, if so 'service' them. */
-                os::MutexLock lock(maplock);
-                for (MQMap::iterator it = mqmap.begin(); it != mqmap.end(); ++it) {
-                    if ( FD_ISSET( it->first, &socks) ) {
-                        //log(Debug) << "New data on " << it->first <<endlog();
-                        it->second->signal();
-                    }
-                }
-            }
+            ~Dispatcher();
 
         public:
             typedef boost::intrusive_ptr<Dispatcher> shared_ptr;
@@ -139,77 +116,15 @@ namespace RTT {
                 return DispatchI;
             }
 
-            void addQueue( mqd_t mqdes, base::ChannelElementBase* chan ) {
-                Logger::In in("Dispatcher");
-                if (mqdes < 0) {
-                    log(Error) <<"Invalid mqd_t given to MQueue Dispatcher." <<endlog();
-                    return;
-                }
-                log(Debug) <<"Dispatcher is monitoring mqdes "<< mqdes <<endlog();
-                os::MutexLock lock(maplock);
-                // we add a refcount per channel we monitor.
-                if (mqmap.count(mqdes) == 0)
-                    refcount.inc();
-                mqmap[mqdes] = chan;
-            }
+            void addQueue( mqd_t mqdes, base::ChannelElementBase* chan );
 
-            void removeQueue(mqd_t mqdes) {
-                Logger::In in("Dispatcher");
-                log(Debug) <<"Dispatcher drops mqdes "<< mqdes <<endlog();
-                os::MutexLock lock(maplock);
-                if (mqmap.count(mqdes)) {
-                    mqmap.erase( mqmap.find(mqdes) );
-                    refcount.dec();
-                }
-            }
+            void removeQueue(mqd_t mqdes);
 
-            bool initialize() {
-                do_exit = false;
-                return true;
-            }
+            bool initialize();
 
-            void loop() {
-                struct timeval timeout;  /* Timeout for select */
-                int readsocks;       /* Number of sockets ready for reading */
-                while (1) { /* select loop */
-                    build_select_list();
-                    timeout.tv_sec = 0;
-                    timeout.tv_usec = 50000;
-
-                    /* The first argument to select is the highest file
-                        descriptor value plus 1.*/
-
-                    readsocks = select(highsock+1, &socks, (fd_set *) 0,
-                      (fd_set *) 0, &timeout);
-
-                    /* select() returns the number of sockets that had
-                        things going on with them -- i.e. they're readable. */
-
-                    /* Once select() returns, the original fd_set has been
-                        modified so it now reflects the state of why select()
-                        woke up. i.e. If file descriptor 4 was originally in
-                        the fd_set, and then it became readable, the fd_set
-                        contains file descriptor 4 in it. */
-
-                    if (readsocks < 0) {
-                        log(Error) <<"Dispatcher failed to select on message queues. Stopped thread."<<endlog();
-                        return;
-                    }
-                    if (readsocks == 0) {
-                        // nop
-                    } else // readsocks > 0
-                        read_socks();
-
-                    if ( do_exit )
-                        return;
-                } /* while(1) */
-            }
+            void loop();
 
-            bool breakLoop() {
-                do_exit = true;
-                return true;
-            }
+            bool breakLoop();
         };
     }
 }
-
@@ -44,6 +44,8 @@
 #include "../../base/ChannelElement.hpp"
 #include "../../internal/DataSource.hpp"
 #include "../../internal/DataSources.hpp"
+#include "../../ConnPolicy.hpp"
+#include "../../types/SampleResize.hpp"
 #include <stdexcept>
 
 namespace RTT
@@ -65,6 +67,8 @@ namespace RTT
             typename internal::ValueDataSource<T>::shared_ptr read_sample;
             /** Used in write() to refer to the sample that needs to be written */
             typename internal::LateConstReferenceDataSource<T>::shared_ptr write_sample;
+            /** The ConnPolicy::max_elements of this connection, or zero. */
+            int mmax_elements;
 
         public:
             /**
@@ -76,9 +80,14 @@ namespace RTT
                 : MQSendRecv(transport)
                 , read_sample(new internal::ValueDataSource<T>)
                 , write_sample(new internal::LateConstReferenceDataSource<T>)
-
+                , mmax_elements(policy.max_elements)
             {
                 Logger::In in("MQChannelElement");
+                // allocate read_sample and, in setupStream, the buffers for the largest sample.
+                if ( mmax_elements > 0 && !types::resize_sample( read_sample->set(), mmax_elements ) ) {
+                    log(Warning) << "ConnPolicy::max_elements is ignored: the samples of this connection are not sequences." << endlog();
+                    mmax_elements = 0;
+                }
                 setupStream(read_sample, port, policy, is_sender);
             }
 
@@ -91,7 +100,13 @@ namespace RTT
                     typename base::ChannelElement<T>::shared_ptr output =
                         this->getOutput();
                     assert(output);
-                    output->data_sample(read_sample->rvalue());
+                    if ( mmax_elements > 0 ) {
+                        // the elements after us copy the data sample into their own samples.
+                        T sample = read_sample->rvalue();
+                        types::resize_sample( sample, mmax_elements );
+                        output->data_sample( sample );
+                    } else
+                        output->data_sample(read_sample->rvalue());
                     return true;
                 }
                 return false;
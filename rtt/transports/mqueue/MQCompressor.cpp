@@ -0,0 +1,235 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "MQCompressor.hpp"
+#include <cstring>
+#include <algorithm>
+
+using namespace RTT::mqueue;
+
+namespace
+{
+    /** The shortest match that is encoded. */
+    const int min_match = 4;
+    /** The data always ends with this many literals. */
+    const int last_literals = 5;
+    /** The last match starts at least this many bytes before the end. */
+    const int match_limit = 12;
+    /** Matches are encoded with a 16 bit offset. */
+    const int max_offset = 65535;
+
+    inline unsigned int read32(const unsigned char* p)
+    {
+        unsigned int v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline unsigned long long read64(const unsigned char* p)
+    {
+        unsigned long long v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    /**
+     * The number of equal bytes at \a a and \a b, where \a a may
+     * not pass \a aend.
+     */
+    inline int matchLength(const unsigned char* a, const unsigned char* b, const unsigned char* aend)
+    {
+        const unsigned char* start = a;
+        // compare a word at a time while it matches.
+        while (aend - a >= 8 && read64(a) == read64(b))
+        {
+            a += 8;
+            b += 8;
+        }
+        while (a != aend && *a == *b)
+        {
+            ++a;
+            ++b;
+        }
+        return int(a - start);
+    }
+
+    inline unsigned int hash(unsigned int v)
+    {
+        return (v * 2654435761U) >> (32 - ORONUM_MQUEUE_COMPRESS_HASH_BITS);
+    }
+
+    /**
+     * Writes the remainder of a length that did not fit in its token.
+     */
+    inline unsigned char* writeLength(unsigned char* op, int length)
+    {
+        for (; length >= 255; length -= 255)
+            *op++ = 255;
+        *op++ = (unsigned char) length;
+        return op;
+    }
+
+    /**
+     * Writes one sequence: \a literals bytes from \a anchor followed by a
+     * match of \a match bytes at \a offset. A zero \a match ends the data.
+     * @return The new output position or zero if it would pass \a oend.
+     */
+    unsigned char* writeSequence(unsigned char* op, unsigned char* oend, const unsigned char* anchor, int literals,
+                                 int offset, int match)
+    {
+        if (oend - op < 1 + literals / 255 + 1 + literals + 2 + match / 255 + 1)
+            return 0;
+        unsigned char* token = op++;
+        *token = (unsigned char) ((literals < 15 ? literals : 15) << 4);
+        if (literals >= 15)
+            op = writeLength(op, literals - 15);
+        memcpy(op, anchor, literals);
+        op += literals;
+        if (match == 0)
+            return op;
+
+        *op++ = (unsigned char) (offset & 0xff);
+        *op++ = (unsigned char) (offset >> 8);
+        int mlength = match - min_match;
+        *token |= (unsigned char) (mlength < 15 ? mlength : 15);
+        if (mlength >= 15)
+            op = writeLength(op, mlength - 15);
+        return op;
+    }
+}
+
+MQCompressor::MQCompressor()
+{
+    memset(table, 0, sizeof(table));
+}
+
+int MQCompressor::compress(const char* source, int size, char* dest, int capacity)
+{
+    const unsigned char* src = (const unsigned char*) source;
+    unsigned char* op = (unsigned char*) dest;
+    unsigned char* oend = op + capacity;
+    int anchor = 0;
+
+    if (size > match_limit)
+    {
+        int ip = 0;
+        // positions left in the table by earlier calls are harmless:
+        // a candidate is only used if it precedes ip and its data matches.
+        while (ip < size - match_limit)
+        {
+            unsigned int sequence = read32(src + ip);
+            unsigned int h = hash(sequence);
+            int ref = table[h];
+            table[h] = ip;
+            if (ref >= ip || ip - ref > max_offset || read32(src + ref) != sequence)
+            {
+                // skip faster through data that does not compress.
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            int match = min_match + matchLength(src + ip + min_match, src + ref + min_match, src + size - last_literals);
+            op = writeSequence(op, oend, src + anchor, ip - anchor, ip - ref, match);
+            if (op == 0)
+                return 0;
+            ip += match;
+            anchor = ip;
+        }
+    }
+    op = writeSequence(op, oend, src + anchor, size - anchor, 0, 0);
+    if (op == 0)
+        return 0;
+    return int(op - (unsigned char*) dest);
+}
+
+int MQCompressor::decompress(const char* source, int size, char* dest, int capacity)
+{
+    const unsigned char* ip = (const unsigned char*) source;
+    const unsigned char* iend = ip + size;
+    unsigned char* op = (unsigned char*) dest;
+    unsigned char* oend = op + capacity;
+
+    while (ip < iend)
+    {
+        unsigned int token = *ip++;
+        int literals = token >> 4;
+        if (literals == 15)
+        {
+            unsigned char b;
+            do
+            {
+                if (ip == iend)
+                    return -1;
+                b = *ip++;
+                literals += b;
+            } while (b == 255);
+        }
+        if (iend - ip < literals || oend - op < literals)
+            return -1;
+        memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == iend)
+            break; // the last sequence has no match.
+
+        if (iend - ip < 2)
+            return -1;
+        int offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op - (unsigned char*) dest)
+            return -1;
+
+        int match = token & 15;
+        if (match == 15)
+        {
+            unsigned char b;
+            do
+            {
+                if (ip == iend)
+                    return -1;
+                b = *ip++;
+                match += b;
+            } while (b == 255);
+        }
+        match += min_match;
+        if (oend - op < match)
+            return -1;
+        // the match may overlap the data it repeats: copy the repeated
+        // pattern in ever larger, non overlapping, pieces.
+        const unsigned char* ref = op - offset;
+        while (match != 0)
+        {
+            int piece = std::min(match, int(op - ref));
+            memcpy(op, ref, piece);
+            op += piece;
+            match -= piece;
+        }
+    }
+    return int(op - (unsigned char*) dest);
+}
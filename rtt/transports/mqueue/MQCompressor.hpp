@@ -0,0 +1,82 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef ORO_MQ_COMPRESSOR_HPP
+#define ORO_MQ_COMPRESSOR_HPP
+
+#ifndef ORONUM_MQUEUE_COMPRESS_HASH_BITS
+/**
+ * The compressor remembers 2^ORONUM_MQUEUE_COMPRESS_HASH_BITS positions
+ * to find repeated data.
+ */
+#define ORONUM_MQUEUE_COMPRESS_HASH_BITS 12
+#endif
+
+namespace RTT
+{
+    namespace mqueue
+    {
+        /**
+         * A fast LZ77 compressor for marshalled samples, which writes
+         * the LZ4 block format. It trades compression ratio for speed
+         * and does not allocate memory.
+         */
+        class MQCompressor
+        {
+        public:
+            MQCompressor();
+
+            /**
+             * Compress \a size bytes of \a src into \a dst.
+             * @param capacity The size of \a dst. Choose it smaller than
+             * \a size to give up early on data that does not compress well.
+             * @return The size of the compressed data or zero if it
+             * did not fit in \a capacity.
+             */
+            int compress(const char* src, int size, char* dst, int capacity);
+
+            /**
+             * Decompress \a size bytes of \a src into \a dst.
+             * @param capacity The size of \a dst.
+             * @return The size of the decompressed data or -1 if \a src
+             * is corrupt or does not fit in \a capacity.
+             */
+            static int decompress(const char* src, int size, char* dst, int capacity);
+
+        private:
+            /**
+             * The last position in the source where each hash of four
+             * bytes was seen.
+             */
+            int table[1 << ORONUM_MQUEUE_COMPRESS_HASH_BITS];
+        };
+    }
+}
+
+#endif
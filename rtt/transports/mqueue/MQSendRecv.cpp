@@ -45,23 +45,72 @@
 #include <cassert>
 #include <stdexcept>
 #include <errno.h>
+#include <cstring>
+#include <algorithm>
 
 #include "MQSendRecv.hpp"
+#include "MQCompressor.hpp"
 #include "../../types/TypeTransporter.hpp"
 #include "../../types/TypeMarshaller.hpp"
+#include "../../types/DeltaMarshaller.hpp"
 #include "../../Logger.hpp"
 #include "Dispatcher.hpp"
 #include "../../base/PortInterface.hpp"
 #include "../../DataFlowInterface.hpp"
 #include "../../TaskContext.hpp"
+#include "../../ConnPolicy.hpp"
 
 using namespace RTT;
 using namespace RTT::detail;
 using namespace RTT::mqueue;
 
+#ifndef ORONUM_MQUEUE_MAX_MSGSIZE
+/**
+ * The largest message size a queue is created with. Larger samples are
+ * sent in chunks. The default is the default Linux msgsize_max limit.
+ */
+#define ORONUM_MQUEUE_MAX_MSGSIZE 8192
+#endif
+
+#ifndef ORONUM_MQUEUE_COMPRESS_MIN
+/**
+ * Samples smaller than this many bytes are never compressed.
+ */
+#define ORONUM_MQUEUE_COMPRESS_MIN 64
+#endif
+
+#ifndef ORONUM_MQUEUE_COMPRESS_BACKOFF
+/**
+ * The number of samples sent uncompressed after a sample did not
+ * compress well.
+ */
+#define ORONUM_MQUEUE_COMPRESS_BACKOFF 16
+#endif
+
+namespace
+{
+    /**
+     * Precedes every message in the queue.
+     */
+    struct MQFrameHeader
+    {
+        /** The sample number, which may wrap around. */
+        unsigned int sequence;
+        /** The position of this chunk in the sample. */
+        unsigned int offset;
+        /** The size of the complete sample. */
+        unsigned int total;
+        /** The size of the sample before compression, or zero if not compressed. */
+        unsigned int raw_size;
+    };
+
+    const int header_size = sizeof(MQFrameHeader);
+}
+
 
 MQSendRecv::MQSendRecv(types::TypeMarshaller const& transport) :
-    mtransport(transport), marshaller_cookie(0), buf(0), mis_sender(false), minit_done(false), max_size(0), mdata_size(0)
+    mtransport(transport), marshaller_cookie(0), mdelta(0), buf(0), frame(0), zbuf(0), zbuf_size(0), compressor(0), mcompress_skip(0), mis_sender(false), minit_done(false), max_size(0), msg_size(0),
+    msequence(0), mrecv_bytes(-1), mdata_size(0)
 {
 }
 
@@ -70,9 +119,16 @@ void MQSendRecv::setupStream(base::DataSourceBase::shared_ptr ds, base::PortInte
 {
     Logger::In in("MQSendRecv");
 
+    if (policy.keyframe_period > 0)
+        mdelta = new types::DeltaMarshaller(mtransport, policy.keyframe_period);
     mdata_size = policy.data_size;
     max_size = policy.data_size ? policy.data_size : mtransport.getSampleSize(ds);
-    marshaller_cookie = mtransport.createCookie();
+    // ds was sized for the largest sample by the channel element.
+    if (policy.max_elements > 0)
+        max_size = std::max(max_size, (int) mtransport.getSampleSize(ds));
+    if (mdelta)
+        max_size += types::DeltaMarshaller::getOverhead();
+    marshaller_cookie = marshaller().createCookie();
     mis_sender = is_sender;
 
     std::stringstream namestr;
@@ -83,7 +139,7 @@ void MQSendRecv::setupStream(base::DataSourceBase::shared_ptr ds, base::PortInte
 
     struct mq_attr mattr;
     mattr.mq_maxmsg = policy.size ? policy.size : 10;
-    mattr.mq_msgsize = max_size;
+    mattr.mq_msgsize = std::min(max_size + header_size, ORONUM_MQUEUE_MAX_MSGSIZE);
     assert( max_size );
     if (policy.name_id[0] != '/')
         throw std::runtime_error("Could not open message queue with wrong name. Names must start with '/' and contain no more '/' after the first one.");
@@ -91,7 +147,7 @@ void MQSendRecv::setupStream(base::DataSourceBase::shared_ptr ds, base::PortInte
         throw std::runtime_error("Could not open message queue with zero message size.");
     int oflag = O_CREAT;
     if (mis_sender)
-        oflag |= O_WRONLY | O_NONBLOCK;
+        oflag |= O_WRONLY | O_NONBLOCK; // writing is always non blocking (see mqWrite() )
     else
         oflag |= O_RDONLY; //reading is always blocking (see mqReady() )
     mqdes = mq_open(policy.name_id.c_str(), oflag, S_IREAD | S_IWRITE, &mattr);
@@ -136,10 +192,27 @@ void MQSendRecv::setupStream(base::DataSourceBase::shared_ptr ds, base::PortInte
         throw std::runtime_error("Could not open message queue: mq_open returned -1.");
     }
 
+    // the other side may have created the queue with other attributes.
+    mq_getattr(mqdes, &mattr);
+    if (mattr.mq_msgsize <= header_size)
+    {
+        mq_close(mqdes);
+        throw std::runtime_error("Could not use message queue: its message size can not hold a frame.");
+    }
+    msg_size = mattr.mq_msgsize;
+
     log(Debug) << "Opened '" << policy.name_id << "' with mqdes='" << mqdes << "', msg size='"<<mattr.mq_msgsize<<"' an queue length='"<<mattr.mq_maxmsg<<"' for " << (is_sender ? "writing." : "reading.") << endlog();
 
-    buf = new char[max_size];
-    memset(buf, 0, max_size); // necessary to trick valgrind
+    if (policy.compression == ConnPolicy::FAST_COMPRESSION)
+    {
+        if (mis_sender)
+            compressor = new MQCompressor();
+        else
+            resizeCompressBuffer(max_size);
+    }
+    resizeBuffer(max_size);
+    frame = new char[msg_size];
+    memset(frame, 0, msg_size); // necessary to trick valgrind
     mqname = policy.name_id;
 }
 
@@ -168,24 +241,65 @@ void MQSendRecv::cleanupStream()
     mq_close( mqdes);
 
     if (marshaller_cookie)
-        mtransport.deleteCookie(marshaller_cookie);
+        marshaller().deleteCookie(marshaller_cookie);
+    marshaller_cookie = 0;
+    delete mdelta;
+    mdelta = 0;
 
     if (buf)
     {
         delete[] buf;
         buf = 0;
     }
+    if (frame)
+    {
+        delete[] frame;
+        frame = 0;
+    }
+    delete[] zbuf;
+    zbuf = 0;
+    zbuf_size = 0;
+    delete compressor;
+    compressor = 0;
+}
+
+types::TypeMarshaller const& MQSendRecv::marshaller() const
+{
+    if (mdelta)
+        return *mdelta;
+    return mtransport;
+}
+
+void MQSendRecv::resizeBuffer(int size)
+{
+    delete[] buf;
+    max_size = size;
+    buf = new char[header_size + max_size];
+    memset(buf, 0, header_size + max_size); // necessary to trick valgrind
+    // the compressed sample is at most as large as the sample.
+    if (compressor)
+        resizeCompressBuffer(max_size);
+}
+
+void MQSendRecv::resizeCompressBuffer(int size)
+{
+    delete[] zbuf;
+    zbuf_size = size;
+    zbuf = new char[header_size + zbuf_size];
+    memset(zbuf, 0, header_size + zbuf_size); // necessary to trick valgrind
 }
 
 
 void MQSendRecv::mqNewSample(RTT::base::DataSourceBase::shared_ptr ds)
 {
-    // only deduce if user did not specify it explicitly:
+    // only deduce if user did not specify it explicitly, and only
+    // grow, such that the buffer is not reallocated for every sample.
     if (mdata_size == 0)
-        max_size = mtransport.getSampleSize(ds);
-    delete[] buf;
-    buf = new char[max_size];
-    memset(buf, 0, max_size); // necessary to trick valgrind
+    {
+        int size = marshaller().getSampleSize(ds);
+        if (size > max_size)
+            resizeBuffer(size);
+    }
 }
 
 bool MQSendRecv::mqReady(base::DataSourceBase::shared_ptr ds, base::ChannelElementBase* chan)
@@ -205,21 +319,20 @@ bool MQSendRecv::mqReady(base::DataSourceBase::shared_ptr ds, base::ChannelEleme
         abs_timeout.tv_sec += abs_timeout.tv_nsec / (1000*1000*1000);
         abs_timeout.tv_nsec = abs_timeout.tv_nsec % (1000*1000*1000);
         //abs_timeout.tv_sec +=1;
-        ssize_t ret = mq_timedreceive(mqdes, buf, max_size, 0, &abs_timeout);
-        if (ret != -1)
+        int ret;
+        while ((ret = receiveFrame(ds, &abs_timeout)) == 0)
+            ; // wait for the remaining chunks of the sample.
+        if (ret == 1)
         {
-            if (mtransport.updateFromBlob((void*) buf, ret, ds, marshaller_cookie))
-            {
-                minit_done = true;
-                // ok, now we can add the dispatcher.
-                Dispatcher::Instance()->addQueue(mqdes, chan);
-                return true;
-            }
-            else
-            {
-                log(Error) << "Failed to initialize MQ Channel Element with initial data sample." << endlog();
-                return false;
-            }
+            minit_done = true;
+            // ok, now we can add the dispatcher.
+            Dispatcher::Instance()->addQueue(mqdes, chan);
+            return true;
+        }
+        else if (ret == -2)
+        {
+            log(Error) << "Failed to initialize MQ Channel Element with initial data sample." << endlog();
+            return false;
         }
         else
         {
@@ -236,39 +349,153 @@ bool MQSendRecv::mqReady(base::DataSourceBase::shared_ptr ds, base::ChannelEleme
 }
 
 
-bool MQSendRecv::mqRead(RTT::base::DataSourceBase::shared_ptr ds)
+int MQSendRecv::receiveFrame(RTT::base::DataSourceBase::shared_ptr ds, const struct timespec* abs_timeout)
 {
-    int bytes = 0;
-    if ((bytes = mq_receive(mqdes, buf, max_size, 0)) == -1)
+    ssize_t bytes = abs_timeout ? mq_timedreceive(mqdes, frame, msg_size, 0, abs_timeout) : mq_receive(mqdes, frame, msg_size, 0);
+    if (bytes == -1)
+        return -1;
+    if (bytes < header_size)
+        return -2;
+
+    MQFrameHeader header;
+    memcpy(&header, frame, header_size);
+    int chunk = bytes - header_size;
+
+    // the common case: the sample fits in one message. It discards
+    // the partial reassembly of a previous sample, if any.
+    if (header.offset == 0 && header.total == (unsigned int)chunk)
     {
-        //log(Debug) << "Tried read on empty mq!" <<endlog();
-        return false;
+        mrecv_bytes = -1;
+        return updateSample(frame + header_size, chunk, header.raw_size, ds);
+    }
+
+    if (header.offset == 0)
+    {
+        // a new sample discards what was left of the previous one.
+        // only grows for a sample larger than any before.
+        if ((int)header.total > max_size)
+            resizeBuffer(header.total);
+        msequence = header.sequence;
+        mrecv_bytes = 0;
     }
-    if (mtransport.updateFromBlob((void*) buf, bytes, ds, marshaller_cookie))
+    // drop the rest of a sample of which a chunk went missing.
+    if (mrecv_bytes < 0 || header.sequence != msequence || header.offset != (unsigned int)mrecv_bytes
+        || header.offset + chunk > header.total)
     {
-        return true;
+        mrecv_bytes = -1;
+        return 0;
+    }
+    memcpy(buf + header.offset, frame + header_size, chunk);
+    mrecv_bytes += chunk;
+    if (mrecv_bytes != (int)header.total)
+        return 0;
+    mrecv_bytes = -1;
+    return updateSample(buf, header.total, header.raw_size, ds);
+}
+
+int MQSendRecv::updateSample(const char* blob, int size, int raw_size, RTT::base::DataSourceBase::shared_ptr ds)
+{
+    if (raw_size != 0)
+    {
+        // only grows for a sample larger than any before.
+        if (raw_size > zbuf_size)
+            resizeCompressBuffer(raw_size);
+        if (MQCompressor::decompress(blob, size, zbuf, zbuf_size) != raw_size)
+            return -2;
+        blob = zbuf;
+        size = raw_size;
     }
-    return false;
+    return marshaller().updateFromBlob((void*) blob, size, ds, marshaller_cookie) ? 1 : -2;
+}
+
+bool MQSendRecv::mqRead(RTT::base::DataSourceBase::shared_ptr ds)
+{
+    return receiveFrame(ds, 0) == 1;
 }
 
 bool MQSendRecv::mqWrite(RTT::base::DataSourceBase::shared_ptr ds)
 {
-    std::pair<void const*, int> blob = mtransport.fillBlob(ds, buf, max_size, marshaller_cookie);
+    std::pair<void const*, int> blob = marshaller().fillBlob(ds, buf + header_size, max_size, marshaller_cookie);
+    if (blob.first == 0)
+    {
+        // the sample may have outgrown the buffer.
+        int size = marshaller().getSampleSize(ds, marshaller_cookie);
+        if (size > max_size)
+        {
+            resizeBuffer(size);
+            blob = marshaller().fillBlob(ds, buf + header_size, max_size, marshaller_cookie);
+        }
+    }
     if (blob.first == 0)
     {
         log(Error) << "MQChannel: failed to marshal sample" << endlog();
         return false;
     }
 
-    char* lbuf = (char*) blob.first;
-    if (mq_send(mqdes, lbuf, blob.second, 0) == -1)
+    MQFrameHeader header;
+    header.sequence = ++msequence;
+    header.offset = 0;
+    header.raw_size = 0;
+
+    const char* data = (const char*) blob.first;
+    int size = blob.second;
+    // the buffer, if any, that holds data right behind room for the header.
+    char* room = data == buf + header_size ? buf : 0;
+    if (compressor && size >= ORONUM_MQUEUE_COMPRESS_MIN)
+    {
+        if (mcompress_skip != 0)
+            --mcompress_skip;
+        else
+        {
+            // only worth it if it saves at least an eighth.
+            int zsize = compressor->compress(data, size, zbuf + header_size, size - size / 8);
+            if (zsize != 0)
+            {
+                header.raw_size = size;
+                data = zbuf + header_size;
+                size = zsize;
+                room = zbuf;
+            }
+            else
+                mcompress_skip = ORONUM_MQUEUE_COMPRESS_BACKOFF;
+        }
+    }
+    header.total = size;
+
+    int payload = msg_size - header_size;
+    if (size > payload)
     {
-        if (errno == EAGAIN)
+        // only start a chunked sample if all its chunks fit in the queue,
+        // such that the reader does not receive a partial sample. We are
+        // the only writer, so the room can only grow while sending.
+        struct mq_attr attr;
+        if (mq_getattr(mqdes, &attr) == 0 && attr.mq_maxmsg - attr.mq_curmsgs < (size + payload - 1) / payload)
             return true;
-
-        log(Error) << "MQChannel "<< mqdes << " became invalid (mq length="<<max_size<<", msg length="<<blob.second<<"): " << strerror(errno) << endlog();
-        return false;
     }
+    do
+    {
+        int chunk = std::min(payload, int(header.total - header.offset));
+        char* msg = frame;
+        if (chunk == size && room)
+            msg = room; // no copy, the header goes in front of the data.
+        else
+            memcpy(frame + header_size, data + header.offset, chunk);
+        memcpy(msg, &header, header_size);
+
+        if (mq_send(mqdes, msg, header_size + chunk, 0) == -1)
+        {
+            // a full queue drops the sample. The reader discards the
+            // chunks that were already sent when the next sample arrives.
+            if (errno == EAGAIN)
+                return true;
+
+            log(Error) << "MQChannel "<< mqdes << " became invalid (mq length="<<msg_size<<", msg length="<<header_size + chunk<<"): " << strerror(errno) << endlog();
+            return false;
+        }
+
+        header.offset += chunk;
+    } while (header.offset != header.total);
+    if (mdelta)
+        mdelta->sent(marshaller_cookie);
     return true;
 }
-
@@ -47,9 +47,21 @@ namespace RTT
 {
     namespace mqueue
     {
+        class MQCompressor;
+
         /**
          * Implements the sending/receiving of mqueue messages.
          * It can only be OR sender OR receiver (logical XOR).
+         *
+         * Each message carries a small frame header. Samples which do not
+         * fit in one message are split over several messages and reassembled
+         * by the receiver, so the queue only needs to be sized for typical
+         * samples.
+         *
+         * With ConnPolicy::FAST_COMPRESSION, the sender compresses each
+         * marshalled sample that compresses well and flags it in the frame
+         * header. The receiver decompresses flagged samples, whatever its
+         * own policy says.
          */
         class MQSendRecv
         {
@@ -65,6 +77,11 @@ namespace RTT
              * the marshalling
              */
             void* marshaller_cookie;
+            /**
+             * Marshals the changes between samples on top of mtransport, if
+             * the ConnPolicy has a keyframe period. Null otherwise.
+             */
+            types::DeltaMarshaller* mdelta;
             /**
              * MQueue file descriptor.
              */
@@ -74,9 +91,36 @@ namespace RTT
              * provided by the ConnPolicy or, if the policy has a zero data
              * size, the sample given to setupStream
              *
-             * Its size is saved in max_size
+             * The sender marshals into it, leaving room for a frame header in
+             * front. The receiver reassembles chunked samples in it.
+             * Its size is saved in max_size, without the header.
              */
             char* buf;
+            /**
+             * One message of the queue: a frame header followed by
+             * (a chunk of) a sample. Its size is saved in msg_size.
+             */
+            char* frame;
+            /**
+             * Sender: holds the compressed sample, behind room for a
+             * frame header. Receiver: holds the decompressed sample.
+             * Its size is saved in zbuf_size, without the header.
+             */
+            char* zbuf;
+            /**
+             * The size of zbuf.
+             */
+            int zbuf_size;
+            /**
+             * The sender's compressor, or null if the ConnPolicy does
+             * not ask for compression.
+             */
+            MQCompressor* compressor;
+            /**
+             * The number of samples the sender still sends uncompressed
+             * after a sample did not compress well.
+             */
+            int mcompress_skip;
             /**
              * True if this object is a sender.
              */
@@ -89,6 +133,21 @@ namespace RTT
              * The size of buf.
              */
             int max_size;
+            /**
+             * The message size of the queue, which may be smaller than
+             * a sample.
+             */
+            int msg_size;
+            /**
+             * Sender: the sequence number of the last sent sample.
+             * Receiver: the sequence number of the sample being reassembled.
+             */
+            unsigned int msequence;
+            /**
+             * Receiver: the number of bytes of the sample being reassembled
+             * that were received so far.
+             */
+            int mrecv_bytes;
             /**
              * The name of the queue, as specified in the ConnPolicy when
              * creating the stream, or self-calculated when that name was empty.
@@ -115,9 +174,10 @@ namespace RTT
             void cleanupStream();
 
             /**
-             * Adapts the mq send/receive buffer size according to the
-             * data in mqdata_source, or the value set in mdata_size;
-             * @param sample
+             * Grows the mq send/receive buffer size according to the
+             * data in \a ds, unless the size was set in mdata_size.
+             * The buffer never shrinks.
+             * @param ds The new data sample.
              */
             virtual void mqNewSample(base::DataSourceBase::shared_ptr ds);
 
@@ -142,6 +202,40 @@ namespace RTT
              * @return true if it could be sent.
              */
             bool mqWrite(base::DataSourceBase::shared_ptr ds);
+
+        private:
+            /**
+             * The marshaller of this stream: mdelta if set, mtransport otherwise.
+             */
+            types::TypeMarshaller const& marshaller() const;
+
+            /**
+             * Resize buf to hold a sample of \a size bytes.
+             */
+            void resizeBuffer(int size);
+
+            /**
+             * Resize zbuf to hold a sample of \a size bytes.
+             */
+            void resizeCompressBuffer(int size);
+
+            /**
+             * Receive one frame and, if it completes a sample, update \a ds.
+             * @param abs_timeout Block at most until this time, or
+             * indefinitely if null.
+             * @return 1 if \a ds was updated, 0 if the sample is not
+             * complete yet, -1 if no frame could be received (see errno)
+             * and -2 if the sample could not be unmarshalled.
+             */
+            int receiveFrame(base::DataSourceBase::shared_ptr ds, const struct timespec* abs_timeout);
+
+            /**
+             * Update \a ds with a complete sample of \a size bytes,
+             * which is compressed if \a raw_size is not zero.
+             * @return 1 if \a ds was updated, -2 if the sample could not
+             * be decompressed or unmarshalled.
+             */
+            int updateSample(const char* blob, int size, int raw_size, base::DataSourceBase::shared_ptr ds);
         };
     }
 }
@@ -47,36 +47,106 @@
 #define MQSERIALIZATIONPROTOCOL_HPP_
 
 #include "MQTemplateProtocolBase.hpp"
-#include "binary_data_archive.hpp"
-#include <boost/iostreams/stream.hpp>
-#include <boost/iostreams/device/array.hpp>
+#include "binary_buffer_archive.hpp"
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/type_traits/is_enum.hpp>
+#include <boost/array.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/mpl/bool.hpp>
+#include <vector>
+#include <cstring>
 #include <iostream>
 namespace RTT
 {
 
     namespace mqueue
     {
+        /**
+         * Marshalling strategies of the MQSerializationProtocol.
+         * The strategy for a type is selected at compile time by
+         * mq_layout<T>.
+         */
+        struct mq_archive_layout {};
+        /** The sample is one contiguous block of memory and is copied as a whole. */
+        struct mq_fixed_layout {};
+        /** The sample is a std::vector of mq_fixed_layout elements. */
+        struct mq_vector_layout {};
 
+        /**
+         * True for types that can be transported with a plain memcpy.
+         * By default, these are the arithmetic and enum types, and plain
+         * C arrays and boost::array of such types. A trivially copyable
+         * struct may still hold pointers or have a serialize() function
+         * which must not be bypassed, so such a type must opt in:
+         * @code
+         * namespace RTT { namespace mqueue {
+         *     template<> struct mq_is_fixed_layout<MyPod> : public boost::mpl::true_ {};
+         * } }
+         * @endcode
+         */
+        template<class T>
+        struct mq_is_fixed_layout
+            : public boost::mpl::bool_< boost::is_arithmetic<T>::value
+                                        || boost::is_enum<T>::value >
+        {};
+
+        template<class T, std::size_t N>
+        struct mq_is_fixed_layout<T[N]>
+            : public mq_is_fixed_layout<T>
+        {};
+
+        template<class T, std::size_t N>
+        struct mq_is_fixed_layout< boost::array<T,N> >
+            : public mq_is_fixed_layout<T>
+        {};
+
+        /**
+         * Selects the marshalling strategy of type \a T from
+         * mq_is_fixed_layout.
+         */
+        template<class T>
+        struct mq_layout
+        {
+            typedef typename boost::mpl::if_< mq_is_fixed_layout<T>, mq_fixed_layout, mq_archive_layout >::type type;
+        };
+
+        template<class T, class Alloc>
+        struct mq_layout< std::vector<T, Alloc> >
+        {
+            typedef typename boost::mpl::if_< mq_is_fixed_layout<T>, mq_vector_layout, mq_archive_layout >::type type;
+        };
+
+        /** std::vector<bool> does not store its elements contiguously. */
+        template<class Alloc>
+        struct mq_layout< std::vector<bool, Alloc> >
+        {
+            typedef mq_archive_layout type;
+        };
+
+        /**
+         * A marshaller which uses the boost::serialization library in
+         * combination with binary_buffer_archive to transport a type T.
+         *
+         * Types for which mq_layout<T> selects a fixed layout, see
+         * mq_is_fixed_layout, bypass the archive: they are transported with a single memcpy, like the
+         * MQTemplateProtocol does. A std::vector of such types is sent as
+         * its element count followed by the elements in one block.
+         * For both, the sample size is computed without serializing.
+         */
         template<class T>
         class MQSerializationProtocol
         : public RTT::mqueue::MQTemplateProtocolBase<T>
         {
+            typedef typename mq_layout<T>::type layout;
         public:
             MQSerializationProtocol() {
             }
 
             virtual std::pair<void const*,int> fillBlob( base::DataSourceBase::shared_ptr source, void* blob, int size, void* cookie) const
             {
-                namespace io = boost::iostreams;
                 typename internal::DataSource<T>::shared_ptr d = boost::dynamic_pointer_cast< internal::DataSource<T> >( source );
-                if ( d ) {
-                    // we use the boost iostreams library for re-using the blob buffer in the stream object.
-                    // and the serialization library to write the data into stream.
-                    io::stream<io::array_sink>  outbuf( (char*)blob, size);
-                    binary_data_oarchive out( outbuf );
-                    out << d->rvalue();
-                    return std::make_pair( blob, out.getArchiveSize() );
-                }
+                if ( d )
+                    return fill( d, blob, size, layout() );
                 return std::make_pair((void*)0,int(0));
             }
 
@@ -84,14 +154,9 @@ namespace RTT
             * Update \a target with the contents of \a blob which is an object of a \a protocol.
             */
             virtual bool updateFromBlob(const void* blob, int size, base::DataSourceBase::shared_ptr target, void* cookie) const {
-                namespace io = boost::iostreams;
                 typename internal::AssignableDataSource<T>::shared_ptr ad = internal::AssignableDataSource<T>::narrow( target.get() );
-                if ( ad ) {
-                    io::stream<io::array_source>  inbuf((const char*)blob, size);
-                    binary_data_iarchive in( inbuf );
-                    in >> ad->set();
-                    return true;
-                }
+                if ( ad )
+                    return update( blob, size, ad, layout() );
                 return false;
             }
 
@@ -101,14 +166,106 @@ namespace RTT
                     log(Error) << "getSampleSize: sample has wrong type."<<endlog();
                     return 0;
                 }
-                namespace io = boost::iostreams;
-                char sink[1];
-                io::stream<io::array_sink>  outbuf(sink,1);
-                binary_data_oarchive out( outbuf, false );
+                return sampleSize( tsample, layout() );
+            }
+
+        private:
+            static std::pair<void const*,int> fill( typename internal::DataSource<T>::shared_ptr d, void* blob, int size, mq_archive_layout )
+            {
+                try {
+                    binary_buffer_oarchive out( blob, size );
+                    out << d->rvalue();
+                    return std::make_pair( (void const*)blob, out.getArchiveSize() );
+                } catch (boost::archive::archive_exception&) {
+                    // the sample does not fit in the blob.
+                }
+                return std::make_pair((void const*)0,int(0));
+            }
+
+            static std::pair<void const*,int> fill( typename internal::DataSource<T>::shared_ptr d, void* blob, int size, mq_fixed_layout )
+            {
+                if ( sizeof(T) > (unsigned int)size )
+                    return std::make_pair((void const*)0,int(0));
+                // no copy at all if the message queue can read straight from the data source.
+                void const* raw = d->getRawConstPointer();
+                if ( raw )
+                    return std::make_pair( raw, int(sizeof(T)) );
+                std::memcpy( blob, &d->rvalue(), sizeof(T) );
+                return std::make_pair( (void const*)blob, int(sizeof(T)) );
+            }
+
+            static std::pair<void const*,int> fill( typename internal::DataSource<T>::shared_ptr d, void* blob, int size, mq_vector_layout )
+            {
+                T const& v = d->rvalue();
+                std::size_t count = v.size();
+                std::size_t bytes = count * sizeof(typename T::value_type);
+                if ( sizeof(count) + bytes > (unsigned int)size )
+                    return std::make_pair((void const*)0,int(0));
+                std::memcpy( blob, &count, sizeof(count) );
+                if ( count )
+                    std::memcpy( (char*)blob + sizeof(count), &v[0], bytes );
+                return std::make_pair( (void const*)blob, int(sizeof(count) + bytes) );
+            }
+
+            static bool update( const void* blob, int size, typename internal::AssignableDataSource<T>::shared_ptr ad, mq_archive_layout )
+            {
+                try {
+                    binary_buffer_iarchive in( blob, size );
+                    in >> ad->set();
+                    return true;
+                } catch (boost::archive::archive_exception&) {
+                    // the blob is truncated.
+                }
+                return false;
+            }
+
+            static bool update( const void* blob, int size, typename internal::AssignableDataSource<T>::shared_ptr ad, mq_fixed_layout )
+            {
+                if ( (unsigned int)size != sizeof(T) )
+                    return false;
+                std::memcpy( (void*)&ad->set(), blob, sizeof(T) );
+                return true;
+            }
+
+            static bool update( const void* blob, int size, typename internal::AssignableDataSource<T>::shared_ptr ad, mq_vector_layout )
+            {
+                std::size_t count;
+                if ( size < int(sizeof(count)) )
+                    return false;
+                std::memcpy( &count, blob, sizeof(count) );
+                std::size_t bytes = count * sizeof(typename T::value_type);
+                if ( sizeof(count) + bytes != (unsigned int)size )
+                    return false;
+                T& v = ad->set();
+                v.resize( count );
+                if ( count )
+                    std::memcpy( &v[0], (const char*)blob + sizeof(count), bytes );
+                return true;
+            }
+
+            /**
+             * A dry run of the archive. The size follows the contents of the sample,
+             * so it is not cached: the transports only ask it for the initial sample
+             * and when a sample no longer fits in their buffer.
+             */
+            static unsigned int sampleSize( typename internal::DataSource<T>::shared_ptr tsample, mq_archive_layout )
+            {
+                binary_buffer_oarchive out( 0, 0, false );
                 out << tsample->get();
-                //std::cout << "sample size is "<< tsample->rvalue().size() <<" archive is " << out.getArchiveSize() <<std::endl; //disable all types but std::vector<double> for this to compile
                 return out.getArchiveSize();
             }
+
+            static unsigned int sampleSize( typename internal::DataSource<T>::shared_ptr, mq_fixed_layout )
+            {
+                return sizeof(T);
+            }
+
+            static unsigned int sampleSize( typename internal::DataSource<T>::shared_ptr tsample, mq_vector_layout )
+            {
+                // rvalue() only reflects the data source after an evaluate().
+                tsample->evaluate();
+                return sizeof(std::size_t) + tsample->rvalue().size() * sizeof(typename T::value_type);
+            }
         };
 
     }
@@ -0,0 +1,580 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef BINARY_BUFFER_ARCHIVE_HPP_
+#define BINARY_BUFFER_ARCHIVE_HPP_
+
+/**
+ * @file binary_buffer_archive.hpp
+ *
+ * This file implements a 'level 2' binary archiver of serializable objects
+ * which reads from and writes to a plain memory buffer.
+ *
+ * It stores the same data as binary_data_archive, but does not go through
+ * a std::streambuf: every primitive is copied directly at a cursor in the
+ * buffer, after checking that it fits. Arrays of bitwise serializable
+ * types, such as the elements of a std::vector<double>, are copied with
+ * one memcpy and std::string is stored as its length followed by its
+ * characters.
+ *
+ * No class information or cross-references are stored.
+ *
+ * This archive is header-only and does not depend on the serialization DLL.
+ */
+
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/is_bitwise_serializable.hpp>
+#include <boost/serialization/array.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/collection_size_type.hpp>
+#include <boost/archive/detail/iserializer.hpp>
+#include <boost/archive/detail/oserializer.hpp>
+#include <boost/archive/archive_exception.hpp>
+#include <boost/config.hpp>
+#include <boost/mpl/bool.hpp>
+
+#include <boost/version.hpp>
+#if BOOST_VERSION >= 104600
+#include <boost/serialization/item_version_type.hpp>
+#endif
+
+namespace RTT
+{
+    namespace mqueue
+    {
+
+        /**
+         * This archive is capable of loading objects of
+         * serialization level 1 and 2 from a memory buffer
+         * written by binary_buffer_oarchive.
+         * Reading past the end of the buffer throws an
+         * boost::archive::archive_exception.
+         * @see binary_buffer_oarchive
+         */
+        class binary_buffer_iarchive
+        {
+            const char* m_cur;
+            const char* m_end;
+            int data_read;
+        public:
+            typedef char Elem;
+            typedef binary_buffer_iarchive Archive;
+
+            /**
+             * Loading Archive Concept::is_loading
+             */
+            typedef boost::mpl::bool_<true> is_loading;
+            /**
+             * Loading Archive Concept::is_saving
+             */
+            typedef boost::mpl::bool_<false> is_saving;
+
+            /**
+             * Constructor from a memory buffer.
+             * @param buf The buffer to serialize from.
+             * @param size The number of bytes in \a buf.
+             */
+            binary_buffer_iarchive(const void* buf, std::size_t size) :
+                m_cur( static_cast<const char*>(buf) ), m_end( static_cast<const char*>(buf) + size ), data_read(0)
+            {
+            }
+
+            /**
+             * Loading Archive Concept::get_library_version()
+             * @return This library's version.
+             */
+            unsigned int get_library_version() { return 0; }
+
+            /**
+             * Loading Archive Concept::reset_object_address(v,u)
+             * @param new_address
+             * @param old_address
+             */
+            void reset_object_address(const void * new_address, const void * old_address) {}
+
+            /**
+             * Loading Archive Concept::delete_created_pointers()
+             */
+            void delete_created_pointers() {}
+
+            /**
+             * Loading Archive Concept::register_type<T>() and ::register_type(u)
+             * @param The data type to register in this archive.
+             * @return
+             */
+            template<class T>
+            const boost::archive::detail::basic_pointer_iserializer *
+            register_type(T * = NULL) {return 0;}
+
+            /**
+             * Note: not in LoadArchive concept but required when we use archive::load !
+             * This function is only used when we call archive::load( *this, t);
+             * @param x
+             * @param bos
+             */
+            void load_object(
+                void *t,
+                const boost::archive::detail::basic_iserializer & bis
+            ) {
+                assert(false);
+            }
+
+            /**
+             * The standard type loading function. It forwards any type T
+             * to the correct internal load_a_type function.
+             */
+            template<class T>
+            void load_override(T & t, BOOST_PFTO int){
+                load_a_type(t, boost::mpl::bool_<boost::serialization::implementation_level<T>::value == boost::serialization::primitive_type>() );
+            }
+
+            /**
+             * Handles the nvp<T> cases in the serialization code.
+             */
+            template<class T>
+            void load_override(const boost::serialization::nvp<T> & t, int){
+                T& x(t.value());
+                * this >> x;
+            }
+
+            /**
+             * Specialisation that covers a boost serialization array created with make_array()
+             * @param t
+             * @return *this
+             */
+            template<class T>
+            void load_override(const boost::serialization::array<T> &t, int)
+            {
+                boost::serialization::array<T> tmp(t.address(), t.count());
+                *this >> tmp;
+            }
+
+            /**
+             * Loading Archive Concept::operator>>
+             * @param t The type to load.
+             * @return *this
+             */
+            template<class T>
+            binary_buffer_iarchive &operator>>(T &t){
+                this->load_override(t, 0);
+                return * this;
+            }
+
+            /**
+             * Loading Archive Concept::operator&
+             * @param t The type to load.
+             * @return *this
+             */
+            template<class T>
+            binary_buffer_iarchive &operator&(T &t){
+                return this->operator>>(t);
+            }
+
+            /**
+             * Loading Archive Concept::load_binary(u, count)
+             * @param address The place in memory where data must be written.
+             * @param count The number of bytes to load.
+             */
+            void load_binary(void *address, std::size_t count)
+            {
+                std::memcpy( address, take(count), count );
+            }
+
+            /**
+             * Specialisation for reading in primitive types.
+             * @param t primitive data (bool, int,...)
+             * @return *this
+             */
+            template<class T>
+            binary_buffer_iarchive &load_a_type(T &t,boost::mpl::true_){
+                load_binary(&t, sizeof(T));
+                return *this;
+            }
+
+            /**
+             * Specialisation for reading in a string: its length
+             * followed by its characters. The string is sized once.
+             * @param t the string to assign.
+             * @return *this
+             */
+            binary_buffer_iarchive &load_a_type(std::string &t,boost::mpl::true_){
+                std::size_t length;
+                load_binary(&length, sizeof(length));
+                t.assign( take(length), length );
+                return *this;
+            }
+
+            /**
+             * Specialisation for reading in composite types (objects).
+             * @param t a serializable class or struct.
+             * @return *this
+             */
+            template<class T>
+            binary_buffer_iarchive &load_a_type(T &t,boost::mpl::false_){
+#if BOOST_VERSION >= 104100
+                boost::archive::detail::load_non_pointer_type<binary_buffer_iarchive>::load_only::invoke(*this,t);
+#else
+                boost::archive::detail::load_non_pointer_type<binary_buffer_iarchive,T>::load_only::invoke(*this,t);
+#endif
+                return *this;
+            }
+
+            /**
+             * We provide an optimized load for all bitwise serializable types
+             * typedef serialization::is_bitwise_serializable<mpl::_1> use_array_optimization;
+             */
+            struct use_array_optimization {
+                template <class T>
+                #if defined(BOOST_NO_DEPENDENT_NESTED_DERIVATIONS)
+                    struct apply {
+                        typedef BOOST_DEDUCED_TYPENAME boost::serialization::is_bitwise_serializable<T>::type type;
+                    };
+                #else
+                    struct apply : public boost::serialization::is_bitwise_serializable<T> {};
+                #endif
+            };
+
+            /**
+             * The optimized load_array copies all elements at once.
+             */
+            template<class ValueType>
+            void load_array(boost::serialization::array<ValueType>& a,
+                            unsigned int)
+            {
+                load_binary(a.address(), a.count()
+                        * sizeof(ValueType));
+            }
+
+            /**
+             * Helper method to say how much we read.
+             */
+            int getArchiveSize() { return data_read; }
+
+            /**
+             * Checks that \a count elements of at least \a size bytes each
+             * can still be read, before a container is sized for them.
+             * A corrupt count thus throws like a read past the end, instead
+             * of failing the allocation.
+             */
+            void check_count(std::size_t count, std::size_t size)
+            {
+                if ( size != 0 && count > std::size_t(m_end - m_cur) / size )
+                    fail();
+            }
+
+        private:
+            /**
+             * Throws the exception of a read past the end of the buffer.
+             */
+            void fail()
+            {
+#if BOOST_VERSION >= 104400
+                boost::serialization::throw_exception(
+                        boost::archive::archive_exception(
+                                boost::archive::archive_exception::input_stream_error));
+#else
+                boost::serialization::throw_exception(
+                        boost::archive::archive_exception(
+                                boost::archive::archive_exception::stream_error));
+#endif
+            }
+
+            /**
+             * Advances the cursor over \a count bytes.
+             * @return the start of these bytes.
+             */
+            const char* take(std::size_t count)
+            {
+                if ( count > std::size_t(m_end - m_cur) )
+                    fail();
+                const char* start = m_cur;
+                m_cur += count;
+                data_read += count;
+                return start;
+            }
+        };
+
+        /**
+         * This archive is capable of saving objects of serialization level 1 and 2
+         * into a memory buffer, in a binary, non-portable format.
+         * Writing past the end of the buffer throws an
+         * boost::archive::archive_exception.
+         * @see binary_buffer_iarchive
+         */
+        class binary_buffer_oarchive
+        {
+            char* m_cur;
+            char* m_end;
+            int data_written;
+            bool mdo_save;
+        public:
+            typedef char Elem;
+            /**
+             * Saving Archive Concept::is_loading
+             */
+            typedef boost::mpl::bool_<false> is_loading;
+            /**
+             * Saving Archive Concept::is_saving
+             */
+            typedef boost::mpl::bool_<true> is_saving;
+
+            /**
+             * Constructor from a memory buffer.
+             * @param buf The buffer to serialize to.
+             * @param size The number of bytes available in \a buf.
+             * @param do_save Set to false to not actually write nor use
+             * the given buffer. After a save operation, only the counter
+             * for getArchiveSize() will have increased. Use this to know
+             * in advance how much space you will need.
+             */
+            binary_buffer_oarchive(void* buf, std::size_t size, bool do_save = true) :
+                m_cur( static_cast<char*>(buf) ), m_end( static_cast<char*>(buf) + size ), data_written(0), mdo_save(do_save)
+            {
+            }
+
+            /**
+             * Saving Archive Concept::get_library_version()
+             * @return This library's version.
+             */
+            unsigned int get_library_version() { return 0; }
+
+            /**
+             * Saving Archive Concept::register_type<T>() and ::register_type(u)
+             * @param The data type to register in this archive.
+             * @return
+             */
+            template<class T>
+            const boost::archive::detail::basic_pointer_iserializer *
+            register_type(T * = NULL) {return 0;}
+
+            /**
+             * Note: not in LoadArchive concept but required when we use archive::save !
+             * @param x
+             * @param bos
+             */
+            void save_object(
+                const void *x,
+                const boost::archive::detail::basic_oserializer & bos
+            ) {
+                assert(false);
+            }
+
+            /**
+             * Saving Archive Concept::operator<<
+             * @param t The type to save.
+             * @return *this
+             */
+            template<class T>
+            binary_buffer_oarchive &operator<<(T const &t){
+                return save_a_type(t,boost::mpl::bool_< boost::serialization::implementation_level<T>::value == boost::serialization::primitive_type>() );
+            }
+
+            /**
+             * Saving Archive Concept::operator&
+             * @param t The type to save.
+             * @return *this
+             */
+            template<class T>
+            binary_buffer_oarchive &operator&(T const &t){
+                return this->operator<<(t);
+            }
+
+            /**
+             * Saving Archive Concept::save_binary(u, count)
+             * @param address The place where data is located in memory.
+             * @param count The number of bytes to save.
+             */
+            inline void save_binary(const void *address, std::size_t count)
+            {
+                if (mdo_save) {
+                    if ( count > std::size_t(m_end - m_cur) )
+#if BOOST_VERSION >= 104400
+                        boost::serialization::throw_exception(
+                                boost::archive::archive_exception(
+                                        boost::archive::archive_exception::output_stream_error));
+#else
+                        boost::serialization::throw_exception(
+                                boost::archive::archive_exception(
+                                        boost::archive::archive_exception::stream_error));
+#endif
+                    std::memcpy( m_cur, address, count );
+                    m_cur += count;
+                }
+                data_written += count;
+            }
+
+            /**
+             * Specialisation for writing out primitive types.
+             * @param t primitive data (bool, int,...)
+             * @return *this
+             */
+            template<class T>
+            binary_buffer_oarchive &save_a_type(T const &t,boost::mpl::true_){
+                save_binary(&t, sizeof(T));
+                return *this;
+            }
+
+            /**
+             * Specialisation for writing out a string: its length
+             * followed by its characters.
+             * @param t the string to save.
+             * @return *this
+             */
+            binary_buffer_oarchive &save_a_type(std::string const &t,boost::mpl::true_){
+                std::size_t length = t.size();
+                save_binary(&length, sizeof(length));
+                save_binary(t.data(), length);
+                return *this;
+            }
+
+#if BOOST_VERSION >= 104600
+            binary_buffer_oarchive &save_a_type(const boost::serialization::version_type & t,boost::mpl::true_){
+                // ignored, the load function is never called, so we don't store it.
+                return *this;
+            }
+            binary_buffer_oarchive &save_a_type(const boost::serialization::item_version_type & t,boost::mpl::true_){
+                // ignored, the load function is never called, so we don't store it.
+                return *this;
+            }
+#endif
+
+            /**
+             * Specialisation for writing out composite types (objects).
+             * @param t a serializable class or struct.
+             * @return *this
+             */
+            template<class T>
+            binary_buffer_oarchive &save_a_type(T const &t,boost::mpl::false_){
+#if BOOST_VERSION >= 104100
+                boost::archive::detail::save_non_pointer_type<binary_buffer_oarchive>::save_only::invoke(*this,t);
+#else
+                boost::archive::detail::save_non_pointer_type<binary_buffer_oarchive,T>::save_only::invoke(*this,t);
+#endif
+                return *this;
+            }
+
+            /**
+             * We provide an optimized save for all bitwise serializable types
+             * typedef serialization::is_bitwise_serializable<mpl::_1> use_array_optimization;
+             */
+            struct use_array_optimization {
+                template <class T>
+                #if defined(BOOST_NO_DEPENDENT_NESTED_DERIVATIONS)
+                    struct apply {
+                        typedef BOOST_DEDUCED_TYPENAME boost::serialization::is_bitwise_serializable<T>::type type;
+                    };
+                #else
+                    struct apply : public boost::serialization::is_bitwise_serializable<T> {};
+                #endif
+            };
+
+            /**
+             * The optimized save_array copies all elements at once.
+             */
+            template<class ValueType>
+            void save_array(boost::serialization::array<ValueType> const& a,
+                            unsigned int)
+            {
+                save_binary(a.address(), a.count()
+                        * sizeof(ValueType));
+            }
+
+            /**
+             * Helper method to say how much we wrote.
+             */
+            int getArchiveSize() { return data_written; }
+        };
+
+        /**
+         * Loads the elements of a std::vector with one copy if they are bitwise serializable.
+         */
+        template<class U, class Allocator>
+        void load_elements(binary_buffer_iarchive& ar, std::vector<U, Allocator>& t, boost::mpl::true_)
+        {
+            ar.load_binary(&t[0], t.size() * sizeof(U));
+        }
+
+        /**
+         * Loads the elements of a std::vector one by one.
+         */
+        template<class U, class Allocator>
+        void load_elements(binary_buffer_iarchive& ar, std::vector<U, Allocator>& t, boost::mpl::false_)
+        {
+            for (typename std::vector<U, Allocator>::size_type i = 0; i != t.size(); ++i)
+                ar >> t[i];
+        }
+
+        /**
+         * Loads a std::vector written by binary_buffer_oarchive into \a t.
+         * This overload is found through argument dependent lookup and replaces
+         * the one of boost::serialization, which clears \a t first.
+         * Resizing \a t instead keeps the elements which are already there,
+         * such that the strings and vectors nested in it keep their storage
+         * when successive samples have the same shape.
+         */
+        template<class U, class Allocator>
+        void load(binary_buffer_iarchive& ar, std::vector<U, Allocator>& t, const unsigned int)
+        {
+            boost::serialization::collection_size_type count;
+            ar >> count;
+            // a bitwise element takes its size, any other at least a byte.
+            ar.check_count( count, boost::serialization::is_bitwise_serializable<U>::value ? sizeof(U) : 1 );
+            t.resize( count );
+            if ( !t.empty() )
+                load_elements( ar, t, boost::mpl::bool_< boost::serialization::is_bitwise_serializable<U>::value >() );
+        }
+
+        /**
+         * std::vector<bool> is stored as its size followed by one bool per element.
+         */
+        template<class Allocator>
+        void load(binary_buffer_iarchive& ar, std::vector<bool, Allocator>& t, const unsigned int)
+        {
+            boost::serialization::collection_size_type count;
+            ar >> count;
+            ar.check_count( count, sizeof(bool) );
+            t.resize( count );
+            for (typename std::vector<bool, Allocator>::size_type i = 0; i != t.size(); ++i) {
+                bool b;
+                ar >> b;
+                t[i] = b;
+            }
+        }
+    }
+}
+
+BOOST_SERIALIZATION_USE_ARRAY_OPTIMIZATION(RTT::mqueue::binary_buffer_oarchive)
+BOOST_SERIALIZATION_USE_ARRAY_OPTIMIZATION(RTT::mqueue::binary_buffer_iarchive)
+
+#endif /* BINARY_BUFFER_ARCHIVE_HPP_ */
@@ -0,0 +1,268 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "ShmRing.hpp"
+#include "../../os/oro_arch.h"
+#include "../../os/CAS.hpp"
+#include "../../os/fosi.h"
+#include "../../Logger.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+
+/**
+ * Identifies an initialized ring segment.
+ */
+#define ORO_SHM_RING_MAGIC 0x52545452
+#define ORO_SHM_RING_VERSION 2
+
+using namespace RTT;
+using namespace RTT::shm;
+
+namespace
+{
+    int futex(volatile unsigned int* addr, int op, unsigned int val, const struct timespec* timeout)
+    {
+        return syscall(SYS_futex, addr, op, val, timeout, 0, 0);
+    }
+
+    unsigned int round_up(unsigned int size, unsigned int align)
+    {
+        return (size + align - 1) / align * align;
+    }
+
+    unsigned int round_up_pow2(unsigned int n)
+    {
+        unsigned int p = 1;
+        while ( p < n )
+            p <<= 1;
+        return p;
+    }
+}
+
+ShmRing::ShmRing()
+    : mfd(-1), mheader(0), mlength(0), mslots(0)
+{
+}
+
+ShmRing::~ShmRing()
+{
+    close();
+}
+
+bool ShmRing::open(const std::string& name, unsigned int slots, unsigned int slot_size, Seconds timeout)
+{
+    Logger::In in("ShmRing");
+    close();
+    mname = name;
+    if ( name.empty() || name[0] != '/' ) {
+        log(Error) << "Shared memory names must start with '/', got '" << name << "'." << endlog();
+        return false;
+    }
+
+    bool creator = true;
+    mfd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if ( mfd < 0 && errno == EEXIST ) {
+        creator = false;
+        mfd = shm_open(name.c_str(), O_RDWR, S_IRUSR | S_IWUSR);
+    }
+    if ( mfd < 0 ) {
+        log(Error) << "Could not open shared memory '" << name << "': " << strerror(errno) << endlog();
+        return false;
+    }
+
+    nsecs deadline = rtos_get_time_ns() + Seconds_to_nsecs(timeout);
+    slots = round_up_pow2( slots ? slots : 1 );
+    if ( creator ) {
+        unsigned int stride = round_up( sizeof(ShmSlot) + slot_size, 64 );
+        mlength = sizeof(ShmRingHeader) + slots * stride;
+        if ( ftruncate(mfd, mlength) != 0 ) {
+            log(Error) << "Could not allocate " << mlength << " bytes of shared memory for '" << name << "': " << strerror(errno) << endlog();
+            close();
+            shm_unlink( name.c_str() );
+            return false;
+        }
+    } else {
+        // the creator may not have sized the segment yet.
+        struct stat st;
+        while ( fstat(mfd, &st) == 0 && st.st_size < (off_t)sizeof(ShmRingHeader) ) {
+            if ( rtos_get_time_ns() > deadline ) {
+                log(Error) << "Timeout while waiting for the creator of shared memory '" << name << "'." << endlog();
+                close();
+                return false;
+            }
+            usleep(1000);
+        }
+        mlength = st.st_size;
+    }
+
+    void* addr = mmap(0, mlength, PROT_READ | PROT_WRITE, MAP_SHARED, mfd, 0);
+    if ( addr == MAP_FAILED ) {
+        log(Error) << "Could not map shared memory '" << name << "': " << strerror(errno) << endlog();
+        close();
+        return false;
+    }
+    mheader = static_cast<ShmRingHeader*>(addr);
+    mslots = static_cast<char*>(addr) + sizeof(ShmRingHeader);
+
+    if ( creator ) {
+        // ftruncate() zeroed the segment.
+        mheader->version = ORO_SHM_RING_VERSION;
+        mheader->slots = slots;
+        mheader->slot_size = slot_size;
+        mheader->stride = (mlength - sizeof(ShmRingHeader)) / slots;
+        for (unsigned int i = 0; i != slots; ++i)
+            slot(i)->sequence = i;
+        oro_release_barrier();
+        mheader->magic = ORO_SHM_RING_MAGIC;
+    } else {
+        while ( mheader->magic != ORO_SHM_RING_MAGIC ) {
+            if ( rtos_get_time_ns() > deadline ) {
+                log(Error) << "Timeout while waiting for the creator of shared memory '" << name << "' to initialize it." << endlog();
+                close();
+                return false;
+            }
+            usleep(1000);
+        }
+        oro_acquire_barrier();
+        if ( mheader->version != ORO_SHM_RING_VERSION
+             || mheader->slots == 0 || (mheader->slots & (mheader->slots - 1)) != 0
+             || sizeof(ShmRingHeader) + mheader->slots * mheader->stride > mlength ) {
+            log(Error) << "Shared memory '" << name << "' does not contain a valid ring." << endlog();
+            close();
+            return false;
+        }
+    }
+    log(Debug) << (creator ? "Created '" : "Opened '") << name << "' with " << mheader->slots << " slots of "
+               << mheader->slot_size << " bytes." << endlog();
+    return true;
+}
+
+void ShmRing::close()
+{
+    if ( mheader )
+        munmap(mheader, mlength);
+    mheader = 0;
+    mslots = 0;
+    mlength = 0;
+    if ( mfd >= 0 )
+        ::close(mfd);
+    mfd = -1;
+}
+
+void ShmRing::unlink()
+{
+    if ( !mname.empty() )
+        shm_unlink( mname.c_str() );
+}
+
+ShmSlot* ShmRing::claim()
+{
+    unsigned int pos = mheader->enqueue_pos;
+    for (;;) {
+        ShmSlot* s = slot(pos);
+        unsigned int seq = s->sequence;
+        oro_acquire_barrier();
+        int dif = int(seq - pos);
+        if ( dif == 0 ) {
+            if ( os::CAS(&mheader->enqueue_pos, pos, pos + 1) )
+                return s;
+        } else if ( dif < 0 )
+            return 0; // full: the reader did not release this slot yet.
+        pos = mheader->enqueue_pos;
+    }
+}
+
+void ShmRing::publish(ShmSlot* s, unsigned int size)
+{
+    s->size = size;
+    oro_release_barrier();
+    s->sequence = s->sequence + 1;
+    // Pairs with the barrier in wait(): either we see the reader
+    // waiting, or the reader sees our slot.
+    oro_smp_mb();
+    if ( mheader->waiting )
+        wake();
+}
+
+ShmSlot* ShmRing::front() const
+{
+    unsigned int pos = mheader->dequeue_pos;
+    ShmSlot* s = slot(pos);
+    if ( int(s->sequence - (pos + 1)) != 0 )
+        return 0;
+    oro_acquire_barrier();
+    return s;
+}
+
+void ShmRing::pop()
+{
+    unsigned int pos = mheader->dequeue_pos;
+    ShmSlot* s = slot(pos);
+    oro_release_barrier();
+    s->sequence = pos + mheader->slots;
+    mheader->dequeue_pos = pos + 1;
+}
+
+bool ShmRing::wait(Seconds timeout)
+{
+    unsigned int seen = mheader->notify;
+    mheader->waiting = 1;
+    oro_smp_mb();
+    if ( front() == 0 ) {
+        struct timespec ts = ticks2timespec( nano2ticks( Seconds_to_nsecs(timeout) ) );
+        futex(&mheader->notify, FUTEX_WAIT, seen, &ts);
+    }
+    mheader->waiting = 0;
+    return front() != 0;
+}
+
+void ShmRing::rewind(unsigned int pos)
+{
+    for (unsigned int i = 0; i != mheader->slots; ++i)
+        slot(pos + i)->sequence = pos + i;
+    mheader->enqueue_pos = pos;
+    mheader->dequeue_pos = pos;
+    oro_release_barrier();
+}
+
+void ShmRing::wake()
+{
+    unsigned int n = mheader->notify;
+    while ( !os::CAS(&mheader->notify, n, n + 1) )
+        n = mheader->notify;
+    futex(&mheader->notify, FUTEX_WAKE, 1, 0);
+}
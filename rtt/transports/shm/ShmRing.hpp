@@ -0,0 +1,201 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_SHM_RING_HPP
+#define ORO_SHM_RING_HPP
+
+#include "../../rtt-config.h"
+#include "../../Time.hpp"
+#include <string>
+
+namespace RTT
+{
+    namespace shm
+    {
+        /**
+         * The header of a ring segment in shared memory. It is
+         * followed by \a slots slots of \a stride bytes each.
+         * The positions are free running counters, which are
+         * compared by their difference, such that they may wrap.
+         * The number of slots is a power of two, so the slot of a
+         * position does not jump when the counters wrap.
+         * The fields which are written by different parties are
+         * kept on separate cache lines.
+         */
+        struct ShmRingHeader
+        {
+            /** Written last by the creator, once the segment is initialized. */
+            volatile unsigned int magic;
+            unsigned int version;
+            /** The number of slots, a power of two. */
+            unsigned int slots;
+            /** The maximum payload of one slot, in bytes. */
+            unsigned int slot_size;
+            /** The distance between two slots, in bytes. */
+            unsigned int stride;
+            char pad0[44];
+            /** The next position a writer will claim. */
+            volatile unsigned int enqueue_pos;
+            char pad1[60];
+            /** The next position the reader will consume. */
+            volatile unsigned int dequeue_pos;
+            char pad2[60];
+            /** The futex word the reader sleeps on. */
+            volatile unsigned int notify;
+            /** Non-zero while the reader sleeps (or is about to). */
+            volatile unsigned int waiting;
+            char pad3[56];
+        };
+
+        /**
+         * The header of one slot, followed by its payload.
+         */
+        struct ShmSlot
+        {
+            /**
+             * Equals the position of the slot when it is free for
+             * a writer, the position plus one when it holds a sample.
+             */
+            volatile unsigned int sequence;
+            /** The size of the sample, zero if the writer failed to fill it. */
+            unsigned int size;
+            unsigned int pad[2];
+
+            char* data() { return reinterpret_cast<char*>(this + 1); }
+        };
+
+        /**
+         * A ring of fixed size slots in a POSIX shared memory segment,
+         * which is mapped by one reader and one or more writers,
+         * possibly in different processes. Writers claim a slot with a
+         * compare-and-swap and fill it in place, the reader consumes
+         * the slots in order. A writer never blocks: when the ring is
+         * full, claim() fails. The reader may sleep on a futex in the
+         * segment, which writers only wake up when the reader sleeps.
+         */
+        class ShmRing
+        {
+            std::string mname;
+            int mfd;
+            ShmRingHeader* mheader;
+            unsigned int mlength;
+            char* mslots;
+
+            ShmSlot* slot(unsigned int pos) const {
+                return reinterpret_cast<ShmSlot*>( mslots + (pos & (mheader->slots - 1)) * mheader->stride );
+            }
+        public:
+            ShmRing();
+
+            ~ShmRing();
+
+            /**
+             * Opens the segment \a name, or creates it with the given
+             * geometry if it does not exist yet. When it exists, the
+             * geometry of the creator is used and slot_size() may
+             * differ from \a slot_size.
+             * @param name The name of the segment, which starts with a '/'.
+             * @param slots The number of slots when creating it. It is
+             * rounded up to the next power of two.
+             * @param slot_size The payload size of a slot when creating it.
+             * @param timeout How long to wait for another party
+             * to finish the creation of the segment.
+             * @return false if the segment could not be opened.
+             */
+            bool open(const std::string& name, unsigned int slots, unsigned int slot_size, Seconds timeout = 0.5);
+
+            /**
+             * Unmaps the segment.
+             */
+            void close();
+
+            /**
+             * Removes the name of the segment, the memory is
+             * freed once all parties closed it.
+             */
+            void unlink();
+
+            bool isOpen() const { return mheader != 0; }
+
+            const std::string& name() const { return mname; }
+
+            unsigned int slots() const { return mheader ? mheader->slots : 0; }
+
+            unsigned int slot_size() const { return mheader ? mheader->slot_size : 0; }
+
+            /**
+             * Writer side: reserves the next slot.
+             * @return the slot to fill, or null if the ring is full.
+             * Every claimed slot must be published.
+             */
+            ShmSlot* claim();
+
+            /**
+             * Writer side: hands a claimed slot over to the reader and
+             * wakes it up if it sleeps.
+             * @param size The number of bytes written in the slot, zero
+             * to publish it as empty.
+             */
+            void publish(ShmSlot* s, unsigned int size);
+
+            /**
+             * Reader side: returns the oldest published slot, or null
+             * if there is none. The slot remains valid until pop().
+             */
+            ShmSlot* front() const;
+
+            /**
+             * Reader side: releases the slot returned by front().
+             */
+            void pop();
+
+            /**
+             * Reader side: sleeps until a slot is published, wake() is
+             * called or \a timeout passed.
+             * @return true if there is a published slot.
+             */
+            bool wait(Seconds timeout);
+
+            /**
+             * Wakes up the reader if it is sleeping in wait().
+             */
+            void wake();
+
+            /**
+             * Moves the positions of an empty ring to \a pos.
+             * Only the creator may call this, before the ring is used.
+             * This allows to test the wrap around of the positions.
+             */
+            void rewind(unsigned int pos);
+        };
+    }
+}
+
+#endif
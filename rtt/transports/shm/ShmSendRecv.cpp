@@ -0,0 +1,226 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "ShmSendRecv.hpp"
+#include "../../types/TypeMarshaller.hpp"
+#include "../../types/DeltaMarshaller.hpp"
+#include "../../ConnPolicy.hpp"
+#include "../../base/ChannelElementBase.hpp"
+#include "../../base/PortInterface.hpp"
+#include "../../DataFlowInterface.hpp"
+#include "../../TaskContext.hpp"
+#include "../../Activity.hpp"
+#include "../../Logger.hpp"
+
+#include <unistd.h>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+
+using namespace RTT;
+using namespace RTT::detail;
+using namespace RTT::shm;
+
+namespace RTT
+{
+    namespace shm
+    {
+        /**
+         * Sleeps on the ring of a receiving stream and signals its
+         * channel element for each sample that arrives.
+         */
+        class ShmReceiver : public Activity
+        {
+            ShmRing& mring;
+            base::ChannelElementBase* mchan;
+            volatile bool do_exit;
+        public:
+            ShmReceiver(ShmRing& ring, base::ChannelElementBase* chan)
+                : Activity(ORO_SCHED_RT, os::HighestPriority, 0.0, 0, "ShmReceive"),
+                  mring(ring), mchan(chan), do_exit(false)
+            {}
+
+            ~ShmReceiver() {
+                stop();
+            }
+
+            bool initialize() {
+                do_exit = false;
+                return true;
+            }
+
+            void loop() {
+                while ( !do_exit ) {
+                    // signal() forwards one sample to the next channel element.
+                    while ( !do_exit && mring.front() && mchan->signal() )
+                        ;
+                    if ( !do_exit )
+                        mring.wait(1.0);
+                }
+            }
+
+            bool breakLoop() {
+                do_exit = true;
+                mring.wake();
+                return true;
+            }
+        };
+    }
+}
+
+ShmSendRecv::ShmSendRecv(types::TypeMarshaller const& transport) :
+    mtransport(transport), marshaller_cookie(0), mdelta(0), mreceiver(0), mis_sender(false), minit_done(false), max_size(0)
+{
+}
+
+void ShmSendRecv::setupStream(base::DataSourceBase::shared_ptr ds, base::PortInterface* port, ConnPolicy const& policy,
+                              bool is_sender)
+{
+    Logger::In in("ShmSendRecv");
+
+    if (policy.keyframe_period > 0)
+        mdelta = new types::DeltaMarshaller(mtransport, policy.keyframe_period);
+    max_size = policy.data_size ? policy.data_size : mtransport.getSampleSize(ds);
+    if (mdelta)
+        max_size += types::DeltaMarshaller::getOverhead();
+    marshaller_cookie = marshaller().createCookie();
+    mis_sender = is_sender;
+
+    std::stringstream namestr;
+    namestr << '/' << port->getInterface()->getOwner()->getName() << '.' << port->getName() << '.' << this << '@' << getpid();
+
+    if (policy.name_id.empty())
+        policy.name_id = namestr.str();
+
+    if (policy.name_id[0] != '/')
+        throw std::runtime_error("Could not open shared memory with wrong name. Names must start with '/' and contain no more '/' after the first one.");
+    if (max_size <= 0)
+        throw std::runtime_error("Could not open shared memory with zero sample size.");
+
+    if ( !mring.open(policy.name_id, policy.size ? policy.size : 10, max_size) )
+        throw std::runtime_error("Could not open shared memory ring.");
+    if ( int(mring.slot_size()) < max_size )
+        log(Warning) << "Shared memory '" << policy.name_id << "' has slots of " << mring.slot_size()
+                     << " bytes, samples of " << max_size << " bytes will be refused." << endlog();
+}
+
+ShmSendRecv::~ShmSendRecv()
+{
+    delete mreceiver;
+}
+
+void ShmSendRecv::cleanupStream()
+{
+    if (mreceiver) {
+        mreceiver->stop();
+        delete mreceiver;
+        mreceiver = 0;
+    }
+    // sender unlinks to avoid future re-use of new readers.
+    if (mis_sender)
+        mring.unlink();
+    // both sender and receiver unmap their end.
+    mring.close();
+    minit_done = false;
+
+    if (marshaller_cookie)
+        marshaller().deleteCookie(marshaller_cookie);
+    marshaller_cookie = 0;
+    delete mdelta;
+    mdelta = 0;
+}
+
+types::TypeMarshaller const& ShmSendRecv::marshaller() const
+{
+    if (mdelta)
+        return *mdelta;
+    return mtransport;
+}
+
+bool ShmSendRecv::shmReady(base::DataSourceBase::shared_ptr ds, base::ChannelElementBase* chan)
+{
+    if (minit_done)
+        return true;
+
+    if (mis_sender)
+        return false; // we can only receive inputReady on the input port side.
+
+    // The output port implementation guarantees that there will be
+    // an initial sample after the connection is ready.
+    if ( !mring.front() && !mring.wait(0.5) ) {
+        log(Error) << "Failed to receive initial data sample for shared memory channel element." << endlog();
+        return false;
+    }
+    if ( !shmRead(ds) ) {
+        log(Error) << "Failed to initialize shared memory channel element with initial data sample." << endlog();
+        return false;
+    }
+    minit_done = true;
+    // ok, now we can start forwarding.
+    mreceiver = new ShmReceiver(mring, chan);
+    mreceiver->start();
+    return true;
+}
+
+bool ShmSendRecv::shmRead(base::DataSourceBase::shared_ptr ds)
+{
+    ShmSlot* s = mring.front();
+    if (s == 0)
+        return false;
+    bool ok = s->size != 0 && marshaller().updateFromBlob(s->data(), s->size, ds, marshaller_cookie);
+    mring.pop();
+    return ok;
+}
+
+bool ShmSendRecv::shmWrite(base::DataSourceBase::shared_ptr ds)
+{
+    ShmSlot* s = mring.claim();
+    // a full ring drops the sample, like a full message queue.
+    if (s == 0)
+        return true;
+    // the marshaller writes in the slot, or returns the
+    // address of a sample which can be copied as is.
+    std::pair<void const*, int> blob = marshaller().fillBlob(ds, s->data(), mring.slot_size(), marshaller_cookie);
+    if (blob.first == 0 || blob.second > int(mring.slot_size()))
+    {
+        // the slot size is fixed, so only this sample is lost:
+        // keep the stream open for the following ones.
+        mring.publish(s, 0);
+        log(Error) << "ShmChannel: failed to marshal sample in slots of "
+                   << mring.slot_size() << " bytes, dropped it." << endlog();
+        return true;
+    }
+    if (blob.first != s->data())
+        memcpy(s->data(), blob.first, blob.second);
+    mring.publish(s, blob.second);
+    if (mdelta)
+        mdelta->sent(marshaller_cookie);
+    return true;
+}
@@ -0,0 +1,135 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_SHM_SENDRECV_HPP
+#define ORO_SHM_SENDRECV_HPP
+
+#include "ShmRing.hpp"
+#include "../../rtt-fwd.hpp"
+#include "../../base/DataSourceBase.hpp"
+
+namespace RTT
+{
+    namespace shm
+    {
+        class ShmReceiver;
+
+        /**
+         * Implements the sending/receiving of samples through a
+         * shared memory ring. It can only be OR sender OR receiver
+         * (logical XOR). The samples are marshalled directly into
+         * and out of the slots of the ring.
+         */
+        class ShmSendRecv
+        {
+        protected:
+            /**
+             * Transport marshaller used for size calculations
+             * and data updates.
+             */
+            types::TypeMarshaller const& mtransport;
+            /**
+             * A private blob that is returned by mtransport.getCookie(). It is
+             * used by the marshallers if they need private internal data to do
+             * the marshalling
+             */
+            void* marshaller_cookie;
+            /**
+             * Marshals the changes between samples on top of mtransport, if
+             * the ConnPolicy has a keyframe period. Null otherwise.
+             */
+            types::DeltaMarshaller* mdelta;
+            /**
+             * The shared memory ring.
+             */
+            ShmRing mring;
+            /**
+             * The thread which forwards received samples, on the receiving side.
+             */
+            ShmReceiver* mreceiver;
+            /**
+             * True if this object is a sender.
+             */
+            bool mis_sender;
+            /**
+             * True once the receiver got the initial sample.
+             */
+            bool minit_done;
+            /**
+             * The size of a sample, as specified in the ConnPolicy when
+             * creating the stream, or calculated using the transport when
+             * that size was zero.
+             */
+            int max_size;
+
+        public:
+            /**
+             * Create a channel element for remote data exchange.
+             * @param transport The type specific object that will be used to marshal the data.
+             */
+            ShmSendRecv(types::TypeMarshaller const& transport);
+
+            void setupStream(base::DataSourceBase::shared_ptr ds, base::PortInterface* port, ConnPolicy const& policy, bool is_sender);
+
+            ~ShmSendRecv();
+
+            void cleanupStream();
+
+            /**
+             * Works only in receive mode, waits for the initial sample
+             * and starts forwarding the following ones to \a chan.
+             */
+            bool shmReady(base::DataSourceBase::shared_ptr ds, base::ChannelElementBase* chan);
+
+            /**
+             * Read the oldest sample from the ring.
+             * @param ds stores the resulting data sample.
+             * @return true if an item could be read.
+             */
+            bool shmRead(base::DataSourceBase::shared_ptr ds);
+
+            /**
+             * Write a sample into the ring. The sample is dropped
+             * when the ring is full or when it does not fit in a slot.
+             * @param ds the data sample to write
+             * @return true, such that the stream remains connected.
+             */
+            bool shmWrite(base::DataSourceBase::shared_ptr ds);
+
+        private:
+            /**
+             * The marshaller of this stream: mdelta if set, mtransport otherwise.
+             */
+            types::TypeMarshaller const& marshaller() const;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,114 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_SHM_TEMPLATE_PROTOCOL_HPP
+#define ORO_SHM_TEMPLATE_PROTOCOL_HPP
+
+#include "ShmLib.hpp"
+#include "ShmChannelElement.hpp"
+#include "../../types/TypeMarshaller.hpp"
+#include "../../types/TypeInfo.hpp"
+
+#include <boost/type_traits/has_virtual_destructor.hpp>
+#include <boost/static_assert.hpp>
+
+namespace RTT
+{ namespace shm
+  {
+      /**
+       * Creates shared memory streams for type T. Subclasses
+       * define how T is marshalled into a slot.
+       */
+      template<class T>
+      class ShmTemplateProtocolBase
+          : public RTT::types::TypeMarshaller
+      {
+      public:
+          typedef T UserType;
+
+          virtual base::ChannelElementBase::shared_ptr createStream(base::PortInterface* port, const ConnPolicy& policy, bool is_sender) const {
+              try {
+                  base::ChannelElementBase::shared_ptr shm = new ShmChannelElement<T>(port, *this, policy, is_sender);
+                  if ( !is_sender ) {
+                      // the receiver needs a buffer to store his samples in.
+                      base::ChannelElementBase::shared_ptr buf = detail::DataSourceTypeInfo<T>::getTypeInfo()->buildDataStorage(policy);
+                      shm->setOutput(buf);
+                  }
+                  return shm;
+              } catch(std::exception& e) {
+                  log(Error) << "Failed to create shared memory channel element: " << e.what() << endlog();
+              }
+              return base::ChannelElementBase::shared_ptr();
+          }
+      };
+
+      /**
+       * Transports a plain old data type T by copying its bytes
+       * straight into a slot of the ring, and out of it on the other
+       * side: one copy per side and no kernel call unless the reader sleeps.
+       * @warning This can only be used if T is a trivial type without
+       * meaningful (copy) constructor and without pointers. For all
+       * other cases use the ShmSerializationProtocol class.
+       */
+      template<class T>
+      class ShmTemplateProtocol
+          : public ShmTemplateProtocolBase<T>
+      {
+      public:
+          BOOST_STATIC_ASSERT( !boost::has_virtual_destructor<T>::value );
+
+          typedef T UserType;
+
+          virtual std::pair<void const*,int> fillBlob( base::DataSourceBase::shared_ptr source, void* blob, int size, void* cookie) const
+          {
+              if ( sizeof(T) <= (unsigned int)size)
+                  return std::make_pair(source->getRawConstPointer(), int(sizeof(T)));
+              return std::make_pair((void const*)0,int(0));
+          }
+
+          virtual bool updateFromBlob(const void* blob, int size, base::DataSourceBase::shared_ptr target, void* cookie) const
+          {
+              typename internal::AssignableDataSource<T>::shared_ptr ad = internal::AssignableDataSource<T>::narrow( target.get() );
+              if ( ad && size == sizeof(T) ) {
+                  ad->set( *(T*)(blob) );
+                  return true;
+              }
+              return false;
+          }
+
+          virtual unsigned int getSampleSize(base::DataSourceBase::shared_ptr ignored, void* cookie) const
+          {
+              return sizeof(T);
+          }
+      };
+}
+}
+
+#endif
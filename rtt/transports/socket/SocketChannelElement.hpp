@@ -0,0 +1,182 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_SOCKET_CHANNEL_ELEMENT_HPP
+#define ORO_SOCKET_CHANNEL_ELEMENT_HPP
+
+#include "SocketSendRecv.hpp"
+#include "../../Logger.hpp"
+#include "../../base/ChannelElement.hpp"
+#include "../../internal/DataSource.hpp"
+#include "../../internal/DataSources.hpp"
+#include "../../ConnPolicy.hpp"
+#include "../../types/SampleResize.hpp"
+#include <boost/type_traits/is_same.hpp>
+#include <stdexcept>
+#include <vector>
+
+namespace RTT
+{
+    namespace socket
+    {
+        /**
+         * Implements a ChannelElement using a socket.
+         * It converts the C++ calls into datagrams and vice versa.
+         */
+        template<typename T>
+        class SocketChannelElement: public base::ChannelElement<T>, public SocketSendRecv
+        {
+            /** Used as a temporary on the reading side */
+            typename internal::ValueDataSource<T>::shared_ptr read_sample;
+            /** Used in write() to refer to the sample that needs to be written */
+            typename internal::LateConstReferenceDataSource<T>::shared_ptr write_sample;
+            /** The ConnPolicy::max_elements of this connection, or zero. */
+            int mmax_elements;
+
+        public:
+            /**
+             * Create a channel element for remote data exchange.
+             * @param transport The type specific object that will be used to marshal the data.
+             */
+            SocketChannelElement(base::PortInterface* port, types::TypeMarshaller const& transport,
+                                 const ConnPolicy& policy, bool is_sender)
+                : SocketSendRecv(transport)
+                , read_sample(new internal::ValueDataSource<T>)
+                , write_sample(new internal::LateConstReferenceDataSource<T>)
+                , mmax_elements(policy.max_elements)
+            {
+                Logger::In in("SocketChannelElement");
+                // size read_sample and, in setupStream, the slots for the largest sample.
+                if ( mmax_elements > 0 && !types::resize_sample( read_sample->set(), mmax_elements ) ) {
+                    log(Warning) << "ConnPolicy::max_elements is ignored: the samples of this connection are not sequences." << endlog();
+                    mmax_elements = 0;
+                }
+                setupStream(read_sample, port, policy, is_sender);
+            }
+
+            ~SocketChannelElement() {
+                cleanupStream();
+            }
+
+            virtual bool inputReady() {
+                return socketReady(this);
+            }
+
+            virtual bool data_sample(typename base::ChannelElement<T>::param_t sample)
+            {
+                // send initial data sample to the other side, flagged as such.
+                if (mis_sender) {
+                    write_sample->setPointer(&sample);
+                    return socketWrite(write_sample, true);
+                }
+                return false;
+            }
+
+            /**
+             * For a sending element, signal triggers a direct read on
+             * the data element and a send on the socket. For a receiving
+             * element, signal is used by the receiver thread to read
+             * the oldest received sample and forward it to the next
+             * channel element.
+             * @return true in case the forwarding could be done, false otherwise.
+             */
+            bool signal()
+            {
+                if (mis_sender) {
+                    typename base::ChannelElement<T>::shared_ptr input =
+                        this->getInput();
+                    if( input && input->read(read_sample->set(), false) == NewData )
+                        return this->write(read_sample->rvalue());
+                    return false;
+                }
+                typename base::ChannelElement<T>::shared_ptr output =
+                    this->getOutput();
+                if (!output)
+                    return false;
+                switch ( socketRead(read_sample) ) {
+                case Sample:
+                    return output->write(read_sample->rvalue());
+                case InitialSample:
+                    // only sizes the storage, the reader sees no new data.
+                    if ( mmax_elements > 0 ) {
+                        T sample = read_sample->rvalue();
+                        types::resize_sample( sample, mmax_elements );
+                        output->data_sample( sample );
+                    } else
+                        output->data_sample(read_sample->rvalue());
+                    return true;
+                default:
+                    return false;
+                }
+            }
+
+            FlowStatus read(typename base::ChannelElement<T>::reference_t sample, bool copy_old_data)
+            {
+                throw std::runtime_error("not implemented");
+            }
+
+            /**
+             * Write to the socket.
+             * @param sample the data sample to write
+             * @return true if it could be sent.
+             */
+            bool write(typename base::ChannelElement<T>::param_t sample)
+            {
+                write_sample->setPointer(&sample);
+                return socketWrite(write_sample);
+            }
+
+            /**
+             * Sends the samples in groups of ORONUM_SOCKET_BATCH with
+             * one system call per group.
+             */
+            bool writeBatch(std::vector<T> const& samples)
+            {
+                // the elements of a std::vector<bool> have no address to send from.
+                if ( boost::is_same<T, bool>::value )
+                    return base::ChannelElement<T>::writeBatch(samples);
+                typename std::vector<T>::const_iterator it = samples.begin();
+                while ( it != samples.end() ) {
+                    int count = 0;
+                    for (; it != samples.end() && count != ORONUM_SOCKET_BATCH; ++it) {
+                        const T& sample = *it;
+                        write_sample->setPointer(&sample);
+                        if ( socketFill(count, write_sample) )
+                            ++count;
+                    }
+                    socketSend(count);
+                }
+                return true;
+            }
+        };
+    }
+}
+
+#endif
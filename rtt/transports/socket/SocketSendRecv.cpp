@@ -0,0 +1,485 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "SocketSendRecv.hpp"
+#include "../../types/TypeMarshaller.hpp"
+#include "../../types/DeltaMarshaller.hpp"
+#include "../../ConnPolicy.hpp"
+#include "../../base/ChannelElementBase.hpp"
+#include "../../base/PortInterface.hpp"
+#include "../../DataFlowInterface.hpp"
+#include "../../TaskContext.hpp"
+#include "../../Activity.hpp"
+#include "../../Logger.hpp"
+
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+using namespace RTT;
+using namespace RTT::detail;
+using namespace RTT::socket;
+
+namespace
+{
+    /**
+     * The frame header which precedes each sample.
+     */
+    enum { SampleFrame = 1, InitialFrame = 2 };
+
+    /**
+     * The largest payload of a UDP datagram.
+     */
+    const int MaxDatagram = 65507;
+
+    /**
+     * Fills in \a addr and \a len with the address in \a name, see SocketSendRecv.
+     * @return true if the name is valid.
+     */
+    bool parseAddress(const std::string& name, sockaddr_storage& addr, socklen_t& len, bool& is_unix)
+    {
+        memset(&addr, 0, sizeof(addr));
+        if (name[0] == '/') {
+            // abstract namespace: a leading zero byte, the name is not null terminated.
+            static const char prefix[] = "rtt-socket";
+            sockaddr_un* un = reinterpret_cast<sockaddr_un*>(&addr);
+            if ( 1 + sizeof(prefix) - 1 + name.size() > sizeof(un->sun_path) )
+                return false;
+            un->sun_family = AF_UNIX;
+            memcpy(un->sun_path + 1, prefix, sizeof(prefix) - 1);
+            memcpy(un->sun_path + sizeof(prefix), name.data(), name.size());
+            len = offsetof(sockaddr_un, sun_path) + sizeof(prefix) + name.size();
+            is_unix = true;
+            return true;
+        }
+        if (name.compare(0, 4, "udp:") != 0)
+            return false;
+        std::string host = "127.0.0.1";
+        std::string port = name.substr(4);
+        std::string::size_type colon = port.rfind(':');
+        if (colon != std::string::npos) {
+            host = port.substr(0, colon);
+            port = port.substr(colon + 1);
+        }
+        char* end = 0;
+        long number = strtol(port.c_str(), &end, 10);
+        if (port.empty() || *end != 0 || number < 0 || number > 65535)
+            return false;
+        sockaddr_in* in = reinterpret_cast<sockaddr_in*>(&addr);
+        in->sin_family = AF_INET;
+        in->sin_port = htons(number);
+        if ( inet_pton(AF_INET, host.c_str(), &in->sin_addr) != 1 )
+            return false;
+        len = sizeof(sockaddr_in);
+        is_unix = false;
+        return true;
+    }
+
+    /**
+     * Opens a non-blocking socket with kernel buffers of at least \a buffer_size bytes.
+     */
+    int openSocket(bool is_unix, int buffer_size, bool is_sender)
+    {
+        int s = ::socket(is_unix ? AF_UNIX : AF_INET, (is_unix ? SOCK_SEQPACKET : SOCK_DGRAM) | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (s == -1)
+            return s;
+        // only grow the default size, the kernel caps it at wmem_max/rmem_max.
+        int option = is_sender ? SO_SNDBUF : SO_RCVBUF;
+        int current = 0;
+        socklen_t len = sizeof(current);
+        if ( getsockopt(s, SOL_SOCKET, option, &current, &len) == 0 && current < buffer_size )
+            setsockopt(s, SOL_SOCKET, option, &buffer_size, sizeof(buffer_size));
+        return s;
+    }
+
+    void closeSocket(int& s)
+    {
+        if (s != -1)
+            close(s);
+        s = -1;
+    }
+}
+
+namespace RTT
+{
+    namespace socket
+    {
+        /**
+         * Accepts the connection of the sender, receives the
+         * samples in batches and signals the channel element for
+         * each of them.
+         */
+        class SocketReceiver : public Activity
+        {
+            SocketSendRecv& mstream;
+            base::ChannelElementBase* mchan;
+            volatile bool do_exit;
+        public:
+            SocketReceiver(SocketSendRecv& stream, base::ChannelElementBase* chan)
+                : Activity(ORO_SCHED_RT, os::HighestPriority, 0.0, 0, "SocketReceive"),
+                  mstream(stream), mchan(chan), do_exit(false)
+            {}
+
+            ~SocketReceiver() {
+                stop();
+            }
+
+            bool initialize() {
+                do_exit = false;
+                return true;
+            }
+
+            void loop() {
+                while ( !do_exit ) {
+                    // signal() forwards one sample to the next channel element.
+                    if ( mstream.receive() ) {
+                        while ( !do_exit && mstream.mforwarded != mstream.mreceived && mchan->signal() )
+                            ;
+                        // a sample which could not be forwarded drops the rest of the batch.
+                        mstream.mforwarded = mstream.mreceived;
+                    }
+                }
+            }
+
+            bool breakLoop() {
+                do_exit = true;
+                mstream.wake();
+                return true;
+            }
+        };
+    }
+}
+
+SocketSendRecv::SocketSendRecv(types::TypeMarshaller const& transport) :
+    mtransport(transport), marshaller_cookie(0), mdelta(0), msocket(-1), mlisten(-1), mwakeup(-1),
+    munix(true), maddress_len(0), mconnected(false), mbuffer_size(0), mreceiver(0), mis_sender(false), max_size(0),
+    mreceived(0), mforwarded(0)
+{
+}
+
+void SocketSendRecv::setupStream(base::DataSourceBase::shared_ptr ds, base::PortInterface* port, ConnPolicy const& policy,
+                                 bool is_sender)
+{
+    Logger::In in("SocketSendRecv");
+
+    if (policy.keyframe_period > 0)
+        mdelta = new types::DeltaMarshaller(mtransport, policy.keyframe_period);
+    max_size = policy.data_size ? policy.data_size : mtransport.getSampleSize(ds);
+    // ds was sized for the largest sample by the channel element.
+    if (policy.max_elements > 0)
+        max_size = std::max(max_size, (int) mtransport.getSampleSize(ds));
+    if (mdelta)
+        max_size += types::DeltaMarshaller::getOverhead();
+    marshaller_cookie = marshaller().createCookie();
+    mis_sender = is_sender;
+
+    std::stringstream namestr;
+    namestr << '/' << port->getInterface()->getOwner()->getName() << '.' << port->getName() << '.' << this << '@' << getpid();
+
+    if (policy.name_id.empty())
+        policy.name_id = namestr.str();
+
+    if ( !parseAddress(policy.name_id, maddress, maddress_len, munix) )
+        throw std::runtime_error("Could not open socket with wrong name '" + policy.name_id + "'. Names must be '/name', 'udp:port' or 'udp:address:port'.");
+    if (max_size <= 0)
+        throw std::runtime_error("Could not open socket with zero sample size.");
+    if ( !munix && max_size + int(sizeof(unsigned int)) > MaxDatagram )
+        log(Warning) << "UDP socket '" << policy.name_id << "' carries at most " << MaxDatagram - sizeof(unsigned int)
+                     << " bytes per sample, samples of " << max_size << " bytes will be refused." << endlog();
+
+    // the slots are set up once, receiving and sending only update the lengths.
+    mslots.resize( ORONUM_SOCKET_BATCH * max_size );
+    mframes.resize( ORONUM_SOCKET_BATCH, SampleFrame );
+    miovecs.resize( 2 * ORONUM_SOCKET_BATCH );
+    mmessages.resize( ORONUM_SOCKET_BATCH );
+    memset(&mmessages[0], 0, mmessages.size() * sizeof(mmsghdr));
+    for (int i = 0; i != ORONUM_SOCKET_BATCH; ++i) {
+        miovecs[2*i].iov_base = &mframes[i];
+        miovecs[2*i].iov_len = sizeof(unsigned int);
+        miovecs[2*i+1].iov_base = &mslots[i * max_size];
+        miovecs[2*i+1].iov_len = max_size;
+        mmessages[i].msg_hdr.msg_iov = &miovecs[2*i];
+        mmessages[i].msg_hdr.msg_iovlen = 2;
+    }
+    mbuffer_size = (policy.size ? policy.size : 10) * (max_size + sizeof(unsigned int));
+
+    if (mis_sender) {
+        // a Unix sender connects once the receiver listens, see connect().
+        if (!munix) {
+            msocket = openSocket(munix, mbuffer_size, true);
+            if ( msocket == -1 || ::connect(msocket, (sockaddr*)&maddress, maddress_len) != 0 )
+                throw std::runtime_error("Could not open socket '" + policy.name_id + "': " + strerror(errno));
+            mconnected = true;
+        }
+        connect();
+        return;
+    }
+
+    int s = openSocket(munix, mbuffer_size, false);
+    if (s == -1)
+        throw std::runtime_error(std::string("Could not open socket: ") + strerror(errno));
+    if ( bind(s, (sockaddr*)&maddress, maddress_len) != 0 || (munix && listen(s, 1) != 0) ) {
+        std::string error = strerror(errno);
+        close(s);
+        throw std::runtime_error("Could not bind socket '" + policy.name_id + "': " + error);
+    }
+    if (munix)
+        mlisten = s;
+    else
+        msocket = s;
+
+    sockaddr_in* inaddr = reinterpret_cast<sockaddr_in*>(&maddress);
+    if ( !munix && inaddr->sin_port == 0 ) {
+        // tell the sender which port was picked.
+        getsockname(s, (sockaddr*)&maddress, &maddress_len);
+        char host[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &inaddr->sin_addr, host, sizeof(host));
+        std::stringstream udpname;
+        udpname << "udp:" << host << ':' << ntohs(inaddr->sin_port);
+        policy.name_id = udpname.str();
+    }
+
+    mwakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mwakeup == -1)
+        throw std::runtime_error(std::string("Could not create eventfd: ") + strerror(errno));
+}
+
+SocketSendRecv::~SocketSendRecv()
+{
+    delete mreceiver;
+}
+
+void SocketSendRecv::cleanupStream()
+{
+    if (mreceiver) {
+        mreceiver->stop();
+        delete mreceiver;
+        mreceiver = 0;
+    }
+    // the abstract namespace and UDP need no unlink.
+    closeSocket(msocket);
+    closeSocket(mlisten);
+    closeSocket(mwakeup);
+    mconnected = false;
+    mreceived = mforwarded = 0;
+
+    if (marshaller_cookie)
+        marshaller().deleteCookie(marshaller_cookie);
+    marshaller_cookie = 0;
+    delete mdelta;
+    mdelta = 0;
+}
+
+types::TypeMarshaller const& SocketSendRecv::marshaller() const
+{
+    if (mdelta)
+        return *mdelta;
+    return mtransport;
+}
+
+bool SocketSendRecv::socketReady(base::ChannelElementBase* chan)
+{
+    if (mis_sender)
+        return false; // we can only receive inputReady on the input port side.
+    if (mreceiver)
+        return true;
+
+    // the sender may connect later, so don't wait for the initial sample:
+    // it is forwarded with data_sample() when it arrives.
+    mreceiver = new SocketReceiver(*this, chan);
+    mreceiver->start();
+    return true;
+}
+
+bool SocketSendRecv::receive()
+{
+    if (mreceived != mforwarded)
+        return true;
+    mreceived = mforwarded = 0;
+
+    pollfd fds[3];
+    int count = 0;
+    fds[count].fd = mwakeup;
+    fds[count++].events = POLLIN;
+    if (mlisten != -1) {
+        fds[count].fd = mlisten;
+        fds[count++].events = POLLIN;
+    }
+    if (msocket != -1) {
+        fds[count].fd = msocket;
+        fds[count++].events = POLLIN;
+    }
+    if ( poll(fds, count, -1) <= 0 )
+        return false;
+
+    if (fds[0].revents) {
+        uint64_t wakeups;
+        ssize_t ignored = read(mwakeup, &wakeups, sizeof(wakeups));
+        (void)ignored;
+        return false;
+    }
+
+    if (mlisten != -1 && fds[1].revents) {
+        // a new connection only replaces the one of a sender which went
+        // away: a stream has one writer, a second one is refused.
+        int c = accept4(mlisten, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (c != -1) {
+            if ( msocket == -1 || (fds[2].revents & (POLLHUP | POLLERR)) ) {
+                closeSocket(msocket);
+                msocket = c;
+            } else {
+                close(c);
+                log(Warning) << "SocketChannel: refused a second sender on a stream with a connected sender." << endlog();
+            }
+        }
+        return false;
+    }
+
+    if (msocket == -1 || fds[count - 1].revents == 0)
+        return false;
+    int received = recvmmsg(msocket, &mmessages[0], ORONUM_SOCKET_BATCH, MSG_DONTWAIT, 0);
+    // an empty message on a Unix socket means that the sender closed its end.
+    int valid = 0;
+    while (valid < received && mmessages[valid].msg_len != 0)
+        ++valid;
+    if ( munix && (valid < received || (received == -1 && errno != EAGAIN && errno != EINTR)) )
+        closeSocket(msocket);
+    mreceived = valid;
+    return valid != 0;
+}
+
+void SocketSendRecv::wake()
+{
+    uint64_t one = 1;
+    ssize_t ignored = write(mwakeup, &one, sizeof(one));
+    (void)ignored;
+}
+
+SocketSendRecv::ReadResult SocketSendRecv::socketRead(base::DataSourceBase::shared_ptr ds)
+{
+    if (mforwarded == mreceived)
+        return NoSample;
+    int i = mforwarded++;
+    const mmsghdr& m = mmessages[i];
+    if ( (m.msg_hdr.msg_flags & MSG_TRUNC) || m.msg_len < sizeof(unsigned int) ) {
+        log(Error) << "SocketChannel: received a sample larger than "
+                   << max_size << " bytes, dropped it." << endlog();
+        return NoSample;
+    }
+    if ( !marshaller().updateFromBlob(&mslots[i * max_size], m.msg_len - sizeof(unsigned int), ds, marshaller_cookie) )
+        return NoSample;
+    return mframes[i] == InitialFrame ? InitialSample : Sample;
+}
+
+bool SocketSendRecv::connect()
+{
+    if (mconnected)
+        return true;
+    if (msocket == -1)
+        msocket = openSocket(munix, mbuffer_size, true);
+    // fails until the receiver listens.
+    if ( msocket != -1 && ::connect(msocket, (sockaddr*)&maddress, maddress_len) == 0 ) {
+        mconnected = true;
+        // the receiver may be a new one.
+        if (mdelta)
+            mdelta->resync(marshaller_cookie);
+    }
+    return mconnected;
+}
+
+bool SocketSendRecv::socketFill(int slot, base::DataSourceBase::shared_ptr ds)
+{
+    // the marshaller writes in the slot, or returns the
+    // address of a sample which can be sent as is.
+    std::pair<void const*, int> blob = marshaller().fillBlob(ds, &mslots[slot * max_size], max_size, marshaller_cookie);
+    if (blob.first == 0 || blob.second > max_size)
+    {
+        log(Error) << "SocketChannel: failed to marshal sample in slots of "
+                   << max_size << " bytes, dropped it." << endlog();
+        return false;
+    }
+    // the next slot of a batch is a delta against this one: if the
+    // batch is not sent completely, socketSend() asks for a keyframe.
+    if (mdelta)
+        mdelta->sent(marshaller_cookie);
+    mframes[slot] = SampleFrame;
+    miovecs[2*slot+1].iov_base = const_cast<void*>(blob.first);
+    miovecs[2*slot+1].iov_len = blob.second;
+    return true;
+}
+
+bool SocketSendRecv::socketSend(int count)
+{
+    if (count == 0)
+        return true;
+    if ( !connect() ) {
+        if (mdelta)
+            mdelta->resync(marshaller_cookie);
+        return true;
+    }
+    int sent = 0;
+    if (count == 1)
+        sent = sendmsg(msocket, &mmessages[0].msg_hdr, MSG_DONTWAIT | MSG_NOSIGNAL) < 0 ? -1 : 1;
+    else
+        sent = sendmmsg(msocket, &mmessages[0], count, MSG_DONTWAIT | MSG_NOSIGNAL);
+    // a full socket or an absent UDP receiver drops the samples, like a
+    // full message queue. A Unix receiver which went away is connected
+    // to again on the next write.
+    if ( sent == -1 && munix && errno != EAGAIN && errno != EINTR ) {
+        closeSocket(msocket);
+        mconnected = false;
+    }
+    // the receiver lacks the base of the next delta.
+    if (sent != count && mdelta)
+        mdelta->resync(marshaller_cookie);
+    return true;
+}
+
+bool SocketSendRecv::socketWrite(base::DataSourceBase::shared_ptr ds, bool initial)
+{
+    if (initial && mdelta)
+        mdelta->resync(marshaller_cookie);
+    if ( !socketFill(0, ds) )
+        return true;
+    if (initial)
+        mframes[0] = InitialFrame;
+    return socketSend(1);
+}
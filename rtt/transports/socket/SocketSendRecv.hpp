@@ -0,0 +1,250 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_SOCKET_SENDRECV_HPP
+#define ORO_SOCKET_SENDRECV_HPP
+
+#include "../../rtt-fwd.hpp"
+#include "../../base/DataSourceBase.hpp"
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
+
+/**
+ * The number of samples sent with one sendmmsg() call by
+ * writeBatch() and received with one recvmmsg() call.
+ */
+#ifndef ORONUM_SOCKET_BATCH
+#define ORONUM_SOCKET_BATCH 16
+#endif
+
+namespace RTT
+{
+    namespace socket
+    {
+        class SocketReceiver;
+
+        /**
+         * Implements the sending/receiving of samples through a socket.
+         * It can only be OR sender OR receiver (logical XOR).
+         *
+         * The ConnPolicy::name_id selects the socket:
+         * - "/name" is a SOCK_SEQPACKET Unix socket in the abstract
+         *   namespace, which needs no clean up in the file system.
+         *   An empty name_id creates such a name.
+         * - "udp:port" or "udp:address:port" is a UDP socket, on
+         *   127.0.0.1 if no numeric address is given. A receiver on
+         *   port 0 picks a free port and stores it in the name_id.
+         *
+         * Each datagram carries one sample, which is marshalled with the
+         * TypeMarshaller fillBlob()/updateFromBlob() interface behind a
+         * small frame header. Both ends size their slots once, when the
+         * stream is set up, for the initial sample, ConnPolicy::data_size
+         * or ConnPolicy::max_elements, whichever is largest. A sample which
+         * does not fit in a slot is dropped: unlike the mqueue transport,
+         * slots are not resized for larger samples, so variable size types
+         * need max_elements set to their largest size.
+         *
+         * Unlike a message queue, a socket does not keep samples while
+         * the reader is absent: the sender drops samples until a receiver
+         * is bound, and a Unix sender connects again when the receiver
+         * comes back. Writing never blocks, a full socket drops the sample.
+         * A stream has one writer: a Unix receiver refuses the connection
+         * of a second sender while the first one is connected, and UDP
+         * receivers do not tell several senders apart.
+         */
+        class SocketSendRecv
+        {
+            friend class SocketReceiver;
+        protected:
+            /**
+             * Transport marshaller used for size calculations
+             * and data updates.
+             */
+            types::TypeMarshaller const& mtransport;
+            /**
+             * A private blob that is returned by mtransport.getCookie(). It is
+             * used by the marshallers if they need private internal data to do
+             * the marshalling
+             */
+            void* marshaller_cookie;
+            /**
+             * Marshals the changes between samples on top of mtransport, if
+             * the ConnPolicy has a keyframe period. Null otherwise.
+             */
+            types::DeltaMarshaller* mdelta;
+            /**
+             * Sender: the socket to send on. Receiver: the bound UDP socket
+             * or the accepted Unix connection. -1 if there is none.
+             */
+            int msocket;
+            /**
+             * Receiver of a Unix socket: the socket which accepts the sender.
+             */
+            int mlisten;
+            /**
+             * Wakes up the receiver thread when the stream is cleaned up.
+             */
+            int mwakeup;
+            /**
+             * True for a Unix socket, false for UDP.
+             */
+            bool munix;
+            /**
+             * The address the receiver binds to and the sender sends to.
+             */
+            sockaddr_storage maddress;
+            socklen_t maddress_len;
+            /**
+             * Sender: true once msocket is connected to the receiver.
+             */
+            bool mconnected;
+            /**
+             * The size of the kernel buffers of the socket, which hold
+             * ConnPolicy::size samples.
+             */
+            int mbuffer_size;
+            /**
+             * The thread which receives and forwards the samples, on the receiving side.
+             */
+            SocketReceiver* mreceiver;
+            /**
+             * True if this object is a sender.
+             */
+            bool mis_sender;
+            /**
+             * The size of a slot, as specified in the ConnPolicy when
+             * creating the stream, or calculated using the transport when
+             * that size was zero, and large enough for
+             * ConnPolicy::max_elements. It never changes afterwards.
+             */
+            int max_size;
+            /**
+             * ORONUM_SOCKET_BATCH slots of max_size bytes, in which the samples
+             * are marshalled or received.
+             */
+            std::vector<char> mslots;
+            /**
+             * The frame header of each slot.
+             */
+            std::vector<unsigned int> mframes;
+            /**
+             * Two iovecs per slot: the frame header and the sample.
+             */
+            std::vector<iovec> miovecs;
+            std::vector<mmsghdr> mmessages;
+            /**
+             * Receiver: the number of messages in the slots and the
+             * number of them which were forwarded.
+             */
+            int mreceived;
+            int mforwarded;
+
+        public:
+            /**
+             * What socketRead() found in the oldest received message.
+             */
+            enum ReadResult { NoSample = 0, Sample, InitialSample };
+
+            /**
+             * Create a channel element for remote data exchange.
+             * @param transport The type specific object that will be used to marshal the data.
+             */
+            SocketSendRecv(types::TypeMarshaller const& transport);
+
+            void setupStream(base::DataSourceBase::shared_ptr ds, base::PortInterface* port, ConnPolicy const& policy, bool is_sender);
+
+            ~SocketSendRecv();
+
+            void cleanupStream();
+
+            /**
+             * Works only in receive mode, starts forwarding the received
+             * samples to \a chan. It does not wait for the initial sample,
+             * since the sender may not even be connected yet.
+             */
+            bool socketReady(base::ChannelElementBase* chan);
+
+            /**
+             * Read the oldest received sample.
+             * @param ds stores the resulting data sample.
+             */
+            ReadResult socketRead(base::DataSourceBase::shared_ptr ds);
+
+            /**
+             * Send a sample. The sample is dropped when the socket is
+             * full, when there is no receiver or when it does not fit
+             * in a slot.
+             * @param ds the data sample to write
+             * @param initial true if this is the initial data sample.
+             * @return true, such that the stream remains connected.
+             */
+            bool socketWrite(base::DataSourceBase::shared_ptr ds, bool initial = false);
+
+            /**
+             * Marshal a sample into slot \a slot, to be sent by socketSend().
+             * @return false if the sample does not fit in the slot.
+             */
+            bool socketFill(int slot, base::DataSourceBase::shared_ptr ds);
+
+            /**
+             * Send the samples in the first \a count slots with one system call.
+             * @return true, such that the stream remains connected.
+             */
+            bool socketSend(int count);
+
+        private:
+            /**
+             * The marshaller of this stream: mdelta if set, mtransport otherwise.
+             */
+            types::TypeMarshaller const& marshaller() const;
+
+            /**
+             * Sender: connects msocket to the receiver, if it is not connected.
+             * @return true if samples can be sent.
+             */
+            bool connect();
+
+            /**
+             * Receiver: waits for a connection or messages, and receives
+             * a batch of messages in the slots.
+             * @return true if there are messages to forward.
+             */
+            bool receive();
+
+            /**
+             * Wakes up the receiver thread in receive().
+             */
+            void wake();
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,95 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_SOCKET_SERIALIZATION_PROTOCOL_HPP
+#define ORO_SOCKET_SERIALIZATION_PROTOCOL_HPP
+
+#include "SocketTemplateProtocol.hpp"
+#include "../mqueue/binary_buffer_archive.hpp"
+
+namespace RTT
+{
+    namespace socket
+    {
+        /**
+         * Transports any boost::serialization enabled type T by
+         * serializing it directly into a slot which is sent as is.
+         * The slots are sized after the sample of the output port,
+         * so larger samples are refused.
+         */
+        template<class T>
+        class SocketSerializationProtocol
+            : public SocketTemplateProtocolBase<T>
+        {
+        public:
+            virtual std::pair<void const*,int> fillBlob( base::DataSourceBase::shared_ptr source, void* blob, int size, void* cookie) const
+            {
+                typename internal::DataSource<T>::shared_ptr d = boost::dynamic_pointer_cast< internal::DataSource<T> >( source );
+                if ( d ) {
+                    try {
+                        mqueue::binary_buffer_oarchive out( blob, size );
+                        out << d->rvalue();
+                        return std::make_pair( (void const*)blob, int(out.getArchiveSize()) );
+                    } catch (std::exception&) {
+                        // the sample does not fit in the slot.
+                    }
+                }
+                return std::make_pair((void const*)0,int(0));
+            }
+
+            virtual bool updateFromBlob(const void* blob, int size, base::DataSourceBase::shared_ptr target, void* cookie) const {
+                typename internal::AssignableDataSource<T>::shared_ptr ad = internal::AssignableDataSource<T>::narrow( target.get() );
+                if ( ad ) {
+                    try {
+                        mqueue::binary_buffer_iarchive in( blob, size );
+                        in >> ad->set();
+                        return true;
+                    } catch (std::exception&) {
+                        // the message is truncated.
+                    }
+                }
+                return false;
+            }
+
+            virtual unsigned int getSampleSize(base::DataSourceBase::shared_ptr sample, void* cookie) const {
+                typename internal::DataSource<T>::shared_ptr tsample = boost::dynamic_pointer_cast< internal::DataSource<T> >( sample );
+                if ( ! tsample ) {
+                    log(Error) << "getSampleSize: sample has wrong type."<<endlog();
+                    return 0;
+                }
+                mqueue::binary_buffer_oarchive out( 0, 0, false );
+                out << tsample->get();
+                return out.getArchiveSize();
+            }
+        };
+    }
+}
+
+#endif
@@ -59,6 +59,13 @@ namespace boost {
             a & boost::serialization::make_nvp("transport", c.transport );
             a & boost::serialization::make_nvp("data_size", c.data_size );
             a & boost::serialization::make_nvp("name_id", c.name_id );
+            a & boost::serialization::make_nvp("shared", c.shared );
+            a & boost::serialization::make_nvp("compression", c.compression );
+            a & boost::serialization::make_nvp("keyframe_period", c.keyframe_period );
+            a & boost::serialization::make_nvp("max_elements", c.max_elements );
+            a & boost::serialization::make_nvp("decimation", c.decimation );
+            a & boost::serialization::make_nvp("min_period", c.min_period );
+            a & boost::serialization::make_nvp("coalesce", c.coalesce );
         }
     }
 }
@@ -0,0 +1,300 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "DeltaMarshaller.hpp"
+#include <vector>
+#include <cstring>
+
+using namespace RTT;
+using namespace RTT::types;
+
+namespace
+{
+    enum { Keyframe = 1, Delta = 2 };
+
+    /**
+     * Precedes every blob.
+     */
+    struct DeltaHeader
+    {
+        /** Keyframe or Delta. */
+        unsigned int kind;
+        /** The number of this sample. */
+        unsigned int sequence;
+        /** The number of the sample a Delta patches. */
+        unsigned int base;
+        /** The size of the marshalled sample. */
+        unsigned int size;
+    };
+
+    /**
+     * Precedes each changed byte range in a Delta.
+     */
+    struct DeltaRange
+    {
+        unsigned int offset;
+        unsigned int length;
+    };
+
+    /**
+     * The state of one end of a stream.
+     */
+    struct DeltaCookie
+    {
+        /** The cookie of the inner marshaller. */
+        void* inner;
+        /** Sender: the inner marshaller writes here. It holds the
+         * last filled sample until it was sent. */
+        std::vector<char> marshalled;
+        /** The previous marshalled sample, valid if sequence is not zero. */
+        std::vector<char> reference;
+        int reference_size;
+        /** The number of the sample in reference. */
+        unsigned int sequence;
+        /** Sender: the number of deltas since the last keyframe. */
+        int deltas;
+        /** Sender: the number of the last filled sample. */
+        unsigned int filled;
+        /** Sender: the size of the sample in marshalled, or -1 if it was sent. */
+        int filled_size;
+        /** Sender: the sample in marshalled is a keyframe. */
+        bool filled_keyframe;
+        /** Sender: the next blob must be a keyframe. */
+        bool keyframe;
+    };
+
+    /**
+     * Writes the byte ranges in which \a cur and \a ref of \a n bytes
+     * differ to \a out.
+     * @return The end of the written ranges, or null if they would pass
+     * \a oend.
+     */
+    char* writeRanges(const char* cur, const char* ref, int n, char* out, char* oend)
+    {
+        int i = 0;
+        while (i != n)
+        {
+            // skip the equal bytes, a word at a time.
+            while (n - i >= 8 && memcmp(cur + i, ref + i, 8) == 0)
+                i += 8;
+            while (i != n && cur[i] == ref[i])
+                ++i;
+            if (i == n)
+                break;
+
+            // a range ends at the first run of equal bytes that is longer
+            // than the header of a new range.
+            int start = i;
+            int equal = 0;
+            for (++i; i != n && equal < int(sizeof(DeltaRange)); ++i)
+                equal = cur[i] == ref[i] ? equal + 1 : 0;
+            i -= equal;
+
+            DeltaRange range;
+            range.offset = start;
+            range.length = i - start;
+            if (oend - out < int(sizeof(range) + range.length))
+                return 0;
+            memcpy(out, &range, sizeof(range));
+            memcpy(out + sizeof(range), cur + start, range.length);
+            out += sizeof(range) + range.length;
+        }
+        return out;
+    }
+}
+
+DeltaMarshaller::DeltaMarshaller(TypeMarshaller const& inner, int keyframe_period)
+    : minner(inner), mkeyframe_period(keyframe_period)
+{
+}
+
+void* DeltaMarshaller::createCookie() const
+{
+    DeltaCookie* c = new DeltaCookie();
+    c->inner = minner.createCookie();
+    c->reference_size = 0;
+    c->sequence = 0;
+    c->deltas = 0;
+    c->filled = 0;
+    c->filled_size = -1;
+    c->filled_keyframe = false;
+    c->keyframe = false;
+    return c;
+}
+
+void DeltaMarshaller::deleteCookie(void* cookie) const
+{
+    DeltaCookie* c = static_cast<DeltaCookie*>(cookie);
+    if (c)
+        minner.deleteCookie(c->inner);
+    delete c;
+}
+
+std::pair<void const*,int> DeltaMarshaller::fillBlob( base::DataSourceBase::shared_ptr source, void* blob, int size, void* cookie) const
+{
+    DeltaCookie* c = static_cast<DeltaCookie*>(cookie);
+    int capacity = size - int(sizeof(DeltaHeader));
+    if (c == 0 || capacity <= 0)
+        return std::make_pair((void const*)0, int(0));
+    // only allocates for a sample larger than any before.
+    if (int(c->marshalled.size()) < capacity)
+        c->marshalled.resize(capacity);
+    if (int(c->reference.size()) < capacity)
+        c->reference.resize(capacity);
+
+    std::pair<void const*,int> inner = minner.fillBlob(source, &c->marshalled[0], capacity, c->inner);
+    if (inner.first == 0)
+        return inner;
+    const char* cur = static_cast<const char*>(inner.first);
+
+    DeltaHeader header;
+    // a sample which was not sent still uses up its number.
+    header.sequence = c->filled + 1;
+    if (header.sequence == 0)
+        header.sequence = 1; // zero means 'no sample'.
+    header.base = c->sequence;
+    header.size = inner.second;
+
+    char* out = static_cast<char*>(blob) + sizeof(header);
+    char* end = 0;
+    if (c->sequence != 0 && !c->keyframe && c->reference_size == inner.second && c->deltas + 1 < mkeyframe_period)
+        // a delta larger than the sample is not worth it.
+        end = writeRanges(cur, &c->reference[0], inner.second, out, out + inner.second);
+    if (end)
+        header.kind = Delta;
+    else
+    {
+        header.kind = Keyframe;
+        memcpy(out, cur, inner.second);
+        end = out + inner.second;
+    }
+    memcpy(blob, &header, sizeof(header));
+
+    // the new sample becomes the reference once it was sent.
+    if (cur != &c->marshalled[0])
+        memcpy(&c->marshalled[0], cur, inner.second);
+    c->filled = header.sequence;
+    c->filled_size = inner.second;
+    c->filled_keyframe = header.kind == Keyframe;
+    return std::make_pair((void const*)blob, int(end - static_cast<char*>(blob)));
+}
+
+void DeltaMarshaller::sent(void* cookie) const
+{
+    DeltaCookie* c = static_cast<DeltaCookie*>(cookie);
+    if (c == 0 || c->filled_size < 0)
+        return;
+    c->marshalled.swap(c->reference);
+    c->reference_size = c->filled_size;
+    c->sequence = c->filled;
+    c->filled_size = -1;
+    if (c->filled_keyframe)
+    {
+        c->deltas = 0;
+        c->keyframe = false;
+    }
+    else
+        ++c->deltas;
+}
+
+void DeltaMarshaller::resync(void* cookie) const
+{
+    DeltaCookie* c = static_cast<DeltaCookie*>(cookie);
+    if (c)
+        c->keyframe = true;
+}
+
+bool DeltaMarshaller::updateFromBlob(const void* blob, int size, base::DataSourceBase::shared_ptr target, void* cookie) const
+{
+    DeltaCookie* c = static_cast<DeltaCookie*>(cookie);
+    DeltaHeader header;
+    if (c == 0 || size < int(sizeof(header)))
+        return false;
+    memcpy(&header, blob, sizeof(header));
+    const char* in = static_cast<const char*>(blob) + sizeof(header);
+    const char* iend = static_cast<const char*>(blob) + size;
+
+    if (header.kind == Keyframe)
+    {
+        if (iend - in != int(header.size))
+            return false;
+        // only allocates for a sample larger than any before.
+        if (c->reference.size() < header.size)
+            c->reference.resize(header.size);
+        if (header.size)
+            memcpy(&c->reference[0], in, header.size);
+    }
+    else if (header.kind == Delta)
+    {
+        // we missed the sample this delta patches: wait for a keyframe.
+        if (c->sequence == 0 || header.base != c->sequence || int(header.size) != c->reference_size)
+            return false;
+        while (in != iend)
+        {
+            DeltaRange range;
+            bool corrupt = iend - in < int(sizeof(range));
+            if (!corrupt)
+            {
+                memcpy(&range, in, sizeof(range));
+                in += sizeof(range);
+                corrupt = iend - in < int(range.length) || range.offset > header.size || header.size - range.offset < range.length;
+            }
+            if (corrupt)
+            {
+                // the reference may be half patched: wait for a keyframe.
+                c->sequence = 0;
+                return false;
+            }
+            memcpy(&c->reference[range.offset], in, range.length);
+            in += range.length;
+        }
+    }
+    else
+        return false;
+
+    c->reference_size = header.size;
+    c->sequence = header.sequence;
+    return minner.updateFromBlob(c->reference_size ? &c->reference[0] : 0, c->reference_size, target, c->inner);
+}
+
+unsigned int DeltaMarshaller::getSampleSize( base::DataSourceBase::shared_ptr sample, void* cookie) const
+{
+    DeltaCookie* c = static_cast<DeltaCookie*>(cookie);
+    return getOverhead() + minner.getSampleSize(sample, c ? c->inner : 0);
+}
+
+unsigned int DeltaMarshaller::getOverhead()
+{
+    return sizeof(DeltaHeader);
+}
+
+base::ChannelElementBase::shared_ptr DeltaMarshaller::createStream(base::PortInterface* port, const ConnPolicy& policy, bool is_sender) const
+{
+    return minner.createStream(port, policy, is_sender);
+}
@@ -0,0 +1,104 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef ORO_DELTA_MARSHALLER_HPP
+#define ORO_DELTA_MARSHALLER_HPP
+
+#include "TypeMarshaller.hpp"
+
+namespace RTT
+{
+    namespace types
+    {
+        /**
+         * A TypeMarshaller which sends only the byte ranges of a marshalled
+         * sample that changed since the previous sample, and a complete
+         * sample (a keyframe) every few samples or when the size of the
+         * marshalled sample changes. The reader patches its copy of the
+         * previous sample.
+         *
+         * Each blob names the sample it was computed against. A reader
+         * which missed that sample ignores the deltas until the next
+         * keyframe, so a lost sample at most delays the reader until then.
+         *
+         * Transports use it on both ends of a connection whose
+         * ConnPolicy::keyframe_period is not zero. It keeps its state in
+         * the cookie, so one stream must not share its cookie with another.
+         * The sending transport calls sent() once a blob left, such that
+         * a sample it dropped is not used as the base of the next delta,
+         * and resync() when a reader may lack the base, for example
+         * because it just connected.
+         */
+        class RTT_API DeltaMarshaller
+            : public TypeMarshaller
+        {
+        public:
+            /**
+             * @param inner The marshaller of the type.
+             * @param keyframe_period Send a keyframe every this many
+             * samples.
+             */
+            DeltaMarshaller(TypeMarshaller const& inner, int keyframe_period);
+
+            virtual void* createCookie() const;
+            virtual void deleteCookie(void* cookie) const;
+            virtual std::pair<void const*,int> fillBlob( base::DataSourceBase::shared_ptr source, void* blob, int size, void* cookie) const;
+            virtual bool updateFromBlob(const void* blob, int size, base::DataSourceBase::shared_ptr target, void* cookie) const;
+            virtual unsigned int getSampleSize( base::DataSourceBase::shared_ptr sample, void* cookie) const;
+
+            /**
+             * Makes the last blob filled with \a cookie the base of the
+             * following deltas. Until then, they are computed against
+             * the last sample that was sent.
+             */
+            void sent(void* cookie) const;
+
+            /**
+             * Makes the next blob filled with \a cookie a keyframe.
+             */
+            void resync(void* cookie) const;
+
+            /**
+             * Streams are created by the transport of the inner marshaller.
+             */
+            virtual base::ChannelElementBase::shared_ptr createStream(base::PortInterface* port, const ConnPolicy& policy, bool is_sender) const;
+
+            /**
+             * The number of bytes a keyframe adds to the marshalled sample.
+             */
+            static unsigned int getOverhead();
+
+        private:
+            TypeMarshaller const& minner;
+            int mkeyframe_period;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,57 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_SAMPLE_RESIZE_HPP
+#define ORO_SAMPLE_RESIZE_HPP
+
+#include <string>
+#include <vector>
+
+namespace RTT
+{
+    namespace types
+    {
+        /**
+         * Resizes \a sample to hold \a count elements, if it is a sequence.
+         * Used by the transports to pre-size their samples.
+         * @return false if T is not a sequence.
+         * @see ConnPolicy::max_elements
+         */
+        template<class T>
+        bool resize_sample(T& sample, int count) { return false; }
+
+        template<class T, class Alloc>
+        bool resize_sample(std::vector<T, Alloc>& sample, int count) { sample.resize(count); return true; }
+
+        inline bool resize_sample(std::string& sample, int count) { sample.resize(count); return true; }
+    }
+}
+
+#endif
@@ -4,6 +4,7 @@
 namespace RTT {
     namespace types {
         class BinaryOp;
+        class DeltaMarshaller;
         class EmptyTypeInfo;
         class GlobalsRepository;
         class OperatorRepository;
@@ -23,6 +23,7 @@
 
 #include <internal/AtomicQueue.hpp>
 #include <internal/AtomicMWSRQueue.hpp>
+#include <internal/AtomicSegmentedMWSRQueue.hpp>
 
 #include <Activity.hpp>
 
@@ -34,8 +35,12 @@
 //#include <internal/SortedList.hpp>
 
 #include <os/Thread.hpp>
+#include <os/TimeService.hpp>
 #include <rtt-config.h>
 
+#include <algorithm>
+#include <vector>
+
 using namespace std;
 using namespace RTT;
 using namespace RTT::detail;
@@ -75,6 +80,7 @@ public:
 
 typedef AtomicQueue<Dummy*> QueueType;
 typedef AtomicMWSRQueue<Dummy*> MWSRQueueType;
+typedef AtomicSegmentedMWSRQueue<Dummy*> SegmentedQueueType;
 
 // Don't make queue size too large, we want to catch
 // overrun issues too.
@@ -130,9 +136,12 @@ public:
     BufferLocked<Dummy>* clocked;
     BufferUnSync<Dummy>* cunsync;
 
+    BufferLockFreeSPSC<Dummy>* spsc;
+
     DataObjectLocked<Dummy>* dlocked;
     DataObjectLockFree<Dummy>* dlockfree;
     DataObjectUnSync<Dummy>* dunsync;
+    DataObjectLockFreeSPSC<Dummy>* dspsc;
 
     ThreadInterface* athread;
     ThreadInterface* bthread;
@@ -147,6 +156,7 @@ public:
         lockfree = new BufferLockFree<Dummy>(QS);
         locked = new BufferLocked<Dummy>(QS);
         unsync = new BufferUnSync<Dummy>(QS);
+        spsc = new BufferLockFreeSPSC<Dummy>(QS);
 
         // circular variants.
         clockfree = new BufferLockFree<Dummy>(QS,Dummy(), true);
@@ -156,6 +166,7 @@ public:
         dlockfree = new DataObjectLockFree<Dummy>();
         dlocked   = new DataObjectLocked<Dummy>();
         dunsync   = new DataObjectUnSync<Dummy>();
+        dspsc     = new DataObjectLockFreeSPSC<Dummy>();
 
         // defaults
         buffer = lockfree;
@@ -166,12 +177,14 @@ public:
         delete lockfree;
         delete locked;
         delete unsync;
+        delete spsc;
         delete clockfree;
         delete clocked;
         delete cunsync;
         delete dlockfree;
         delete dlocked;
         delete dunsync;
+        delete dspsc;
     }
 };
 
@@ -694,6 +707,105 @@ struct AQEater : public RunnableInterface
     }
 };
 
+typedef os::TimeService::ticks Stamp;
+
+bool benchWrite(BufferInterface<Stamp>* b, Stamp s) { return b->Push(s); }
+bool benchWrite(DataObjectInterface<Stamp>* d, Stamp s) { d->Set(s); return true; }
+bool benchRead(BufferInterface<Stamp>* b, Stamp& s, Stamp) { return b->Pop(s); }
+bool benchRead(DataObjectInterface<Stamp>* d, Stamp& s, Stamp last) { d->Get(s); return s != last; }
+
+/**
+ * Writes time stamps as fast as possible, retrying when the buffer is full.
+ */
+template<class T>
+struct BenchWriter : public RunnableInterface
+{
+    T* mobj;
+    int count;
+    volatile bool done;
+    BenchWriter(T* obj, int count) : mobj(obj), count(count), done(false) {}
+    bool initialize() {
+        done = false;
+        return true;
+    }
+    void step() {
+        for (int i = 0; i != count; ++i) {
+            Stamp s = os::TimeService::Instance()->getTicks();
+            while ( benchWrite(mobj, s) == false ) {}
+        }
+        done = true;
+    }
+    void finalize() {}
+};
+
+/**
+ * Reads time stamps until the writer is done and records
+ * how old each new stamp is when it is read.
+ */
+template<class T>
+struct BenchReader : public RunnableInterface
+{
+    T* mobj;
+    BenchWriter<T>* writer;
+    volatile bool done;
+    Stamp last;
+    std::vector<os::TimeService::nsecs> latencies;
+    BenchReader(T* obj, BenchWriter<T>* w) : mobj(obj), writer(w), done(false), last(0) {
+        latencies.reserve( w->count );
+    }
+    bool initialize() {
+        done = false;
+        return true;
+    }
+    void step() {
+        Stamp s;
+        while ( true ) {
+            // check before reading, such that nothing is left behind once we stop.
+            bool finished = writer->done;
+            if ( benchRead(mobj, s, last) ) {
+                latencies.push_back( os::TimeService::ticks2nsecs( os::TimeService::Instance()->ticksSince(s) ) );
+                last = s;
+            } else if ( finished )
+                break;
+        }
+        done = true;
+    }
+    void finalize() {}
+};
+
+/**
+ * Runs one writer and one reader thread on \a obj and reports the
+ * throughput and the age of the samples when they are read.
+ * @return the number of samples read.
+ */
+template<class T>
+int benchSPSC(const char* name, T* obj, int count)
+{
+    BenchWriter<T> writer(obj, count);
+    BenchReader<T> reader(obj, &writer);
+    os::TimeService::ticks start;
+    {
+        boost::scoped_ptr<Activity> wthread( new Activity(ORO_SCHED_OTHER, 0, 0, &writer, "BenchWriter" ));
+        boost::scoped_ptr<Activity> rthread( new Activity(ORO_SCHED_OTHER, 0, 0, &reader, "BenchReader" ));
+        rthread->start();
+        start = os::TimeService::Instance()->getTicks();
+        wthread->start();
+        while ( reader.done == false )
+            usleep(1000);
+        rthread->stop();
+        wthread->stop();
+    }
+    double secs = os::TimeService::Instance()->secondsSince(start);
+    std::vector<os::TimeService::nsecs>& l = reader.latencies;
+    BOOST_REQUIRE( !l.empty() );
+    std::sort( l.begin(), l.end() );
+    BOOST_TEST_MESSAGE( name << ": " << int(count / secs) << " writes/s, " << int(l.size() / secs) << " new reads/s, sample age (ns):"
+                        << " p50=" << l[ l.size() / 2 ]
+                        << " p99=" << l[ l.size() * 99 / 100 ]
+                        << " p99.9=" << l[ l.size() * 999 / 1000 ]
+                        << " max=" << l.back() );
+    return l.size();
+}
 
 BOOST_FIXTURE_TEST_SUITE( BuffersAtomicTestSuite, BuffersAQueueTest )
 
@@ -735,6 +847,31 @@ BOOST_AUTO_TEST_CASE( testAtomicQueue )
 
     delete d;
 }
+
+/**
+ * Tests that erased elements do not remain alive in
+ * the unused copies of a lock-free list.
+ */
+BOOST_AUTO_TEST_CASE( testListLockFreeClearUnused )
+{
+    ListLockFree< boost::shared_ptr<Dummy> > lst(4, 2);
+    boost::shared_ptr<Dummy> d( new Dummy(1,2,3) );
+    BOOST_CHECK( lst.append( d ) );
+    BOOST_CHECK( lst.append( boost::shared_ptr<Dummy>( new Dummy() ) ) );
+    BOOST_CHECK( d.use_count() > 1 );
+
+    BOOST_CHECK( lst.erase( d ) );
+    BOOST_CHECK_EQUAL( lst.size(), 1u );
+    lst.clear_unused();
+    BOOST_CHECK_EQUAL( d.use_count(), 1 );
+    BOOST_CHECK_EQUAL( lst.size(), 1u );
+
+    BOOST_CHECK( lst.append( d ) );
+    lst.clear();
+    lst.clear_unused();
+    BOOST_CHECK_EQUAL( d.use_count(), 1 );
+    BOOST_CHECK( lst.empty() );
+}
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_FIXTURE_TEST_SUITE( BuffersMWSRQueueTestSuite, BuffersAtomicMWSRQueueTest )
@@ -783,6 +920,93 @@ BOOST_AUTO_TEST_CASE( testAtomicMWSRQueue )
     delete d;
 }
 
+BOOST_AUTO_TEST_CASE( testAtomicSegmentedMWSRQueue )
+{
+    /**
+     * Single Threaded test for AtomicSegmentedMWSRQueue.
+     * The capacity spans three segments.
+     */
+    SegmentedQueueType squeue(4, QS);
+    Dummy d[2*QS];
+    Dummy* c = 0;
+
+    BOOST_REQUIRE_EQUAL( SegmentedQueueType::size_type(QS), squeue.capacity() );
+    BOOST_REQUIRE_EQUAL( SegmentedQueueType::size_type(4), squeue.segmentSize() );
+    BOOST_CHECK( squeue.isEmpty() );
+    BOOST_CHECK( squeue.dequeue(c) == false );
+    BOOST_CHECK( squeue.enqueue(0) == false );
+
+    for ( int round = 0; round < 3; ++round) {
+        for ( int i = 0; i < QS; ++i) {
+            BOOST_CHECK( squeue.enqueue( &d[i] ) == true);
+            BOOST_REQUIRE_EQUAL( SegmentedQueueType::size_type(i+1), squeue.size() );
+        }
+        BOOST_CHECK( squeue.isFull() );
+        BOOST_CHECK( squeue.enqueue( &d[0] ) == false );
+        for ( int i = 0; i < QS; ++i) {
+            BOOST_CHECK( squeue.dequeue( c ) == true);
+            BOOST_CHECK_EQUAL( c, &d[i] );
+        }
+        BOOST_CHECK( squeue.isEmpty() );
+        BOOST_CHECK( squeue.dequeue(c) == false );
+    }
+
+    // grow and shrink at run-time
+    squeue.setCapacity( 2*QS );
+    for ( int i = 0; i < 2*QS; ++i)
+        BOOST_CHECK( squeue.enqueue( &d[i] ) == true);
+    BOOST_CHECK( squeue.enqueue( &d[0] ) == false );
+    squeue.setCapacity( QS );
+    BOOST_REQUIRE_EQUAL( SegmentedQueueType::size_type(2*QS), squeue.size() );
+    BOOST_CHECK( squeue.isFull() );
+    for ( int i = 0; i < QS + 1; ++i) {
+        BOOST_CHECK( squeue.dequeue( c ) == true);
+        BOOST_CHECK_EQUAL( c, &d[i] );
+    }
+    BOOST_CHECK( squeue.enqueue( &d[0] ) == true );
+    squeue.clear();
+    BOOST_CHECK( squeue.isEmpty() );
+}
+
+/**
+ * Tests that emptied segments are recycled while writers
+ * keep on writing.
+ */
+BOOST_AUTO_TEST_CASE( testAtomicSegmentedMWSRQueueReclaim )
+{
+    SegmentedQueueType squeue(4, QS);
+    AQGrower<SegmentedQueueType>* agrower = new AQGrower<SegmentedQueueType>( &squeue );
+    AQGrower<SegmentedQueueType>* bgrower = new AQGrower<SegmentedQueueType>( &squeue );
+    Dummy* c = 0;
+    int erases = 0;
+    {
+        boost::scoped_ptr<Activity> athread( new Activity(ORO_SCHED_OTHER, 0, 0, agrower, "ActivityA" ));
+        boost::scoped_ptr<Activity> bthread( new Activity(ORO_SCHED_OTHER, 0, 0, bgrower, "ActivityB" ));
+        athread->start();
+        bthread->start();
+
+        os::TimeService::ticks start = os::TimeService::Instance()->getTicks();
+        while ( os::TimeService::Instance()->secondsSince(start) < 1.0 )
+            if ( squeue.dequeue(c) )
+                ++erases;
+        // the segments which passed by were recycled, despite the writers.
+        BOOST_CHECK_LT( squeue.retiredSegments(), SegmentedQueueType::size_type(erases / 8) );
+
+        athread->stop();
+        bthread->stop();
+    }
+    while ( squeue.dequeue(c) )
+        ++erases;
+    // without writers, the last retired segments are released
+    // by the next (empty) dequeue.
+    BOOST_CHECK( squeue.dequeue(c) == false );
+    BOOST_CHECK_EQUAL( squeue.retiredSegments(), SegmentedQueueType::size_type(0) );
+    BOOST_CHECK_EQUAL( agrower->appends + bgrower->appends, erases );
+
+    delete agrower;
+    delete bgrower;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_FIXTURE_TEST_SUITE( BuffersDataFlowTestSuite, BuffersDataFlowTest )
@@ -811,6 +1035,12 @@ BOOST_AUTO_TEST_CASE( testBufUnsync )
     testCirc();
 }
 
+BOOST_AUTO_TEST_CASE( testBufLockFreeSPSC )
+{
+    buffer = spsc;
+    testBuf();
+}
+
 BOOST_AUTO_TEST_CASE( testDObjLockFree )
 {
     dataobj = dlockfree;
@@ -829,6 +1059,12 @@ BOOST_AUTO_TEST_CASE( testDObjUnSync )
     testDObj();
 }
 
+BOOST_AUTO_TEST_CASE( testDObjLockFreeSPSC )
+{
+    dataobj = dspsc;
+    testDObj();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 BOOST_FIXTURE_TEST_SUITE( BuffersMPoolTestSuite, BuffersMPoolTest )
 
@@ -1005,6 +1241,24 @@ BOOST_AUTO_TEST_CASE( testListLockFree )
 #endif
 
 #ifdef OROPKG_OS_GNULINUX
+/**
+ * Compares the single-writer/single-reader buffer and data object
+ * with the general lock-free implementations.
+ */
+BOOST_AUTO_TEST_CASE( testSPSCBenchmark )
+{
+    const int count = 200000;
+    BufferLockFree<Stamp> lockfree(64);
+    BufferLockFreeSPSC<Stamp> spsc(64);
+    BOOST_CHECK_EQUAL( benchSPSC<BufferInterface<Stamp> >("BufferLockFree", &lockfree, count), count );
+    BOOST_CHECK_EQUAL( benchSPSC<BufferInterface<Stamp> >("BufferLockFreeSPSC", &spsc, count), count );
+
+    DataObjectLockFree<Stamp> dlockfree;
+    DataObjectLockFreeSPSC<Stamp> dspsc;
+    BOOST_CHECK( benchSPSC<DataObjectInterface<Stamp> >("DataObjectLockFree", &dlockfree, count) <= count );
+    BOOST_CHECK( benchSPSC<DataObjectInterface<Stamp> >("DataObjectLockFreeSPSC", &dspsc, count) <= count );
+}
+
 BOOST_AUTO_TEST_CASE( testAtomicQueue )
 {
     QueueType* qt = new QueueType(QS);
@@ -1155,5 +1409,79 @@ BOOST_AUTO_TEST_CASE( testAtomicMWSRQueue )
     delete grower;
     delete eater;
 }
+
+BOOST_AUTO_TEST_CASE( testAtomicSegmentedMWSRQueue )
+{
+    SegmentedQueueType* qt = new SegmentedQueueType(4, QS);
+    AQGrower<SegmentedQueueType>* aworker = new AQGrower<SegmentedQueueType>( qt );
+    AQGrower<SegmentedQueueType>* bworker = new AQGrower<SegmentedQueueType>( qt );
+    AQGrower<SegmentedQueueType>* cworker = new AQGrower<SegmentedQueueType>( qt );
+    AQGrower<SegmentedQueueType>* grower = new AQGrower<SegmentedQueueType>( qt );
+    AQEater<SegmentedQueueType>* eater = new AQEater<SegmentedQueueType>( qt );
+
+    {
+        boost::scoped_ptr<Activity> athread( new Activity(20, aworker, "ActivityA" ));
+        boost::scoped_ptr<Activity> bthread( new Activity(20, bworker, "ActivityB" ));
+        boost::scoped_ptr<Activity> cthread( new Activity(20, cworker, "ActivityC" ));
+        boost::scoped_ptr<Activity> gthread( new Activity(20, grower, "ActivityG"));
+        boost::scoped_ptr<Activity> ethread( new Activity(20, eater, "ActivityE"));
+
+        // avoid system lock-ups
+        athread->thread()->setScheduler(ORO_SCHED_OTHER);
+        bthread->thread()->setScheduler(ORO_SCHED_OTHER);
+        cthread->thread()->setScheduler(ORO_SCHED_OTHER);
+        gthread->thread()->setScheduler(ORO_SCHED_OTHER);
+        ethread->thread()->setScheduler(ORO_SCHED_OTHER);
+
+        log(Info) <<"Stressing multi-write/single-read..." <<endlog();
+        athread->start();
+        bthread->start();
+        cthread->start();
+        gthread->start();
+        ethread->start();
+        sleep(5);
+        athread->stop();
+        bthread->stop();
+        cthread->stop();
+        log(Info) <<"Stressing single-write/single-read..." <<endlog();
+        sleep(5);
+        gthread->stop();
+        ethread->stop();
+    }
+
+    cout <<endl
+         << "Total appends: " << aworker->appends + bworker->appends + cworker->appends+ grower->appends<<endl;
+    cout << "Total erases : " << eater->erases <<endl;
+    if (aworker->appends + bworker->appends + cworker->appends+ grower->appends != int(qt->size()) + eater->erases) {
+        cout << "Mismatch detected !" <<endl;
+    }
+    int i = 0; // left-over count
+    Dummy* d = 0;
+    BOOST_CHECK( qt->size() <= QS );
+    while( qt->size() != 0 ) {
+        BOOST_CHECK( qt->dequeue(d) == true);
+        BOOST_CHECK( d );
+        i++;
+        if ( i > QS ) {
+            BOOST_CHECK( i <= QS); // avoid infinite loop.
+            break;
+        }
+    }
+    cout << "Left in Queue: "<< i <<endl;
+    BOOST_CHECK( qt->dequeue(d) == false );
+    BOOST_CHECK( qt->dequeue(d) == false );
+    BOOST_CHECK( qt->isEmpty() );
+    BOOST_CHECK_EQUAL( qt->size(), 0 );
+
+    // assert: sum queues == sum dequeues
+    BOOST_CHECK_EQUAL( aworker->appends + bworker->appends + cworker->appends + grower->appends,
+                       i + eater->erases );
+    delete aworker;
+    delete bworker;
+    delete cworker;
+    delete grower;
+    delete eater;
+    delete qt;
+}
 #endif
 BOOST_AUTO_TEST_SUITE_END()
@@ -22,6 +22,7 @@
 #include "logger_test.hpp"
 
 #include <iostream>
+#include <sstream>
 #include <boost/scoped_ptr.hpp>
 #include <Activity.hpp>
 #include <base/RunnableInterface.hpp>
@@ -118,4 +119,62 @@ BOOST_AUTO_TEST_CASE( testThreadLog )
 
 }
 
+BOOST_AUTO_TEST_CASE( testAsyncLog )
+{
+  std::stringstream out;
+  Logger::LogLevel ll = logger->getLogLevel();
+  logger->setLogLevel( Logger::Info );
+  logger->setStdStream( out );
+
+  BOOST_CHECK( logger->isAsynchronous() == false );
+  BOOST_CHECK( logger->setAsynchronous( true, 8 ) );
+  BOOST_CHECK( logger->isAsynchronous() );
+  {
+      Logger::In in("AsyncModule");
+      log(Info) << "First asynchronous line" << endlog();
+      log(Info) << "Second asynchronous " << 2 << nlog();
+  }
+  log(Info) << std::string(1000, 'x') << endlog();
+  BOOST_CHECK_EQUAL( logger->getTruncatedLines(), 1u );
+
+  // overflow the buffer:
+  unsigned int dropped = logger->getDroppedLines();
+  for (int i = 0; i != 1000; ++i)
+      log(Info) << "Flooding line " << i << endlog();
+  BOOST_CHECK( logger->getDroppedLines() > dropped );
+
+  // writes out the remaining lines:
+  BOOST_CHECK( logger->setAsynchronous( false ) );
+  BOOST_CHECK( logger->isAsynchronous() == false );
+  std::string result = out.str();
+  BOOST_CHECK( result.find("[AsyncModule] First asynchronous line\n") != std::string::npos );
+  BOOST_CHECK( result.find("[AsyncModule] Second asynchronous 2\n") != std::string::npos );
+  BOOST_CHECK( result.find("[ Info   ][Logger] " + std::string(255, 'x') + "\n") != std::string::npos );
+  BOOST_CHECK( result.find("asynchronous log buffer was full") != std::string::npos );
+
+  // from several threads at once:
+  BOOST_CHECK( logger->setAsynchronous( true ) );
+  boost::scoped_ptr<TestLog> run( new TestLog() );
+  boost::scoped_ptr<ActivityInterface> t( new Activity(25, 0.001, 0, "ORActivity1") );
+  boost::scoped_ptr<TestLog> run2( new TestLog() );
+  boost::scoped_ptr<ActivityInterface> t2( new Activity(25, 0.001, 0, "ORActivity2") );
+  t->run( run.get() );
+  t2->run( run2.get() );
+  t->start();
+  t2->start();
+  usleep(200000);
+  t->stop();
+  t2->stop();
+  BOOST_CHECK( logger->setAsynchronous( false ) );
+  BOOST_CHECK( out.str().find("[TLOG] Hello this is the world") != std::string::npos );
+  // each thread formats in its own line: the lines are never mixed.
+  result = out.str();
+  const std::string line = "[TLOG] Hello this is the world speaking elaborately and lengthy...!\n";
+  for (std::string::size_type pos = result.find("[TLOG]"); pos != std::string::npos; pos = result.find("[TLOG]", pos + 1))
+      BOOST_CHECK_EQUAL( result.compare(pos, line.size(), line), 0 );
+
+  logger->setStdStream( std::cerr );
+  logger->setLogLevel( ll );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -24,7 +24,15 @@
 #include <transports/mqueue/MQLib.hpp>
 #include <transports/mqueue/MQChannelElement.hpp>
 #include <transports/mqueue/MQTemplateProtocol.hpp>
+#include <transports/mqueue/MQSerializationProtocol.hpp>
+#include <transports/mqueue/MQCompressor.hpp>
+#include <types/DeltaMarshaller.hpp>
+#include <internal/DataSources.hpp>
+#include <transports/mqueue/binary_buffer_archive.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/array.hpp>
 #include <os/fosi.h>
+#include <os/Atomic.hpp>
 
 using namespace std;
 using namespace RTT;
@@ -34,10 +42,76 @@ using namespace RTT::detail;
 #include <OutputPort.hpp>
 #include <TaskContext.hpp>
 #include <string>
+#include <new>
+#include <cstdlib>
 
 using namespace RTT;
 using namespace RTT::detail;
 
+/**
+ * Counts the heap allocations of the process, such that the tests
+ * can check that a transport does not allocate in its steady state.
+ */
+static os::AtomicInt allocations(0);
+
+#if __cplusplus >= 201103L
+#define MQTEST_THROW_BAD_ALLOC
+#else
+#define MQTEST_THROW_BAD_ALLOC throw(std::bad_alloc)
+#endif
+
+void* operator new(std::size_t size) MQTEST_THROW_BAD_ALLOC
+{
+    void* p = std::malloc( size ? size : 1 );
+    if ( p == 0 )
+        throw std::bad_alloc();
+    allocations.inc();
+    return p;
+}
+
+void operator delete(void* p) throw()
+{
+    std::free( p );
+}
+
+struct FixedSample
+{
+    int id;
+    boost::array<double,4> values;
+};
+
+namespace RTT { namespace mqueue {
+    template<> struct mq_is_fixed_layout<FixedSample> : public boost::mpl::true_ {};
+} }
+
+/**
+ * A trivially copyable type which only transports its id. It must
+ * go through its serialize() function, and so must a type which
+ * holds a pointer.
+ */
+struct SerializedSample
+{
+    int id;
+    int local;
+    SerializedSample() : id(0), local(0) {}
+    template<class Archive>
+    void serialize(Archive& a, unsigned int) { a & id; }
+};
+
+struct PointerSample
+{
+    int id;
+    const char* name;
+};
+
+BOOST_STATIC_ASSERT(( boost::is_same< mqueue::mq_layout<FixedSample>::type, mqueue::mq_fixed_layout >::value ));
+BOOST_STATIC_ASSERT(( boost::is_same< mqueue::mq_layout<SerializedSample>::type, mqueue::mq_archive_layout >::value ));
+BOOST_STATIC_ASSERT(( boost::is_same< mqueue::mq_layout<PointerSample>::type, mqueue::mq_archive_layout >::value ));
+BOOST_STATIC_ASSERT(( boost::is_same< mqueue::mq_layout< boost::array<float,3> >::type, mqueue::mq_fixed_layout >::value ));
+BOOST_STATIC_ASSERT(( boost::is_same< mqueue::mq_layout< std::vector<double> >::type, mqueue::mq_vector_layout >::value ));
+BOOST_STATIC_ASSERT(( boost::is_same< mqueue::mq_layout< std::vector<bool> >::type, mqueue::mq_archive_layout >::value ));
+BOOST_STATIC_ASSERT(( boost::is_same< mqueue::mq_layout< std::vector< std::vector<double> > >::type, mqueue::mq_archive_layout >::value ));
+
 class MQueueTest
 {
 public:
@@ -324,6 +398,36 @@ BOOST_AUTO_TEST_CASE( testPortStreamsWrongName )
     mw2->disconnect();
 }
 
+BOOST_AUTO_TEST_CASE( testPortStreamsBurst )
+{
+    // A burst of writes may wake up the dispatcher only once,
+    // it must still forward every message.
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 8;
+    policy.name_id = "/burst1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+
+    for (int i = 0; i != 8; ++i)
+        mw1->write( double(i) );
+
+    double value = -1;
+    int received = 0;
+    for (int tries = 0; tries != 100 && received != 8; ++tries) {
+        while ( mr2->read(value) == NewData ) {
+            BOOST_CHECK_EQUAL( double(received), value );
+            ++received;
+        }
+        usleep(10000);
+    }
+    BOOST_CHECK_EQUAL( received, 8 );
+
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+}
+
 // copied from testPortStreams
 BOOST_AUTO_TEST_CASE( testVectorTransport )
 {
@@ -381,5 +485,430 @@ BOOST_AUTO_TEST_CASE( testVectorTransport )
     rtos_disable_rt_warning();
 }
 
+/**
+ * Sends samples which are larger than the queue's message size
+ * and must be split over several messages.
+ */
+BOOST_AUTO_TEST_CASE( testChunkedVectorTransport )
+{
+    DataFlowInterface* ports  = tc->ports();
+    DataFlowInterface* ports2 = t2->ports();
+
+    std::vector<double> data(10, 1.0);
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("Vout");
+    ports->addPort(vin).doc("input port");
+    ports2->addPort(vout).doc("output port");
+
+    // the queue is sized for 10 doubles.
+    vout.setDataSample( data );
+
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/vdata2";
+    BOOST_REQUIRE( vout.createStream( policy ) );
+    BOOST_REQUIRE( vin.createStream( policy ) );
+
+    // two chunks, then as many as the queue of 10 messages holds.
+    unsigned int sizes[] = { 20, 100 };
+    for (unsigned int s = 0; s != 2; ++s) {
+        data.resize( sizes[s] );
+        for (unsigned int i = 0; i != data.size(); ++i)
+            data[i] = s + 0.5 * i;
+        vout.write( data );
+        usleep(200000);
+
+        std::vector<double> result;
+        BOOST_CHECK_EQUAL( vin.read(result), NewData);
+        BOOST_REQUIRE_EQUAL( result.size(), sizes[s] );
+        BOOST_CHECK( result == data );
+    }
+
+    // the writer does not block: a sample with more chunks than the
+    // queue can hold is dropped as a whole, and the next one arrives.
+    std::vector<double> result;
+    vout.write( std::vector<double>(2000, 3.0) );
+    usleep(200000);
+    BOOST_CHECK_EQUAL( vin.read(result), OldData);
+    BOOST_CHECK( vout.connected() );
+    data.assign( 30, 4.0 );
+    vout.write( data );
+    usleep(200000);
+    BOOST_CHECK_EQUAL( vin.read(result), NewData);
+    BOOST_CHECK( result == data );
+}
+
+BOOST_AUTO_TEST_CASE( testReservedVectorTransport )
+{
+    DataFlowInterface* ports  = tc->ports();
+    DataFlowInterface* ports2 = t2->ports();
+
+    InputPort< std::vector<double> > vin("VIn");
+    // the port itself does not keep a copy of the written samples.
+    OutputPort< std::vector<double> > vout("Vout", false);
+    ports->addPort(vin).doc("input port");
+    ports2->addPort(vout).doc("output port");
+
+    // the port sample holds 10 doubles, the connection is made for 1000.
+    vout.setDataSample( std::vector<double>(10, 1.0) );
+
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/vdata5";
+    policy.max_elements = 1000;
+    BOOST_REQUIRE( vout.createStream( policy ) );
+    BOOST_REQUIRE( vin.createStream( policy ) );
+
+    // samples of any size up to max_elements are transported without allocating.
+    unsigned int sizes[] = { 1000, 3, 500, 0, 1000 };
+    std::vector< std::vector<double> > samples;
+    for (unsigned int s = 0; s != 5; ++s)
+        samples.push_back( std::vector<double>( sizes[s], s + 0.5 ) );
+    std::vector<double> result;
+    result.reserve( 1000 );
+    for (unsigned int s = 0; s != 5; ++s) {
+        int allocs = allocations.read();
+        vout.write( samples[s] );
+        FlowStatus fs;
+        for (int tries = 0; (fs = vin.read( result, false )) != NewData && tries != 100; ++tries)
+            usleep(10000);
+        allocs = allocations.read() - allocs;
+
+        BOOST_CHECK_EQUAL( fs, NewData );
+        BOOST_CHECK( result == samples[s] );
+        BOOST_CHECK_EQUAL( allocs, 0 );
+    }
+    BOOST_CHECK( vout.connected() );
+}
+
+BOOST_AUTO_TEST_CASE( testCompressor )
+{
+    mqueue::MQCompressor compressor;
+    std::vector<char> input(20000), packed(21000), unpacked(20000);
+
+    // repetitive data, with long and overlapping matches.
+    for (unsigned int i = 0; i != input.size(); ++i)
+        input[i] = (i / 100) % 7 + (i % 3);
+    int size = compressor.compress(&input[0], input.size(), &packed[0], packed.size());
+    BOOST_REQUIRE( size > 0 );
+    BOOST_CHECK( size < int(input.size() / 10) );
+    BOOST_CHECK_EQUAL( mqueue::MQCompressor::decompress(&packed[0], size, &unpacked[0], unpacked.size()), int(input.size()) );
+    BOOST_CHECK( input == unpacked );
+    // the output does not fit.
+    BOOST_CHECK_EQUAL( mqueue::MQCompressor::decompress(&packed[0], size, &unpacked[0], input.size() - 1), -1 );
+
+    // random data does not compress, but still round-trips.
+    for (unsigned int i = 0; i != input.size(); ++i)
+        input[i] = rand();
+    BOOST_CHECK_EQUAL( compressor.compress(&input[0], input.size(), &packed[0], input.size() - input.size() / 8), 0 );
+    size = compressor.compress(&input[0], input.size(), &packed[0], packed.size());
+    BOOST_REQUIRE( size > 0 );
+    BOOST_CHECK_EQUAL( mqueue::MQCompressor::decompress(&packed[0], size, &unpacked[0], unpacked.size()), int(input.size()) );
+    BOOST_CHECK( input == unpacked );
+
+    // too short to hold a match.
+    size = compressor.compress(&input[0], 5, &packed[0], packed.size());
+    BOOST_CHECK_EQUAL( mqueue::MQCompressor::decompress(&packed[0], size, &unpacked[0], unpacked.size()), 5 );
+    BOOST_CHECK( std::equal(input.begin(), input.begin() + 5, unpacked.begin()) );
+}
+
+/**
+ * Sends compressible and random samples over a compressed stream.
+ */
+BOOST_AUTO_TEST_CASE( testCompressedVectorTransport )
+{
+    DataFlowInterface* ports  = tc->ports();
+    DataFlowInterface* ports2 = t2->ports();
+
+    std::vector<double> data(100, 1.0);
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("Vout");
+    ports->addPort(vin).doc("input port");
+    ports2->addPort(vout).doc("output port");
+    vout.setDataSample( data );
+
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/vdata3";
+    policy.compression = ConnPolicy::FAST_COMPRESSION;
+    BOOST_REQUIRE( vout.createStream( policy ) );
+    // the receiver accepts compressed samples anyway.
+    policy.compression = ConnPolicy::NO_COMPRESSION;
+    BOOST_REQUIRE( vin.createStream( policy ) );
+
+    for (unsigned int s = 0; s != 3; ++s) {
+        // the large sample only fits in the queue when compressed, so it
+        // goes before the random one, after which compression backs off.
+        data.resize( s == 1 ? 5000 : 100 );
+        for (unsigned int i = 0; i != data.size(); ++i)
+            data[i] = s == 2 ? double(rand()) / RAND_MAX : 0.25 * (i % 10);
+        vout.write( data );
+        usleep(200000);
+
+        std::vector<double> result;
+        BOOST_CHECK_EQUAL( vin.read(result), NewData);
+        BOOST_CHECK( result == data );
+    }
+    BOOST_CHECK( vout.connected() );
+}
+
+/**
+ * Checks the blobs of the DeltaMarshaller, including a lost sample.
+ */
+BOOST_AUTO_TEST_CASE( testDeltaMarshaller )
+{
+    typedef boost::array<int, 256> Sample;
+    mqueue::MQSerializationProtocol<Sample> inner;
+    types::DeltaMarshaller delta(inner, 4);
+    void* sender = delta.createCookie();
+    void* receiver = delta.createCookie();
+    char blob[2048];
+
+    Sample sample;
+    sample.assign(0);
+    ValueDataSource<Sample>::shared_ptr source = new ValueDataSource<Sample>( sample );
+    ValueDataSource<Sample>::shared_ptr target = new ValueDataSource<Sample>();
+    unsigned int keyframe = delta.getSampleSize(source, sender);
+    BOOST_CHECK_EQUAL( keyframe, sizeof(Sample) + types::DeltaMarshaller::getOverhead() );
+
+    // the first sample is a keyframe.
+    std::pair<void const*,int> res = delta.fillBlob(source, blob, sizeof(blob), sender);
+    BOOST_REQUIRE( res.first );
+    BOOST_CHECK_EQUAL( res.second, int(keyframe) );
+    delta.sent(sender);
+    BOOST_REQUIRE( delta.updateFromBlob(res.first, res.second, target, receiver) );
+    BOOST_CHECK( target->get() == sample );
+
+    // the next ones only carry the changed fields, until the next keyframe.
+    for (int i = 1; i != 4; ++i) {
+        source->set()[10 * i] = i;
+        source->set()[200] = i;
+        res = delta.fillBlob(source, blob, sizeof(blob), sender);
+        BOOST_REQUIRE( res.first );
+        BOOST_CHECK( res.second < 100 );
+        delta.sent(sender);
+        BOOST_REQUIRE( delta.updateFromBlob(res.first, res.second, target, receiver) );
+        BOOST_CHECK( target->get() == source->get() );
+    }
+    res = delta.fillBlob(source, blob, sizeof(blob), sender);
+    BOOST_CHECK_EQUAL( res.second, int(keyframe) );
+    delta.sent(sender);
+    BOOST_REQUIRE( delta.updateFromBlob(res.first, res.second, target, receiver) );
+
+    // a sample which was not sent is not the base of the next delta.
+    source->set()[2] = 41;
+    delta.fillBlob(source, blob, sizeof(blob), sender);
+    source->set()[3] = 40;
+    res = delta.fillBlob(source, blob, sizeof(blob), sender);
+    BOOST_CHECK( res.second < 100 );
+    delta.sent(sender);
+    BOOST_REQUIRE( delta.updateFromBlob(res.first, res.second, target, receiver) );
+    BOOST_CHECK( target->get() == source->get() );
+
+    // a receiver which missed a sample waits for the next keyframe.
+    source->set()[0] = 42;
+    delta.fillBlob(source, blob, sizeof(blob), sender);
+    delta.sent(sender);
+    source->set()[1] = 43;
+    res = delta.fillBlob(source, blob, sizeof(blob), sender);
+    delta.sent(sender);
+    BOOST_CHECK( !delta.updateFromBlob(res.first, res.second, target, receiver) );
+    BOOST_CHECK_EQUAL( target->get()[1], 0 );
+    res = delta.fillBlob(source, blob, sizeof(blob), sender);
+    BOOST_CHECK_EQUAL( res.second, int(keyframe) );
+    delta.sent(sender);
+    BOOST_REQUIRE( delta.updateFromBlob(res.first, res.second, target, receiver) );
+    BOOST_CHECK( target->get() == source->get() );
+
+    // or asks for one, for example when it connects.
+    void* late = delta.createCookie();
+    delta.resync(sender);
+    source->set()[4] = 39;
+    res = delta.fillBlob(source, blob, sizeof(blob), sender);
+    BOOST_CHECK_EQUAL( res.second, int(keyframe) );
+    delta.sent(sender);
+    BOOST_REQUIRE( delta.updateFromBlob(res.first, res.second, target, late) );
+    BOOST_CHECK( target->get() == source->get() );
+    delta.deleteCookie(late);
+
+    delta.deleteCookie(sender);
+    delta.deleteCookie(receiver);
+}
+
+/**
+ * Sends samples of changing size over a delta encoded stream.
+ */
+BOOST_AUTO_TEST_CASE( testDeltaVectorTransport )
+{
+    DataFlowInterface* ports  = tc->ports();
+    DataFlowInterface* ports2 = t2->ports();
+
+    std::vector<double> data(1000, 1.0);
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("Vout");
+    ports->addPort(vin).doc("input port");
+    ports2->addPort(vout).doc("output port");
+    vout.setDataSample( data );
+
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/vdata4";
+    policy.keyframe_period = 3;
+    BOOST_REQUIRE( vout.createStream( policy ) );
+    BOOST_REQUIRE( vin.createStream( policy ) );
+
+    for (unsigned int s = 0; s != 8; ++s) {
+        if (s == 5)
+            data.resize(2000, 2.0);
+        data[s] = s;
+        vout.write( data );
+        usleep(100000);
+
+        std::vector<double> result;
+        BOOST_CHECK_EQUAL( vin.read(result), NewData);
+        BOOST_CHECK( result == data );
+    }
+    BOOST_CHECK( vout.connected() );
+}
+
+/**
+ * Checks the memcpy paths of the MQSerializationProtocol without
+ * a message queue in between.
+ */
+BOOST_AUTO_TEST_CASE( testFixedLayoutMarshalling )
+{
+    char blob[1024];
+
+    // struct which opted in: sent as is.
+    mqueue::MQSerializationProtocol<FixedSample> fixed;
+    FixedSample fs;
+    fs.id = 7;
+    for (unsigned int i = 0; i != fs.values.size(); ++i)
+        fs.values[i] = 0.5 * i;
+    ValueDataSource<FixedSample>::shared_ptr fsource = new ValueDataSource<FixedSample>( fs );
+    ValueDataSource<FixedSample>::shared_ptr ftarget = new ValueDataSource<FixedSample>();
+    BOOST_CHECK_EQUAL( fixed.getSampleSize( fsource, 0 ), sizeof(FixedSample) );
+    std::pair<void const*,int> res = fixed.fillBlob( fsource, blob, sizeof(blob), 0 );
+    BOOST_REQUIRE( res.first );
+    BOOST_CHECK_EQUAL( res.second, int(sizeof(FixedSample)) );
+    BOOST_REQUIRE( fixed.updateFromBlob( res.first, res.second, ftarget, 0 ) );
+    BOOST_CHECK_EQUAL( ftarget->get().id, 7 );
+    for (unsigned int i = 0; i != fs.values.size(); ++i)
+        BOOST_CHECK_EQUAL( ftarget->get().values[i], 0.5 * i );
+    BOOST_CHECK( fixed.fillBlob( fsource, blob, sizeof(FixedSample) - 1, 0 ).first == 0 );
+    BOOST_CHECK( !fixed.updateFromBlob( res.first, res.second - 1, ftarget, 0 ) );
+
+    // vector of PODs: element count followed by the elements.
+    mqueue::MQSerializationProtocol< std::vector<int> > vec;
+    std::vector<int> v(10);
+    for (unsigned int i = 0; i != v.size(); ++i)
+        v[i] = i * i;
+    ValueDataSource< std::vector<int> >::shared_ptr vsource = new ValueDataSource< std::vector<int> >( v );
+    ValueDataSource< std::vector<int> >::shared_ptr vtarget = new ValueDataSource< std::vector<int> >();
+    unsigned int vsize = vec.getSampleSize( vsource, 0 );
+    BOOST_CHECK_EQUAL( vsize, sizeof(std::size_t) + 10 * sizeof(int) );
+    res = vec.fillBlob( vsource, blob, sizeof(blob), 0 );
+    BOOST_REQUIRE( res.first );
+    BOOST_CHECK_EQUAL( res.second, int(vsize) );
+    BOOST_REQUIRE( vec.updateFromBlob( res.first, res.second, vtarget, 0 ) );
+    BOOST_CHECK( vtarget->get() == v );
+    BOOST_CHECK( vec.fillBlob( vsource, blob, vsize - 1, 0 ).first == 0 );
+    BOOST_CHECK( !vec.updateFromBlob( res.first, res.second - 1, vtarget, 0 ) );
+
+    // an empty vector only carries its element count.
+    vsource->set().clear();
+    res = vec.fillBlob( vsource, blob, sizeof(blob), 0 );
+    BOOST_REQUIRE( res.first );
+    BOOST_CHECK_EQUAL( res.second, int(sizeof(std::size_t)) );
+    BOOST_REQUIRE( vec.updateFromBlob( res.first, res.second, vtarget, 0 ) );
+    BOOST_CHECK( vtarget->get().empty() );
+
+    // other types still go through the archive.
+    typedef std::vector< std::vector<double> > Nested;
+    mqueue::MQSerializationProtocol< Nested > nested;
+    ValueDataSource< Nested >::shared_ptr nsource = new ValueDataSource< Nested >( Nested(3, std::vector<double>(5, 1.5)) );
+    ValueDataSource< Nested >::shared_ptr ntarget = new ValueDataSource< Nested >();
+    res = nested.fillBlob( nsource, blob, sizeof(blob), 0 );
+    BOOST_REQUIRE( res.first );
+    BOOST_CHECK_EQUAL( res.second, int(nested.getSampleSize( nsource, 0 )) );
+    BOOST_REQUIRE( nested.updateFromBlob( res.first, res.second, ntarget, 0 ) );
+    BOOST_CHECK( ntarget->get() == nsource->get() );
+
+    // a trivially copyable struct which did not opt in uses its serialize().
+    mqueue::MQSerializationProtocol< SerializedSample > ser;
+    SerializedSample ss;
+    ss.id = 3;
+    ss.local = 42;
+    ValueDataSource< SerializedSample >::shared_ptr ssource = new ValueDataSource< SerializedSample >( ss );
+    ValueDataSource< SerializedSample >::shared_ptr starget = new ValueDataSource< SerializedSample >();
+    res = ser.fillBlob( ssource, blob, sizeof(blob), 0 );
+    BOOST_REQUIRE( res.first );
+    BOOST_CHECK_EQUAL( res.second, int(sizeof(int)) );
+    BOOST_REQUIRE( ser.updateFromBlob( res.first, res.second, starget, 0 ) );
+    BOOST_CHECK_EQUAL( starget->get().id, 3 );
+    BOOST_CHECK_EQUAL( starget->get().local, 0 );
+}
+
+BOOST_AUTO_TEST_CASE( testBufferArchive )
+{
+    char blob[1024];
+
+    // strings are stored as their length followed by their characters.
+    std::string hello("hello world");
+    mqueue::binary_buffer_oarchive out( blob, sizeof(blob) );
+    out << hello;
+    BOOST_CHECK_EQUAL( out.getArchiveSize(), int(sizeof(std::size_t) + hello.size()) );
+    std::string result;
+    mqueue::binary_buffer_iarchive in( blob, out.getArchiveSize() );
+    in >> result;
+    BOOST_CHECK_EQUAL( result, hello );
+    BOOST_CHECK_EQUAL( in.getArchiveSize(), out.getArchiveSize() );
+
+    // writing or reading past the end of the buffer throws.
+    mqueue::binary_buffer_oarchive small( blob, hello.size() );
+    BOOST_CHECK_THROW( small << hello, boost::archive::archive_exception );
+    mqueue::binary_buffer_iarchive truncated( blob, out.getArchiveSize() - 1 );
+    BOOST_CHECK_THROW( truncated >> result, boost::archive::archive_exception );
+
+    // std::vector<bool> is not stored as one block.
+    std::vector<bool> bits(13);
+    for (unsigned int i = 0; i < bits.size(); i += 3)
+        bits[i] = true;
+    mqueue::binary_buffer_oarchive bout( blob, sizeof(blob) );
+    bout << bits;
+    std::vector<bool> bresult(2, true);
+    mqueue::binary_buffer_iarchive bin( blob, bout.getArchiveSize() );
+    bin >> bresult;
+    BOOST_CHECK( bresult == bits );
+
+    // a corrupt element count is refused before the vector is sized.
+    std::size_t huge = std::size_t(-1) / 2;
+    std::memcpy( blob, &huge, sizeof(huge) );
+    std::vector<double> dresult(3, 1.0);
+    mqueue::binary_buffer_iarchive corrupt( blob, sizeof(huge) + sizeof(double) );
+    BOOST_CHECK_THROW( corrupt >> dresult, boost::archive::archive_exception );
+    BOOST_CHECK_EQUAL( dresult.size(), 3u );
+    mqueue::binary_buffer_iarchive bcorrupt( blob, sizeof(huge) + 1 );
+    BOOST_CHECK_THROW( bcorrupt >> bresult, boost::archive::archive_exception );
+
+    // nested sequences through the MQSerializationProtocol.
+    typedef std::vector< std::string > Strings;
+    Strings strings;
+    strings.push_back( "one" );
+    strings.push_back( "" );
+    strings.push_back( std::string(100, 'x') );
+    mqueue::MQSerializationProtocol< Strings > sp;
+    ValueDataSource< Strings >::shared_ptr ssource = new ValueDataSource< Strings >( strings );
+    ValueDataSource< Strings >::shared_ptr starget = new ValueDataSource< Strings >();
+    unsigned int ssize = sp.getSampleSize( ssource, 0 );
+    std::pair<void const*,int> res = sp.fillBlob( ssource, blob, sizeof(blob), 0 );
+    BOOST_REQUIRE( res.first );
+    BOOST_CHECK_EQUAL( res.second, int(ssize) );
+    BOOST_REQUIRE( sp.updateFromBlob( res.first, res.second, starget, 0 ) );
+    BOOST_CHECK( starget->get() == strings );
+    BOOST_CHECK( sp.fillBlob( ssource, blob, ssize - 1, 0 ).first == 0 );
+    BOOST_CHECK( !sp.updateFromBlob( res.first, res.second - 1, starget, 0 ) );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
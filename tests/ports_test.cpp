@@ -27,7 +27,13 @@
 #include <extras/SimulationThread.hpp>
 
 #include <boost/function_types/function_type.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <OperationCaller.hpp>
+#include <Activity.hpp>
+#include <os/TimeService.hpp>
+
+#include <algorithm>
+#include <vector>
 
 using namespace std;
 using namespace RTT;
@@ -51,6 +57,38 @@ public:
     }
 };
 
+/**
+ * Connects and disconnects an input port to an output port
+ * in a loop, in order to stress the connection management of
+ * the output port.
+ */
+struct ConnectionChurner : public RunnableInterface
+{
+    volatile bool stop;
+    OutputPort<double>& wp;
+    InputPort<double> rp;
+    int cycles;
+    ConnectionChurner(OutputPort<double>& w) : stop(false), wp(w), rp("churn"), cycles(0) {}
+    bool initialize() {
+        stop = false; cycles = 0;
+        return true;
+    }
+    void step() {
+        while (stop == false) {
+            wp.createConnection(rp, ConnPolicy::data());
+            wp.disconnect(&rp);
+            ++cycles;
+        }
+    }
+
+    void finalize() {}
+
+    bool breakLoop() {
+        stop = true;
+        return true;
+    }
+};
+
 /**
  * Fixture.
  */
@@ -64,9 +102,11 @@ public:
     ActivityInterface* stsim;
 
     PortInterface* signalled_port;
+    int signal_count;
     void new_data_listener(PortInterface* port)
     {
         signalled_port = port;
+        ++signal_count;
     }
 
 public:
@@ -678,5 +718,260 @@ BOOST_AUTO_TEST_CASE(testPortDataSource)
     BOOST_CHECK_EQUAL(20, source->value());
 }
 
+BOOST_AUTO_TEST_CASE(testPortLoanCommit)
+{
+    OutputPort< std::vector<double> > wp("W");
+    ConnPolicy shared_data = ConnPolicy::data();
+    shared_data.shared = true;
+    ConnPolicy shared_buffer = ConnPolicy::buffer(4);
+    shared_buffer.shared = true;
+    InputPort< std::vector<double> > rp1("R1", shared_data);
+    InputPort< std::vector<double> > rp2("R2", shared_buffer);
+    InputPort< std::vector<double> > rp3("R3", ConnPolicy::data());
+
+    wp.setDataSample( std::vector<double>(10, 0.0) );
+    BOOST_REQUIRE( wp.createConnection(rp1) );
+    BOOST_REQUIRE( wp.createConnection(rp2) );
+    BOOST_REQUIRE( wp.createConnection(rp3) );
+
+    extras::ReadOnlyPointer< std::vector<double> > ptr1, ptr2, ptr3;
+    BOOST_CHECK_EQUAL( rp1.readShared(ptr1), NoData );
+    BOOST_CHECK_EQUAL( rp2.readShared(ptr2), NoData );
+
+    std::vector<double>& loaned = wp.loan();
+    BOOST_CHECK_EQUAL( loaned.size(), 10u );
+    loaned[0] = 1.0;
+    std::vector<double> const* address = &loaned;
+    wp.commit();
+
+    // shared connections hand out the loaned sample itself.
+    BOOST_CHECK_EQUAL( rp1.readShared(ptr1), NewData );
+    BOOST_CHECK_EQUAL( ptr1.get(), address );
+    BOOST_CHECK_EQUAL( rp2.readShared(ptr2), NewData );
+    BOOST_CHECK_EQUAL( ptr2.get(), address );
+    BOOST_CHECK_EQUAL( rp1.readShared(ptr1), OldData );
+    BOOST_CHECK_EQUAL( ptr1.get(), address );
+    BOOST_CHECK_EQUAL( rp2.readShared(ptr2), OldData );
+
+    // other connections receive a copy.
+    BOOST_CHECK_EQUAL( rp3.readShared(ptr3), NewData );
+    BOOST_CHECK( ptr3.get() != address );
+    BOOST_CHECK_EQUAL( (*ptr3)[0], 1.0 );
+
+    // the sample is in use, so the next loan must return another one.
+    std::vector<double>& loaned2 = wp.loan();
+    BOOST_CHECK( &loaned2 != address );
+    loaned2[0] = 2.0;
+    wp.commit();
+
+    std::vector<double> value;
+    BOOST_CHECK_EQUAL( rp1.read(value), NewData );
+    BOOST_CHECK_EQUAL( value[0], 2.0 );
+    BOOST_CHECK_EQUAL( rp2.read(value), NewData );
+    BOOST_CHECK_EQUAL( value[0], 2.0 );
+    BOOST_CHECK_EQUAL( rp3.read(value), NewData );
+    BOOST_CHECK_EQUAL( value[0], 2.0 );
+
+    // plain writes still work on shared connections.
+    wp.write( std::vector<double>(10, 3.0) );
+    BOOST_CHECK_EQUAL( rp1.readShared(ptr1), NewData );
+    BOOST_CHECK_EQUAL( (*ptr1)[0], 3.0 );
+    BOOST_CHECK_EQUAL( rp2.readShared(ptr2), NewData );
+    BOOST_CHECK_EQUAL( (*ptr2)[0], 3.0 );
+}
+
+BOOST_AUTO_TEST_CASE(testPortBatchWriteRead)
+{
+    OutputPort<double> wp("W");
+    InputPort<double> rp1("R1", ConnPolicy::buffer(8));
+    InputPort<double> rp2("R2", ConnPolicy::data());
+    InputPort<double> rp3("R3", ConnPolicy::buffer(8, ConnPolicy::LOCK_FREE_SPSC));
+    InputPort<double> rp4("R4", ConnPolicy::buffer(8, ConnPolicy::LOCKED));
+    BOOST_REQUIRE( wp.createConnection(rp1) );
+    BOOST_REQUIRE( wp.createConnection(rp2) );
+    BOOST_REQUIRE( wp.createConnection(rp3) );
+    BOOST_REQUIRE( wp.createConnection(rp4) );
+
+    tce->start();
+    tce->addEventPort(rp1, boost::bind(&PortsTestFixture::new_data_listener, this, _1) );
+
+    std::vector<double> batch, result;
+    BOOST_CHECK_EQUAL( rp1.readAll(result), NoData );
+    for (int i = 0; i != 5; ++i)
+        batch.push_back(i);
+    signal_count = 0;
+    wp.write(batch);
+    // one signal for the whole batch.
+    BOOST_CHECK_EQUAL( signal_count, 1 );
+
+    BOOST_CHECK_EQUAL( rp1.readAll(result), NewData );
+    BOOST_CHECK( result == batch );
+    double value = -1.0;
+    BOOST_CHECK_EQUAL( rp1.read(value), OldData );
+    BOOST_CHECK_EQUAL( value, 4.0 );
+    BOOST_CHECK_EQUAL( rp1.readAll(result), OldData );
+    BOOST_CHECK( result.empty() );
+
+    // a data connection only keeps the last sample.
+    BOOST_CHECK_EQUAL( rp2.readAll(result), NewData );
+    BOOST_REQUIRE_EQUAL( result.size(), 1u );
+    BOOST_CHECK_EQUAL( result[0], 4.0 );
+    BOOST_CHECK_EQUAL( rp2.readAll(result), OldData );
+
+    BOOST_CHECK_EQUAL( rp3.readAll(result), NewData );
+    BOOST_CHECK( result == batch );
+    BOOST_CHECK_EQUAL( rp4.readAll(result), NewData );
+    BOOST_CHECK( result == batch );
+
+    // samples of a batch that do not fit in a buffer are dropped.
+    batch.clear();
+    for (int i = 0; i != 10; ++i)
+        batch.push_back(i);
+    wp.write(batch);
+    batch.resize(8);
+    BOOST_CHECK_EQUAL( rp1.read(value), NewData );
+    BOOST_CHECK_EQUAL( value, 0.0 );
+    BOOST_CHECK_EQUAL( rp1.readAll(result), NewData );
+    BOOST_CHECK( result == std::vector<double>(batch.begin() + 1, batch.end()) );
+    BOOST_CHECK_EQUAL( rp1.read(value), OldData );
+    BOOST_CHECK_EQUAL( value, 7.0 );
+    BOOST_CHECK_EQUAL( rp3.readAll(result), NewData );
+    BOOST_CHECK( result == batch );
+    BOOST_CHECK_EQUAL( rp4.readAll(result), NewData );
+    BOOST_CHECK( result == batch );
+
+    // mandatory
+    tce->ports()->removePort( rp1.getName() );
+}
+
+BOOST_AUTO_TEST_CASE(testPortConnectionQos)
+{
+    OutputPort<double> wp("W");
+    InputPort<double> rp1("R1");
+    InputPort<double> rp2("R2");
+    InputPort<double> rp3("R3");
+
+    ConnPolicy decimated = ConnPolicy::buffer(16);
+    decimated.decimation = 3;
+    BOOST_REQUIRE( wp.createConnection(rp1, decimated) );
+    ConnPolicy limited = ConnPolicy::buffer(16);
+    limited.min_period = 0.2;
+    BOOST_REQUIRE( wp.createConnection(rp2, limited) );
+    ConnPolicy coalesced = ConnPolicy::buffer(16);
+    coalesced.decimation = 2;
+    coalesced.coalesce = true;
+    BOOST_REQUIRE( wp.createConnection(rp3, coalesced) );
+
+    // one out of three samples, starting with the first.
+    std::vector<double> result;
+    for (int i = 0; i != 10; ++i)
+        wp.write( double(i) );
+    BOOST_CHECK_EQUAL( rp1.readAll(result), NewData );
+    BOOST_REQUIRE_EQUAL( result.size(), 4u );
+    BOOST_CHECK_EQUAL( result[0], 0.0 );
+    BOOST_CHECK_EQUAL( result[1], 3.0 );
+    BOOST_CHECK_EQUAL( result[3], 9.0 );
+
+    // only the first sample of the period.
+    BOOST_CHECK_EQUAL( rp2.readAll(result), NewData );
+    BOOST_REQUIRE_EQUAL( result.size(), 1u );
+    BOOST_CHECK_EQUAL( result[0], 0.0 );
+    usleep(250000);
+    wp.write( 10.0 );
+    wp.write( 11.0 );
+    BOOST_CHECK_EQUAL( rp2.readAll(result), NewData );
+    BOOST_REQUIRE_EQUAL( result.size(), 1u );
+    BOOST_CHECK_EQUAL( result[0], 10.0 );
+
+    // single writes are decimated, 0 2 4 6 8 10 arrived.
+    BOOST_CHECK_EQUAL( rp3.readAll(result), NewData );
+    BOOST_CHECK_EQUAL( result.size(), 6u );
+
+    // a batch in which a sample is due forwards its latest sample only.
+    std::vector<double> batch;
+    batch.push_back( 12.0 );
+    batch.push_back( 13.0 );
+    batch.push_back( 14.0 );
+    wp.write( batch );
+    BOOST_CHECK_EQUAL( rp3.readAll(result), NewData );
+    BOOST_REQUIRE_EQUAL( result.size(), 1u );
+    BOOST_CHECK_EQUAL( result[0], 14.0 );
+    // 15 is not due.
+    batch.resize(1, 15.0);
+    batch[0] = 15.0;
+    wp.write( batch );
+    BOOST_CHECK_EQUAL( rp3.readAll(result), OldData );
+    BOOST_CHECK_EQUAL( rp1.readAll(result), NewData );
+    BOOST_CHECK_EQUAL( result.size(), 2u );
+}
+
+BOOST_AUTO_TEST_CASE(testPortWriteLatencyDuringConnectionChurn)
+{
+    const unsigned int readers = 8;
+    const unsigned int samples = 100000;
+    OutputPort<double> wp("W");
+    std::vector< InputPort<double>* > rps;
+    for (unsigned int i = 0; i != readers; ++i) {
+        rps.push_back( new InputPort<double>("R") );
+        BOOST_REQUIRE( wp.createConnection(*rps.back(), i % 2 ? ConnPolicy::data() : ConnPolicy::buffer(16)) );
+    }
+
+    ConnectionChurner* churner = new ConnectionChurner(wp);
+    std::vector<os::TimeService::nsecs> latencies;
+    latencies.reserve(samples);
+    // the next value each buffer connection must deliver.
+    std::vector<double> next(readers, 0.0);
+    unsigned int lost = 0;
+    {
+        boost::scoped_ptr<Activity> cthread( new Activity(ORO_SCHED_OTHER, 0, 0, churner, "ActivityChurn" ));
+        BOOST_REQUIRE( cthread->start() );
+        double value = 0.0;
+        for (unsigned int i = 0; i != samples; ++i) {
+            os::TimeService::ticks start = os::TimeService::Instance()->getTicks();
+            wp.write( double(i) );
+            latencies.push_back( os::TimeService::ticks2nsecs( os::TimeService::Instance()->ticksSince(start) ) );
+            // keep the buffer connections from overflowing.
+            if ( i % 8 == 0 )
+                for (unsigned int r = 0; r != readers; ++r) {
+                    bool fresh = false;
+                    while ( rps[r]->read(value) == NewData ) {
+                        // a buffer connection delivers every write, in order.
+                        if ( r % 2 == 0 ) {
+                            if ( value != next[r] )
+                                ++lost;
+                            next[r] = value + 1.0;
+                        }
+                        fresh = true;
+                    }
+                    // every connection has the last write, untorn.
+                    if ( !fresh || value != double(i) )
+                        ++lost;
+                }
+        }
+        cthread->stop();
+        BOOST_CHECK( churner->cycles > 0 );
+    }
+    BOOST_CHECK_EQUAL( lost, 0u );
+    delete churner;
+
+    // all permanent connections must have survived the churning.
+    double value = -1.0;
+    wp.write( 1.0 );
+    for (unsigned int r = 0; r != readers; ++r) {
+        BOOST_CHECK( rps[r]->connected() );
+        while ( rps[r]->read(value, false) == NewData ) {}
+        BOOST_CHECK_EQUAL( 1.0, value );
+        delete rps[r];
+    }
+    BOOST_CHECK( !wp.connected() );
+
+    std::sort( latencies.begin(), latencies.end() );
+    BOOST_TEST_MESSAGE( "Write latency with " << readers << " readers during connection churn (ns): "
+                        << "p50=" << latencies[samples / 2]
+                        << " p99=" << latencies[samples * 99 / 100]
+                        << " p99.9=" << latencies[samples * 999 / 1000]
+                        << " max=" << latencies.back() );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,341 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "unit.hpp"
+
+#include <iostream>
+
+#include <transports/shm/ShmLib.hpp>
+#include <transports/shm/ShmRing.hpp>
+#include <transports/shm/ShmTemplateProtocol.hpp>
+#include <types/TypeInfo.hpp>
+#include <types/TypeTransporter.hpp>
+#include <os/fosi.h>
+
+#include <InputPort.hpp>
+#include <OutputPort.hpp>
+#include <TaskContext.hpp>
+#include <string>
+#include <ctime>
+
+using namespace std;
+using namespace RTT;
+using namespace RTT::detail;
+
+class ShmTest
+{
+public:
+    ShmTest()
+    {
+        mr2 = new InputPort<double>("mr");
+        mw1 = new OutputPort<double>("mw");
+
+        // both tc's are non periodic
+        tc =  new TaskContext( "root" );
+        tc->ports()->addPort( *mw1 );
+
+        t2 = new TaskContext("other");
+        t2->ports()->addEventPort( *mr2, boost::bind(&ShmTest::new_data_listener, this, _1) );
+
+        tc->start();
+        t2->start();
+
+        policy.type = ConnPolicy::DATA;
+        policy.init = false;
+        policy.lock_policy = ConnPolicy::LOCK_FREE;
+        policy.size = 0;
+        policy.pull = true;
+        policy.transport = ORO_SHM_PROTOCOL_ID;
+    }
+
+    ~ShmTest()
+    {
+        delete tc;
+        delete t2;
+
+        delete mr2;
+        delete mw1;
+    }
+
+    TaskContext* tc;
+    TaskContext* t2;
+
+    PortInterface* signalled_port;
+    void new_data_listener(PortInterface* port)
+    {
+        signalled_port = port;
+    }
+
+    InputPort<double>*  mr2;
+    OutputPort<double>* mw1;
+
+    ConnPolicy policy;
+};
+
+#define ASSERT_PORT_SIGNALLING(code, read_port) \
+    signalled_port = 0; \
+    code; \
+    usleep(100000); \
+    BOOST_CHECK( read_port == signalled_port );
+
+// Registers the fixture into the 'registry'
+BOOST_FIXTURE_TEST_SUITE(  ShmTestSuite,  ShmTest )
+
+BOOST_AUTO_TEST_CASE( testRing )
+{
+    shm::ShmRing writer, reader;
+    BOOST_REQUIRE( writer.open("/rtt-shm-test-ring", 4, sizeof(int)) );
+    // the second party adopts the geometry of the creator.
+    BOOST_REQUIRE( reader.open("/rtt-shm-test-ring", 16, 1024) );
+    writer.unlink();
+    BOOST_CHECK_EQUAL( reader.slots(), 4u );
+    BOOST_CHECK_EQUAL( reader.slot_size(), sizeof(int) );
+
+    BOOST_CHECK( reader.front() == 0 );
+    BOOST_CHECK( reader.wait(0.01) == false );
+
+    // fill it twice to check the wrap around.
+    for (int round = 0; round != 2; ++round) {
+        for (int i = 0; i != 4; ++i) {
+            shm::ShmSlot* s = writer.claim();
+            BOOST_REQUIRE( s );
+            *(int*)s->data() = i;
+            writer.publish(s, sizeof(int));
+        }
+        BOOST_CHECK( writer.claim() == 0 );
+        BOOST_CHECK( reader.wait(0.01) );
+        for (int i = 0; i != 4; ++i) {
+            shm::ShmSlot* s = reader.front();
+            BOOST_REQUIRE( s );
+            BOOST_CHECK_EQUAL( s->size, sizeof(int) );
+            BOOST_CHECK_EQUAL( *(int*)s->data(), i );
+            reader.pop();
+        }
+        BOOST_CHECK( reader.front() == 0 );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( testRingWrapAround )
+{
+    shm::ShmRing writer, reader;
+    // 10 slots do not divide 2^32: they are rounded up to 16.
+    BOOST_REQUIRE( writer.open("/rtt-shm-test-wrap", 10, sizeof(unsigned int)) );
+    BOOST_CHECK_EQUAL( writer.slots(), 16u );
+    writer.rewind( 0xFFFFFFFFu - 20 );
+    BOOST_REQUIRE( reader.open("/rtt-shm-test-wrap", 10, sizeof(unsigned int)) );
+    writer.unlink();
+
+    // pass the wrap around of the positions a few samples at a time.
+    unsigned int next = 0;
+    for (unsigned int round = 0; round != 10; ++round) {
+        for (unsigned int i = 0; i != 7; ++i) {
+            shm::ShmSlot* s = writer.claim();
+            BOOST_REQUIRE( s );
+            *(unsigned int*)s->data() = round * 7 + i;
+            writer.publish(s, sizeof(unsigned int));
+        }
+        for (unsigned int i = 0; i != 7; ++i) {
+            shm::ShmSlot* s = reader.front();
+            BOOST_REQUIRE( s );
+            BOOST_CHECK_EQUAL( *(unsigned int*)s->data(), next++ );
+            reader.pop();
+        }
+        BOOST_CHECK( reader.front() == 0 );
+    }
+    // and fill it completely.
+    for (unsigned int i = 0; i != 16; ++i)
+        BOOST_CHECK( writer.claim() != 0 );
+    BOOST_CHECK( writer.claim() == 0 );
+}
+
+BOOST_AUTO_TEST_CASE( testPortStreams )
+{
+    double value = 0;
+
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/shmdata1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    BOOST_CHECK( mw1->connected() );
+    BOOST_CHECK( mr2->connected() );
+    BOOST_CHECK( NoData == mr2->read(value) );
+
+    ASSERT_PORT_SIGNALLING(mw1->write(1.0), mr2);
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 1.0, value );
+    ASSERT_PORT_SIGNALLING(mw1->write(2.0), mr2);
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 2.0, value );
+    BOOST_CHECK( OldData == mr2->read(value) );
+    mw1->disconnect();
+    mr2->disconnect();
+    BOOST_CHECK( !mw1->connected() );
+    BOOST_CHECK( !mr2->connected() );
+
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 3;
+    policy.name_id = "/shmbuffer1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    ASSERT_PORT_SIGNALLING(mw1->write(1.0), mr2);
+    ASSERT_PORT_SIGNALLING(mw1->write(2.0), mr2);
+    ASSERT_PORT_SIGNALLING(mw1->write(3.0), mr2);
+    ASSERT_PORT_SIGNALLING(mw1->write(4.0), 0);  // because size == 3
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 1.0, value );
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 2.0, value );
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 3.0, value );
+    BOOST_CHECK( OldData == mr2->read(value) );
+    mw1->disconnect();
+    mr2->disconnect();
+}
+
+BOOST_AUTO_TEST_CASE( testPortConnection )
+{
+    // an out-of-band connection picks the name of the segment.
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 8;
+    policy.name_id = "";
+    BOOST_REQUIRE( mw1->createConnection(*mr2, policy) );
+    BOOST_CHECK( !policy.name_id.empty() );
+
+    for (int i = 0; i != 8; ++i)
+        mw1->write( double(i) );
+
+    double value = -1;
+    int received = 0;
+    for (int tries = 0; tries != 100 && received != 8; ++tries) {
+        while ( mr2->read(value) == NewData ) {
+            BOOST_CHECK_EQUAL( double(received), value );
+            ++received;
+        }
+        usleep(10000);
+    }
+    BOOST_CHECK_EQUAL( received, 8 );
+    mw1->disconnect();
+    mr2->disconnect();
+}
+
+BOOST_AUTO_TEST_CASE( testReaderDisconnect )
+{
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 4;
+    policy.name_id = "/shmdisconnect1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    mw1->write( 1.0 );
+    types::TypeTransporter* protocol = mr2->getTypeInfo()->getProtocol( ORO_SHM_PROTOCOL_ID );
+    BOOST_REQUIRE( protocol );
+    base::ChannelElementBase::shared_ptr reader = protocol->createStream( mr2, policy, false );
+    BOOST_REQUIRE( reader );
+    BOOST_REQUIRE( reader->inputReady() );
+
+    // the reader goes away while the writer keeps writing.
+    reader->disconnect( true );
+    for (int i = 0; i != 100; ++i) {
+        mw1->write( double(i) );
+        usleep(1000);
+    }
+    BOOST_CHECK( mw1->connected() );
+
+    // the receiver drops the samples instead of spinning on them.
+    std::clock_t start = std::clock();
+    usleep(200000);
+    BOOST_CHECK( std::clock() - start < CLOCKS_PER_SEC / 20 );
+
+    reader = 0;
+    mw1->disconnect();
+}
+
+BOOST_AUTO_TEST_CASE( testVectorTransport )
+{
+    std::vector<double> data(20, 3.33);
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("Vout");
+    tc->ports()->addPort(vin);
+    t2->ports()->addPort(vout);
+
+    // the slots are sized after this sample.
+    vout.setDataSample( data );
+
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/shmvdata1";
+    BOOST_REQUIRE( vout.createStream( policy ) );
+    BOOST_REQUIRE( vin.createStream( policy ) );
+    BOOST_CHECK_EQUAL( vin.read(data), NoData);
+
+    data.clear();
+    data.resize(10, 6.66);
+    vout.write( data );
+
+    data.clear();
+    data.resize(20, 0.0);
+    usleep(200000);
+    BOOST_CHECK_EQUAL( vin.read(data), NewData);
+    BOOST_CHECK_EQUAL( data.size(), 10);
+    for(unsigned int i=0; i != data.size(); ++i)
+        BOOST_CHECK_CLOSE( data[i], 6.66, 0.01);
+
+    // a sample which does not fit in a slot is dropped,
+    // the following ones still arrive.
+    data.resize(100, 1.0);
+    vout.write( data );
+    usleep(200000);
+    BOOST_CHECK_EQUAL( vin.read(data), OldData);
+    BOOST_CHECK_EQUAL( data.size(), 10);
+    BOOST_CHECK( vout.connected() );
+
+    data.resize(5, 9.99);
+    vout.write( data );
+    usleep(200000);
+    BOOST_CHECK_EQUAL( vin.read(data), NewData);
+    BOOST_CHECK_EQUAL( data.size(), 5);
+
+    vout.disconnect();
+    vin.disconnect();
+}
+
+BOOST_AUTO_TEST_CASE( testDeltaTransport )
+{
+    std::vector<double> data(200, 1.0);
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("Vout");
+    tc->ports()->addPort(vin);
+    t2->ports()->addPort(vout);
+    vout.setDataSample( data );
+
+    // the slots leave room for a keyframe.
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/shmvdata2";
+    policy.keyframe_period = 4;
+    BOOST_REQUIRE( vout.createStream( policy ) );
+    BOOST_REQUIRE( vin.createStream( policy ) );
+
+    for (unsigned int s = 0; s != 6; ++s) {
+        data[s * 10] = s;
+        vout.write( data );
+        usleep(100000);
+
+        std::vector<double> result;
+        BOOST_CHECK_EQUAL( vin.read(result), NewData);
+        BOOST_CHECK( result == data );
+    }
+
+    vout.disconnect();
+    vin.disconnect();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
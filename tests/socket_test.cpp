@@ -0,0 +1,329 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "unit.hpp"
+
+#include <iostream>
+
+#include <transports/socket/SocketLib.hpp>
+#include <transports/socket/SocketTemplateProtocol.hpp>
+#include <os/fosi.h>
+
+#include <InputPort.hpp>
+#include <OutputPort.hpp>
+#include <TaskContext.hpp>
+#include <string>
+
+using namespace std;
+using namespace RTT;
+using namespace RTT::detail;
+
+class SocketTest
+{
+public:
+    SocketTest()
+    {
+        mr2 = new InputPort<double>("mr");
+        mw1 = new OutputPort<double>("mw");
+
+        // both tc's are non periodic
+        tc =  new TaskContext( "root" );
+        tc->ports()->addPort( *mw1 );
+
+        t2 = new TaskContext("other");
+        t2->ports()->addEventPort( *mr2, boost::bind(&SocketTest::new_data_listener, this, _1) );
+
+        tc->start();
+        t2->start();
+
+        policy.type = ConnPolicy::DATA;
+        policy.init = false;
+        policy.lock_policy = ConnPolicy::LOCK_FREE;
+        policy.size = 0;
+        policy.pull = true;
+        policy.transport = ORO_SOCKET_PROTOCOL_ID;
+    }
+
+    ~SocketTest()
+    {
+        delete tc;
+        delete t2;
+
+        delete mr2;
+        delete mw1;
+    }
+
+    TaskContext* tc;
+    TaskContext* t2;
+
+    PortInterface* signalled_port;
+    void new_data_listener(PortInterface* port)
+    {
+        signalled_port = port;
+    }
+
+    InputPort<double>*  mr2;
+    OutputPort<double>* mw1;
+
+    ConnPolicy policy;
+
+    /**
+     * Reads from mr2 until \a count samples arrived, which must be 0, 1, 2, ...
+     */
+    int readSequence(int count)
+    {
+        double value = -1;
+        int received = 0;
+        for (int tries = 0; tries != 100 && received != count; ++tries) {
+            while ( mr2->read(value) == NewData ) {
+                BOOST_CHECK_EQUAL( double(received), value );
+                ++received;
+            }
+            usleep(10000);
+        }
+        return received;
+    }
+};
+
+#define ASSERT_PORT_SIGNALLING(code, read_port) \
+    signalled_port = 0; \
+    code; \
+    usleep(100000); \
+    BOOST_CHECK( read_port == signalled_port );
+
+// Registers the fixture into the 'registry'
+BOOST_FIXTURE_TEST_SUITE(  SocketTestSuite,  SocketTest )
+
+BOOST_AUTO_TEST_CASE( testPortStreams )
+{
+    double value = 0;
+
+    // the sender is created first and connects on its first write.
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/sockdata1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    BOOST_CHECK( mw1->connected() );
+    BOOST_CHECK( mr2->connected() );
+    BOOST_CHECK( NoData == mr2->read(value) );
+
+    ASSERT_PORT_SIGNALLING(mw1->write(1.0), mr2);
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 1.0, value );
+    ASSERT_PORT_SIGNALLING(mw1->write(2.0), mr2);
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 2.0, value );
+    BOOST_CHECK( OldData == mr2->read(value) );
+
+    // a new receiver on the same name gets the samples once
+    // the sender noticed that the previous one went away.
+    mr2->disconnect();
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    for (int tries = 0; tries != 10 && mr2->read(value) != NewData; ++tries) {
+        mw1->write(3.0);
+        usleep(100000);
+    }
+    BOOST_CHECK_EQUAL( 3.0, value );
+    mw1->disconnect();
+    mr2->disconnect();
+    BOOST_CHECK( !mw1->connected() );
+    BOOST_CHECK( !mr2->connected() );
+
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 3;
+    policy.name_id = "/sockbuffer1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    ASSERT_PORT_SIGNALLING(mw1->write(1.0), mr2);
+    ASSERT_PORT_SIGNALLING(mw1->write(2.0), mr2);
+    ASSERT_PORT_SIGNALLING(mw1->write(3.0), mr2);
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 1.0, value );
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 2.0, value );
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 3.0, value );
+    BOOST_CHECK( OldData == mr2->read(value) );
+    mw1->disconnect();
+    mr2->disconnect();
+}
+
+BOOST_AUTO_TEST_CASE( testPortConnection )
+{
+    // an out-of-band connection picks the name of the socket.
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 8;
+    policy.name_id = "";
+    BOOST_REQUIRE( mw1->createConnection(*mr2, policy) );
+    BOOST_CHECK( !policy.name_id.empty() );
+
+    for (int i = 0; i != 8; ++i)
+        mw1->write( double(i) );
+    BOOST_CHECK_EQUAL( readSequence(8), 8 );
+    mw1->disconnect();
+    mr2->disconnect();
+}
+
+BOOST_AUTO_TEST_CASE( testUdpConnection )
+{
+    // the receiver picks a free port and tells the sender.
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 8;
+    policy.name_id = "udp:0";
+    BOOST_REQUIRE( mw1->createConnection(*mr2, policy) );
+    BOOST_CHECK_EQUAL( policy.name_id.substr(0, 14), "udp:127.0.0.1:" );
+    BOOST_CHECK( policy.name_id != "udp:127.0.0.1:0" );
+
+    for (int i = 0; i != 8; ++i)
+        mw1->write( double(i) );
+    BOOST_CHECK_EQUAL( readSequence(8), 8 );
+    mw1->disconnect();
+    mr2->disconnect();
+
+    policy.name_id = "udp:localhost:1234";
+    BOOST_CHECK( !mw1->createStream( policy ) );
+}
+
+BOOST_AUTO_TEST_CASE( testBatchTransport )
+{
+    // 40 samples take three sendmmsg() calls.
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 64;
+    policy.name_id = "/sockbatch1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+
+    std::vector<double> samples;
+    for (int i = 0; i != 40; ++i)
+        samples.push_back( double(i) );
+    mw1->write( samples );
+    BOOST_CHECK_EQUAL( readSequence(40), 40 );
+    mw1->disconnect();
+    mr2->disconnect();
+}
+
+BOOST_AUTO_TEST_CASE( testVectorTransport )
+{
+    std::vector<double> data(20, 3.33);
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("Vout");
+    tc->ports()->addPort(vin);
+    t2->ports()->addPort(vout);
+
+    // the slots are sized after this sample.
+    vout.setDataSample( data );
+
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/sockvdata1";
+    BOOST_REQUIRE( vout.createStream( policy ) );
+    BOOST_REQUIRE( vin.createStream( policy ) );
+    BOOST_CHECK_EQUAL( vin.read(data), NoData);
+
+    data.clear();
+    data.resize(10, 6.66);
+    vout.write( data );
+
+    data.clear();
+    data.resize(20, 0.0);
+    usleep(200000);
+    BOOST_CHECK_EQUAL( vin.read(data), NewData);
+    BOOST_CHECK_EQUAL( data.size(), 10);
+    for(unsigned int i=0; i != data.size(); ++i)
+        BOOST_CHECK_CLOSE( data[i], 6.66, 0.01);
+
+    // a sample which does not fit in a slot is dropped,
+    // the following ones still arrive.
+    data.resize(100, 1.0);
+    vout.write( data );
+    usleep(200000);
+    BOOST_CHECK_EQUAL( vin.read(data), OldData);
+    BOOST_CHECK_EQUAL( data.size(), 10);
+    BOOST_CHECK( vout.connected() );
+
+    data.resize(5, 9.99);
+    vout.write( data );
+    usleep(200000);
+    BOOST_CHECK_EQUAL( vin.read(data), NewData);
+    BOOST_CHECK_EQUAL( data.size(), 5);
+
+    vout.disconnect();
+    vin.disconnect();
+}
+
+BOOST_AUTO_TEST_CASE( testReservedVectorTransport )
+{
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("Vout");
+    tc->ports()->addPort(vin);
+    t2->ports()->addPort(vout);
+    vout.setDataSample( std::vector<double>(10, 1.0) );
+
+    // the slots of both ends are sized for max_elements.
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/sockvdata2";
+    policy.max_elements = 500;
+    BOOST_REQUIRE( vout.createStream( policy ) );
+    BOOST_REQUIRE( vin.createStream( policy ) );
+
+    std::vector<double> data;
+    unsigned int sizes[] = { 500, 3, 200 };
+    for (unsigned int s = 0; s != 3; ++s) {
+        vout.write( std::vector<double>( sizes[s], s + 0.5 ) );
+        usleep(200000);
+        BOOST_CHECK_EQUAL( vin.read(data), NewData);
+        BOOST_CHECK( data == std::vector<double>( sizes[s], s + 0.5 ) );
+    }
+
+    // larger samples are dropped.
+    vout.write( std::vector<double>( 501, 7.0 ) );
+    usleep(200000);
+    BOOST_CHECK_EQUAL( vin.read(data), OldData);
+
+    vout.disconnect();
+    vin.disconnect();
+}
+
+BOOST_AUTO_TEST_CASE( testSecondWriterRefused )
+{
+    OutputPort<double> mw2("mw2");
+    tc->ports()->addPort( mw2 );
+
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/sockdata9";
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    mw1->write( 1.0 );
+    usleep(100000);
+
+    // the second writer does not take over the stream of the first.
+    BOOST_REQUIRE( mw2.createStream( policy ) );
+    double value = 0;
+    for (int i = 0; i != 5; ++i) {
+        mw2.write( 2.0 );
+        usleep(50000);
+        mw1->write( 3.0 + i );
+        usleep(50000);
+        BOOST_CHECK_EQUAL( mr2->read(value), NewData );
+        BOOST_CHECK_EQUAL( value, 3.0 + i );
+    }
+
+    mw2.disconnect();
+    mw1->disconnect();
+    mr2->disconnect();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -28,6 +28,10 @@
 
 #include <boost/function_types/function_type.hpp>
 #include <OperationCaller.hpp>
+#include <internal/ExecutionTrace.hpp>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
 
 using namespace std;
 using namespace RTT;
@@ -637,5 +641,170 @@ BOOST_AUTO_TEST_CASE( testExecutionEngine)
     tsim->run(0);
 }
 
+/**
+ * A message which counts its executions.
+ */
+struct CountingMsg : public DisposableInterface
+{
+    int count;
+    CountingMsg() : count(0) {}
+    void executeAndDispose() { ++count; }
+    void dispose() {}
+    bool isError() const { return false; }
+};
+
+unsigned int statistic(TaskContext* tc, const std::string& name)
+{
+    BOOST_REQUIRE( tc->loadService("statistics") );
+    AttributeBase* a = tc->provides("statistics")->getAttribute(name);
+    BOOST_REQUIRE( a );
+    DataSource<unsigned int>::shared_ptr ds = DataSource<unsigned int>::narrow( a->getDataSource().get() );
+    BOOST_REQUIRE( ds );
+    return ds->get();
+}
+
+BOOST_AUTO_TEST_CASE( testMessageQueueCapacity)
+{
+    CountingMsg msg;
+    ExecutionEngine* ee = tc->engine();
+    BOOST_CHECK_EQUAL( ee->getMessageQueueCapacity(), 100u );
+    // the statistics are only offered on demand.
+    BOOST_CHECK( tc->provides()->getAttribute("MessageQueueHighWaterMark") == 0 );
+    BOOST_CHECK( tc->provides()->hasService("statistics") == false );
+
+    // grow beyond the default capacity:
+    ee->setMessageQueueCapacity( 250 );
+    for (int i = 0; i != 250; ++i)
+        BOOST_CHECK( ee->process( &msg ) );
+    BOOST_CHECK( ee->process( &msg ) == false );
+    BOOST_CHECK_EQUAL( statistic(tc, "MessageQueueHighWaterMark"), 250u );
+    BOOST_CHECK_EQUAL( statistic(tc, "MessageQueueRejected"), 1u );
+
+    BOOST_CHECK( SimulationThread::Instance()->run(1) );
+    BOOST_CHECK_EQUAL( msg.count, 250 );
+
+    // shrink again:
+    ee->setMessageQueueCapacity( 10 );
+    for (int i = 0; i != 10; ++i)
+        BOOST_CHECK( ee->process( &msg ) );
+    BOOST_CHECK( ee->process( &msg ) == false );
+    BOOST_CHECK_EQUAL( ee->getMessageQueueHighWaterMark(), 250u );
+    BOOST_CHECK_EQUAL( ee->getMessageQueueRejected(), 2u );
+    BOOST_CHECK( SimulationThread::Instance()->run(1) );
+    BOOST_CHECK_EQUAL( msg.count, 260 );
+
+    ee->resetQueueStatistics();
+    BOOST_CHECK_EQUAL( statistic(tc, "MessageQueueHighWaterMark"), 0u );
+    BOOST_CHECK_EQUAL( statistic(tc, "MessageQueueRejected"), 0u );
+    BOOST_CHECK_EQUAL( statistic(tc, "FunctionQueueRejected"), 0u );
+    BOOST_CHECK_EQUAL( statistic(tc, "PortQueueRejected"), 0u );
+    BOOST_CHECK( ee->setFunctionQueueCapacity( 5 ) );
+    BOOST_CHECK_EQUAL( ee->getFunctionQueueCapacity(), 5u );
+    tc->setPortQueueCapacity( 128 );
+    BOOST_CHECK_EQUAL( tc->getPortQueueCapacity(), 128u );
+}
+
+BOOST_AUTO_TEST_CASE( testLatencyHistogram )
+{
+    LatencyHistogram h;
+    // every value lies in its own bucket.
+    for (nsecs v = 0; v < 100000; v += 7) {
+        unsigned int i = LatencyHistogram::index(v);
+        BOOST_REQUIRE( LatencyHistogram::lowest(i) <= v );
+        BOOST_REQUIRE( v < LatencyHistogram::lowest(i + 1) );
+    }
+    BOOST_CHECK( LatencyHistogram::index( 1LL << 62 ) < LatencyHistogram::Buckets );
+
+    for (nsecs v = 1; v <= 1000; ++v)
+        h.add( v * 1000 );
+    BOOST_CHECK_EQUAL( h.count(), 1000u );
+    BOOST_CHECK_EQUAL( h.min(), 1000 );
+    BOOST_CHECK_EQUAL( h.max(), 1000000 );
+    BOOST_CHECK_CLOSE( h.mean(), 500500.0, 0.001 );
+    // within the resolution of the histogram:
+    BOOST_CHECK( h.percentile(50) >= 500000 && h.percentile(50) <= 500000 * 9 / 8 );
+    BOOST_CHECK( h.percentile(99) >= 990000 && h.percentile(99) <= 1000000 );
+    BOOST_CHECK_EQUAL( h.percentile(100), 1000000 );
+    h.reset();
+    BOOST_CHECK_EQUAL( h.count(), 0u );
+    BOOST_CHECK_EQUAL( h.percentile(50), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( testExecutionTrace )
+{
+    // the trace only exists on demand.
+    BOOST_CHECK( tc->provides()->hasService("trace") == false );
+    BOOST_REQUIRE( tc->loadService("trace") );
+    BOOST_REQUIRE( tc->provides()->hasService("trace") );
+    ExecutionTrace* trace = tc->trace();
+    BOOST_REQUIRE( trace );
+    BOOST_CHECK( trace == tc->trace() );
+    BOOST_CHECK( trace->isEnabled() == false );
+    BOOST_CHECK( trace->histogram(ExecutionTrace::Cycle) == 0 );
+
+    // nothing is recorded while disabled.
+    BOOST_CHECK( tc->start() );
+    BOOST_CHECK( SimulationThread::Instance()->run(5) );
+    BOOST_CHECK_EQUAL( trace->cycles(), 0u );
+
+    OperationCaller<void(bool)> enable = tc->provides("trace")->getOperation("enable");
+    OperationCaller<unsigned int(const std::string&)> count = tc->provides("trace")->getOperation("count");
+    OperationCaller<double(const std::string&, double)> percentile = tc->provides("trace")->getOperation("percentile");
+    BOOST_REQUIRE( enable.ready() && count.ready() && percentile.ready() );
+    enable( true );
+    BOOST_CHECK( trace->isEnabled() );
+
+    TaskCore child( tc->engine() );
+    child.trace()->enable( true );
+    BOOST_CHECK( child.start() );
+
+    BOOST_CHECK( SimulationThread::Instance()->run(10) );
+    BOOST_CHECK_EQUAL( trace->cycles(), 10u );
+    BOOST_CHECK_EQUAL( count("cycle"), 10u );
+    BOOST_CHECK_EQUAL( count("messages"), 10u );
+    BOOST_CHECK_EQUAL( count("functions"), 10u );
+    BOOST_CHECK_EQUAL( count("updateHook"), 10u );
+    BOOST_CHECK_EQUAL( count("prepareUpdateHook"), 10u );
+    BOOST_CHECK_EQUAL( count("errorHook"), 0u );
+    BOOST_CHECK_EQUAL( count("nonsense"), 0u );
+    BOOST_CHECK_EQUAL( child.trace()->getCount("updateHook"), 10u );
+    BOOST_CHECK_EQUAL( child.trace()->cycles(), 0u );
+    BOOST_CHECK( trace->getMin("cycle") <= trace->getMean("cycle") );
+    BOOST_CHECK( trace->getMean("cycle") <= trace->getMax("cycle") );
+    BOOST_CHECK( percentile("cycle", 50.0) <= trace->getMax("cycle") );
+
+    // trace file: header and 5 events per cycle, errorHook did not run.
+    BOOST_CHECK( trace->write("trace_test.bin") );
+    std::ifstream file("trace_test.bin", std::ios::binary);
+    char magic[8];
+    unsigned int header[4];
+    file.read( magic, 8 );
+    file.read( (char*)header, sizeof(header) );
+    BOOST_REQUIRE( file );
+    BOOST_CHECK( std::strncmp( magic, "RTTTRACE", 8 ) == 0 );
+    BOOST_CHECK_EQUAL( header[0], 1u );
+    BOOST_CHECK_EQUAL( header[1], 24u );
+    BOOST_CHECK_EQUAL( header[2], 50u );
+    BOOST_CHECK_EQUAL( header[3], (unsigned int)ExecutionTrace::PhaseCount );
+    file.seekg( 0, std::ios::end );
+    BOOST_CHECK_EQUAL( (int)file.tellg(), 8 + 16 + 50 * 24 );
+    file.close();
+    std::remove("trace_test.bin");
+
+    // a cycle longer than the period is an overrun.
+    BOOST_CHECK_EQUAL( trace->overruns(), 0u );
+    trace->cycle( 0, 2000000, 0.001 );
+    BOOST_CHECK_EQUAL( trace->overruns(), 1u );
+
+    trace->reset();
+    BOOST_CHECK_EQUAL( trace->cycles(), 0u );
+    BOOST_CHECK_EQUAL( count("cycle"), 0u );
+    enable( false );
+    BOOST_CHECK( SimulationThread::Instance()->run(5) );
+    BOOST_CHECK_EQUAL( count("cycle"), 0u );
+    BOOST_CHECK( child.stop() );
+    BOOST_CHECK( tc->stop() );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -24,11 +24,19 @@
 #include <iostream>
 
 #include <extras/Activities.hpp>
+#include <extras/DeadlineActivity.hpp>
 #include <extras/TimerThread.hpp>
 #include <extras/SimulationThread.hpp>
 #include <os/MainThread.hpp>
+#include <os/fosi_internal_interface.hpp>
+#include <os/TimeService.hpp>
 #include <Logger.hpp>
 #include <rtt-config.h>
+#include <ctime>
+#include <algorithm>
+#ifdef OROCOS_TARGET_GNULINUX
+#include <sched.h>
+#endif
 
 using namespace std;
 using namespace RTT;
@@ -405,6 +413,174 @@ BOOST_AUTO_TEST_CASE( testSequential )
     BOOST_CHECK( mtask.start() == false );
 }
 
+/**
+ * Counts the steps and checks that step() is
+ * never executed concurrently with itself.
+ */
+struct ExclusiveRunner
+    : public RunnableInterface
+{
+    os::AtomicInt inside;
+    volatile int steps;
+    volatile int violations;
+    ExclusiveRunner() : inside(0), steps(0), violations(0) {}
+    bool initialize() { return true; }
+    void step() {
+        inside.inc();
+        if ( inside.read() != 1 )
+            ++violations;
+        ++steps;
+        usleep(100);
+        inside.dec();
+    }
+    void finalize() {}
+};
+
+/**
+ * Measures the delay between trigger() and step().
+ */
+struct LatencyRunner
+    : public RunnableInterface
+{
+    os::TimeService::ticks stamp;
+    os::TimeService::nsecs total, worst;
+    volatile int steps;
+    LatencyRunner() : stamp(0), total(0), worst(0), steps(0) {}
+    bool initialize() { return true; }
+    void step() {
+        // an Activity also executes once when it is started.
+        if ( stamp == 0 )
+            return;
+        os::TimeService::nsecs d = os::TimeService::ticks2nsecs( os::TimeService::Instance()->getTicks() - stamp );
+        stamp = 0;
+        total += d;
+        worst = std::max(worst, d);
+        ++steps;
+    }
+    void finalize() {}
+};
+
+template<class Act>
+void benchTriggers(const std::string& name, std::vector<Act*>& acts, std::vector<LatencyRunner*>& runners, int rounds)
+{
+    std::clock_t cpu = std::clock();
+    for (int r = 0; r != rounds; ++r) {
+        for (unsigned int i = 0; i != acts.size(); ++i) {
+            runners[i]->stamp = os::TimeService::Instance()->getTicks();
+            acts[i]->trigger();
+        }
+        // wait until all components executed.
+        for (unsigned int i = 0; i != acts.size(); ++i)
+            while ( runners[i]->steps <= r )
+                usleep(100);
+    }
+    cpu = std::clock() - cpu;
+    os::TimeService::nsecs total = 0, worst = 0;
+    for (unsigned int i = 0; i != runners.size(); ++i) {
+        total += runners[i]->total;
+        worst = std::max(worst, runners[i]->worst);
+    }
+    BOOST_TEST_MESSAGE( name << ": " << acts.size() << " components, mean wake-up latency "
+                        << total / (rounds * acts.size()) / 1000 << " us, worst " << worst / 1000
+                        << " us, cpu time " << (cpu * 1000 / CLOCKS_PER_SEC) << " ms" );
+}
+
+BOOST_AUTO_TEST_CASE( testPool )
+{
+    ThreadPoolPtr pool( new ThreadPool(2, ORO_SCHED_OTHER, os::LowestPriority, "TestPool") );
+    BOOST_CHECK_EQUAL( pool->size(), 2u );
+    TestRunner r(true);
+
+    PoolActivity mtask(pool, &r);
+    BOOST_CHECK( mtask.getPool() == pool );
+    BOOST_CHECK( mtask.isActive() == false );
+    BOOST_CHECK( mtask.isRunning() == false );
+    BOOST_CHECK( mtask.isPeriodic() == false );
+    BOOST_CHECK( mtask.getPeriod() == 0.0 );
+    BOOST_CHECK( mtask.execute() == false );
+    BOOST_CHECK( mtask.trigger() == false );
+    BOOST_CHECK( mtask.thread() == os::MainThread::Instance() );
+
+    // starting...
+    BOOST_CHECK( mtask.start() == true );
+    BOOST_CHECK( r.init == true );
+    BOOST_CHECK( mtask.isActive() == true );
+    BOOST_CHECK( mtask.start() == false );
+
+    // calls step() in a worker
+    BOOST_CHECK( mtask.trigger() );
+    for (int i = 0; i != 1000 && !r.stepped; ++i)
+        usleep(1000);
+    BOOST_CHECK( r.stepped == true );
+    BOOST_CHECK( r.wasrunning );
+    BOOST_CHECK( r.wasactive );
+
+    // stopping...
+    BOOST_CHECK( mtask.stop() == true );
+    BOOST_CHECK( r.fini == true );
+    BOOST_CHECK( mtask.isRunning() == false );
+    BOOST_CHECK( mtask.isActive() == false );
+    BOOST_CHECK( mtask.stop() == false );
+    BOOST_CHECK( mtask.trigger() == false );
+
+    // many activities, triggered while they execute.
+    std::vector<ExclusiveRunner*> runners;
+    std::vector<PoolActivity*> acts;
+    for (int i = 0; i != 8; ++i) {
+        runners.push_back( new ExclusiveRunner() );
+        acts.push_back( new PoolActivity(pool, runners.back()) );
+        BOOST_CHECK( acts.back()->start() );
+    }
+    for (int t = 0; t != 200; ++t)
+        for (unsigned int i = 0; i != acts.size(); ++i)
+            BOOST_CHECK( acts[i]->trigger() );
+    // stop() cancels queued triggers, so wait for the workers to get to all of them.
+    for (unsigned int i = 0; i != acts.size(); ++i)
+        for (int w = 0; w != 1000 && runners[i]->steps == 0; ++w)
+            usleep(1000);
+    for (unsigned int i = 0; i != acts.size(); ++i) {
+        BOOST_CHECK( acts[i]->stop() );
+        BOOST_CHECK( runners[i]->steps > 0 );
+        BOOST_CHECK_EQUAL( runners[i]->violations, 0 );
+        delete acts[i];
+        delete runners[i];
+    }
+}
+
+/**
+ * Compares the wake-up latency and cpu time of one
+ * thread per component with the thread pool.
+ */
+BOOST_AUTO_TEST_CASE( testPoolBenchmark )
+{
+    const int components = 100, rounds = 50;
+    std::vector<LatencyRunner*> runners;
+    std::vector<Activity*> threads;
+    for (int i = 0; i != components; ++i) {
+        runners.push_back( new LatencyRunner() );
+        threads.push_back( new Activity(ORO_SCHED_OTHER, os::LowestPriority, 0.0, runners.back(), "Bench") );
+        BOOST_CHECK( threads.back()->start() );
+    }
+    benchTriggers("One thread per component", threads, runners, rounds);
+    for (int i = 0; i != components; ++i) {
+        delete threads[i];
+        delete runners[i];
+    }
+
+    runners.clear();
+    std::vector<PoolActivity*> acts;
+    for (int i = 0; i != components; ++i) {
+        runners.push_back( new LatencyRunner() );
+        acts.push_back( new PoolActivity(runners.back()) );
+        BOOST_CHECK( acts.back()->start() );
+    }
+    benchTriggers("PoolActivity", acts, runners, rounds);
+    for (int i = 0; i != components; ++i) {
+        delete acts[i];
+        delete runners[i];
+    }
+}
+
 BOOST_AUTO_TEST_CASE( testScheduler )
 {
     int rtsched = ORO_SCHED_OTHER;
@@ -543,6 +719,119 @@ BOOST_AUTO_TEST_CASE( testThreadConfig )
 }
 #endif
 
+#ifdef OROCOS_TARGET_GNULINUX
+BOOST_AUTO_TEST_CASE( testCpuSet )
+{
+    os::CpuSet cpus( 0x5 );
+    BOOST_CHECK_EQUAL( cpus.count(), 2u );
+    BOOST_CHECK( cpus.isSet(0) && !cpus.isSet(1) && cpus.isSet(2) );
+    cpus.set( 100 ).clear( 2 );
+    BOOST_CHECK( cpus.isSet(100) );
+    BOOST_CHECK_EQUAL( cpus.toMask(), 0x1u );
+
+    // pin to the first cpu this process may use, which need not be cpu 0.
+    cpu_set_t allowed;
+    CPU_ZERO( &allowed );
+    BOOST_REQUIRE( sched_getaffinity( 0, sizeof(allowed), &allowed ) == 0 );
+    unsigned int cpu = 0;
+    while ( cpu != CPU_SETSIZE && !CPU_ISSET( cpu, &allowed ) )
+        ++cpu;
+    BOOST_REQUIRE( cpu < os::CpuSet::MaxCpus );
+
+    Activity activity( ORO_SCHED_OTHER, os::LowestPriority, 0.0, 0, "CpuSetTest" );
+    BOOST_CHECK( activity.setCpuSet( os::CpuSet().set(cpu) ) );
+    BOOST_CHECK( activity.getCpuSet() == os::CpuSet().set(cpu) );
+    if ( cpu < 32 )
+        BOOST_CHECK_EQUAL( activity.getCpuAffinity(), 1u << cpu );
+    // an empty set clears the affinity again.
+    BOOST_CHECK( activity.setCpuSet( os::CpuSet() ) );
+    BOOST_CHECK( activity.getCpuSet().isSet(cpu) );
+
+    BOOST_CHECK( activity.setNumaNode( os::CpuSet::MaxCpus ) == false );
+    BOOST_CHECK_EQUAL( activity.getNumaNode(), -1 );
+    os::CpuSet node0 = os::rtos_numa_node_cpus( 0 );
+    if ( !node0.empty() ) {
+        BOOST_CHECK( activity.setNumaNode( 0 ) );
+        BOOST_CHECK_EQUAL( activity.getNumaNode(), 0 );
+        BOOST_CHECK( activity.start() );
+        BOOST_CHECK( activity.stop() );
+        BOOST_CHECK( activity.getCpuSet() == node0 );
+    }
+}
+#endif
+
+#ifdef OROCOS_TARGET_GNULINUX
+BOOST_AUTO_TEST_CASE( testPageFaults )
+{
+    long minor = -1, major = -1;
+    BOOST_CHECK_EQUAL( os::rtos_task_prefault_stack( 64 * 1024 ), 0 );
+    BOOST_CHECK_EQUAL( os::rtos_task_get_page_faults( &minor, &major ), 0 );
+    BOOST_CHECK( minor > 0 );
+
+    Activity activity( ORO_SCHED_OTHER, os::LowestPriority, 0.01, 0, "PageFaultTest" );
+    BOOST_CHECK( activity.getPageFaults( minor, major ) == false );
+    BOOST_CHECK( activity.start() );
+    usleep( 50000 );
+    BOOST_CHECK( activity.stop() );
+    // the counters are taken by the thread itself when it leaves the running state.
+    usleep( 50000 );
+    BOOST_CHECK( activity.getPageFaults( minor, major ) );
+    BOOST_CHECK( minor >= 0 && major >= 0 );
+}
+#endif
+
+#ifdef OROCOS_TARGET_GNULINUX
+/**
+ * Uses a given amount of CPU time in each step.
+ */
+struct BusyRunner
+    : public RunnableInterface
+{
+    volatile nsecs busy;
+
+    BusyRunner(nsecs busy) : busy(busy) {}
+
+    bool initialize() { return true; }
+    void step() {
+        RTOS_TASK* task = getActivity()->thread()->getTask();
+        nsecs end = os::rtos_task_get_cpu_time( task ) + busy;
+        while ( os::rtos_task_get_cpu_time( task ) < end )
+            ;
+    }
+    void finalize() {}
+};
+
+BOOST_AUTO_TEST_CASE( testDeadlineActivity )
+{
+    BusyRunner runner( 1000000 );
+    DeadlineActivity activity( 0.01, 0.005, 0.0, &runner, "DeadlineTest" );
+    BOOST_CHECK_CLOSE( activity.getBudget(), 0.005, 0.1 );
+    BOOST_CHECK_CLOSE( activity.getPeriod(), 0.01, 0.1 );
+    // the deadline may not lie after the period.
+    BOOST_CHECK( activity.setBudget( 0.005, 0.02 ) == false );
+
+    activity.setMaxOverrun( 1 );
+    BOOST_CHECK( activity.start() );
+    // the thread enters SCHED_DEADLINE when it starts, if the kernel allows it.
+    usleep( 20000 );
+    if ( activity.getScheduler() != ORO_SCHED_DEADLINE ) {
+        BOOST_TEST_MESSAGE( "Skipping testDeadlineActivity: the kernel refused SCHED_DEADLINE." );
+        activity.stop();
+        return;
+    }
+    usleep( 100000 );
+    BOOST_CHECK( activity.isRunning() );
+    BOOST_CHECK( activity.getMaxExecutionTime() >= 0.001 );
+    BOOST_CHECK( activity.getMaxExecutionTime() < 0.005 );
+
+    // using more than the budget is an overrun, which stops the activity.
+    runner.busy = 8000000;
+    usleep( 200000 );
+    BOOST_CHECK( !activity.isRunning() );
+    BOOST_CHECK( activity.getMaxExecutionTime() >= 0.005 );
+}
+#endif
+
 #if !defined( ORO_EMBEDDED ) && !defined( OROCOS_TARGET_WIN32 )
 BOOST_AUTO_TEST_CASE( testExceptionRecovery )
 {
@@ -21,8 +21,14 @@
 #include "time_test.hpp"
 #include <boost/bind.hpp>
 #include <os/Timer.hpp>
+#include <os/Semaphore.hpp>
+#include <os/Condition.hpp>
+#include <os/MutexLock.hpp>
+#include <os/Thread.hpp>
+#include <os/fosi.h>
 #include <rtt-detail-fwd.hpp>
 #include <iostream>
+#include <vector>
 
 #define EPSILON 0.000000002
 
@@ -86,6 +92,38 @@ struct TestTimer
     }
 };
 
+/**
+ * Counts the expirations of many timers.
+ */
+struct BenchTimer
+    : public Timer
+{
+    std::vector<int> fired;
+    std::vector<nsecs> due;
+    nsecs last;
+    int total;
+    int out_of_order;
+    BenchTimer(TimerId max)
+        :Timer(max, ORO_SCHED_OTHER, os::LowestPriority), fired(max, 0), due(max, 0),
+         last(0), total(0), out_of_order(0)
+    {}
+    bool bench_arm(TimerId id, Seconds wait)
+    {
+        // arm() takes the current time just after this.
+        due[id] = rtos_get_time_ns() + Seconds_to_nsecs(wait);
+        return arm(id, wait);
+    }
+    void timeout(Timer::TimerId id)
+    {
+        // timeout() must be called in order of expiry, even within one wake-up.
+        if ( due[id] < last )
+            ++out_of_order;
+        last = due[id];
+        ++fired[id];
+        ++total;
+    }
+};
+
 BOOST_FIXTURE_TEST_SUITE( TimeTestSuite, TimeTest )
 
 BOOST_AUTO_TEST_CASE( testSecondsConversion )
@@ -350,4 +388,148 @@ BOOST_AUTO_TEST_CASE( testTimerWaitFor )
     BOOST_REQUIRE_CLOSE( hbg->secondsSince(0), now + 0.5, 0.1 );
 }
 
+/**
+ * Arms and kills 10000 timers and measures the cost of each.
+ */
+BOOST_AUTO_TEST_CASE( testTimerBenchmark )
+{
+    const int count = 10000;
+    BenchTimer timer(count);
+
+    // arm all timers within 0.2 to 0.7 seconds, in a scattered order.
+    TimeService::ticks t = hbg->getTicks();
+    for (int i = 0; i != count; ++i)
+        BOOST_CHECK( timer.bench_arm( (i * 7919) % count, 0.2 + 0.5 * i / count ) );
+    Seconds arm_time = hbg->secondsSince(t);
+
+    // kill every other timer.
+    t = hbg->getTicks();
+    for (int i = 0; i < count; i += 2)
+        BOOST_CHECK( timer.killTimer( i ) );
+    Seconds kill_time = hbg->secondsSince(t);
+
+    // re-arm the others in the reverse order.
+    t = hbg->getTicks();
+    for (int i = 1; i < count; i += 2)
+        BOOST_CHECK( timer.bench_arm( i, 0.7 - 0.5 * i / count ) );
+    Seconds rearm_time = hbg->secondsSince(t);
+
+    BOOST_TEST_MESSAGE( "Timer with " << count << " timers: arm " << arm_time * 1e9 / count
+                        << " ns, kill " << kill_time * 1e9 / (count/2)
+                        << " ns, re-arm " << rearm_time * 1e9 / (count/2) << " ns per timer." );
+
+    sleep(1);
+    BOOST_CHECK_EQUAL( timer.total, count / 2 );
+    BOOST_CHECK_EQUAL( timer.out_of_order, 0 );
+    for (int i = 0; i != count; ++i) {
+        BOOST_CHECK_EQUAL( timer.fired[i], i % 2 );
+        BOOST_CHECK( !timer.isArmed(i) );
+    }
+}
+
+#ifdef OROCOS_TARGET_GNULINUX
+/**
+ * Switches the time base to the monotonic clocks and checks that timed
+ * waits and timers still wait for the requested duration.
+ */
+BOOST_AUTO_TEST_CASE( testMonotonicTimeBase )
+{
+    clockid_t saved = rtos_clock_id;
+    BOOST_CHECK_EQUAL( rtos_set_clock( CLOCK_PROCESS_CPUTIME_ID ), -1 );
+    BOOST_CHECK_EQUAL( rtos_clock_id, saved );
+
+    clockid_t clocks[] = { CLOCK_MONOTONIC, CLOCK_MONOTONIC_RAW };
+    for (int i = 0; i != 2; ++i) {
+        BOOST_REQUIRE_EQUAL( rtos_set_clock( clocks[i] ), 0 );
+        BOOST_CHECK( abs( rtos_get_time_ns() - rtos_clock_get_ns( clocks[i] ) ) < 10000000 );
+
+        // Semaphore::waitUntil
+        os::Semaphore sem(0);
+        Seconds now = hbg->secondsSince( 0 );
+        BOOST_CHECK( sem.waitUntil( hbg->getNSecs() + Seconds_to_nsecs(0.2) ) == false );
+        BOOST_REQUIRE_CLOSE( hbg->secondsSince( 0 ), now + 0.2, 10.0 );
+
+        // Condition::wait_until
+        os::Mutex m;
+        os::Condition c;
+        now = hbg->secondsSince( 0 );
+        {
+            os::MutexLock lock(m);
+            BOOST_CHECK( c.wait_until( m, hbg->getNSecs() + Seconds_to_nsecs(0.2) ) == false );
+        }
+        BOOST_REQUIRE_CLOSE( hbg->secondsSince( 0 ), now + 0.2, 10.0 );
+
+        // Timer, which runs in a Thread and waits on a Condition
+        TestTimer timer;
+        now = hbg->secondsSince( 0 );
+        BOOST_CHECK( timer.arm(0, 0.2) );
+        BOOST_CHECK( timer.waitFor( 0 ) );
+        BOOST_REQUIRE_CLOSE( hbg->secondsSince( 0 ), now + 0.2, 10.0 );
+    }
+    rtos_set_clock( saved );
+}
+#endif
+
+namespace {
+    /**
+     * Signals a semaphore twice and then sets a flag and broadcasts
+     * a condition, from its own thread.
+     */
+    class Poster : public os::Thread
+    {
+        os::Semaphore& sem;
+        os::Mutex& m;
+        os::Condition& c;
+        bool& flag;
+    public:
+        Poster(os::Semaphore& sem, os::Mutex& m, os::Condition& c, bool& flag)
+            : os::Thread(ORO_SCHED_OTHER, os::LowestPriority, 0.0, ~0, "Poster"),
+              sem(sem), m(m), c(c), flag(flag)
+        {}
+        ~Poster() { stop(); }
+
+        void loop()
+        {
+            sem.signal();
+            sem.signal();
+            os::MutexLock lock(m);
+            flag = true;
+            c.broadcast();
+        }
+    };
+}
+
+/**
+ * Checks the counting of Semaphore and that Semaphore and Condition
+ * wake up a thread which is signalled from another thread.
+ */
+BOOST_AUTO_TEST_CASE( testSemaphoreCondition )
+{
+    os::Semaphore sem(1);
+    BOOST_CHECK_EQUAL( sem.value(), 1 );
+    BOOST_CHECK( sem.trywait() );
+    BOOST_CHECK( !sem.trywait() );
+    BOOST_CHECK_EQUAL( sem.value(), 0 );
+    sem.signal();
+    sem.signal();
+    BOOST_CHECK_EQUAL( sem.value(), 2 );
+    sem.wait();
+    BOOST_CHECK( sem.waitUntil( hbg->getNSecs() ) );
+    BOOST_CHECK( !sem.waitUntil( hbg->getNSecs() + Seconds_to_nsecs(0.01) ) );
+
+    os::Mutex m;
+    os::Condition c;
+    bool flag = false;
+    Poster poster( sem, m, c, flag );
+    {
+        os::MutexLock lock(m);
+        BOOST_CHECK( poster.start() );
+        while ( !flag )
+            BOOST_REQUIRE( c.wait_until( m, hbg->getNSecs() + Seconds_to_nsecs(5.0) ) );
+    }
+    BOOST_CHECK( sem.waitUntil( hbg->getNSecs() + Seconds_to_nsecs(5.0) ) );
+    BOOST_CHECK( sem.trywait() );
+    BOOST_CHECK_EQUAL( sem.value(), 0 );
+}
+
 BOOST_AUTO_TEST_SUITE_END()